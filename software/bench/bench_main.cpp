@@ -0,0 +1,177 @@
+// Firmware side of the simavr benchmark, see bench/run_bench.py
+// Each benchmarked call is wrapped in BENCH_START/BENCH_STOP. The writes to the GPIOR registers
+// are picked up by bench/simavr_runner.c that records the cycle count and stack depth between them.
+
+#include <Arduino.h>
+#include <NMEAGPS.h>
+#include <avr/sleep.h>
+#include "defines.hpp"
+#include "datatypes.hpp"
+#include "i2c.hpp"
+#include "Si5351.hpp"
+#include "eeprom.hpp"
+#include "wspr_packet_formatting.hpp"
+
+#define BENCH_START(id) GPIOR0 = id
+#define BENCH_STOP(id) GPIOR1 = id
+#define BENCH_DONE() GPIOR2 = 1
+
+// Benchmark ids, must match bench/budget.json
+#define BENCH_WSPR_ENCODE 1
+#define BENCH_SET_FREQUENCY 2
+#define BENCH_SET_TONE 3
+#define BENCH_CALC_LOCATOR 4
+#define BENCH_EEPROM_CRC 5
+#define BENCH_NMEA_PARSE 6
+#define BENCH_CONVOLVE 7
+#define BENCH_CONVOLVE_ORIGINAL 8
+
+// Globals of main.cpp that the linked modules refer to with extern. main.cpp itself is left out, so every extern
+// in src/ and include/ that points to main.cpp must have its definition here or the bench will not link
+NMEAGPS gps;
+gps_fix fix;
+S_GadgetData GadgetData;
+S_FactoryData FactoryData;
+E_Mode CurrentMode = Idle;
+int GPSH, GPSM, GPSS;
+int fixstate;
+uint8_t CurrentBand;
+uint8_t CurrentLP;
+uint64_t freq;
+
+const uint8_t Message[11] = {0xc1, 0x7c, 0x39, 0x47, 0x5d, 0xb5, 0xc0, 0, 0, 0, 0}; // SM7PNV JO65 23 as wspr_encode packs it
+
+// The encoder before the single pass convolve: two registers with a 32 step parity loop each, a runtime bit reversal
+// interleaver and the merge with a 162 entry sync vector. Kept here to compare against
+static const uint8_t SyncOriginal[WSPR_SYMBOL_COUNT] =
+    {1, 1, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 1, 1, 1, 0, 0, 0, 1, 0, 0,
+     1, 0, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 1, 0, 1, 0, 0,
+     0, 0, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 0, 1, 1, 0, 1,
+     0, 0, 0, 0, 1, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 0,
+     1, 1, 0, 0, 0, 1, 1, 0, 1, 0, 1, 0, 0, 0, 1, 0, 0, 0, 0, 0, 1,
+     0, 0, 1, 0, 0, 1, 1, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 0, 1,
+     1, 1, 0, 0, 0, 0, 0, 1, 0, 1, 0, 0, 1, 1, 0, 0, 0, 0, 0, 0, 0,
+     1, 1, 0, 1, 0, 1, 1, 0, 0, 0, 1, 1, 0, 0, 0};
+
+static void __attribute__((noinline)) ConvolveOriginal(const uint8_t *c, uint8_t *symbols)
+{
+    uint8_t s[WSPR_SYMBOL_COUNT];
+    uint8_t d[WSPR_SYMBOL_COUNT];
+    uint32_t reg_0 = 0, reg_1 = 0, reg_temp;
+    uint8_t bit_count = 0, parity_bit, rev, index_temp, i, j, k;
+
+    for (i = 0; (i < 11) && (bit_count < WSPR_SYMBOL_COUNT); i++)
+    {
+        for (j = 0; (j < 8) && (bit_count < WSPR_SYMBOL_COUNT); j++)
+        {
+            reg_0 = (reg_0 << 1) | (((c[i] << j) & 0x80) ? 1 : 0);
+            reg_1 = (reg_1 << 1) | (((c[i] << j) & 0x80) ? 1 : 0);
+            reg_temp = reg_0 & 0xf2d05351;
+            parity_bit = 0;
+            for (k = 0; k < 32; k++)
+            {
+                parity_bit ^= reg_temp & 0x01;
+                reg_temp >>= 1;
+            }
+            s[bit_count++] = parity_bit;
+            reg_temp = reg_1 & 0xe4613c47;
+            parity_bit = 0;
+            for (k = 0; k < 32; k++)
+            {
+                parity_bit ^= reg_temp & 0x01;
+                reg_temp >>= 1;
+            }
+            s[bit_count++] = parity_bit;
+        }
+    }
+    i = 0;
+    for (j = 0; (j < 255) && (i < WSPR_SYMBOL_COUNT); j++)
+    {
+        index_temp = j;
+        rev = 0;
+        for (k = 0; k < 8; k++)
+        {
+            if (index_temp & 0x01)
+            {
+                rev |= 1 << (7 - k);
+            }
+            index_temp >>= 1;
+        }
+        if (rev < WSPR_SYMBOL_COUNT)
+        {
+            d[rev] = s[i++];
+        }
+    }
+    for (i = 0; i < WSPR_SYMBOL_COUNT; i++)
+    {
+        symbols[i] = SyncOriginal[i] + 2 * d[i];
+    }
+}
+
+const char NMEASentences[] PROGMEM = "$GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W*6A\r\n"
+                                     "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47\r\n";
+
+void setup()
+{
+    uint8_t *tx_buffer = get_tx_buffer_ptr();
+    uint8_t Symbols[WSPR_SYMBOL_COUNT];
+    char c;
+
+    Serial.begin(9600);
+    i2cInit();
+    DetectSi5351I2CAddress();
+    FactoryData.RefFreq = 26000000;
+    strcpy(GadgetData.WSPRData.CallSign, "SM7PNV");
+    strcpy(GadgetData.WSPRData.MaidenHead4, "JO65");
+    GadgetData.WSPRData.TXPowerdBm = 23;
+    GadgetData.WSPRData.SuPreFixOption = None;
+
+    BENCH_START(BENCH_WSPR_ENCODE);
+    wspr_encode(GadgetData.WSPRData.CallSign, GadgetData.WSPRData.MaidenHead4, GadgetData.WSPRData.TXPowerdBm, tx_buffer, 1, GadgetData);
+    BENCH_STOP(BENCH_WSPR_ENCODE);
+
+    memset(tx_buffer, 0, WSPR_PACKED_SIZE);
+    BENCH_START(BENCH_CONVOLVE);
+    convolve((uint8_t *)Message, tx_buffer, 11, WSPR_SYMBOL_COUNT);
+    BENCH_STOP(BENCH_CONVOLVE);
+
+    BENCH_START(BENCH_CONVOLVE_ORIGINAL);
+    ConvolveOriginal(Message, Symbols);
+    BENCH_STOP(BENCH_CONVOLVE_ORIGINAL);
+
+    BENCH_START(BENCH_SET_FREQUENCY);
+    si5351aSetFrequency(WSPR_FREQ20m, FactoryData.RefFreq);
+    BENCH_STOP(BENCH_SET_FREQUENCY);
+
+    si5351aStartToneTable(WSPR_FREQ20m, FactoryData.RefFreq, get_tx_symbol(0));
+    si5351aSetTone(get_tx_symbol(0));
+    BENCH_START(BENCH_SET_TONE);
+    si5351aSetTone(get_tx_symbol(1));
+    i2cWait();
+    BENCH_STOP(BENCH_SET_TONE);
+
+    BENCH_START(BENCH_CALC_LOCATOR);
+    calcLocator(557000000L, 132000000L, &GadgetData.WSPRData);
+    BENCH_STOP(BENCH_CALC_LOCATOR);
+
+    BENCH_START(BENCH_EEPROM_CRC);
+    GetEEPROM_CRC(UserSpace);
+    BENCH_STOP(BENCH_EEPROM_CRC);
+
+    BENCH_START(BENCH_NMEA_PARSE);
+    for (uint8_t i = 0; (c = pgm_read_byte(&NMEASentences[i])) != 0; i++)
+    {
+        gps.handle(c);
+    }
+    BENCH_STOP(BENCH_NMEA_PARSE);
+
+    Serial.flush();
+    BENCH_DONE();
+    cli();
+    sleep_enable();
+    sleep_cpu(); // Sleeping with interrupts off ends the simulation
+}
+
+void loop()
+{
+}
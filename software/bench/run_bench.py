@@ -0,0 +1,149 @@
+#!/usr/bin/env python3
+"""Cycle count benchmark of firmware hot paths under simavr.
+
+Builds the bench environment (bench/bench_main.cpp linked with the firmware modules) and the simavr
+runner, runs the firmware on a simulated ATmega328P and writes cycles, peak stack depth and flash size
+per benchmarked function plus total flash/RAM usage to a JSON file.
+
+The budgets in bench/budget.json start out as placeholders ("measured": false). Benchmarks over a placeholder budget
+are only reported. --update-budget replaces the budgets with the measured values plus BUDGET_MARGIN and sets measured,
+from then on the script exits with 1 if any benchmark is over its budget.
+
+Needs platformio, simavr (library and headers), libelf and the avr-gcc binutils from platformio.
+
+usage: run_bench.py [--no-build] [--output FILE] [--update-budget]
+"""
+
+import argparse
+import glob
+import json
+import os
+import shutil
+import subprocess
+import sys
+
+ProjectDir = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+BenchDir = os.path.join(ProjectDir, "bench")
+BuildDir = os.path.join(ProjectDir, ".pio", "build", "bench")
+Elf = os.path.join(BuildDir, "firmware.elf")
+Runner = os.path.join(BuildDir, "simavr_runner")
+BudgetFile = os.path.join(BenchDir, "budget.json")
+BUDGET_MARGIN = 1.1  # Measured cycles and stack times this are the new budget
+
+
+def Tool(Name):
+    """Find an avr binutils program, on the PATH or in the platformio toolchain."""
+    Path = shutil.which(Name)
+    if Path:
+        return Path
+    Found = glob.glob(os.path.expanduser("~/.platformio/packages/toolchain-atmelavr/bin/" + Name))
+    if not Found:
+        sys.exit("run_bench: can not find " + Name)
+    return Found[0]
+
+
+def Build():
+    subprocess.check_call(["pio", "run", "-e", "bench"], cwd=ProjectDir)
+    try:
+        Flags = subprocess.check_output(["pkg-config", "--cflags", "--libs", "simavr"], text=True).split()
+    except (OSError, subprocess.CalledProcessError):
+        Flags = ["-lsimavr"]
+    subprocess.check_call(["cc", "-O2", os.path.join(BenchDir, "simavr_runner.c"), "-o", Runner] + Flags + ["-lelf"])
+
+
+def SymbolSizes():
+    """Flash size of every function in the firmware, keyed by demangled name without arguments."""
+    Sizes = {}
+    Out = subprocess.check_output([Tool("avr-nm"), "-C", "-S", "--size-sort", Elf], text=True)
+    for Line in Out.splitlines():
+        Parts = Line.split(None, 3)
+        if len(Parts) == 4 and Parts[2] in "tTwW":
+            Name = Parts[3].split("(")[0]
+            Sizes[Name] = Sizes.get(Name, 0) + int(Parts[1], 16)
+    return Sizes
+
+
+def SectionSizes():
+    """Total flash and RAM use from the section sizes."""
+    Sections = {}
+    Out = subprocess.check_output([Tool("avr-size"), "-A", Elf], text=True)
+    for Line in Out.splitlines():
+        Parts = Line.split()
+        if len(Parts) >= 2 and Parts[0].startswith(".") and Parts[1].isdigit():
+            Sections[Parts[0]] = int(Parts[1])
+    return {
+        "flash": Sections.get(".text", 0) + Sections.get(".data", 0),
+        "ram": Sections.get(".data", 0) + Sections.get(".bss", 0),
+    }
+
+
+def main():
+    Parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    Parser.add_argument("--no-build", action="store_true", help="use the existing build")
+    Parser.add_argument("--output", default=os.path.join(BuildDir, "bench_results.json"))
+    Parser.add_argument("--update-budget", action="store_true", help="write the measured values to bench/budget.json")
+    Args = Parser.parse_args()
+
+    if not Args.no_build:
+        Build()
+    with open(BudgetFile) as File:
+        BudgetData = json.load(File)
+    Budget = BudgetData["benchmarks"]
+    Measured = BudgetData.get("measured", False)
+
+    Out = subprocess.run([Runner, Elf], capture_output=True, text=True)
+    if Out.returncode != 0:
+        sys.exit("run_bench: simulation failed\n" + Out.stderr)
+    Results = {}
+    Si5351Writes = 0
+    for Line in Out.stdout.splitlines():
+        Id, Cycles, Stack = Line.split(",")
+        if Id == "si5351":
+            Si5351Writes = int(Cycles)
+        else:
+            Results[int(Id)] = (int(Cycles), int(Stack))
+
+    Sizes = SymbolSizes()
+    Output = {"totals": SectionSizes(), "si5351_register_writes": Si5351Writes, "budget_measured": Measured, "benchmarks": []}
+    Failed = False
+    for Entry in Budget:
+        Cycles, Stack = Results.get(Entry["id"], (None, None))
+        if Cycles is None:
+            print("%-24s not run" % Entry["name"])
+            Failed = True
+            continue
+        Over = Cycles > Entry["max_cycles"] or Stack > Entry["max_stack"]
+        Failed |= Over and Measured and not Args.update_budget
+        if Args.update_budget:
+            Entry["max_cycles"] = int(Cycles * BUDGET_MARGIN)
+            Entry["max_stack"] = int(Stack * BUDGET_MARGIN)
+        Output["benchmarks"].append({
+            "id": Entry["id"],
+            "name": Entry["name"],
+            "cycles": Cycles,
+            "stack": Stack,
+            "flash": Sizes.get(Entry["symbol"]),
+            "max_cycles": Entry["max_cycles"],
+            "max_stack": Entry["max_stack"],
+            "over_budget": Over,
+        })
+        print("%-24s %10s cycles %5s bytes stack %6s bytes flash%s" % (
+            Entry["name"], Cycles, Stack, Sizes.get(Entry["symbol"]),
+            ("  OVER BUDGET" if Measured else "  over the placeholder budget") if Over else ""))
+    print("flash %(flash)d bytes, ram %(ram)d bytes" % Output["totals"])
+    if not Measured and not Args.update_budget:
+        print("the budgets in bench/budget.json are placeholders, run with --update-budget to replace them")
+
+    with open(Args.output, "w") as File:
+        json.dump(Output, File, indent=4)
+    if Args.update_budget and not Failed:
+        BudgetData["measured"] = True
+        BudgetData["_comment"] = BudgetData["_comment"].split(" PLACEHOLDERS:")[0]
+        with open(BudgetFile, "w") as File:
+            json.dump(BudgetData, File, indent=4)
+            File.write("\n")
+    return 1 if Failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,163 @@
+/*
+  simavr runner for the firmware benchmark (bench/bench_main.cpp)
+
+  Runs the firmware on a simulated ATmega328P at 8MHz with a fake Si5351 on the TWI bus.
+  The firmware writes a benchmark id to GPIOR0 when a measurement starts, to GPIOR1 when it
+  stops and to GPIOR2 when all are done. For every measurement one CSV line is printed:
+      id,cycles,stack_bytes
+  followed by a last line with the number of bytes the fake Si5351 received:
+      si5351,register_writes,0
+
+  Build: cc -O2 simavr_runner.c -o simavr_runner $(pkg-config --cflags --libs simavr) -lelf
+  Usage: simavr_runner firmware.elf
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+#include <simavr/sim_io.h>
+#include <simavr/avr_twi.h>
+
+#define GPIOR0_ADDR 0x3E
+#define GPIOR1_ADDR 0x4A
+#define GPIOR2_ADDR 0x4B
+#define MAX_CYCLES 800000000ULL // 100 seconds at 8MHz
+
+static avr_t *avr;
+
+// Benchmark state
+static uint8_t CurrentId;
+static avr_cycle_count_t StartCycle;
+static uint16_t StartSP;
+static uint16_t MinSP;
+static int Done;
+
+// Fake Si5351, acknowledges its address (96 or 98) and keeps a register file
+static avr_irq_t *SiIrq;
+static uint8_t SiSelected;
+static uint8_t SiRegs[256];
+static uint8_t SiRegAddr;
+static int SiIndex;
+static unsigned long SiWrites;
+
+static uint16_t GetSP(void)
+{
+    return avr->data[R_SPL] | (avr->data[R_SPH] << 8);
+}
+
+static void GPIORWrite(struct avr_t *avr, avr_io_addr_t addr, uint8_t v, void *param)
+{
+    avr->data[addr] = v;
+    if (addr == GPIOR0_ADDR)
+    {
+        CurrentId = v;
+        StartCycle = avr->cycle;
+        StartSP = MinSP = GetSP();
+    }
+    else if (addr == GPIOR1_ADDR && CurrentId == v)
+    {
+        printf("%u,%llu,%u\n", v, (unsigned long long)(avr->cycle - StartCycle), StartSP - MinSP);
+        CurrentId = 0;
+    }
+    else if (addr == GPIOR2_ADDR)
+    {
+        Done = 1;
+    }
+}
+
+static void SiHook(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+    avr_twi_msg_irq_t v;
+    v.u.v = value;
+
+    if (v.u.twi.msg & TWI_COND_STOP)
+    {
+        SiSelected = 0;
+    }
+    if (v.u.twi.msg & TWI_COND_START)
+    {
+        SiSelected = 0;
+        SiIndex = 0;
+        if ((v.u.twi.addr >> 1) == 96 || (v.u.twi.addr >> 1) == 98)
+        {
+            SiSelected = v.u.twi.addr;
+            avr_raise_irq(SiIrq + TWI_IRQ_INPUT, avr_twi_irq_msg(TWI_COND_ACK, SiSelected, 1));
+        }
+    }
+    if (SiSelected)
+    {
+        if (v.u.twi.msg & TWI_COND_WRITE)
+        {
+            avr_raise_irq(SiIrq + TWI_IRQ_INPUT, avr_twi_irq_msg(TWI_COND_ACK, SiSelected, 1));
+            if (SiIndex++ == 0)
+            {
+                SiRegAddr = v.u.twi.data; // First byte is the register address, it auto increments after that
+            }
+            else
+            {
+                SiRegs[SiRegAddr++] = v.u.twi.data;
+                SiWrites++;
+            }
+        }
+        if (v.u.twi.msg & TWI_COND_READ)
+        {
+            avr_raise_irq(SiIrq + TWI_IRQ_INPUT, avr_twi_irq_msg(TWI_COND_READ, SiSelected, SiRegs[SiRegAddr++]));
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    elf_firmware_t firmware;
+    static const char *SiIrqNames[2] = {"8>si5351.in", "8<si5351.out"};
+    int State;
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s firmware.elf\n", argv[0]);
+        return 2;
+    }
+    memset(&firmware, 0, sizeof(firmware));
+    if (elf_read_firmware(argv[1], &firmware) != 0)
+    {
+        fprintf(stderr, "%s: can not read %s\n", argv[0], argv[1]);
+        return 2;
+    }
+    avr = avr_make_mcu_by_name("atmega328p");
+    if (!avr)
+    {
+        fprintf(stderr, "%s: simavr has no atmega328p\n", argv[0]);
+        return 2;
+    }
+    avr_init(avr);
+    avr->frequency = 8000000;
+    avr_load_firmware(avr, &firmware);
+
+    avr_register_io_write(avr, GPIOR0_ADDR, GPIORWrite, NULL);
+    avr_register_io_write(avr, GPIOR1_ADDR, GPIORWrite, NULL);
+    avr_register_io_write(avr, GPIOR2_ADDR, GPIORWrite, NULL);
+
+    SiIrq = avr_alloc_irq(&avr->irq_pool, 0, 2, SiIrqNames);
+    avr_irq_register_notify(SiIrq + TWI_IRQ_OUTPUT, SiHook, NULL);
+    avr_connect_irq(SiIrq + TWI_IRQ_INPUT, avr_io_getirq(avr, AVR_IOCTL_TWI_GETIRQ(0), TWI_IRQ_INPUT));
+    avr_connect_irq(avr_io_getirq(avr, AVR_IOCTL_TWI_GETIRQ(0), TWI_IRQ_OUTPUT), SiIrq + TWI_IRQ_OUTPUT);
+
+    do
+    {
+        State = avr_run(avr);
+        if (CurrentId && GetSP() < MinSP)
+        {
+            MinSP = GetSP();
+        }
+    } while (!Done && State != cpu_Done && State != cpu_Crashed && avr->cycle < MAX_CYCLES);
+
+    printf("si5351,%lu,0\n", SiWrites);
+    if (!Done)
+    {
+        fprintf(stderr, "%s: firmware did not finish (state %d, cycle %llu)\n", argv[0], State, (unsigned long long)avr->cycle);
+        return 1;
+    }
+    return 0;
+}
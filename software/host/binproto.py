@@ -0,0 +1,357 @@
+#!/usr/bin/env python3
+"""Host side of the binary framed Serial API, see include/binary_protocol.hpp for the packet format.
+
+A packet is [message ID][payload][CRC-16 low][CRC-16 high], COBS encoded and sent between zero bytes.
+Replies to text commands sent with TEXT_COMMAND come back as plain text lines between the packets.
+
+    Link = BinLink("/dev/ttyUSB0")
+    Link.EnterBinary()
+    print(Link.ConfigGet("OTP"))
+    for Msg in Link.Messages(10):
+        print(Msg)
+
+usage: binproto.py [--port DEVICE] [--seconds N]   show the messages from a transmitter
+       binproto.py --demo                          run against a pseudo-terminal stand-in of the firmware
+"""
+
+import argparse
+import os
+import pty
+import select
+import struct
+import sys
+import termios
+import threading
+import time
+import tty
+
+MSG_TIME = 0x01
+MSG_LOCATOR = 0x02
+MSG_SATELLITES = 0x03
+MSG_TX_PROGRESS = 0x04
+MSG_GPS_LOCK = 0x05
+MSG_TX_ON = 0x06
+MSG_FREQUENCY = 0x07
+MSG_PAUSE = 0x08
+MSG_BAND = 0x09
+MSG_MODE = 0x0A
+MSG_VCC = 0x0B
+MSG_LPF = 0x0C
+MSG_CYCLE_DONE = 0x0D
+MSG_CONFIG_GET = 0x20
+MSG_CONFIG_VALUE = 0x21
+MSG_CONFIG_SET = 0x22
+MSG_TEXT_COMMAND = 0x30
+MSG_TEXT_MODE = 0x31
+MSG_ERROR = 0x7F
+
+MAX_PAYLOAD = 61
+
+Modes = ["Idle", "WSPRBeacon", "SignalGen"]
+
+
+def CRC16(Data, CRC=0xFFFF):
+    """CRC-16/CCITT-FALSE, the same as BinCRC16 in the firmware."""
+    for Byte in Data:
+        CRC ^= Byte << 8
+        for _ in range(8):
+            CRC = ((CRC << 1) ^ 0x1021) if CRC & 0x8000 else CRC << 1
+            CRC &= 0xFFFF
+    return CRC
+
+
+def CobsEncode(Data):
+    Out = bytearray()
+    for Block in bytes(Data).split(b"\x00"):
+        while len(Block) >= 254:
+            Out += b"\xff" + Block[:254]
+            Block = Block[254:]
+        Out += bytes([len(Block) + 1]) + Block
+    return bytes(Out)
+
+
+def CobsDecode(Data):
+    """Decoded bytes, or None if the data is not valid COBS."""
+    Out = bytearray()
+    i = 0
+    while i < len(Data):
+        Code = Data[i]
+        if Code == 0 or i + Code > len(Data):
+            return None
+        Out += Data[i + 1:i + Code]
+        i += Code
+        if Code < 0xFF and i < len(Data):
+            Out.append(0)
+    return bytes(Out)
+
+
+def EncodePacket(MsgID, Payload=b""):
+    """A complete frame with delimiters, ready to write to the serial port."""
+    if len(Payload) > MAX_PAYLOAD:
+        raise ValueError("payload longer than %d bytes" % MAX_PAYLOAD)
+    Packet = bytes([MsgID]) + bytes(Payload)
+    return b"\x00" + CobsEncode(Packet + struct.pack("<H", CRC16(Packet))) + b"\x00"
+
+
+def DecodePacket(Frame):
+    """(MsgID, payload) of a frame without its delimiters, None if it is damaged."""
+    Packet = CobsDecode(Frame)
+    if Packet is None or len(Packet) < 3:
+        return None
+    if struct.unpack("<H", Packet[-2:])[0] != CRC16(Packet[:-2]):
+        return None
+    return Packet[0], Packet[1:-2]
+
+
+def ParseMessage(MsgID, Payload):
+    """Device to host message as a (name, value) tuple."""
+    if MsgID == MSG_TIME:
+        return "time", "%02d:%02d:%02d" % tuple(Payload)
+    if MsgID == MSG_LOCATOR:
+        return "locator", Payload.decode("ascii", "replace")
+    if MsgID == MSG_SATELLITES:
+        return "satellites", [dict(zip(("id", "azimuth", "elevation", "snr"), struct.unpack_from("<BHBB", Payload, i)))
+                              for i in range(0, len(Payload) - 4, 5)]
+    if MsgID == MSG_TX_PROGRESS:
+        return "tx_progress", {"band": Payload[0], "indicator": Payload[1]}
+    if MsgID == MSG_GPS_LOCK:
+        return "gps_lock", bool(Payload[0])
+    if MsgID == MSG_TX_ON:
+        return "tx_on", bool(Payload[0])
+    if MsgID == MSG_FREQUENCY:
+        return "frequency", struct.unpack("<Q", Payload)[0] / 100.0
+    if MsgID == MSG_PAUSE:
+        return "pause", struct.unpack("<I", Payload)[0]
+    if MsgID == MSG_BAND:
+        return "band", Payload[0]
+    if MsgID == MSG_MODE:
+        return "mode", Modes[Payload[0]] if Payload[0] < len(Modes) else Payload[0]
+    if MsgID == MSG_VCC:
+        return "vcc", struct.unpack("<H", Payload)[0] / 1000.0
+    if MsgID == MSG_LPF:
+        return "lpf", "ABCD"[Payload[0] & 3]
+    if MsgID == MSG_CYCLE_DONE:
+        return "cycle_done", None
+    if MsgID == MSG_CONFIG_VALUE:
+        return "config", (Payload[:3].decode("ascii", "replace"), bytes(Payload[3:]))
+    if MsgID == MSG_ERROR:
+        return "error", Payload[0]
+    return "unknown_%02x" % MsgID, bytes(Payload)
+
+
+class StreamReader:
+    """Splits the byte stream from the device into packets and text lines.
+
+    The text lines the firmware prints have no zero bytes, so everything between two zeros is either a packet
+    or text. A packet is told apart by its CRC.
+    """
+
+    def __init__(self):
+        self.Pending = b""
+
+    def Feed(self, Data):
+        """List of ("packet", MsgID, payload) and ("text", line, None) found in Data."""
+        Found = []
+        Chunks = (self.Pending + Data).split(b"\x00")
+        self.Pending = Chunks.pop()
+        for Chunk in Chunks:
+            if not Chunk:
+                continue
+            Packet = DecodePacket(Chunk)
+            if Packet is not None:
+                Found.append(("packet",) + Packet)
+            else:
+                Found += self.Text(Chunk)
+        return Found
+
+    def Flush(self):
+        """Text that has not been followed by a zero byte, after the device went quiet."""
+        Chunk, self.Pending = self.Pending, b""
+        return self.Text(Chunk)
+
+    @staticmethod
+    def Text(Chunk):
+        return [("text", Line, None) for Line in Chunk.decode("ascii", "replace").splitlines() if Line.strip()]
+
+
+class BinLink:
+    """Serial link to a transmitter, the port is set to raw 9600 baud 8N1 like the firmware."""
+
+    def __init__(self, Port, Fd=None):
+        self.Fd = os.open(Port, os.O_RDWR | os.O_NOCTTY) if Fd is None else Fd
+        if os.isatty(self.Fd):
+            tty.setraw(self.Fd)
+            Attr = termios.tcgetattr(self.Fd)
+            Attr[4] = Attr[5] = termios.B9600
+            termios.tcsetattr(self.Fd, termios.TCSANOW, Attr)
+        self.Reader = StreamReader()
+        self.Queue = []
+
+    def Close(self):
+        os.close(self.Fd)
+
+    def Send(self, MsgID, Payload=b""):
+        os.write(self.Fd, EncodePacket(MsgID, Payload))
+
+    def Read(self, Timeout):
+        """Next packet or text line, None on timeout."""
+        End = time.monotonic() + Timeout
+        while not self.Queue:
+            Left = End - time.monotonic()
+            if Left <= 0:
+                return None
+            if select.select([self.Fd], [], [], min(Left, 0.2))[0]:
+                self.Queue += self.Reader.Feed(os.read(self.Fd, 256))
+            else:
+                self.Queue += self.Reader.Flush()
+        return self.Queue.pop(0)
+
+    def Messages(self, Seconds):
+        """Parsed messages as (name, value), text lines as ("text", line), for a number of seconds."""
+        End = time.monotonic() + Seconds
+        while time.monotonic() < End:
+            Item = self.Read(End - time.monotonic())
+            if Item is None:
+                break
+            if Item[0] == "packet":
+                yield ParseMessage(Item[1], Item[2])
+            else:
+                yield Item[:2]
+
+    def WaitFor(self, MsgIDs, Timeout=2.0):
+        """Payload of the first packet with one of the IDs, other packets and text are dropped."""
+        End = time.monotonic() + Timeout
+        while True:
+            Item = self.Read(max(End - time.monotonic(), 0))
+            if Item is None:
+                raise TimeoutError("no reply from the transmitter")
+            if Item[0] == "packet" and Item[1] in MsgIDs:
+                return Item[1], Item[2]
+
+    def EnterBinary(self):
+        os.write(self.Fd, b"[CBM] S\r\n")
+        End = time.monotonic() + 2.0
+        while time.monotonic() < End:
+            Item = self.Read(End - time.monotonic())
+            if Item is not None and Item[0] == "text" and Item[1].startswith("{CBM} T"):
+                return
+        raise TimeoutError("transmitter did not switch to binary mode")
+
+    def LeaveBinary(self):
+        self.Send(MSG_TEXT_MODE)
+
+    def TextCommand(self, Command):
+        """Sends a text Serial API command, e.g. "[OTP] G". The replies come as text lines from Read."""
+        self.Send(MSG_TEXT_COMMAND, Command.encode("ascii"))
+
+    def ConfigGet(self, Code):
+        """Raw stored value of a setting, e.g. ConfigGet("OTP") gives the four bytes of the TX pause."""
+        self.Send(MSG_CONFIG_GET, Code.encode("ascii"))
+        return self.ConfigReply(MSG_CONFIG_GET)
+
+    def ConfigSet(self, Code, Value):
+        """Sets a setting from its raw value, returns the value read back."""
+        self.Send(MSG_CONFIG_SET, Code.encode("ascii") + bytes(Value))
+        return self.ConfigReply(MSG_CONFIG_SET)
+
+    def ConfigReply(self, Request):
+        MsgID, Payload = self.WaitFor((MSG_CONFIG_VALUE, MSG_ERROR))
+        if MsgID == MSG_ERROR:
+            raise ValueError("transmitter refused message 0x%02x" % Request)
+        return Payload[3:]
+
+
+class DemoDevice(threading.Thread):
+    """Stand-in for the firmware on the far end of a pseudo-terminal, for trying the host side without hardware."""
+
+    def __init__(self, Fd):
+        threading.Thread.__init__(self, daemon=True)
+        self.Fd = Fd
+        self.Binary = False
+        self.Config = {b"OTP": struct.pack("<I", 480), b"OSM": b"\x00", b"FRF": struct.pack("<Q", 2500000000)}
+
+    def Send(self, MsgID, Payload=b""):
+        os.write(self.Fd, EncodePacket(MsgID, Payload))
+
+    def Handle(self, MsgID, Payload):
+        if MsgID == MSG_CONFIG_SET and Payload[:3] in self.Config and len(Payload) - 3 == len(self.Config[Payload[:3]]):
+            self.Config[Payload[:3]] = bytes(Payload[3:])
+            MsgID = MSG_CONFIG_GET
+        if MsgID == MSG_CONFIG_GET and Payload[:3] in self.Config:
+            self.Send(MSG_CONFIG_VALUE, Payload[:3] + self.Config[Payload[:3]])
+        elif MsgID == MSG_TEXT_COMMAND:
+            os.write(self.Fd, b"{MIN} Text command " + bytes(Payload) + b"\r\n")
+        elif MsgID == MSG_TEXT_MODE:
+            self.Binary = False
+            os.write(self.Fd, b"{CBM} F\r\n")
+        else:
+            self.Send(MSG_ERROR, bytes([MsgID]))
+
+    def Telemetry(self):
+        Now = time.gmtime()
+        self.Send(MSG_TIME, bytes([Now.tm_hour, Now.tm_min, Now.tm_sec]))
+        self.Send(MSG_LOCATOR, b"JO65ab")
+        self.Send(MSG_SATELLITES, struct.pack("<BHBB", 5, 123, 45, 38) + struct.pack("<BHBB", 12, 301, 12, 0))
+        self.Send(MSG_SATELLITES)
+        self.Send(MSG_FREQUENCY, struct.pack("<Q", 1409710000))
+        self.Send(MSG_TX_PROGRESS, bytes([6, 0x10]))
+
+    def run(self):
+        Reader = StreamReader()
+        Line = b""
+        while True:
+            if not select.select([self.Fd], [], [], 0.5)[0]:
+                if self.Binary:
+                    self.Telemetry()
+                continue
+            Data = os.read(self.Fd, 256)
+            if self.Binary:
+                for Item in Reader.Feed(Data):
+                    if Item[0] == "packet":
+                        self.Handle(Item[1], Item[2])
+                continue
+            Line += Data
+            if b"\n" in Line:
+                if Line.startswith(b"[CBM] S"):
+                    os.write(self.Fd, b"{CBM} T\r\n")
+                    self.Binary = True
+                Line = b""
+
+
+def Demo():
+    Master, Slave = pty.openpty()
+    tty.setraw(Master)
+    DemoDevice(Master).start()
+    Link = BinLink(os.ttyname(Slave))
+    Link.EnterBinary()
+    print("OTP", struct.unpack("<I", Link.ConfigGet("OTP"))[0])
+    print("OTP set to", struct.unpack("<I", Link.ConfigSet("OTP", struct.pack("<I", 600)))[0])
+    Link.TextCommand("[OTP] G")
+    for Msg in Link.Messages(1.2):
+        print(*Msg)
+    Link.LeaveBinary()
+    print(*Link.Read(1.0)[:2])
+
+
+def main():
+    Parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    Parser.add_argument("--port", default="/dev/ttyUSB0")
+    Parser.add_argument("--seconds", type=float, default=60)
+    Parser.add_argument("--demo", action="store_true", help="run against a pseudo-terminal stand-in of the firmware")
+    Args = Parser.parse_args()
+    if Args.demo:
+        Demo()
+        return
+    Link = BinLink(Args.port)
+    Link.EnterBinary()
+    try:
+        for Msg in Link.Messages(Args.seconds):
+            print(*Msg)
+            sys.stdout.flush()
+    finally:
+        Link.LeaveBinary()
+        Link.Close()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,88 @@
+// Stand-in for the NeoGPS parser in the native environment, with just the parts of its interface the firmware modules
+// use so they build on the host without the library. Nothing is parsed, the tests put the fix and the satellite list
+// in directly. The replay environment builds with the real NeoGPS instead (-DHOST_NEOGPS, lib_deps)
+#ifndef __neogps_standin__
+#define __neogps_standin__
+
+#include "Arduino.h"
+
+#define NMEAGPS_MAX_SATELLITES 20 // As the NeoGPS default
+#define GPS_FIX_SATELLITES        // Fields of gps_fix beyond position and time, as set in the NeoGPS GPSfix_cfg.h
+
+struct S_NeoTime
+{
+    uint8_t year; // Years since 2000
+    uint8_t month;
+    uint8_t date;
+    uint8_t hours;
+    uint8_t minutes;
+    uint8_t seconds;
+};
+
+class gps_fix
+{
+public:
+    enum status_t
+    {
+        STATUS_NONE,
+        STATUS_EST,
+        STATUS_TIME_ONLY,
+        STATUS_STD
+    };
+
+    struct
+    {
+        bool status;
+        bool location;
+        bool altitude;
+        bool date;
+        bool time;
+        bool satellites;
+    } valid;
+    status_t status;
+    S_NeoTime dateTime;
+    uint8_t dateTime_cs; // Hundredths of the second
+    struct
+    {
+        int32_t Lat; // 1e-7 degrees, as latitudeL and longitudeL return them
+        int32_t Lon;
+        int32_t lat() const { return Lat; }
+        int32_t lon() const { return Lon; }
+        void lat(int32_t Value) { Lat = Value; }
+        void lon(int32_t Value) { Lon = Value; }
+    } location;
+    struct
+    {
+        int16_t whole; // Meters
+        int16_t frac;  // Hundredths
+    } alt;
+    uint8_t satellites;
+
+    gps_fix() { init(); }
+    void init() { memset(this, 0, sizeof(*this)); }
+    int32_t latitudeL() const { return location.lat(); }
+    int32_t longitudeL() const { return location.lon(); }
+};
+
+class NMEAGPS
+{
+public:
+    struct satellite_view_t
+    {
+        uint8_t id;
+        uint8_t elevation; // 0-90 degrees
+        uint16_t azimuth;  // 0-359 degrees
+        uint8_t snr;       // dB
+        bool tracked;
+    };
+
+    satellite_view_t satellites[NMEAGPS_MAX_SATELLITES];
+    uint8_t sat_count = 0;
+
+    bool available(Stream &Port) { return false; }
+    gps_fix read() { return Fix; }
+
+    gps_fix Fix; // What read returns
+};
+
+#endif
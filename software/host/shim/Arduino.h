@@ -0,0 +1,169 @@
+// Minimal Arduino API for host (native) builds of the hardware independent firmware modules
+#ifndef __arduino_shim__
+#define __arduino_shim__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <string>
+#include <avr/pgmspace.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#ifndef F_CPU
+#define F_CPU 8000000UL // As the pro8MHzatmega328 board
+#endif
+
+#define HIGH 1
+#define LOW 0
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+// Pin numbers of the ATmega328P analog pins
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A4 18
+#define A5 19
+#define A6 20
+#define A7 21
+#define SDA 18
+#define SCL 19
+#define NUM_DIGITAL_PINS 22
+
+// Flash strings are plain strings on the host
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+
+class String
+{
+public:
+    String(const char *Str = "") : s(Str) {}
+    String(const __FlashStringHelper *Str) : s(reinterpret_cast<const char *>(Str)) {}
+    String(unsigned long Value, unsigned char Base = DEC);
+    unsigned int length() const { return s.length(); }
+    char charAt(unsigned int Index) const { return Index < s.length() ? s[Index] : 0; }
+    void toCharArray(char *Buffer, unsigned int Size) const;
+    void trim();
+    const char *c_str() const { return s.c_str(); }
+    String &operator=(const char *Str)
+    {
+        s = Str;
+        return *this;
+    }
+    String operator+(const char *Str) const { return String((s + Str).c_str()); }
+    String operator+(const String &Str) const { return String((s + Str.s).c_str()); }
+
+private:
+    std::string s;
+};
+
+// Byte streams, the print functions as in the Arduino core so libraries like NeoGPS build on the host
+class Print
+{
+public:
+    virtual size_t write(uint8_t Data) = 0;
+    size_t write(const uint8_t *Buffer, size_t Size)
+    {
+        size_t Written = 0;
+        while (Size--)
+            Written += write(*Buffer++);
+        return Written;
+    }
+    size_t write(const char *Str) { return write((const uint8_t *)Str, strlen(Str)); }
+    size_t print(const __FlashStringHelper *Str) { return write(reinterpret_cast<const char *>(Str)); }
+    size_t print(const char *Str) { return write(Str); }
+    size_t print(const String &Str) { return write(Str.c_str()); }
+    size_t print(char Ch) { return write((uint8_t)Ch); }
+    size_t print(unsigned long Value, int Base = DEC) { return PrintNumber(Value, Base); }
+    size_t print(long Value, int Base = DEC)
+    {
+        if ((Base == DEC) && (Value < 0))
+            return print('-') + PrintNumber(-(unsigned long)Value, Base);
+        return PrintNumber(Value, Base);
+    }
+    size_t print(int Value, int Base = DEC) { return print((long)Value, Base); }
+    size_t print(unsigned int Value, int Base = DEC) { return print((unsigned long)Value, Base); }
+    size_t print(unsigned char Value, int Base = DEC) { return print((unsigned long)Value, Base); }
+    size_t print(double Value, int Digits = 2)
+    {
+        char Buffer[32];
+        snprintf(Buffer, sizeof(Buffer), "%.*f", Digits, Value);
+        return write(Buffer);
+    }
+    template <typename T>
+    size_t println(T Value) { return print(Value) + println(); }
+    template <typename T>
+    size_t println(T Value, int Format) { return print(Value, Format) + println(); }
+    size_t println() { return write("\r\n"); }
+
+private:
+    size_t PrintNumber(unsigned long Value, int Base)
+    {
+        char Buffer[8 * sizeof(long) + 1];
+        char *Digit = &Buffer[sizeof(Buffer) - 1];
+
+        *Digit = 0;
+        if (Base < 2)
+            Base = DEC;
+        do
+        {
+            *--Digit = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ"[Value % Base];
+            Value /= Base;
+        } while (Value);
+        return write(Digit);
+    }
+};
+
+class Stream : public Print
+{
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+};
+
+// Serial port, everything written ends up on stdout or, when a test has set ShimSerialOutput, in that function
+typedef void (*ShimSerialSink)(uint8_t Data);
+
+extern ShimSerialSink ShimSerialOutput; // NULL for stdout
+extern int ShimSerialRoom;              // What availableForWrite returns, SERIAL_TX_BUFFER_SIZE - 1 of the Arduino core to start with
+
+class HardwareSerial : public Print
+{
+public:
+    void begin(unsigned long) {}
+    void setTimeout(unsigned long) {}
+    int available() { return 0; }
+    int read() { return -1; }
+    int availableForWrite() { return ShimSerialRoom; }
+    size_t write(uint8_t Data);
+    using Print::write;
+    void flush() { fflush(stdout); }
+};
+
+extern HardwareSerial Serial;
+
+extern uint16_t ShimPinOutputs[NUM_DIGITAL_PINS]; // Number of times each pin was made an output
+
+unsigned long millis();
+void ShimStopClock(bool Stop); // While stopped, time only passes with delay and sleep_cpu so time based code can be tested exactly
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void pinMode(uint8_t Pin, uint8_t Mode);
+void digitalWrite(uint8_t Pin, uint8_t Value);
+
+#endif
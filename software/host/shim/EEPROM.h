@@ -0,0 +1,36 @@
+// ATmega328 EEPROM for host builds, 1kB of RAM that starts out erased
+#ifndef __eeprom_shim__
+#define __eeprom_shim__
+
+#include <stdint.h>
+#include <string.h>
+
+class EEPROMClass
+{
+public:
+    EEPROMClass() { memset(Data, 0xFF, sizeof(Data)); }
+    uint8_t &operator[](int Address) { return Data[Address]; }
+    uint8_t read(int Address) { return Data[Address]; }
+    void write(int Address, uint8_t Value) { Data[Address] = Value; }
+    void update(int Address, uint8_t Value) { Data[Address] = Value; }
+    uint16_t length() { return sizeof(Data); }
+    template <typename T>
+    T &get(int Address, T &Value)
+    {
+        memcpy(&Value, &Data[Address], sizeof(T));
+        return Value;
+    }
+    template <typename T>
+    const T &put(int Address, const T &Value)
+    {
+        memcpy(&Data[Address], &Value, sizeof(T));
+        return Value;
+    }
+
+private:
+    uint8_t Data[1024];
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
@@ -0,0 +1,2 @@
+// Print class of the Arduino core, part of the Arduino shim on the host
+#include "Arduino.h"
@@ -0,0 +1,200 @@
+#include "Arduino.h"
+#include "EEPROM.h"
+#include <avr/sleep.h>
+#include <util/atomic.h>
+#include <chrono>
+#include <thread>
+
+HardwareSerial Serial;
+EEPROMClass EEPROM;
+ShimSerialSink ShimSerialOutput;
+int ShimSerialRoom = 63;
+
+volatile uint8_t TWBR;
+volatile uint8_t TWSR;
+volatile uint8_t TWDR;
+volatile uint8_t PRR;
+volatile uint8_t TCCR1A;
+volatile uint8_t TCCR1B;
+volatile uint8_t TIMSK1;
+volatile uint8_t TIFR1;
+volatile uint16_t TCNT1;
+volatile uint16_t OCR1A;
+volatile uint16_t ICR1;
+volatile uint8_t ADMUX;
+volatile uint16_t ADC;
+ADCControlRegister ADCSRA;
+volatile uint8_t DDRB;
+volatile uint8_t DDRC;
+volatile uint8_t DDRD;
+volatile uint8_t PORTB;
+volatile uint8_t PORTC;
+volatile uint8_t PORTD;
+WatchdogControlRegister WDTCSR;
+ShimWatchdogHook ShimWatchdogStart;
+volatile unsigned long timer0_millis;
+
+uint16_t ShimPinOutputs[NUM_DIGITAL_PINS];
+
+static const std::chrono::steady_clock::time_point StartTime = std::chrono::steady_clock::now();
+static unsigned long Slept;   // Milliseconds sleep_cpu, and delay while the clock is stopped, have let pass without waiting
+static bool ClockStopped;
+static unsigned long StopTime; // Real time in milliseconds when the clock was stopped
+
+#define SHIM_PENDING_MAX 4
+
+static bool InterruptsOn = true;
+static bool InInterrupt;
+static ShimVector Pending[SHIM_PENDING_MAX];
+static uint8_t PendingCount;
+
+// Marks an interrupt as pending, an interrupt that is already pending is only taken once as on the AVR
+void ShimPend(ShimVector Vector)
+{
+    for (uint8_t i = 0; i < PendingCount; i++)
+    {
+        if (Pending[i] == Vector)
+            return;
+    }
+    if (PendingCount < SHIM_PENDING_MAX)
+        Pending[PendingCount++] = Vector;
+}
+
+// Marks an interrupt as pending and takes it at once when interrupts are enabled
+void ShimRaise(ShimVector Vector)
+{
+    ShimPend(Vector);
+    ShimDispatch();
+}
+
+// Runs the pending interrupts in the order they were raised, with interrupts disabled while each one runs
+void ShimDispatch()
+{
+    ShimVector Vector;
+
+    while (InterruptsOn && !InInterrupt && (PendingCount > 0))
+    {
+        Vector = Pending[0];
+        PendingCount--;
+        memmove(&Pending[0], &Pending[1], PendingCount * sizeof(Pending[0]));
+        InInterrupt = true;
+        InterruptsOn = false;
+        Vector();
+        InterruptsOn = true;
+        InInterrupt = false;
+    }
+}
+
+void cli()
+{
+    InterruptsOn = false;
+}
+
+void sei()
+{
+    InterruptsOn = true;
+    ShimDispatch();
+}
+
+void sleep_cpu()
+{
+    if (PendingCount > 0)
+    {
+        sei(); // Any interrupt wakes the CPU
+    }
+    else
+    {
+        Slept++; // Nothing will happen, let time pass
+    }
+}
+
+ShimAtomic::ShimAtomic() : Saved(InterruptsOn), Done(false)
+{
+    InterruptsOn = false;
+}
+
+ShimAtomic::~ShimAtomic()
+{
+    InterruptsOn = Saved;
+    ShimDispatch();
+}
+
+size_t HardwareSerial::write(uint8_t Data)
+{
+    if (ShimSerialOutput != NULL)
+    {
+        ShimSerialOutput(Data);
+        return 1;
+    }
+    return fputc(Data, stdout) == EOF ? 0 : 1;
+}
+
+String::String(unsigned long Value, unsigned char Base)
+{
+    char Buffer[24];
+    snprintf(Buffer, sizeof(Buffer), Base == 16 ? "%lX" : "%lu", Value);
+    s = Buffer;
+}
+
+void String::toCharArray(char *Buffer, unsigned int Size) const
+{
+    if (Size == 0)
+        return;
+    strncpy(Buffer, s.c_str(), Size - 1);
+    Buffer[Size - 1] = 0;
+}
+
+void String::trim()
+{
+    size_t First = s.find_first_not_of(" \t\r\n");
+    size_t Last = s.find_last_not_of(" \t\r\n");
+    s = (First == std::string::npos) ? "" : s.substr(First, Last - First + 1);
+}
+
+static unsigned long RealMillis()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - StartTime).count();
+}
+
+unsigned long millis()
+{
+    return (ClockStopped ? StopTime : RealMillis()) + Slept;
+}
+
+void ShimStopClock(bool Stop)
+{
+    if (Stop && !ClockStopped)
+    {
+        StopTime = RealMillis();
+    }
+    else if (!Stop && ClockStopped)
+    {
+        Slept -= RealMillis() - StopTime; // millis() carries on from where it stopped
+    }
+    ClockStopped = Stop;
+}
+
+void delay(unsigned long ms)
+{
+    if (ClockStopped)
+    {
+        Slept += ms;
+        return;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void pinMode(uint8_t Pin, uint8_t Mode)
+{
+    if ((Mode == OUTPUT) && (Pin < NUM_DIGITAL_PINS))
+        ShimPinOutputs[Pin]++;
+}
+
+void digitalWrite(uint8_t Pin, uint8_t Value)
+{
+}
@@ -0,0 +1,16 @@
+// Interrupts for host builds. An ISR is an ordinary function, the models raise it with ShimRaise and it runs at once
+// when interrupts are enabled, otherwise as soon as they are enabled again (sei, the end of an ATOMIC_BLOCK or sleep_cpu)
+#ifndef __interrupt_shim__
+#define __interrupt_shim__
+
+#define ISR(vector) void vector()
+
+typedef void (*ShimVector)();
+
+void cli();
+void sei();
+void ShimRaise(ShimVector Vector);
+void ShimPend(ShimVector Vector); // Only marks it pending, it runs at the next point interrupts are enabled again
+void ShimDispatch();
+
+#endif
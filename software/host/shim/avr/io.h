@@ -0,0 +1,133 @@
+// AVR registers for host builds, only the ones the native modules use. They are plain variables except TWCR, a write
+// to it starts the bus action it asks for on the TWI model (host/twi_model.cpp) just like on the ATmega328P,
+// ADCSRA, where a conversion is done as soon as it is started, and WDTCSR, which reports each watchdog period started
+#ifndef __io_shim__
+#define __io_shim__
+
+#include <stdint.h>
+
+#define _BV(bit) (1 << (bit))
+#define bit_is_set(sfr, bit) ((sfr) & _BV(bit))
+#define bit_is_clear(sfr, bit) (!((sfr) & _BV(bit)))
+
+// TWI
+class TWIControlRegister
+{
+public:
+    TWIControlRegister &operator=(uint8_t NewValue);
+    operator uint8_t() const { return Value; }
+
+private:
+    uint8_t Value;
+};
+
+extern volatile uint8_t TWBR;
+extern volatile uint8_t TWSR;
+extern volatile uint8_t TWDR;
+extern TWIControlRegister TWCR;
+extern volatile uint8_t PRR;
+
+#define TWINT 7
+#define TWEA 6
+#define TWSTA 5
+#define TWSTO 4
+#define TWWC 3
+#define TWEN 2
+#define TWIE 0
+
+// Timer1
+extern volatile uint8_t TCCR1A;
+extern volatile uint8_t TCCR1B;
+extern volatile uint8_t TIMSK1;
+extern volatile uint8_t TIFR1;
+extern volatile uint16_t TCNT1;
+extern volatile uint16_t OCR1A;
+extern volatile uint16_t ICR1;
+
+#define CS10 0
+#define CS11 1
+#define CS12 2
+#define TOIE1 0
+#define OCIE1A 1
+#define ICIE1 5
+#define TOV1 0
+#define OCF1A 1
+#define ICF1 5
+
+// ADC, ADC holds whatever reading the test has put there
+#define REFS1 7
+#define REFS0 6
+#define MUX3 3
+#define MUX2 2
+#define MUX1 1
+#define MUX0 0
+#define ADEN 7
+#define ADSC 6
+#define ADIE 3
+#define ADPS2 2
+#define ADPS1 1
+#define ADPS0 0
+
+class ADCControlRegister
+{
+public:
+    ADCControlRegister &operator=(uint8_t NewValue)
+    {
+        Value = NewValue & ~_BV(ADSC); // ADSC reads back as 0, the conversion is already done
+        return *this;
+    }
+    ADCControlRegister &operator|=(int Bits) { return *this = Value | Bits; }
+    ADCControlRegister &operator&=(int Bits) { return *this = Value & Bits; }
+    operator uint8_t() const { return Value; }
+
+private:
+    uint8_t Value;
+};
+
+extern volatile uint8_t ADMUX;
+extern volatile uint16_t ADC;
+extern ADCControlRegister ADCSRA;
+
+// Ports
+extern volatile uint8_t DDRB;
+extern volatile uint8_t DDRC;
+extern volatile uint8_t DDRD;
+extern volatile uint8_t PORTB;
+extern volatile uint8_t PORTC;
+extern volatile uint8_t PORTD;
+
+// Watchdog, a write that enables its interrupt starts a period and is passed on to ShimWatchdogStart when a test has set it
+#define WDIF 7
+#define WDIE 6
+#define WDP3 5
+#define WDCE 4
+#define WDE 3
+#define WDP2 2
+#define WDP1 1
+#define WDP0 0
+
+typedef void (*ShimWatchdogHook)(uint8_t Prescaler);
+
+extern ShimWatchdogHook ShimWatchdogStart; // Gets the WDP bits of each period
+
+class WatchdogControlRegister
+{
+public:
+    WatchdogControlRegister &operator=(uint8_t NewValue)
+    {
+        Value = NewValue;
+        if ((NewValue & _BV(WDIE)) && (ShimWatchdogStart != 0))
+        {
+            ShimWatchdogStart(NewValue & (_BV(WDP3) | _BV(WDP2) | _BV(WDP1) | _BV(WDP0)));
+        }
+        return *this;
+    }
+    operator uint8_t() const { return Value; }
+
+private:
+    uint8_t Value;
+};
+
+extern WatchdogControlRegister WDTCSR;
+
+#endif
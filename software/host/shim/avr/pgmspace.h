@@ -0,0 +1,19 @@
+// Program memory access for host builds, flash data is ordinary memory
+#ifndef __pgmspace_shim__
+#define __pgmspace_shim__
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+#define memcpy_P memcpy
+#define memcmp_P memcmp
+#define strchr_P strchr
+#define strcmp_P strcmp
+#define strlen_P strlen
+
+#endif
@@ -0,0 +1,16 @@
+// Sleep modes for host builds. sleep_cpu runs the pending interrupts, if there are none it lets a millisecond pass
+#ifndef __sleep_shim__
+#define __sleep_shim__
+
+#define SLEEP_MODE_IDLE 0
+#define SLEEP_MODE_ADC 1
+#define SLEEP_MODE_PWR_DOWN 2
+
+#define set_sleep_mode(mode)
+#define sleep_enable()
+#define sleep_disable()
+#define sleep_bod_disable()
+
+void sleep_cpu();
+
+#endif
@@ -0,0 +1,14 @@
+// Watchdog for host builds, there is no reset mode. The periods themselves pass in sleep_cpu like any other sleep
+#ifndef __wdt_shim__
+#define __wdt_shim__
+
+#include <avr/io.h>
+
+#define wdt_reset()
+
+inline void wdt_disable()
+{
+    WDTCSR = 0;
+}
+
+#endif
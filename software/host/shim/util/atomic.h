@@ -0,0 +1,22 @@
+// Atomic blocks for host builds, interrupts raised inside the block run when it ends
+#ifndef __atomic_shim__
+#define __atomic_shim__
+
+#include <avr/interrupt.h>
+
+class ShimAtomic
+{
+public:
+    ShimAtomic();
+    ~ShimAtomic();
+    bool Once() { return Done ? false : (Done = true); }
+
+private:
+    bool Saved;
+    bool Done;
+};
+
+#define ATOMIC_RESTORESTATE
+#define ATOMIC_BLOCK(type) for (ShimAtomic Atomic_; Atomic_.Once();)
+
+#endif
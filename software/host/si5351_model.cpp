@@ -0,0 +1,45 @@
+#include "si5351_model.hpp"
+#include "defines.hpp"
+#include "i2c.hpp"
+#include "Si5351.hpp"
+#include "twi_model.hpp"
+
+uint8_t Si5351Regs[256];
+uint16_t Si5351Writes;
+
+void Si5351ModelReset()
+{
+    memset(Si5351Regs, 0, sizeof(Si5351Regs));
+    TWIModelReset();
+    TWIModelAttach(96, Si5351Regs, &Si5351Writes);
+    i2cInit();
+    DetectSi5351I2CAddress();
+    Si5351Writes = 0;
+}
+
+// Ratio (P1 + 512 + P2 / P3) / 128 of a PLL or MultiSynth from its eight register block (AN619)
+static long double Ratio(uint8_t Reg)
+{
+    const uint8_t *r = &Si5351Regs[Reg];
+    uint32_t P1 = ((uint32_t)(r[2] & 0x03) << 16) | ((uint32_t)r[3] << 8) | r[4];
+    uint32_t P2 = ((uint32_t)(r[5] & 0x0F) << 16) | ((uint32_t)r[6] << 8) | r[7];
+    uint32_t P3 = ((uint32_t)(r[5] & 0xF0) << 12) | ((uint32_t)r[0] << 8) | r[1];
+
+    if (P3 == 0)
+        return 0;
+    return (P1 + 512 + (long double)P2 / P3) / 128;
+}
+
+long double Si5351ModelOutput(uint8_t Clk, uint32_t RefFreq)
+{
+    uint8_t Control = Si5351Regs[SI_CLK0_CONTROL + Clk];
+    uint8_t MS = SI_SYNTH_MS_0 + 8 * Clk;
+    uint8_t PLL = (Control & SI_CLK_SRC_PLL_B) ? SI_SYNTH_PLL_B : SI_SYNTH_PLL_A;
+    uint8_t R = 1 << ((Si5351Regs[MS + 2] >> 4) & 0x07);
+    long double MSRatio = Ratio(MS);
+
+    if ((Control & 0x80) || MSRatio == 0)
+        return 0;
+    return RefFreq * Ratio(PLL) / MSRatio / R;
+}
+
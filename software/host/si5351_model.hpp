@@ -0,0 +1,9 @@
+// Register level model of the Si5351 for host builds. It is a slave on the TWI model (twi_model.hpp) so the firmware
+// Si5351 code and I2C driver run unchanged and the output frequencies are reconstructed from the registers written
+#include "Arduino.h"
+
+extern uint8_t Si5351Regs[256]; // Register file as written by the firmware
+extern uint16_t Si5351Writes;   // Number of register bytes written since the last Si5351ModelReset
+
+void Si5351ModelReset(); // Also starts the I2C driver and detects the Si5351 as the firmware does
+long double Si5351ModelOutput(uint8_t Clk, uint32_t RefFreq); // Output frequency of CLK0-2 in Hz, 0 if the output is off
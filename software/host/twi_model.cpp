@@ -0,0 +1,205 @@
+#include "twi_model.hpp"
+#include "defines.hpp"
+
+#define TWI_MODEL_SLAVES 2
+
+struct S_TWISlave
+{
+    uint8_t Address;  // 7 bit I2C address
+    uint8_t *Regs;    // 256 byte register file
+    uint16_t *Writes; // Counts the register bytes written, NULL if not needed
+    uint8_t Pointer;  // Register address of the next read or write
+};
+
+enum E_TWIBus
+{
+    BusIdle,    // No START from this master
+    BusAddress, // START sent, the next byte is the slave address
+    BusWrite,   // Slave addressed for writing
+    BusRead     // Slave addressed for reading
+};
+
+uint8_t TWIModelNackByte;
+uint8_t TWIModelArbLostByte;
+boolean TWIModelStuck;
+boolean TWIModelHold;
+uint16_t TWIModelStarts;
+uint16_t TWIModelStops;
+char TWIModelTrace[256];
+
+TWIControlRegister TWCR;
+
+static S_TWISlave Slaves[TWI_MODEL_SLAVES];
+static uint8_t SlaveCount;
+static S_TWISlave *Selected; // Slave of the current transaction, NULL if none answered
+static E_TWIBus Bus;
+static uint8_t ByteCount; // Bytes written after the address in the current transaction
+static boolean Held;      // A bus action completed while TWIModelHold was set, its interrupt not raised yet
+
+void TWI_vect(); // ISR in i2c.cpp
+
+static void Trace(const char *Format, unsigned Value = 0)
+{
+    size_t Length = strlen(TWIModelTrace);
+
+    snprintf(&TWIModelTrace[Length], sizeof(TWIModelTrace) - Length, Format, Value);
+}
+
+// No slaves, no faults and an idle bus
+void TWIModelReset()
+{
+    SlaveCount = 0;
+    Selected = NULL;
+    Bus = BusIdle;
+    TWIModelNackByte = TWI_MODEL_NEVER;
+    TWIModelArbLostByte = TWI_MODEL_NEVER;
+    TWIModelStuck = false;
+    TWIModelHold = false;
+    Held = false;
+    TWIModelStarts = 0;
+    TWIModelStops = 0;
+    TWIModelTrace[0] = 0;
+    TWCR = 0;
+}
+
+void TWIModelAttach(uint8_t Address, uint8_t *Regs, uint16_t *Writes)
+{
+    if (SlaveCount < TWI_MODEL_SLAVES)
+    {
+        Slaves[SlaveCount].Address = Address;
+        Slaves[SlaveCount].Regs = Regs;
+        Slaves[SlaveCount].Writes = Writes;
+        Slaves[SlaveCount].Pointer = 0;
+        SlaveCount++;
+    }
+}
+
+static S_TWISlave *FindSlave(uint8_t Address)
+{
+    for (uint8_t i = 0; i < SlaveCount; i++)
+    {
+        if (Slaves[i].Address == Address)
+            return &Slaves[i];
+    }
+    return NULL;
+}
+
+// Writing TWCR with TWINT set clears the flag and starts the next bus action, as on the ATmega328P
+TWIControlRegister &TWIControlRegister::operator=(uint8_t NewValue)
+{
+    uint8_t Status = 0;
+
+    Value = NewValue & ~(_BV(TWINT) | _BV(TWSTO));
+    if (!(NewValue & _BV(TWEN))) // TWI switched off, the pins are released
+    {
+        Bus = BusIdle;
+        return *this;
+    }
+    if (!(NewValue & _BV(TWINT)))
+    {
+        return *this;
+    }
+    if (NewValue & _BV(TWSTO))
+    {
+        if (Bus != BusIdle)
+        {
+            TWIModelStops++;
+            Trace("P ");
+        }
+        Bus = BusIdle;
+    }
+    if (NewValue & _BV(TWSTA))
+    {
+        if (TWIModelStuck)
+        {
+            return *this; // The START waits for a free bus forever
+        }
+        Status = (Bus == BusIdle) ? I2C_START : I2C_START_RPT;
+        Trace((Bus == BusIdle) ? "S " : "Sr ");
+        TWIModelStarts++;
+        Bus = BusAddress;
+    }
+    else
+    {
+        switch (Bus)
+        {
+        case BusIdle:
+            return *this;
+
+        case BusAddress:
+            Selected = FindSlave(TWDR >> 1);
+            ByteCount = 0;
+            Trace((TWDR & 0x01) ? "A%02Xr" : "A%02Xw", TWDR >> 1);
+            if (Selected == NULL)
+            {
+                Trace("- ");
+                Status = (TWDR & 0x01) ? I2C_SLA_R_NACK : I2C_SLA_W_NACK;
+            }
+            else
+            {
+                Trace(" ");
+                Bus = (TWDR & 0x01) ? BusRead : BusWrite;
+                Status = (TWDR & 0x01) ? I2C_SLA_R_ACK : I2C_SLA_W_ACK;
+            }
+            break;
+
+        case BusWrite:
+            if (ByteCount == TWIModelArbLostByte)
+            {
+                Trace("%02X! ", TWDR);
+                Bus = BusIdle; // The TWI hardware leaves the bus to the other master
+                Status = I2C_ARB_LOST;
+            }
+            else if (ByteCount == TWIModelNackByte)
+            {
+                Trace("%02X- ", TWDR);
+                Status = I2C_DATA_NACK;
+            }
+            else
+            {
+                Trace("%02X ", TWDR);
+                if (ByteCount == 0)
+                {
+                    Selected->Pointer = TWDR;
+                }
+                else
+                {
+                    Selected->Regs[Selected->Pointer++] = TWDR;
+                    if (Selected->Writes != NULL)
+                        (*Selected->Writes)++;
+                }
+                Status = I2C_DATA_ACK;
+            }
+            ByteCount++;
+            break;
+
+        case BusRead:
+            TWDR = Selected->Regs[Selected->Pointer++];
+            Trace((NewValue & _BV(TWEA)) ? "<%02X " : "<%02X- ", TWDR);
+            Status = (NewValue & _BV(TWEA)) ? I2C_DATA_R_ACK : I2C_DATA_R_NACK;
+            break;
+        }
+    }
+    TWSR = (TWSR & 0x07) | Status; // The action is done, TWINT is set and the interrupt raised if it is enabled
+    Value |= _BV(TWINT);
+    if (TWIModelHold)
+    {
+        Held = true;
+    }
+    else if (Value & _BV(TWIE))
+    {
+        ShimRaise(TWI_vect);
+    }
+    return *this;
+}
+
+// Ends the hold. The interrupt of a held bus action becomes pending, the firmware takes it as soon as interrupts are enabled
+void TWIModelRelease()
+{
+    TWIModelHold = false;
+    if (Held && (TWCR & _BV(TWIE)))
+    {
+        ShimPend(TWI_vect);
+    }
+    Held = false;
+}
@@ -0,0 +1,19 @@
+// Model of the ATmega328P TWI hardware and the slaves on the bus for host builds. A write to TWCR starts the bus
+// action it asks for, the action completes at once and raises the TWI interrupt with the new status in TWSR, so the
+// firmware I2C driver (i2c.cpp) runs unchanged. The slaves are register files: the first byte written sets the
+// register address, the bytes after it are written or read from there on with auto-increment
+#include "Arduino.h"
+
+#define TWI_MODEL_NEVER 0xFF
+
+extern uint8_t TWIModelNackByte;    // Byte written after the address that the slave NACKs, 0 is the register address
+extern uint8_t TWIModelArbLostByte; // Byte written after the address during which another master takes the bus
+extern boolean TWIModelStuck;       // A slave holds SDA low, a START never completes
+extern boolean TWIModelHold;        // Bus actions complete without raising the interrupt until TWIModelRelease
+extern uint16_t TWIModelStarts;     // START and repeated START conditions since the last reset
+extern uint16_t TWIModelStops;      // STOP conditions since the last reset
+extern char TWIModelTrace[256];     // Bus conditions and bytes since the last reset, e.g. "S A60w 05 01 P "
+
+void TWIModelReset();
+void TWIModelAttach(uint8_t Address, uint8_t *Regs, uint16_t *Writes);
+void TWIModelRelease();
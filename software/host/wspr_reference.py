@@ -0,0 +1,210 @@
+#!/usr/bin/env python3
+"""Reference WSPR encoder, written from the WSJT-X wsprcode packing rules and independent of the firmware code.
+
+It produces the golden vectors of test/test_wspr_vectors. Messages are given the way WSJT-X takes them:
+
+    K1ABC FN42 37          Type 1, call, four character locator and power
+    PJ4/K1ABC 37           Type 2, call with a prefix of 1-3 characters or a suffix of one character or two digits
+    <PJ4/K1ABC> FN42AX 37  Type 3, hashed call and six character locator
+
+usage: wspr_reference.py <message>...   print the 162 channel symbols of each message
+       wspr_reference.py --test-vectors print the golden vector table of test/test_wspr_vectors
+"""
+
+import sys
+
+# Sync vector, npr3 in WSJT-X
+SYNC = [1, 1, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 1, 1, 1, 0, 0, 0, 1, 0,
+        0, 1, 0, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 1, 0, 1,
+        0, 0, 0, 0, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 0, 1,
+        1, 0, 1, 0, 0, 0, 0, 1, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 0, 1,
+        0, 0, 1, 0, 1, 1, 0, 0, 0, 1, 1, 0, 1, 0, 1, 0, 0, 0, 1, 0,
+        0, 0, 0, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 0, 1, 1, 0, 0, 1, 1,
+        0, 1, 0, 0, 0, 1, 1, 1, 0, 0, 0, 0, 0, 1, 0, 1, 0, 0, 1, 1,
+        0, 0, 0, 0, 0, 0, 0, 1, 1, 0, 1, 0, 1, 1, 0, 0, 0, 1, 1, 0,
+        0, 0]
+
+POLY1 = 0xF2D05351
+POLY2 = 0xE4613C47
+MASK = 0xFFFFFFFF
+
+# Messages of the golden vector table, all three types and the odd corners of the call and prefix/suffix rules
+TEST_VECTORS = [
+    "K1ABC FN42 37",
+    "G4JNT IO90 30",
+    "SM7PNV JO65 10",
+    "K1AB AA00 0",
+    "VK2RG QF56 60",
+    "W1AW RR99 23",
+    "PJ4/K1ABC 37",
+    "F/G4JNT 27",
+    "K1ABC/P 37",
+    "K1ABC/7 33",
+    "K1ABC/12 13",
+    "<K1ABC> FN42AX 37",
+    "<G4JNT> IO90JU 7",
+    "<SM7PNV> JO65MR 23",
+    "<PJ4/K1ABC> FN42AX 37",
+    "<F/G4JNT> IN88QK 20",
+    "<K1ABC/P> FN42AX 37",
+    "<K1ABC/12> FN42AX 10",
+]
+
+
+def Code(Char):
+    """WSJT-X character code: digits 0-9, letters 10-35 and space 36"""
+    if Char.isdigit():
+        return ord(Char) - ord("0")
+    if "A" <= Char <= "Z":
+        return ord(Char) - ord("A") + 10
+    if Char == " ":
+        return 36
+    raise ValueError("bad character %r" % Char)
+
+
+def PackCall(Call):
+    """28 bit call field, the third character must be a digit so a call like G4JNT gets a leading space"""
+    if len(Call) > 2 and not Call[2].isdigit():
+        Call = " " + Call
+    Call = Call.ljust(6)
+    if len(Call) > 6 or not Call[2].isdigit():
+        raise ValueError("call %s can not be packed" % Call)
+    N = Code(Call[0])
+    N = N * 36 + Code(Call[1])
+    N = N * 10 + Code(Call[2])
+    for Char in Call[3:]:
+        N = N * 27 + Code(Char) - 10
+    return N
+
+
+def PackGrid(Grid):
+    """15 bit grid number of a four character locator"""
+    return (179 - 10 * (ord(Grid[0]) - ord("A")) - int(Grid[2])) * 180 + 10 * (ord(Grid[1]) - ord("A")) + int(Grid[3])
+
+
+def PackPrefixSuffix(Call):
+    """Base call field and the 15 bit prefix/suffix number with its nadd bit, as packpfx in WSJT-X"""
+    Slash = Call.index("/")
+    Suffix = Call[Slash + 1:]
+    if len(Suffix) == 1:  # One character suffix
+        return PackCall(Call[:Slash]), 60000 - 32768 + Code(Suffix), 1
+    if len(Suffix) == 2 and Suffix.isdigit():  # Two digit suffix
+        return PackCall(Call[:Slash]), 60000 + 26 + int(Suffix) - 32768, 1
+    Prefix = Call[:Slash].rjust(3)
+    Number = 0
+    for Char in Prefix:
+        Number = 37 * Number + Code(Char)
+    if Number >= 32768:
+        return PackCall(Call[Slash + 1:]), Number - 32768, 1
+    return PackCall(Call[Slash + 1:]), Number, 0
+
+
+def Rot(x, k):
+    return ((x << k) | (x >> (32 - k))) & MASK
+
+
+def HashLittle(Key, InitVal):
+    """Bob Jenkins lookup3 hashlittle, nhash in WSJT-X"""
+    Length = len(Key)
+    a = b = c = (0xDEADBEEF + Length + InitVal) & MASK
+    Offset = 0
+    while Length > 12:
+        a = (a + int.from_bytes(Key[Offset:Offset + 4], "little")) & MASK
+        b = (b + int.from_bytes(Key[Offset + 4:Offset + 8], "little")) & MASK
+        c = (c + int.from_bytes(Key[Offset + 8:Offset + 12], "little")) & MASK
+        a = (a - c) & MASK; a ^= Rot(c, 4); c = (c + b) & MASK
+        b = (b - a) & MASK; b ^= Rot(a, 6); a = (a + c) & MASK
+        c = (c - b) & MASK; c ^= Rot(b, 8); b = (b + a) & MASK
+        a = (a - c) & MASK; a ^= Rot(c, 16); c = (c + b) & MASK
+        b = (b - a) & MASK; b ^= Rot(a, 19); a = (a + c) & MASK
+        c = (c - b) & MASK; c ^= Rot(b, 4); b = (b + a) & MASK
+        Offset += 12
+        Length -= 12
+    if Length == 0:
+        return c
+    Tail = Key[Offset:] + bytes(12 - Length)
+    a = (a + int.from_bytes(Tail[0:4], "little")) & MASK
+    b = (b + int.from_bytes(Tail[4:8], "little")) & MASK
+    c = (c + int.from_bytes(Tail[8:12], "little")) & MASK
+    c ^= b; c = (c - Rot(b, 14)) & MASK
+    a ^= c; a = (a - Rot(c, 11)) & MASK
+    b ^= a; b = (b - Rot(a, 25)) & MASK
+    c ^= b; c = (c - Rot(b, 16)) & MASK
+    a ^= c; a = (a - Rot(c, 4)) & MASK
+    b ^= a; b = (b - Rot(a, 14)) & MASK
+    c ^= b; c = (c - Rot(b, 24)) & MASK
+    return c
+
+
+def Pack(Message):
+    """The 28 bit and 22 bit fields of a message"""
+    Words = Message.upper().split()
+    if len(Words) == 3 and Words[0].startswith("<"):  # Type 3
+        Call = Words[0].strip("<>")
+        Grid = Words[1]
+        Power = int(Words[2])
+        N = PackCall(Grid[1:] + Grid[0])
+        M = 128 * (HashLittle(Call.encode(), 146) & 32767) - (Power + 1) + 64
+    elif len(Words) == 2:  # Type 2
+        N, Number, Add = PackPrefixSuffix(Words[0])
+        M = 128 * Number + int(Words[1]) + 1 + Add + 64
+    else:  # Type 1
+        N = PackCall(Words[0])
+        M = 128 * PackGrid(Words[1]) + int(Words[2]) + 64
+    return N, M
+
+
+def Encode(Message):
+    N, M = Pack(Message)
+    Bits = [(N >> (27 - i)) & 1 for i in range(28)] + [(M >> (21 - i)) & 1 for i in range(22)] + [0] * 31
+    Coded = []
+    Reg = 0
+    for Bit in Bits:
+        Reg = ((Reg << 1) | Bit) & MASK
+        Coded.append(bin(Reg & POLY1).count("1") & 1)
+        Coded.append(bin(Reg & POLY2).count("1") & 1)
+    Interleaved = [0] * 162
+    Index = 0
+    for i in range(256):
+        j = int("{:08b}".format(i)[::-1], 2)
+        if j < 162:
+            Interleaved[j] = Coded[Index]
+            Index += 1
+    return [SYNC[i] + 2 * Interleaved[i] for i in range(162)]
+
+
+def TestVectorRow(Message):
+    """A row of the golden vector table, the message split in to the firmware settings (S_WSPRData) and its symbols"""
+    Words = Message.upper().split()
+    Call = Words[0].strip("<>")
+    Type = 3 if Words[0].startswith("<") else (1 if len(Words) == 3 else 2)
+    Locator = "" if Type == 2 else Words[1]
+    Option, Prefix, Suffix = "None", "", 0
+    if "/" in Call:
+        Slash = Call.index("/")
+        Add = Call[Slash + 1:]
+        if len(Add) == 1:
+            Option, Suffix, Call = "Sufix", Code(Add), Call[:Slash]
+        elif len(Add) == 2 and Add.isdigit():
+            Option, Suffix, Call = "Sufix", 26 + int(Add), Call[:Slash]
+        else:
+            Option, Prefix, Call = "Prefix", Call[:Slash].rjust(3), Add
+    Symbols = "".join(str(s) for s in Encode(Message))
+    return '    {"%s", "%s", "%s", %s, %d, %s, "%s", %d,\n     "%s"},' % (Message, Call, Locator, Words[-1], Type, Option, Prefix, Suffix, Symbols)
+
+
+def Main():
+    if len(sys.argv) < 2:
+        print(__doc__)
+        return 1
+    if sys.argv[1] == "--test-vectors":
+        for Message in TEST_VECTORS:
+            print(TestVectorRow(Message))
+        return 0
+    for Message in sys.argv[1:]:
+        print("".join(str(s) for s in Encode(Message)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(Main())
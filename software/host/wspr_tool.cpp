@@ -0,0 +1,296 @@
+// Host side WSPR encoder and Si5351 frequency planner built from the firmware sources by the native PlatformIO environment,
+// so the symbols and frequencies printed are exactly what the transmitter would send.
+//
+// Usage:
+//   wspr_tool encode <call> <locator> <dBm> [type] [/suffix | prefix/]
+//        type 1: call, four character locator and power (default)
+//        type 2: call with a suffix or prefix and power
+//        type 3: hashed call (with suffix or prefix), six character locator and power
+//   wspr_tool locator <latitude> <longitude>
+//   wspr_tool bench <count>
+//   wspr_tool geofence <latitude> <longitude>
+//   wspr_tool synth <centiHz> [reference Hz]
+//        CLK0 set up by the firmware Si5351 code, the output read back from the register model
+//   wspr_tool tones <centiHz> [reference Hz]
+//        the four WSPR tones from the firmware tone table, read back from the register model
+//   wspr_tool replay <NMEA log>
+//        a recorded GPS log streamed through the GPS transport in to NeoGPS, each fix with its locator. Only in the replay
+//        environment (pio run -e replay), the native one is built without NeoGPS
+
+#include "Arduino.h"
+#include "datatypes.hpp"
+#include "wspr_packet_formatting.hpp"
+#include "Si5351.hpp"
+#include "geofence.hpp"
+#include "si5351_model.hpp"
+#include "gps_transport.hpp"
+#include <chrono>
+#include <math.h>
+#include <NMEAGPS.h>
+
+S_GadgetData GadgetData;   // Used by eeprom.cpp
+S_FactoryData FactoryData; // Used by eeprom.cpp
+
+// The state main.cpp keeps for state_machine.cpp, telemetry.cpp and filter_management.cpp
+E_Mode CurrentMode;
+uint8_t CurrentBand;
+uint8_t CurrentLP;
+uint64_t freq;
+int GPSH;
+int GPSM;
+int GPSS;
+int fixstate;
+NMEAGPS gps;
+gps_fix fix;
+
+#ifndef PIO_UNIT_TESTING // The tests under test/ have their own main() and only use the globals above
+
+static int Usage()
+{
+    fprintf(stderr, "usage: wspr_tool encode <call> <locator> <dBm> [type] [/suffix | prefix/]\n"
+                    "       wspr_tool locator <latitude> <longitude>\n"
+                    "       wspr_tool bench <count>\n"
+                    "       wspr_tool geofence <latitude> <longitude>\n"
+                    "       wspr_tool synth <centiHz> [reference Hz]\n"
+                    "       wspr_tool tones <centiHz> [reference Hz]\n"
+                    "       wspr_tool replay <NMEA log>\n");
+    return 1;
+}
+
+// Parse a "/S" suffix or a "PFX/" prefix in to the WSPR settings
+static bool ParseSuPrefix(const char *Arg, S_WSPRData *WSPRData)
+{
+    size_t Length = strlen(Arg);
+
+    if (Arg[0] == '/' && Length == 2 && isalnum(Arg[1]))
+    {
+        WSPRData->SuPreFixOption = Sufix;
+        WSPRData->Sufix = isdigit(Arg[1]) ? Arg[1] - '0' : 10 + (toupper(Arg[1]) - 'A');
+        return true;
+    }
+    if (Arg[0] == '/' && Length == 3 && isdigit(Arg[1]) && isdigit(Arg[2]))
+    {
+        WSPRData->SuPreFixOption = Sufix;
+        WSPRData->Sufix = 26 + atoi(&Arg[1]); // 10-99 is coded as 36-125
+        return true;
+    }
+    if (Length >= 2 && Length <= 4 && Arg[Length - 1] == '/')
+    {
+        WSPRData->SuPreFixOption = Prefix;
+        memset(WSPRData->Prefix, ' ', 3); // Right aligned and padded with spaces
+        memcpy(&WSPRData->Prefix[3 - (Length - 1)], Arg, Length - 1);
+        WSPRData->Prefix[3] = 0;
+        for (int i = 0; i < 3; i++)
+            WSPRData->Prefix[i] = toupper(WSPRData->Prefix[i]);
+        return true;
+    }
+    return false;
+}
+
+static int Encode(int argc, char **argv)
+{
+    S_GadgetData Data;
+    uint8_t Symbols[WSPR_PACKED_SIZE];
+    uint8_t Type = 1;
+
+    if (argc < 5)
+        return Usage();
+    memset(&Data, 0, sizeof(Data));
+    Data.WSPRData.SuPreFixOption = None;
+    strncpy(Data.WSPRData.CallSign, argv[2], 6);
+    strncpy(Data.WSPRData.MaidenHead6, argv[3], 6);
+    strncpy(Data.WSPRData.MaidenHead4, argv[3], 4);
+    Data.WSPRData.TXPowerdBm = atoi(argv[4]);
+    if (argc > 5)
+        Type = atoi(argv[5]);
+    if (argc > 6 && !ParseSuPrefix(argv[6], &Data.WSPRData))
+        return Usage();
+    if (Type < 1 || Type > 3 || (Type == 2 && Data.WSPRData.SuPreFixOption == None))
+        return Usage();
+
+    wspr_encode(Data.WSPRData.CallSign, Data.WSPRData.MaidenHead4, Data.WSPRData.TXPowerdBm, Symbols, Type, Data);
+    if (Type == 3) // The call sign hash prints a debug line, keep the symbols on a line of their own
+        printf("\n");
+    for (uint8_t i = 0; i < WSPR_SYMBOL_COUNT; i++)
+    {
+        printf("%u", (Symbols[i >> 2] >> ((i & 0x03) << 1)) & 0x03);
+    }
+    printf("\n");
+    return 0;
+}
+
+static int Locator(int argc, char **argv)
+{
+    char Locator[11];
+
+    if (argc < 4)
+        return Usage();
+    calcLocatorPrecise(lround(atof(argv[2]) * 1e7), lround(atof(argv[3]) * 1e7), Locator, 10);
+    printf("%.4s %.6s %.8s %s\n", Locator, Locator, Locator, Locator);
+    return 0;
+}
+
+static int GeoFence(int argc, char **argv)
+{
+    S_WSPRData WSPRData;
+    int32_t Lat, Lon;
+
+    if (argc < 4)
+        return Usage();
+    Lat = lround(atof(argv[2]) * 1e7);
+    Lon = lround(atof(argv[3]) * 1e7);
+    calcLocator(Lat, Lon, &WSPRData);
+    printf("%s %s\n", WSPRData.MaidenHead4, OutsideGeoFence(WSPRData, Lat, Lon) ? "outside, transmissions allowed" : "inside the geofence, no transmissions");
+    return 0;
+}
+
+// Encode a number of Type 1 messages with varying call, locator and power and report the rate
+static int Bench(int argc, char **argv)
+{
+    S_GadgetData Data;
+    uint8_t Symbols[WSPR_PACKED_SIZE];
+    uint32_t Check = 0;
+    long Count;
+
+    if (argc < 3)
+        return Usage();
+    Count = atol(argv[2]);
+    memset(&Data, 0, sizeof(Data));
+    Data.WSPRData.SuPreFixOption = None;
+    auto Start = std::chrono::steady_clock::now();
+    for (long n = 0; n < Count; n++)
+    {
+        snprintf(Data.WSPRData.CallSign, sizeof(Data.WSPRData.CallSign), "%c%c%u%c%c%c", (char)('A' + n % 26), (char)('A' + (n / 26) % 26), (unsigned)(n % 10), (char)('A' + (n / 7) % 26), (char)('A' + (n / 3) % 26), (char)('A' + (n / 11) % 26));
+        snprintf(Data.WSPRData.MaidenHead4, sizeof(Data.WSPRData.MaidenHead4), "%c%c%u%u", (char)('A' + n % 18), (char)('A' + (n / 18) % 18), (unsigned)(n % 10), (unsigned)((n / 10) % 10));
+        wspr_encode(Data.WSPRData.CallSign, Data.WSPRData.MaidenHead4, n % 61, Symbols, 1, Data);
+        Check += Symbols[n % WSPR_PACKED_SIZE];
+    }
+    double Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+    printf("%ld messages in %.3f s, %.0f messages/s (check %u)\n", Count, Seconds, Count / Seconds, Check);
+    return 0;
+}
+
+// Reference oscillator frequency argument, the nominal 25MHz if not given
+static uint32_t RefArg(int argc, char **argv)
+{
+    return (argc > 3) ? strtoul(argv[3], NULL, 10) : 25000000UL;
+}
+
+static int Synth(int argc, char **argv)
+{
+    uint64_t Freq;
+    uint32_t RefFreq = RefArg(argc, argv);
+    long double Requested, Output;
+
+    if (argc < 3)
+        return Usage();
+    Freq = strtoull(argv[2], NULL, 10);
+    Requested = Freq / 100.0L;
+    Si5351ModelReset();
+    si5351aSetFrequency(Freq, RefFreq);
+    Output = Si5351ModelOutput(0, RefFreq);
+    printf("requested %.2Lf Hz, output %.6Lf Hz, error %.3Lf mHz (firmware reports %ld mHz)\n", Requested, Output, (Output - Requested) * 1000, (long)si5351aFrequencyError());
+    return 0;
+}
+
+static int Tones(int argc, char **argv)
+{
+    uint64_t Freq;
+    uint32_t RefFreq = RefArg(argc, argv);
+    long double Output[4];
+
+    if (argc < 3)
+        return Usage();
+    Freq = strtoull(argv[2], NULL, 10);
+    Si5351ModelReset();
+    si5351aStartToneTable(Freq, RefFreq, 0);
+    for (uint8_t Tone = 0; Tone < 4; Tone++)
+    {
+        Si5351Writes = 0;
+        si5351aSetTone(Tone);
+        Output[Tone] = Si5351ModelOutput(0, RefFreq);
+        printf("tone %u: %.6Lf Hz, %.6Lf Hz above tone 0, error %ld mHz, %u register bytes written\n", Tone, Output[Tone], Output[Tone] - Output[0],
+               (long)si5351aFrequencyError(), Si5351Writes);
+    }
+    return 0;
+}
+
+#ifdef HOST_NEOGPS
+static FILE *ReplayFile;
+
+// The log is read as fast as the parser takes it from the transport
+static uint16_t ReplaySource(uint8_t *Data, uint16_t Room)
+{
+    return fread(Data, 1, Room, ReplayFile);
+}
+
+// Reads the GPS the way the firmware does: the replay backend of GPSSerial in to NeoGPS
+static int Replay(int argc, char **argv)
+{
+    NMEAGPS gps;
+    gps_fix fix;
+    S_WSPRData WSPRData;
+    uint16_t Fixes = 0;
+
+    if (argc < 3)
+        return Usage();
+    ReplayFile = fopen(argv[2], "rb");
+    if (ReplayFile == NULL)
+    {
+        perror(argv[2]);
+        return 1;
+    }
+    GPSTransportReplay(ReplaySource, NULL);
+    GPSSerial.begin(9600);
+    do
+    {
+        while (gps.available(GPSSerial))
+        {
+            fix = gps.read();
+            Fixes++;
+            if (fix.valid.location && fix.valid.time)
+            {
+                calcLocator(fix.latitudeL(), fix.longitudeL(), &WSPRData);
+                printf("%02u:%02u:%02u %11.7f %12.7f %6.1f m %s\n", fix.dateTime.hours, fix.dateTime.minutes, fix.dateTime.seconds,
+                       fix.latitudeL() / 1e7, fix.longitudeL() / 1e7, fix.altitude(), WSPRData.MaidenHead6);
+            }
+            else
+            {
+                printf("no fix\n");
+            }
+        }
+    } while (GPSSerial.available());
+    fclose(ReplayFile);
+    GPSTransportReplay(NULL, NULL);
+    printf("%u fixes\n", Fixes);
+    return 0;
+}
+#else
+static int Replay(int argc, char **argv)
+{
+    fprintf(stderr, "built without NeoGPS, use pio run -e replay\n");
+    return 1;
+}
+#endif
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+        return Usage();
+    if (!strcmp(argv[1], "encode"))
+        return Encode(argc, argv);
+    if (!strcmp(argv[1], "locator"))
+        return Locator(argc, argv);
+    if (!strcmp(argv[1], "bench"))
+        return Bench(argc, argv);
+    if (!strcmp(argv[1], "geofence"))
+        return GeoFence(argc, argv);
+    if (!strcmp(argv[1], "synth"))
+        return Synth(argc, argv);
+    if (!strcmp(argv[1], "tones"))
+        return Tones(argc, argv);
+    if (!strcmp(argv[1], "replay"))
+        return Replay(argc, argv);
+    return Usage();
+}
+#endif
@@ -5,5 +5,12 @@ void Si5351PowerOn();
 void si5351aOutputOff(uint8_t clk);
 void setupMultisynth(uint8_t synth, uint32_t Divider, uint8_t rDiv);
 void si5351aSetFrequency(uint64_t frequency, uint32_t RefFreq);
+int32_t si5351aCalcFrequency(uint64_t FreqmHz, uint32_t RefFreq, uint8_t *PLLRegs, uint32_t *Divider, uint8_t *rDiv);
+int32_t si5351aFrequencyError();
+void si5351aSendFrequency();
+void si5351aStartToneTable(uint64_t BaseFreq, uint32_t RefFreq, uint8_t FirstTone);
+void si5351aSetTone(uint8_t Tone);
+void si5351aCalibrationOutput(boolean On);
 boolean DetectSi5351I2CAddress();
 void setupPLL(uint8_t pll, uint8_t mult, uint32_t num, uint32_t denom);
+void calcPLLRegisters(uint8_t mult, uint32_t num, uint32_t denom, uint8_t *PLLRegs);
@@ -1,3 +1,17 @@
 #include "Arduino.h"
 
-int GetVCC();
+// ADC readings of the internal channels. Each reading is 4^ADC_OVERSAMPLE_BITS conversions added up and decimated
+// to 10 + ADC_OVERSAMPLE_BITS bits. A Quiet reading converts in ADC noise reduction sleep, which also stops the UARTs,
+// so it may only be asked for when neither the GPS nor the PC can be sending. Timer0 and Timer1 stop as well, so never
+// while symbols are timed. millis() is put forward by the conversion time afterwards, see ADCConvert
+#define ADC_OVERSAMPLE_BITS 2     // Extra bits of resolution, 16 conversions for 12 bits. At most 3, the sum must fit 16 bits
+#define ADC_SETTLE 4              // Conversions thrown away after the channel has changed, replaces a 2ms delay
+#define ADC_SETTLE_REF 16         // Conversions thrown away after the reference has changed
+#define ADC_BANDGAP_DEFAULT 11000 // Internal 1.1V reference in 0.1 mV, used until FactoryData.Bandgap has been calibrated
+#define ADC_BANDGAP_MIN 10000     // The datasheet allows 1.0V to 1.2V, a calibration outside that is not used
+#define ADC_BANDGAP_MAX 12000
+
+uint16_t ADCRead(uint8_t Mux, boolean Quiet);
+int GetVCC(boolean Quiet);
+int GetTemperature(boolean Quiet);
+uint16_t ADCCalibrateBandgap(uint16_t VCC);
@@ -0,0 +1,39 @@
+#include "Arduino.h"
+
+// Binary framed alternative to the text Serial API, see host/binproto.py for the host side.
+// A packet is [message ID][payload][CRC-16 low][CRC-16 high], COBS encoded so it holds no zero bytes and
+// sent with a zero byte before and after. The CRC is CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) over ID and payload.
+// Multi byte values in the payloads are little endian.
+// The text command [CBM] S switches to binary mode, BIN_MSG_TEXT_MODE switches back.
+
+#define BIN_MAX_PAYLOAD 61 // Largest payload, a packet is then 64 bytes
+
+// Device to host
+#define BIN_MSG_TIME 0x01         // Hours, minutes, seconds
+#define BIN_MSG_LOCATOR 0x02      // Six character Maidenhead locator
+#define BIN_MSG_SATELLITES 0x03   // Up to 12 times ID, azimuth (16 bit), elevation, SNR. An empty message ends the list
+#define BIN_MSG_TX_PROGRESS 0x04  // Band, symbol indicator as in {TWS}
+#define BIN_MSG_GPS_LOCK 0x05     // 1 if the GPS has a fix
+#define BIN_MSG_TX_ON 0x06        // 1 if transmitting
+#define BIN_MSG_FREQUENCY 0x07    // Output frequency in centiHz, 64 bit
+#define BIN_MSG_PAUSE 0x08        // Seconds left of the pause, 32 bit
+#define BIN_MSG_BAND 0x09         // Band number
+#define BIN_MSG_MODE 0x0A         // Current mode, E_Mode
+#define BIN_MSG_VCC 0x0B          // Supply voltage in mV, 16 bit
+#define BIN_MSG_LPF 0x0C          // Low pass filter in use, 0-3
+#define BIN_MSG_CYCLE_DONE 0x0D   // WSPR band cycle complete, no payload
+#define BIN_MSG_CONFIG_VALUE 0x21 // Three letter code of a Serial API setting and its value as stored in the config
+#define BIN_MSG_ERROR 0x7F        // The ID of a message from the host that failed
+
+// Host to device
+#define BIN_MSG_CONFIG_GET 0x20   // Three letter code, answered with BIN_MSG_CONFIG_VALUE
+#define BIN_MSG_CONFIG_SET 0x22   // Three letter code and the new value, answered with BIN_MSG_CONFIG_VALUE
+#define BIN_MSG_TEXT_COMMAND 0x30 // A text Serial API command, e.g. "[CSE] S". Replies come back as text lines
+#define BIN_MSG_TEXT_MODE 0x31    // Go back to the text Serial API
+
+extern boolean BinaryMode; // True when the PC link uses binary packets
+
+uint16_t BinCRC16(uint16_t CRC, uint8_t Data);
+void BinSend(uint8_t MsgID, const void *Payload, uint8_t Length);
+void BinSendByte(uint8_t MsgID, uint8_t Value);
+void BinReceiveByte(uint8_t InByte);
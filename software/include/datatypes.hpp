@@ -68,6 +68,7 @@ struct S_FactoryData
     uint8_t LP_B_BandNum; // Low Pass filter B Band number (0-15)
     uint8_t LP_C_BandNum; // Low Pass filter C Band number (0-15)
     uint8_t LP_D_BandNum; // Low Pass filter D Band number (0-15)
+    uint16_t Bandgap;     // The internal 1.1V ADC reference in 0.1 mV as measured on this unit, set with [FVC]
 };
 
 #endif
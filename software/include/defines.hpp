@@ -4,6 +4,12 @@
 #define I2C_SLA_W_ACK 0x18
 #define I2C_SLA_R_ACK 0x40
 #define I2C_DATA_ACK 0x28
+#define I2C_SLA_W_NACK 0x20
+#define I2C_DATA_NACK 0x30
+#define I2C_ARB_LOST 0x38
+#define I2C_SLA_R_NACK 0x48
+#define I2C_DATA_R_ACK 0x50
+#define I2C_DATA_R_NACK 0x58
 #define SI5351A_H
 
 #define SI_CLK0_CONTROL 16 // Register definitions
@@ -28,6 +34,16 @@
 #define SI_CLK_SRC_PLL_A 0b00000000
 #define SI_CLK_SRC_PLL_B 0b00100000
 
+#define SI_VCO_MAX 900000000000ULL // Maximum PLL frequency, 900MHz in milliHz
+#define SI_VCO_MIN 600000000000ULL // Minimum PLL frequency, 600MHz in milliHz
+#define SI_MAX_DENOM 1048575UL     // Largest PLL fractional denominator
+#define SI_MAX_ERROR 1             // Frequency error in milliHz that is good enough
+#define SI_DIVIDER_TRIES 4         // Number of MultiSynth dividers to try for a frequency error below SI_MAX_ERROR
+#define SI_EvenDivider false       // Only use even MultiSynth dividers, less jitter at the cost of a somewhat lower PLL frequency
+
+#define SI_CAL_PLL_MULT 32 // PLL B multiplier when CLK2 is used to measure the reference oscillator, 800MHz with a 25MHz reference keeps the VCO mid-range
+#define SI_CAL_DIVIDER 320 // MultiSynth 2 divider, gives a CLK2 of about 2.5MHz that Timer1 can count
+
 #define WSPR_FREQ23cm 129650150000ULL // 23cm 1296.501,500MHz (Overtone, not implemented)
 #define WSPR_FREQ70cm 43230150000ULL  // 70cm  432.301,500MHz (Overtone, not implemented)
 #define WSPR_FREQ2m 14449500000ULL    // 2m    144.490,000MHz //Not working. No decode in bench test with WSJT-X decoding Software
@@ -45,6 +61,8 @@
 #define WSPR_FREQ630m 47570000ULL     // 630m      475.700kHz
 #define WSPR_FREQ2190m 13750000ULL    // 2190m     137.500kHz
 
+#define WSPR_TONE_OFFSET(Tone) (((Tone) * 12000000UL + 4096) / 8192) // Offset of a WSPR tone in milliHz, rounded. Tone spacing is 12000/8192 = 1.46484375Hz
+
 #define FactorySpace true
 #define UserSpace false
 
@@ -59,6 +77,11 @@
 #define UMesLPF 9
 #define UMesVCC 10
 #define UMesWSPRBandCycleComplete 11
+#define UMesSatData 12    // Only through TelemetryPost, the drain sends the satellite list in parts
+#define UMesTXProgress 13 // Only through TelemetryPostValue with the symbol indicator
+#define UMesPause 14      // Only through TelemetryPostValue with the seconds left
+#define UMesBand 15       // Only through TelemetryPost
+#define UMesTXFreq 16     // Only through TelemetryPost, the actual output frequency of the Si5351
 
 // Hardware defines
 
@@ -68,6 +91,54 @@
 #define TransmitLED 8 // Red LED next to RF out SMA that will turn on when Transmitting (Pico model do not have a TX LED)
 #define GPSPower A1   // Sleep-Wake signal of the GPS on the WSPR-TX Pico
 #define SiPower A3    // Power the Si5351 from this pin on the WSPR-TX Mini
+#define GPSPPS 8      // GPS PPS input to Timer1 input capture (ICP1) when PPS_Mode is true, replaces the TX LED
+#define SiCalInput 5  // Si5351 CLK2 input to Timer1 external clock (T1) when PPS_Mode is true, replaces Relay1
+
+// GPS serial link, selects the backend of GPSSerial
+#define GPS_TRANSPORT_SOFT 0   // Interrupt driven soft UART, RX on pin 2 (INT0) and TX on pin 3 with the bits timed by Timer2
+#define GPS_TRANSPORT_UART 1   // GPS wired to the hardware UART given by GPS_UART
+#define GPS_TRANSPORT_REPLAY 2 // No GPS, NMEA data comes from GPSTransportFeed or GPSTransportReplay. Used by host builds to replay recorded logs
+#ifndef GPS_Transport
+#define GPS_Transport GPS_TRANSPORT_SOFT
+#endif
+#define GPS_UART Serial
+#define GPS_UBlox false       // The GPS is a u-blox receiver, its power saving and NMEA output are then set up with UBX commands (ubx.cpp)
+#define GPS_UBX_Nav false     // Position and time from UBX NAV-PVT instead of NMEA, a fifth of the data to receive and decode. Needs GPS_UBlox
+#define GPS_RX_BUFFER_SIZE 64 // Must be a power of two
+#define GPS_TX_BUFFER_SIZE 16 // Must be a power of two
+
+// GPS PPS disciplined transmissions and reference oscillator calibration.
+// Needs the GPS PPS output wired to pin 8 and the Si5351 CLK2 output wired to pin 5, so only on models without relays
+#define PPS_Mode false
+
+// Sleeping between WSPR cycles on the Mini and Pico models
+#define WDT_PERIOD_DEFAULT 8800 // Length in milliseconds of the nominal 8 second watchdog period until it has been measured against GPS time
+#define WDT_PERIOD_MIN 6000     // Measured 8 second periods shorter than this or longer than WDT_PERIOD_MAX are thrown away
+#define WDT_PERIOD_MAX 12000    // The watchdog oscillator can be some 20 percent off, this allows for more
+#define WDT_CAL_MIN_TIME 600    // Shortest sleep in seconds that is used to measure the watchdog period, the GPS time is only good to a second
+#define WDT_CAL_ENTRIES 8       // Number of watchdog period measurements kept, each for its own supply voltage and temperature
+#define WDT_CAL_EEPROM 450      // EEPROM address of the watchdog period measurements, after the factory data
+#define SLEEP_MIN_TIME 30       // Shortest sleep in seconds worth powering down for
+#define GPS_REACQUIRE_TIME 60   // Seconds the GPS is assumed to need for a fix after sleep, until it has been measured
+#define GPS_WAKE_MARGIN 20      // Seconds the GPS is woken before a slot on top of its measured time to a fix
+
+// Energy ledger, see energy.hpp. Default currents in microampere of each power state, they can be changed with [CEC]
+#define ENERGY_CURRENT_MCU 4000      // MCU awake at 8MHz and 3.3V
+#define ENERGY_CURRENT_SLEEP 15      // Whole board with the MCU powered down, regulator quiescent current included
+#define ENERGY_CURRENT_GPS 25000     // GPS module acquiring or tracking
+#define ENERGY_CURRENT_SI5351 15000  // Si5351 with its PLLs running
+#define ENERGY_CURRENT_TX 25000      // Extra current with CLK0 driving the output stage
+#define ENERGY_CURRENT_RELAY 30000   // Each energized low pass filter relay
+#define ENERGY_SAVE_INTERVAL 3600    // Seconds of ledger time between saves to EEPROM, an hour keeps well within the EEPROM write endurance
+#define ENERGY_EEPROM 490            // EEPROM address of the energy ledger, after the watchdog period measurements
+#define ENERGY_BATTERY_CAPACITY 3000 // mAh of a full battery, [CEL] gives the run time on it at the average current so far
+
+// Battery aware transmission policy, see policy.hpp. GetVCC must see the battery voltage, not a regulated supply
+#ifndef Power_Policy
+#define Power_Policy false       // Adapt pause, bands, Type 3 messages and GPS fix rate to the supply voltage
+#endif
+#define POLICY_HYSTERESIS 100    // mV above the start of a higher power level before it is used
+#define POLICY_LOCKOUT_SLEEP 900 // Seconds between voltage checks in the low voltage lockout
 
 // Product model. WSPR-TX_LP1                             =1011
 // Product model. WSPR-TX Desktop                         =1012
@@ -0,0 +1,22 @@
+#include "Arduino.h"
+
+// Energy ledger. The time spent in each power state is added up at every state change and kept in EEPROM,
+// the charge drawn is the time in each state times the current set for it. Read and cleared with [CEL], currents set with [CEC]
+#define ENERGY_MCU 0    // MCU awake
+#define ENERGY_SLEEP 1  // MCU powered down, the whole board at rest
+#define ENERGY_GPS 2    // GPS module on, acquiring or tracking
+#define ENERGY_SI5351 3 // Si5351 powered, PLLs running
+#define ENERGY_TX 4     // CLK0 output on, on top of ENERGY_SI5351
+#define ENERGY_RELAY 5  // Low pass filter relays, counted per energized relay. Released while the MCU sleeps
+#define ENERGY_STATES 6
+
+void EnergyInit();
+void EnergyState(uint8_t State, uint8_t Count);
+void EnergySlept(uint32_t Millis);
+void EnergySaveIfDue();
+void EnergySave();
+void EnergyClear();
+uint32_t EnergySeconds(uint8_t State);
+uint32_t EnergyCharge(uint8_t State);
+uint32_t EnergyCurrent(uint8_t State);
+void EnergySetCurrent(uint8_t State, uint32_t Current);
@@ -1,4 +1,20 @@
 #include "Arduino.h"
 #include "datatypes.hpp"
 
-boolean OutsideGeoFence();
+// Corner of a polygon fence, NeoGPS integer coordinates in 1e-7 degrees
+struct S_GeoPoint
+{
+    int32_t Lat;
+    int32_t Lon;
+};
+
+// Polygon fence, the last corner connects back to the first
+struct S_GeoPolygon
+{
+    const S_GeoPoint *Points; // Corners in program memory
+    uint8_t Count;            // Number of corners
+};
+
+uint16_t GridCode(const char *Grid);
+boolean OutsideGeoFence(const S_WSPRData &WSPRData, int32_t Lat, int32_t Lon);
+boolean InsidePolygon(const S_GeoPolygon &Polygon, int32_t Lat, int32_t Lon);
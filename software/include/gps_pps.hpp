@@ -0,0 +1,12 @@
+#include "Arduino.h"
+
+#define PPS_CAL_SECONDS 4 // Number of GPS seconds the reference oscillator is measured over
+
+typedef void (*PPSService)(); // Called while waiting for PPS edges, e.g to keep the GPS parser fed
+
+extern boolean RefCalDue;
+
+void PPSInit();
+boolean PPSWaitForEdge(uint16_t Timeout, uint16_t *CaptureTime);
+boolean PPSCalibrateRef(uint8_t Seconds, PPSService Service);
+uint32_t CalibratedRefFreq();
@@ -0,0 +1,25 @@
+#include "Arduino.h"
+
+// Serial link to the GPS module, NMEA data is received in to a ring buffer by the selected backend (see GPS_Transport in defines.hpp)
+class GPSTransport : public Stream
+{
+public:
+    void begin(unsigned long Baud);
+    void end();
+    int available();
+    int read();
+    int peek();
+    size_t write(uint8_t Data);
+    void flush();
+    using Print::write;
+};
+
+extern GPSTransport GPSSerial;
+
+uint16_t GPSTransportFeed(const uint8_t *Data, uint16_t Length);
+uint16_t GPSTransportOverruns();
+
+// GPS_TRANSPORT_REPLAY only. The source is called with room for up to Room bytes and returns how many it put in Data
+typedef uint16_t (*GPSReplaySource)(uint8_t *Data, uint16_t Room);
+typedef void (*GPSReplaySink)(uint8_t Data);
+void GPSTransportReplay(GPSReplaySource Source, GPSReplaySink Sink);
@@ -1,10 +1,41 @@
 
 #include <Arduino.h>
 
-uint8_t i2cStart();
-void i2cStop();
-uint8_t i2cByteSend(uint8_t data);
-uint8_t i2cByteRead();
+// Result codes of an I2C transaction
+#define I2C_RESULT_OK 0
+#define I2C_RESULT_NO_START 1
+#define I2C_RESULT_ADDRESS_NACK 2
+#define I2C_RESULT_REG_NACK 3
+#define I2C_RESULT_DATA_NACK 4
+#define I2C_RESULT_READ_NACK 5
+#define I2C_RESULT_TIMEOUT 6
+#define I2C_RESULT_BUS_ERROR 7
+#define I2C_RESULT_QUEUE_FULL 8
+
+#define I2C_QUEUE_SIZE 4 // Number of transactions that can be waiting for the bus
+#define I2C_TIMEOUT 20   // Max time in ms a transaction may use the bus before the bus is recovered
+
+typedef void (*I2CCallback)(uint8_t Result); // Called from the TWI interrupt when a queued transaction has completed
+
+struct S_I2CTransaction
+{
+    uint8_t Address;      // 7 bit I2C address
+    uint8_t Reg;          // First register to write or read
+    uint8_t *Data;        // Data to write or buffer for read data, must stay valid until the transaction has completed
+    uint8_t Length;       // Number of data bytes to write or read
+    boolean Read;         // True to read Length bytes from Reg, false to write them
+    boolean Probe;        // Address only, STOP after the slave has acknowledged it (i2cProbe)
+    I2CCallback Callback; // Optional completion callback, NULL if not used
+};
+
+void i2cInit();
+uint8_t i2cQueueTransaction(uint8_t i2c_address, uint8_t reg, uint8_t *data, uint8_t len, boolean Read, I2CCallback Callback);
+boolean i2cBusy();
+uint8_t i2cWait();
+void i2cService();
+void i2cRecoverBus();
+void i2cStateMachine(uint8_t Status);
+uint8_t i2cProbe(uint8_t i2c_address);
 uint8_t i2cSendRegister(uint8_t reg, uint8_t data, uint8_t i2c_address);
+uint8_t i2cSendRegisters(uint8_t reg, const uint8_t *data, uint8_t len, uint8_t i2c_address);
 uint8_t i2cReadRegister(uint8_t reg, uint8_t *data, uint8_t i2c_address);
-void i2cInit();
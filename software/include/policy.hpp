@@ -0,0 +1,16 @@
+#include "Arduino.h"
+
+// Battery aware transmission policy, used when Power_Policy is set in defines.hpp.
+// Once per WSPR cycle the supply voltage picks a power level from the PowerLevels table in policy.cpp. Each level sets the
+// shortest pause, the bands per cycle, if Type 3 messages are sent and how often a u-blox GPS tracks. A level is only left
+// upwards with POLICY_HYSTERESIS to spare. Level 0 is the low voltage lockout, the unit then sleeps until the voltage is back up
+#define POLICY_LOCKOUT 0
+
+uint8_t PolicyUpdate(boolean Quiet);
+uint8_t PolicyLevel();
+uint16_t PolicyVCC();
+int16_t PolicyTrend();
+uint32_t PolicyPause(uint32_t TXPause);
+uint8_t PolicyMaxBands();
+boolean PolicyType3();
+void PolicyGPSSetup();
@@ -1,3 +1,3 @@
 #include "Arduino.h"
 
-void SerialPrintZero();
+void SerialPrintPadded(uint64_t Value, uint8_t Width);
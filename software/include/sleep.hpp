@@ -1,7 +1,8 @@
 #include "Arduino.h"
 
 // Sleep code from Kevin Darrah https://www.youtube.com/watch?v=urLSDi7SD8M
-void MCUGoToSleep(int SleepTime); // Sleep time in seconds, accurate to the nearest 8 seconds
+void MCUGoToSleep(uint32_t SleepTime); // Sleep time in seconds, accurate to about a second
+void WDTCalibrate(uint32_t SleptMillis);
 void AllIOtoLow();
 void DisableADC();
 void EnableADC();
\ No newline at end of file
@@ -2,4 +2,6 @@
 #include "datatypes.hpp"
 
 void SendAPIUpdate(uint8_t UpdateType);
-void DecodeSerialCMD(const char *InputCMD, S_GadgetData GadgetData);
+void DecodeSerialCMD(const char *InputCMD);
+uint8_t GetConfigField(const char *Code, uint8_t *Value);
+boolean SetConfigField(const char *Code, const uint8_t *Value, uint8_t Length);
@@ -1,4 +1,6 @@
 #include "Arduino.h"
 
-uint64_t StrTouint64_t(String InString);
-String uint64ToStr(uint64_t p_InNumber, boolean p_LeadingZeros);
+#define UINT64_DIGITS 20 // Digits in the largest uint64_t, a buffer for uint64ToStr needs one more for the zero termination
+
+uint64_t StrTouint64_t(const char *InString);
+uint8_t uint64ToStr(uint64_t Value, char *Buffer, uint8_t Width);
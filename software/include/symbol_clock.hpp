@@ -0,0 +1,7 @@
+#include "Arduino.h"
+
+void SymbolClockStart();
+void SymbolClockStartAt(uint16_t StartTime);
+void SymbolClockStop();
+uint8_t SymbolClockCount();
+boolean SymbolClockWait(uint8_t Symbol);
@@ -0,0 +1,11 @@
+#include "Arduino.h"
+
+// Status updates to the PC are posted here and sent later by TelemetryDrain, a few at a time,
+// so a full Serial TX buffer can never make Serial.print block inside a time critical loop.
+#define TELEMETRY_BYTES_PER_SECOND 480 // Byte budget for status updates, half of what 9600 baud can carry
+#define TELEMETRY_SAT_BATCH 4          // Satellites in each binary satellite message sent by the drain
+
+void TelemetryPost(uint8_t UpdateType);
+void TelemetryPostValue(uint8_t UpdateType, uint32_t Value);
+void TelemetryHold(boolean Hold);
+void TelemetryDrain();
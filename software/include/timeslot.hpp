@@ -0,0 +1,11 @@
+#include "Arduino.h"
+
+// WSPR transmission schedules, selected by S_WSPRData.TimeSlotCode
+// 0-4: one slot every ten minutes on minute TimeSlotCode * 2, 5-14: one slot every twenty minutes on minute (TimeSlotCode - 5) * 2,
+// 15: band coordinated, each band on its own minutes, 16: every even minute, 17: tracker, every even minute the unit has moved
+#define TIMESLOT_BAND_COORDINATED 15
+#define TIMESLOT_ANY 16
+#define TIMESLOT_TRACKER 17
+
+boolean TimeslotMinute(uint8_t TimeSlotCode, uint8_t Band, uint8_t Minute);
+uint32_t SecondsToNextSlot(uint8_t TimeSlotCode, uint8_t Band, uint16_t HourSecond, uint32_t MinSeconds);
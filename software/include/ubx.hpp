@@ -0,0 +1,49 @@
+#include "Arduino.h"
+
+// UBX binary protocol of u-blox GPS receivers, used when GPS_UBlox is set in defines.hpp.
+// A frame is 0xB5 0x62, class, ID, payload length (16 bit), payload and two checksum bytes.
+// The checksum is the 8-bit Fletcher algorithm over class, ID, length and payload.
+// Multi byte values in the payloads are little endian. CFG messages are answered with ACK-ACK or ACK-NAK.
+
+#define UBX_SYNC_1 0xB5
+#define UBX_SYNC_2 0x62
+
+#define UBX_CLASS_NAV 0x01
+#define UBX_CLASS_RXM 0x02
+#define UBX_CLASS_ACK 0x05
+#define UBX_CLASS_CFG 0x06
+#define UBX_CLASS_NMEA 0xF0 // Class of the NMEA sentences in CFG-MSG
+
+#define UBX_NAV_PVT 0x07 // Position, velocity and time, decoded by ubx_nav.cpp
+#define UBX_NAV_SAT 0x35    // Satellite information, u-blox 8 (protocol 15) and later
+#define UBX_NAV_SVINFO 0x30 // Satellite information of u-blox 7 and earlier, replaced by NAV-SAT
+#define UBX_ACK_NAK 0x00
+#define UBX_ACK_ACK 0x01
+#define UBX_CFG_MSG 0x01   // Output rate of a message: class, ID, rate in navigation solutions (0 = off)
+#define UBX_CFG_RST 0x04   // Restart of the receiver, not acknowledged
+#define UBX_CFG_RXM 0x11   // Continuous or power save mode
+#define UBX_CFG_PM2 0x3B   // Power save mode settings, version 1 (44 bytes)
+#define UBX_RXM_PMREQ 0x41 // Backup mode for a time, not acknowledged
+
+#define UBX_NMEA_GGA 0x00
+#define UBX_NMEA_GLL 0x01
+#define UBX_NMEA_GSA 0x02
+#define UBX_NMEA_GSV 0x03
+#define UBX_NMEA_RMC 0x04
+#define UBX_NMEA_VTG 0x05
+
+#define UBX_ACK_TIMEOUT 300 // Milliseconds to wait for ACK-ACK or ACK-NAK
+#define UBX_RETRIES 3       // Times a CFG message is sent before giving up
+#define UBX_WAKE_TIME 500   // Milliseconds the receiver needs after it is woken from backup mode
+#define UBX_NAV_SAT_RATE 10 // NAV-SAT or NAV-SVINFO once every this many fixes while a PC is connected
+
+void UBXSend(uint8_t Class, uint8_t ID, const uint8_t *Payload, uint8_t Length);
+boolean UBXCommand(uint8_t Class, uint8_t ID, const uint8_t *Payload, uint8_t Length);
+boolean UBXSetMessageRate(uint8_t Class, uint8_t ID, uint8_t Rate);
+boolean UBXSetPowerSave(boolean PowerSave);
+boolean UBXSetCyclicTracking(uint32_t UpdatePeriod, uint32_t SearchPeriod);
+boolean UBXSetSatelliteData(boolean On);
+boolean UBXSetupReceiver(boolean SatelliteData);
+void UBXBackup(uint32_t Duration);
+void UBXWakeUp();
+void UBXReset();
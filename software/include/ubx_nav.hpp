@@ -0,0 +1,16 @@
+#include "Arduino.h"
+#include <NMEAGPS.h>
+
+// UBX navigation data in place of NMEA, used when GPS_UBX_Nav is set in defines.hpp.
+// NAV-PVT is decoded in to the same gps_fix fields NeoGPS fills from NMEA, NAV-SAT (u-blox 8 and later) or NAV-SVINFO
+// (u-blox 7) in to the NeoGPS satellite list.
+// The frames are decoded byte by byte as they arrive, nothing is buffered
+
+#define UBX_NAV_PVT_LENGTH 84 // NAV-PVT is 84 bytes on u-blox 7 and 92 bytes from u-blox 8, only the first 84 are used
+
+extern uint32_t UBXNavHorizontalAccuracy; // Estimated accuracy of the last fix in mm
+extern uint32_t UBXNavVerticalAccuracy;
+extern unsigned long UBXNavFixMillis; // millis() when the last fix with a valid position was received, for its age
+
+boolean UBXNavAvailable();
+gps_fix UBXNavRead();
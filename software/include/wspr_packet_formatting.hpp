@@ -13,27 +13,33 @@
 #include "Arduino.h"
 #include "datatypes.hpp"
 
+#define WSPR_SYMBOL_COUNT 162
+#define WSPR_PACKED_SIZE ((WSPR_SYMBOL_COUNT + 3) / 4) // Bytes needed for the symbols packed four to a byte
+
+extern const uint8_t InterleavePos[WSPR_SYMBOL_COUNT];         // In flash, interleaved position of each encoded bit
+extern const uint8_t SyncVector[(WSPR_SYMBOL_COUNT + 7) / 8]; // In flash, one sync bit per symbol, MSB first
+
 /**
  * @brief Takes an arbitrary message of up to 13 allowable characters and returns.
  *
  * @param call Callsign (6 characters maximum).
  * @param loc Maidenhead grid locator (4 charcters maximum).
  * @param dbm Output power in dBm.
- * @param symbols Array of channel symbols to transmit returned by the method. Ensure that you pass a uint8_t array of
- * size WSPR_SYMBOL_COUNT to the method.
+ * @param symbols Array of channel symbols to transmit returned by the method, packed 2 bits per symbol. Ensure that you pass a uint8_t array of
+ * size WSPR_PACKED_SIZE to the method.
  * @param WSPRMessageType
  * @param GadgetData
  */
-void wspr_encode(const char *call, const char *loc, const uint8_t dbm, uint8_t *symbols, uint8_t WSPRMessageType, S_GadgetData GadgetData);
+void wspr_encode(const char *call, const char *loc, const uint8_t dbm, uint8_t *symbols, uint8_t WSPRMessageType, const S_GadgetData &GadgetData);
 void wspr_message_prep(char *call, char *loc, uint8_t dbm);
 uint8_t ValiddBmValue(uint8_t dBmIn);
-void convolve(uint8_t *c, uint8_t *s, uint8_t message_size, uint8_t bit_size);
-void wspr_interleave(uint8_t *s);
-void wspr_merge_sync_vector(uint8_t *g, uint8_t *symbols);
+void convolve(uint8_t *c, uint8_t *symbols, uint8_t message_size, uint8_t bit_size);
 uint8_t wspr_code(char c);
 
 uint8_t *get_tx_buffer_ptr();
 uint8_t get_tx_buffer_size();
+uint8_t get_tx_symbol(uint8_t i);
 
-uint32_t WSPRCallHash(const char *call, S_GadgetData GadgetData);
-void calcLocator(double lat, double lon, S_WSPRData *WSPRData);
+uint32_t WSPRCallHash(const char *call, const S_GadgetData &GadgetData);
+void calcLocator(int32_t lat, int32_t lon, S_WSPRData *WSPRData);
+void calcLocatorPrecise(int32_t lat, int32_t lon, char *Locator, uint8_t Length);
@@ -2,10 +2,20 @@
 #include "defines.hpp"
 #include "i2c.hpp"
 #include "string_operations.hpp"
-#include "state_machine.hpp"
+#include "binary_protocol.hpp"
+#include "telemetry.hpp"
+#include "energy.hpp"
 
 uint8_t Si5351I2CAddress; // The I2C address on the Si5351 as detected on startup
 
+uint8_t ToneRegs[4][8]; // PLL A register images for the four WSPR tones
+uint8_t CurrentTone;    // The WSPR tone that is currently loaded in to PLL A
+uint64_t ToneBaseFreq;  // Frequency of tone 0 in milliHz
+boolean ToneOutputOn;   // False until the first tone of a transmission has switched on CLK0
+int32_t ToneErrors[4];  // Frequency error in milliHz of each tone in the table
+uint64_t PLLAFreq;      // The CLK0 frequency in milliHz that PLL A is currently set up for, used to decide when the PLL needs a reset
+int32_t FreqError;      // Frequency error in milliHz of the current CLK0 setup
+
 void Si5351PowerOff()
 {
     if (Product_Model == 1017 || Product_Model == 1028) // If its the WSPR-TX Mini it has a control line that can cut power to the Si5351
@@ -13,6 +23,10 @@ void Si5351PowerOff()
         // Power off the Si5351
         digitalWrite(SiPower, HIGH);
     }
+    if (Product_Model == 1017) // The power switch is only wired up on the Mini
+    {
+        EnergyState(ENERGY_SI5351, 0);
+    }
 }
 
 void Si5351PowerOn()
@@ -25,6 +39,7 @@ void Si5351PowerOn()
         delay(100);
         // re-initialize the Si5351
         i2cInit();
+        EnergyState(ENERGY_SI5351, 1);
         si5351aOutputOff(SI_CLK0_CONTROL);
     }
 }
@@ -40,19 +55,21 @@ void setupMultisynth(uint8_t synth, uint32_t Divider, uint8_t rDiv)
     uint32_t P1; // Synth config register P1
     uint32_t P2; // Synth config register P2
     uint32_t P3; // Synth config register P3
+    uint8_t MSRegs[8];
 
     P1 = 128 * Divider - 512;
     P2 = 0; // P2 = 0, P3 = 1 forces an integer value for the Divider
     P3 = 1;
 
-    i2cSendRegister(synth + 0, (P3 & 0x0000FF00) >> 8, Si5351I2CAddress);
-    i2cSendRegister(synth + 1, (P3 & 0x000000FF), Si5351I2CAddress);
-    i2cSendRegister(synth + 2, ((P1 & 0x00030000) >> 16) | rDiv, Si5351I2CAddress);
-    i2cSendRegister(synth + 3, (P1 & 0x0000FF00) >> 8, Si5351I2CAddress);
-    i2cSendRegister(synth + 4, (P1 & 0x000000FF), Si5351I2CAddress);
-    i2cSendRegister(synth + 5, ((P3 & 0x000F0000) >> 12) | ((P2 & 0x000F0000) >> 16), Si5351I2CAddress);
-    i2cSendRegister(synth + 6, (P2 & 0x0000FF00) >> 8, Si5351I2CAddress);
-    i2cSendRegister(synth + 7, (P2 & 0x000000FF), Si5351I2CAddress);
+    MSRegs[0] = (P3 & 0x0000FF00) >> 8;
+    MSRegs[1] = (P3 & 0x000000FF);
+    MSRegs[2] = ((P1 & 0x00030000) >> 16) | rDiv;
+    MSRegs[3] = (P1 & 0x0000FF00) >> 8;
+    MSRegs[4] = (P1 & 0x000000FF);
+    MSRegs[5] = ((P3 & 0x000F0000) >> 12) | ((P2 & 0x000F0000) >> 16);
+    MSRegs[6] = (P2 & 0x0000FF00) >> 8;
+    MSRegs[7] = (P2 & 0x000000FF);
+    i2cSendRegisters(synth, MSRegs, 8, Si5351I2CAddress);
 }
 
 // Switches off Si5351a output
@@ -60,68 +77,164 @@ void si5351aOutputOff(uint8_t clk)
 {
     i2cSendRegister(clk, 0x80, Si5351I2CAddress); // Refer to SiLabs AN619 to see
     // bit values - 0x80 turns off the output stage
-    digitalWrite(TransmitLED, LOW);
-    SendAPIUpdate(UMesTXOff);
+    if (!PPS_Mode) // In PPS mode the TX LED pin is the PPS input
+    {
+        digitalWrite(TransmitLED, LOW);
+    }
+    if (clk == SI_CLK0_CONTROL)
+    {
+        EnergyState(ENERGY_TX, 0);
+    }
+    TelemetryPost(UMesTXOff);
 }
 
-// Set CLK0 output ON and to the specified frequency
-// Frequency is in the range 10kHz to 150MHz and given in centiHertz (hundreds of Hertz)
-// Example: si5351aSetFrequency(1000000200);
-// will set output CLK0 to 10.000,002MHz
-//
-// This example sets up PLL A
-// and MultiSynth 0
-// and produces the output on CLK0
-//
-void si5351aSetFrequency(uint64_t frequency, uint32_t RefFreq) // Frequency is in centiHz
+// Best rational approximation Num / Denom of the fraction Rem / Ref (Rem < Ref) with Denom no larger than SI_MAX_DENOM
+// Walks the continued fraction expansion of Rem / Ref. When the next convergent would get a too large denominator
+// the largest semiconvergent that fits is used instead, if it is closer than the last convergent
+static void BestRational(uint64_t Rem, uint64_t Ref, uint32_t *Num, uint32_t *Denom)
 {
-    static uint64_t oldFreq;
-    int32_t FreqChange;
-    uint64_t pllFreq;
-    // uint32_t xtalFreq = XTAL_FREQ;
-    uint32_t l;
-    float f;
+    uint32_t p0 = 0, q0 = 1; // Convergent before the last one
+    uint32_t p1 = 1, q1 = 0; // Last convergent
+    uint32_t p2, q2;
+    uint64_t a; // Next term of the continued fraction
+    uint64_t t; // Next remainder
+
+    while (Ref != 0)
+    {
+        if (((Rem | Ref) >> 32) == 0) // The terms shrink fast, use the much cheaper 32 bit division on the AVR as soon as they fit
+        {
+            a = (uint32_t)Rem / (uint32_t)Ref;
+            t = (uint32_t)Rem % (uint32_t)Ref;
+        }
+        else
+        {
+            a = Rem / Ref;
+            t = Rem % Ref;
+        }
+        if ((q1 != 0) && (a > (SI_MAX_DENOM - q0) / q1))
+        {
+            t = (SI_MAX_DENOM - q0) / q1; // Largest term that keeps the denominator in range
+            if (2 * t > a)                // Semiconvergents above half the full term are better than the last convergent
+            {
+                p1 = t * p1 + p0;
+                q1 = t * q1 + q0;
+            }
+            break;
+        }
+        p2 = a * p1 + p0;
+        q2 = a * q1 + q0;
+        p0 = p1;
+        q0 = q1;
+        p1 = p2;
+        q1 = q2;
+        Rem = Ref;
+        Ref = t;
+    }
+    *Num = p1;
+    *Denom = q1;
+}
+
+// PLL A register image for a total division Div (MultiSynth Divider * R Divider) from PLL A to CLK0
+// Returns the difference between the frequency the registers will produce and the requested one in milliHz
+static int32_t CalcPLLA(uint64_t FreqmHz, uint64_t RefmHz, uint64_t Div, uint8_t *PLLRegs)
+{
+    uint64_t pllFreq = FreqmHz * Div; // PLL A frequency in milliHz
+    uint64_t Achieved;                // Output frequency in milliHz the registers will give
     uint8_t mult;
     uint32_t num;
     uint32_t denom;
-    uint32_t Divider;
-    uint8_t rDiv;
 
-    if (frequency > 100000000ULL)
-    { // If higher than 1MHz then set R output divider to 1
-        rDiv = SI_R_DIV_1;
-        Divider = 90000000000ULL / frequency; // Calculate the division ratio. 900MHz is the maximum VCO freq (expressed as deciHz)
-        pllFreq = Divider * frequency;        // Calculate the pllFrequency:
-        mult = pllFreq / (RefFreq * 100UL);   // Determine the multiplier to
-        l = pllFreq % (RefFreq * 100UL);      // It has three parts:
-        f = l;                                // mult is an integer that must be in the range 15..90
-        f *= 1048575;                         // num and denom are the fractional parts, the numerator and denominator
-        f /= RefFreq;                         // each is 20 bits (range 0..1048575)
-        num = f;                              // the actual multiplier is mult + num / denom
-        denom = 1048575;                      // For simplicity we set the denominator to the maximum 1048575
-        num = num / 100;
+    mult = pllFreq / RefmHz; // mult is an integer that must be in the range 15..90
+    BestRational(pllFreq % RefmHz, RefmHz, &num, &denom);
+    calcPLLRegisters(mult, num, denom, PLLRegs);
+
+    Achieved = (RefmHz * ((uint64_t)mult * denom + num) + (denom * Div) / 2) / (denom * Div);
+    return (int32_t)(Achieved - FreqmHz);
+}
+
+// Calculates the PLL A register image, the MultiSynth Divider and the R Divider for a CLK0 frequency
+// Frequency is in milliHz, the PLL register image is 8 bytes starting at SI_SYNTH_PLL_A
+// All integer math. The MultiSynth runs with an integer divider (even if SI_EvenDivider is set) and PLL A gets
+// the fractional part of its multiplier as the best num/denom with a denominator up to 1048575.
+// Now and then the best fraction is still off by more than SI_MAX_ERROR, then a few lower dividers are tried as well.
+// Returns the difference between the frequency the registers will produce and the requested one in milliHz
+int32_t si5351aCalcFrequency(uint64_t FreqmHz, uint32_t RefFreq, uint8_t *PLLRegs, uint32_t *Divider, uint8_t *rDiv)
+{
+    uint64_t RefmHz = RefFreq * 1000ULL;
+    uint8_t TryRegs[8];
+    uint32_t TryDivider;
+    uint8_t Step = SI_EvenDivider ? 2 : 1;
+    uint8_t R;
+    int32_t Error, BestError;
+
+    if (FreqmHz > 1000000000ULL) // If higher than 1MHz then set R output divider to 1
+    {
+        *rDiv = SI_R_DIV_1;
+        R = 1;
     }
     else // lower freq than 1MHz - use output Divider set to 128
     {
-        rDiv = SI_R_DIV_128;
-        // frequency = frequency * 128ULL; //Set base freq 128 times higher as we are dividing with 128 in the last output stage
-        Divider = 90000000000ULL / (frequency * 128ULL); // Calculate the division ratio. 900MHz is the maximum VCO freq
+        *rDiv = SI_R_DIV_128;
+        R = 128;
+    }
+    TryDivider = SI_VCO_MAX / (FreqmHz * R); // Calculate the division ratio. 900MHz is the maximum VCO freq
+    if (SI_EvenDivider)
+    {
+        TryDivider &= ~1UL;
+    }
+    *Divider = TryDivider;
+    BestError = CalcPLLA(FreqmHz, RefmHz, (uint64_t)TryDivider * R, PLLRegs);
+    for (uint8_t Try = 1; (Try < SI_DIVIDER_TRIES) && (labs(BestError) > SI_MAX_ERROR); Try++)
+    {
+        TryDivider -= Step;
+        if (FreqmHz * R * TryDivider < SI_VCO_MIN)
+        {
+            break;
+        }
+        Error = CalcPLLA(FreqmHz, RefmHz, (uint64_t)TryDivider * R, TryRegs);
+        if (labs(Error) < labs(BestError))
+        {
+            BestError = Error;
+            *Divider = TryDivider;
+            memcpy(PLLRegs, TryRegs, 8);
+        }
+    }
+    return BestError;
+}
+
+// Send the output frequency in centiHz to the PC, {TFQ} in the Serial API
+void si5351aSendFrequency()
+{
+    uint64_t FreqcHz;
+    char Buffer[UINT64_DIGITS + 1];
+    uint8_t Length;
 
-        pllFreq = Divider * frequency * 128ULL; // Calculate the pllFrequency:
-        // the Divider * desired output frequency
-        mult = pllFreq / (RefFreq * 100UL); // Determine the multiplier to
-        // get to the required pllFrequency
-        l = pllFreq % (RefFreq * 100UL); // It has three parts:
-        f = l;                           // mult is an integer that must be in the range 15..90
-        f *= 1048575;                    // num and denom are the fractional parts, the numerator and denominator
-        f /= RefFreq;                    // each is 20 bits (range 0..1048575)
-        num = f;                         // the actual multiplier is mult + num / denom
-        denom = 1048575;                 // For simplicity we set the denominator to the maximum 1048575
-        num = num / 100;
+    if (BinaryMode)
+    {
+        FreqcHz = PLLAFreq / 10;
+        BinSend(BIN_MSG_FREQUENCY, &FreqcHz, 8);
+    }
+    else
+    {
+        Length = uint64ToStr(PLLAFreq, Buffer, 2);
+        Buffer[Length - 1] = 0; // Drop the milliHz digit, the same as PLLAFreq / 10 without a 64 bit division
+        Serial.print(F("{TFQ} "));
+        Serial.println(Buffer);
     }
+}
+
+// Set up PLL A, MultiSynth 0 and CLK0 for a frequency in milliHz
+static void si5351aSetFrequencymHz(uint64_t FreqmHz, uint32_t RefFreq)
+{
+    uint64_t FreqChange;
+    uint8_t PLLRegs[8];
+    uint32_t Divider;
+    uint8_t rDiv;
+
+    FreqError = si5351aCalcFrequency(FreqmHz, RefFreq, PLLRegs, &Divider, &rDiv);
 
     // Set up PLL A with the calculated  multiplication ratio
-    setupPLL(SI_SYNTH_PLL_A, mult, num, denom);
+    i2cSendRegisters(SI_SYNTH_PLL_A, PLLRegs, 8, Si5351I2CAddress);
 
     // Set up MultiSynth Divider 0, with the calculated Divider.
     // The final R division stage can divide by a power of two, from 1..128.
@@ -132,9 +245,9 @@ void si5351aSetFrequency(uint64_t frequency, uint32_t RefFreq) // Frequency is i
 
     // Reset the PLL. This causes a glitch in the output. For small changes to
     // the parameters, you don't need to reset the PLL, and there is no glitch
-    FreqChange = frequency - oldFreq;
+    FreqChange = (FreqmHz > PLLAFreq) ? FreqmHz - PLLAFreq : PLLAFreq - FreqmHz;
 
-    if (abs(FreqChange) > 100000) // If changed more than 1kHz then reset PLL (completely arbitrary choosen)
+    if (FreqChange > 1000000) // If changed more than 1kHz then reset PLL (completely arbitrary choosen)
     {
         i2cSendRegister(SI_PLL_RESET, 0xA0, Si5351I2CAddress);
     }
@@ -142,11 +255,116 @@ void si5351aSetFrequency(uint64_t frequency, uint32_t RefFreq) // Frequency is i
     // Finally switch on the CLK0 output (0x4F)
     // and set the MultiSynth0 input to be PLL A
     i2cSendRegister(SI_CLK0_CONTROL, 0x4F | SI_CLK_SRC_PLL_A, Si5351I2CAddress);
-    oldFreq = frequency;
-    digitalWrite(TransmitLED, HIGH);
-    Serial.print(F("{TFQ} "));
-    Serial.println(uint64ToStr(frequency, false));
-    SendAPIUpdate(UMesTXOn);
+    PLLAFreq = FreqmHz;
+    if (!PPS_Mode)
+    {
+        digitalWrite(TransmitLED, HIGH);
+    }
+    EnergyState(ENERGY_TX, 1);
+    TelemetryPost(UMesTXFreq);
+    TelemetryPost(UMesTXOn);
+}
+
+// Set CLK0 output ON and to the specified frequency
+// Frequency is in the range 10kHz to 150MHz and given in centiHertz (hundreds of Hertz)
+// Example: si5351aSetFrequency(1000000200);
+// will set output CLK0 to 10.000,002MHz
+//
+// This example sets up PLL A
+// and MultiSynth 0
+// and produces the output on CLK0
+//
+void si5351aSetFrequency(uint64_t frequency, uint32_t RefFreq) // Frequency is in centiHz
+{
+    si5351aSetFrequencymHz(frequency * 10, RefFreq);
+}
+
+// Difference in milliHz between the frequency CLK0 was last set up for and the requested one
+int32_t si5351aFrequencyError()
+{
+    return FreqError;
+}
+
+// Tone table mode for WSPR transmissions
+// The PLL A register images for the four WSPR tones are calculated once per transmission,
+// a symbol change then only writes the PLL registers that differ from the tone currently sent.
+// The four tones share the same MultiSynth divider so the rest of the Si5351 setup is left untouched.
+// PLL A and the MultiSynth are preloaded with FirstTone while CLK0 is still off, so starting the
+// transmission with si5351aSetTone(FirstTone) is a single register write that can be timed exactly.
+void si5351aStartToneTable(uint64_t BaseFreq, uint32_t RefFreq, uint8_t FirstTone) // Frequency is in centiHz
+{
+    uint32_t Divider;
+    uint8_t rDiv;
+    uint64_t Div; // Total division from PLL A to CLK0
+
+    ToneBaseFreq = BaseFreq * 10;
+    ToneOutputOn = false;
+    ToneErrors[0] = si5351aCalcFrequency(ToneBaseFreq, RefFreq, ToneRegs[0], &Divider, &rDiv);
+    Div = (uint64_t)Divider * ((rDiv == SI_R_DIV_128) ? 128 : 1);
+    for (uint8_t Tone = 1; Tone < 4; Tone++) // The other tones keep the dividers of tone 0 so only PLL A changes between symbols
+    {
+        ToneErrors[Tone] = CalcPLLA(ToneBaseFreq + WSPR_TONE_OFFSET(Tone), RefFreq * 1000ULL, Div, ToneRegs[Tone]);
+    }
+    i2cSendRegisters(SI_SYNTH_PLL_A, ToneRegs[FirstTone], 8, Si5351I2CAddress);
+    setupMultisynth(SI_SYNTH_MS_0, Divider, rDiv);
+    i2cSendRegister(SI_PLL_RESET, 0xA0, Si5351I2CAddress); // The output is off so the glitch from a PLL reset does not matter
+    PLLAFreq = ToneBaseFreq + WSPR_TONE_OFFSET(FirstTone);
+    CurrentTone = FirstTone;
+}
+
+// Switch CLK0 to one of the four WSPR tones (0-3), si5351aStartToneTable must have been called first
+void si5351aSetTone(uint8_t Tone)
+{
+    // Only write the PLL registers that changes, usually the low bytes of P1 and P2. Registers in between are rewritten with their current value so it can be done in one burst
+    uint8_t First = 8;
+    uint8_t Last = 0;
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        if (ToneRegs[Tone][i] != ToneRegs[CurrentTone][i])
+        {
+            if (First == 8)
+                First = i;
+            Last = i;
+        }
+    }
+    if (First < 8)
+    {
+        // Queue the write without waiting for it, the tone table stays valid for the whole transmission
+        i2cQueueTransaction(Si5351I2CAddress, SI_SYNTH_PLL_A + First, &ToneRegs[Tone][First], Last - First + 1, false, NULL);
+    }
+    PLLAFreq = ToneBaseFreq + WSPR_TONE_OFFSET(Tone);
+    FreqError = ToneErrors[Tone];
+    if (!ToneOutputOn) // First tone of the transmission, switch on CLK0 with PLL A as source
+    {
+        i2cSendRegister(SI_CLK0_CONTROL, 0x4F | SI_CLK_SRC_PLL_A, Si5351I2CAddress);
+        ToneOutputOn = true;
+        if (!PPS_Mode)
+        {
+            digitalWrite(TransmitLED, HIGH);
+        }
+        EnergyState(ENERGY_TX, 1);
+        TelemetryPost(UMesTXOn);
+    }
+    TelemetryPost(UMesTXFreq);
+    CurrentTone = Tone;
+}
+
+// Output the reference oscillator on CLK2 so the MCU can count it against the GPS PPS
+// PLL B is set to an integer multiple of the reference and MultiSynth 2 to an integer divider,
+// the CLK2 frequency is then exactly RefFreq * SI_CAL_PLL_MULT / SI_CAL_DIVIDER
+void si5351aCalibrationOutput(boolean On)
+{
+    if (On)
+    {
+        setupPLL(SI_SYNTH_PLL_B, SI_CAL_PLL_MULT, 0, 1);
+        setupMultisynth(SI_SYNTH_MS_2, SI_CAL_DIVIDER, SI_R_DIV_1);
+        i2cSendRegister(SI_PLL_RESET, 0x80, Si5351I2CAddress); // Reset PLL B only, PLL A may hold a preloaded WSPR tone
+        i2cSendRegister(SI_CLK2_CONTROL, 0x4F | SI_CLK_SRC_PLL_B, Si5351I2CAddress);
+    }
+    else
+    {
+        i2cSendRegister(SI_CLK2_CONTROL, 0x80, Si5351I2CAddress);
+    }
 }
 
 boolean DetectSi5351I2CAddress()
@@ -154,10 +372,8 @@ boolean DetectSi5351I2CAddress()
     uint8_t I2CResult;
     boolean Result;
     Si5351I2CAddress = 96; // Try with the normal adress of 96
-    i2cStart();
-    I2CResult = i2cByteSend((Si5351I2CAddress << 1));
-    i2cStop();
-    if (I2CResult == I2C_SLA_W_ACK)
+    I2CResult = i2cProbe(Si5351I2CAddress);
+    if (I2CResult == I2C_RESULT_OK)
     {
         // We found it
         // Serial.println("Detected at adress 96");
@@ -167,10 +383,8 @@ boolean DetectSi5351I2CAddress()
     {
         // Serial.println("Not Detected at adress 96");
         Si5351I2CAddress = 98; // Try the alternative address of 98
-        i2cStart();
-        I2CResult = i2cByteSend((Si5351I2CAddress << 1));
-        i2cStop();
-        if (I2CResult == I2C_SLA_W_ACK)
+        I2CResult = i2cProbe(Si5351I2CAddress);
+        if (I2CResult == I2C_RESULT_OK)
         {
             // Serial.println("Detected at adress 98");
             Result = true;
@@ -193,23 +407,32 @@ boolean DetectSi5351I2CAddress()
 // denom is 0..1,048,575 (0xFFFFF)
 //
 void setupPLL(uint8_t pll, uint8_t mult, uint32_t num, uint32_t denom)
+{
+    uint8_t PLLRegs[8];
+
+    calcPLLRegisters(mult, num, denom, PLLRegs);
+    i2cSendRegisters(pll, PLLRegs, 8, Si5351I2CAddress);
+}
+
+// Builds the eight register image for a PLL from mult, num and denom
+void calcPLLRegisters(uint8_t mult, uint32_t num, uint32_t denom, uint8_t *PLLRegs)
 {
     uint32_t P1; // PLL config register P1
     uint32_t P2; // PLL config register P2
     uint32_t P3; // PLL config register P3
 
-    P1 = (uint32_t)(128 * ((float)num / (float)denom));
-    P1 = (uint32_t)(128 * (uint32_t)(mult) + P1 - 512);
-    P2 = (uint32_t)(128 * ((float)num / (float)denom));
-    P2 = (uint32_t)(128 * num - denom * P2);
+    uint32_t Frac = (128 * num) / denom; // Integer part of 128 * num / denom
+
+    P1 = 128 * (uint32_t)mult + Frac - 512;
+    P2 = 128 * num - denom * Frac;
     P3 = denom;
 
-    i2cSendRegister(pll + 0, (P3 & 0x0000FF00) >> 8, Si5351I2CAddress);
-    i2cSendRegister(pll + 1, (P3 & 0x000000FF), Si5351I2CAddress);
-    i2cSendRegister(pll + 2, (P1 & 0x00030000) >> 16, Si5351I2CAddress);
-    i2cSendRegister(pll + 3, (P1 & 0x0000FF00) >> 8, Si5351I2CAddress);
-    i2cSendRegister(pll + 4, (P1 & 0x000000FF), Si5351I2CAddress);
-    i2cSendRegister(pll + 5, ((P3 & 0x000F0000) >> 12) | ((P2 & 0x000F0000) >> 16), Si5351I2CAddress);
-    i2cSendRegister(pll + 6, (P2 & 0x0000FF00) >> 8, Si5351I2CAddress);
-    i2cSendRegister(pll + 7, (P2 & 0x000000FF), Si5351I2CAddress);
-}
+    PLLRegs[0] = (P3 & 0x0000FF00) >> 8;
+    PLLRegs[1] = (P3 & 0x000000FF);
+    PLLRegs[2] = (P1 & 0x00030000) >> 16;
+    PLLRegs[3] = (P1 & 0x0000FF00) >> 8;
+    PLLRegs[4] = (P1 & 0x000000FF);
+    PLLRegs[5] = ((P3 & 0x000F0000) >> 12) | ((P2 & 0x000F0000) >> 16);
+    PLLRegs[6] = (P2 & 0x0000FF00) >> 8;
+    PLLRegs[7] = (P2 & 0x000000FF);
+}
\ No newline at end of file
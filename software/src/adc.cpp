@@ -1,32 +1,140 @@
 #include "adc.hpp"
+#include "datatypes.hpp"
+#include <avr/sleep.h>
+#include <util/atomic.h>
 
-// Arduino voltmeter from TINKER : https://code.google.com/archive/p/tinkerit/wikis/SecretVoltmeter.wiki
-// Retun VCC voltage measured in milliVolt
-// So 5000 is 5V, 3300 is 3.3V.
-int GetVCC()
-{
-    // Read 1.1V reference against AVcc
-    // set the reference to Vcc and the measurement to the internal 1.1V reference
+extern S_FactoryData FactoryData; // TODO: replace with getters and setters
+
+#define ADC_SAMPLES (1 << (2 * ADC_OVERSAMPLE_BITS))
+#define ADC_FULL_SCALE (1023UL << ADC_OVERSAMPLE_BITS) // Reading of the reference voltage itself
+
+// The 1.1V reference measured against AVcc
 #if defined(__AVR_ATmega32U4__) || defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
-    ADMUX = _BV(REFS0) | _BV(MUX4) | _BV(MUX3) | _BV(MUX2) | _BV(MUX1);
+#define ADC_MUX_BANDGAP (_BV(REFS0) | _BV(MUX4) | _BV(MUX3) | _BV(MUX2) | _BV(MUX1))
 #elif defined(__AVR_ATtiny24__) || defined(__AVR_ATtiny44__) || defined(__AVR_ATtiny84__)
-    ADMUX = _BV(MUX5) | _BV(MUX0);
+#define ADC_MUX_BANDGAP (_BV(MUX5) | _BV(MUX0))
 #elif defined(__AVR_ATtiny25__) || defined(__AVR_ATtiny45__) || defined(__AVR_ATtiny85__)
-    ADMUX = _BV(MUX3) | _BV(MUX2);
+#define ADC_MUX_BANDGAP (_BV(MUX3) | _BV(MUX2))
 #else
-    ADMUX = _BV(REFS0) | _BV(MUX3) | _BV(MUX2) | _BV(MUX1);
+#define ADC_MUX_BANDGAP (_BV(REFS0) | _BV(MUX3) | _BV(MUX2) | _BV(MUX1))
 #endif
+#define ADC_MUX_TEMPERATURE (_BV(REFS1) | _BV(REFS0) | _BV(MUX3)) // Channel 8 measured against the internal 1.1V reference
+
+ISR(ADC_vect)
+{
+    // Only here to wake the MCU from ADC noise reduction sleep when the conversion is done
+}
+
+// Millisecond count of the Arduino core (wiring.c), corrected for the time Timer0 is stopped by Quiet conversions
+extern volatile unsigned long timer0_millis;
+
+static uint16_t LostMicros; // Time Timer0 was stopped that has not been added to millis() yet
+
+// Adds the Timer0 time lost by one Quiet conversion to millis(), a conversion takes 13 ADC clock cycles
+static void ADCAddLostTime()
+{
+    LostMicros += 13UL * (1 << (ADCSRA & (_BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0)))) * 1000000UL / F_CPU; // A prescaler setting of 0 also divides by 2
+    if (LostMicros >= 1000)
+    {
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            timer0_millis += LostMicros / 1000;
+        }
+        LostMicros %= 1000;
+    }
+}
+
+// One conversion. Quiet halts the CPU and the IO clock while converting, the conversion starts when the sleep is entered.
+// Timer0 runs on the IO clock so millis() stands still and its interrupt can not end the sleep, ADCAddLostTime makes up
+// for it. Only the ADC and the interrupts that work without the IO clock (TWI, external pins) wake the MCU, if one of the
+// latter comes first the MCU goes back to sleep until the conversion is done
+static uint16_t ADCConvert(boolean Quiet)
+{
+    if (Quiet)
+    {
+        ADCSRA |= _BV(ADIE);
+        set_sleep_mode(SLEEP_MODE_ADC);
+        sleep_enable();
+        do
+        {
+            sleep_cpu();
+        } while (bit_is_set(ADCSRA, ADSC));
+        sleep_disable();
+        ADCSRA &= ~_BV(ADIE);
+        ADCAddLostTime();
+    }
+    else
+    {
+        ADCSRA |= _BV(ADSC); // Start conversion
+        while (bit_is_set(ADCSRA, ADSC))
+            ; // measuring
+    }
+    return ADC; // Reads ADCL before ADCH
+}
 
-    delay(2);            // Wait for Vref to settle
-    ADCSRA |= _BV(ADSC); // Start conversion
-    while (bit_is_set(ADCSRA, ADSC))
-        ; // measuring
+// Oversampled reading of the channel and reference given by Mux, 10 + ADC_OVERSAMPLE_BITS bits.
+// The first conversions after a change of channel or reference are thrown away while the input settles
+uint16_t ADCRead(uint8_t Mux, boolean Quiet)
+{
+    uint8_t Settle = ((ADMUX ^ Mux) & (_BV(REFS1) | _BV(REFS0))) ? ADC_SETTLE_REF : ADC_SETTLE;
+    uint16_t Sum = 0;
+
+    ADMUX = Mux;
+    for (uint8_t i = 0; i < Settle; i++)
+    {
+        ADCConvert(Quiet);
+    }
+    for (uint8_t i = 0; i < ADC_SAMPLES; i++)
+    {
+        Sum += ADCConvert(Quiet);
+    }
+    return Sum >> ADC_OVERSAMPLE_BITS;
+}
+
+// The internal reference in 0.1 mV as calibrated for this unit
+static uint16_t Bandgap()
+{
+    if ((FactoryData.Bandgap < ADC_BANDGAP_MIN) || (FactoryData.Bandgap > ADC_BANDGAP_MAX))
+    {
+        return ADC_BANDGAP_DEFAULT;
+    }
+    return FactoryData.Bandgap;
+}
+
+// Arduino voltmeter from TINKER : https://code.google.com/archive/p/tinkerit/wikis/SecretVoltmeter.wiki
+// Retun VCC voltage measured in milliVolt
+// So 5000 is 5V, 3300 is 3.3V.
+int GetVCC(boolean Quiet)
+{
+    // Read 1.1V reference against AVcc
+    uint32_t Reading = ADCRead(ADC_MUX_BANDGAP, Quiet);
 
-    uint8_t low = ADCL;  // must read ADCL first - it then locks ADCH
-    uint8_t high = ADCH; // unlocks both
+    if (Reading == 0)
+    {
+        return 0;
+    }
+    return (Bandgap() * ADC_FULL_SCALE + Reading * 5) / (Reading * 10); // Vcc in millivolts, the bandgap is in 0.1 mV
+}
 
-    long result = (high << 8) | low;
+// Temperature of the chip from the internal sensor in degrees Celsius, typical values from the datasheet.
+// Can be off by ten degrees but is the same for the same temperature, good enough to tell conditions apart
+int GetTemperature(boolean Quiet)
+{
+    int32_t Reading = ADCRead(ADC_MUX_TEMPERATURE, Quiet);
+
+    Reading = Reading * Bandgap() / ADC_BANDGAP_DEFAULT;                                    // To the reading with an exact 1.1V reference
+    return (Reading - (324L << ADC_OVERSAMPLE_BITS)) * 100 / (122L << ADC_OVERSAMPLE_BITS); // 324 at 0 degrees and 1.22 per degree in 10 bits
+}
+
+// Calibrates the internal reference from the supply voltage in mV as measured with a meter. Returns the new bandgap
+// in 0.1 mV, it is stored in FactoryData when in range. The supply must be steady while this runs
+uint16_t ADCCalibrateBandgap(uint16_t VCC)
+{
+    uint32_t Calibrated = ((uint32_t)VCC * 10 * ADCRead(ADC_MUX_BANDGAP, false) + ADC_FULL_SCALE / 2) / ADC_FULL_SCALE;
 
-    result = 1125300L / result; // Calculate Vcc (in mV); 1125300 = 1.1*1023*1000
-    return result;              // Vcc in millivolts
+    if ((Calibrated >= ADC_BANDGAP_MIN) && (Calibrated <= ADC_BANDGAP_MAX))
+    {
+        FactoryData.Bandgap = Calibrated;
+    }
+    return Calibrated;
 }
@@ -0,0 +1,158 @@
+#include "binary_protocol.hpp"
+#include "state_machine.hpp"
+
+boolean BinaryMode = false;
+
+// CRC-16/CCITT-FALSE, one byte at a time
+uint16_t BinCRC16(uint16_t CRC, uint8_t Data)
+{
+    CRC ^= (uint16_t)Data << 8;
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        CRC = (CRC & 0x8000) ? (CRC << 1) ^ 0x1021 : CRC << 1;
+    }
+    return CRC;
+}
+
+// COBS encodes and sends a packet with a zero delimiter on both sides.
+// Each block is a code byte telling how many bytes follow up to the next zero (code - 1), the zero itself is not sent.
+static void SendCOBS(const uint8_t *Packet, uint8_t Length)
+{
+    uint8_t Start = 0;
+    uint8_t End;
+
+    Serial.write((uint8_t)0);
+    while (Start <= Length)
+    {
+        End = Start;
+        while ((End < Length) && (Packet[End] != 0))
+        {
+            End++;
+        }
+        Serial.write((uint8_t)(End - Start + 1));
+        Serial.write(&Packet[Start], End - Start);
+        Start = End + 1; // Skip the zero, a packet that does not end in a zero gets a phantom one that the receiver drops
+    }
+    Serial.write((uint8_t)0);
+}
+
+void BinSend(uint8_t MsgID, const void *Payload, uint8_t Length)
+{
+    uint8_t Packet[BIN_MAX_PAYLOAD + 3];
+    uint16_t CRC = 0xFFFF;
+
+    if (Length > BIN_MAX_PAYLOAD)
+    {
+        return;
+    }
+    Packet[0] = MsgID;
+    memcpy(&Packet[1], Payload, Length);
+    for (uint8_t i = 0; i <= Length; i++)
+    {
+        CRC = BinCRC16(CRC, Packet[i]);
+    }
+    Packet[Length + 1] = CRC & 0xFF;
+    Packet[Length + 2] = CRC >> 8;
+    SendCOBS(Packet, Length + 3);
+}
+
+void BinSendByte(uint8_t MsgID, uint8_t Value)
+{
+    BinSend(MsgID, &Value, 1);
+}
+
+// Handles a decoded packet from the host
+static void BinDecodePacket(uint8_t *Packet, uint8_t Length)
+{
+    uint8_t Reply[BIN_MAX_PAYLOAD];
+    uint8_t Size;
+    uint16_t CRC = 0xFFFF;
+
+    if (Length < 3)
+    {
+        return;
+    }
+    for (uint8_t i = 0; i < Length - 2; i++)
+    {
+        CRC = BinCRC16(CRC, Packet[i]);
+    }
+    if ((Packet[Length - 2] != (CRC & 0xFF)) || (Packet[Length - 1] != (CRC >> 8)))
+    {
+        return; // Damaged packet, the host will time out and retry
+    }
+    Length -= 3; // Payload length
+    switch (Packet[0])
+    {
+    case BIN_MSG_CONFIG_SET:
+        if ((Length < 3) || !SetConfigField((const char *)&Packet[1], &Packet[4], Length - 3))
+        {
+            BinSendByte(BIN_MSG_ERROR, Packet[0]);
+            break;
+        }
+        // Fall through and reply with the new value
+
+    case BIN_MSG_CONFIG_GET:
+        memcpy(Reply, &Packet[1], 3);
+        Size = (Length >= 3) ? GetConfigField((const char *)&Packet[1], &Reply[3]) : 0;
+        if (Size == 0)
+        {
+            BinSendByte(BIN_MSG_ERROR, Packet[0]);
+            break;
+        }
+        BinSend(BIN_MSG_CONFIG_VALUE, Reply, Size + 3);
+        break;
+
+    case BIN_MSG_TEXT_COMMAND:
+        Packet[Length + 1] = 0; // Zero terminate the command in place of the CRC
+        DecodeSerialCMD((const char *)&Packet[1]);
+        break;
+
+    case BIN_MSG_TEXT_MODE:
+        BinaryMode = false;
+        Serial.println(F("{CBM} F"));
+        break;
+
+    default:
+        BinSendByte(BIN_MSG_ERROR, Packet[0]);
+    }
+}
+
+// Collects a frame up to the zero delimiter and decodes it in place
+void BinReceiveByte(uint8_t InByte)
+{
+    static uint8_t Frame[BIN_MAX_PAYLOAD + 5]; // Packet and COBS overhead
+    static uint8_t FramePos = 0;
+    uint8_t In = 0, Out = 0, Code;
+
+    if (InByte != 0)
+    {
+        if (FramePos < sizeof(Frame))
+        {
+            Frame[FramePos++] = InByte;
+        }
+        else
+        {
+            FramePos = sizeof(Frame) + 1; // Too long, held here so it can not wrap back in to range, dropped at the delimiter
+        }
+        return;
+    }
+    if ((FramePos == 0) || (FramePos > sizeof(Frame)))
+    {
+        FramePos = 0;
+        return;
+    }
+    while (In < FramePos)
+    {
+        Code = Frame[In++];
+        for (uint8_t i = 1; (i < Code) && (In < FramePos); i++)
+        {
+            Frame[Out++] = Frame[In++];
+        }
+        if ((Code < 0xFF) && (In < FramePos))
+        {
+            Frame[Out++] = 0;
+        }
+    }
+    FramePos = 0;
+    BinDecodePacket(Frame, Out);
+}
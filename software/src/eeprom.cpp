@@ -2,13 +2,14 @@
 #include "defines.hpp"
 #include "datatypes.hpp"
 #include <EEPROM.h>
+#include <stddef.h>
 
 extern S_FactoryData FactoryData; // TODO: replace with getters and setters
 extern S_GadgetData GadgetData;   // TODO: replace with getters and setters
 
 // CRC calculation from Christopher Andrews : https://www.arduino.cc/en/Tutorial/EEPROMCrc
-// Calculate CRC on either Factory data or Userspace data
-unsigned long GetEEPROM_CRC(boolean EEPROMSpace)
+// Calculate CRC on Length bytes of EEPROM from Start
+static unsigned long EEPROMRangeCRC(int Start, int Length)
 {
 
     const unsigned long crc_table[16] = {
@@ -18,19 +19,7 @@ unsigned long GetEEPROM_CRC(boolean EEPROMSpace)
         0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c};
 
     unsigned long crc = ~0L;
-    int Start;
-    int Length;
 
-    if (EEPROMSpace == FactorySpace)
-    {
-        Start = 400;
-        Length = sizeof(FactoryData);
-    }
-    else
-    {
-        Start = 0;
-        Length = sizeof(GadgetData);
-    }
     for (int index = Start; index < (Start + Length); ++index)
     {
         crc = crc_table[(crc ^ EEPROM[index]) & 0x0f] ^ (crc >> 4);
@@ -40,6 +29,16 @@ unsigned long GetEEPROM_CRC(boolean EEPROMSpace)
     return crc;
 }
 
+// Calculate CRC on either Factory data or Userspace data
+unsigned long GetEEPROM_CRC(boolean EEPROMSpace)
+{
+    if (EEPROMSpace == FactorySpace)
+    {
+        return EEPROMRangeCRC(400, sizeof(FactoryData));
+    }
+    return EEPROMRangeCRC(0, sizeof(GadgetData));
+}
+
 // Load FactoryData or UserSpace Data from ATMega EEPROM
 bool LoadFromEPROM(boolean EEPROMSpace)
 {
@@ -62,6 +61,14 @@ bool LoadFromEPROM(boolean EEPROMSpace)
         CalculatedCRC = GetEEPROM_CRC(UserSpace); // Calculate the CRC of the data
     }
     EEPROM.get(Start + Length, CRCFromEEPROM); // Load the saved CRC at the end of the data
+    if ((EEPROMSpace == FactorySpace) && (CRCFromEEPROM != CalculatedCRC))
+    {
+        // Factory data saved before the ADC bandgap calibration was added has its CRC right after the filter bands, keep that data
+        Length = offsetof(S_FactoryData, Bandgap);
+        EEPROM.get(Start + Length, CRCFromEEPROM);
+        CalculatedCRC = EEPROMRangeCRC(Start, Length);
+        FactoryData.Bandgap = 0; // Not calibrated, the ADC uses the nominal 1.1V
+    }
     return (CRCFromEEPROM == CalculatedCRC);   // If  Stored and Calculated CRC are the same return true
 }
 
@@ -0,0 +1,137 @@
+#include "energy.hpp"
+#include "defines.hpp"
+#include <EEPROM.h>
+
+#define ENERGY_MAGIC 0xE1ED // Marks a saved ledger, an erased EEPROM reads 0xFFFF
+
+// The ledger as it is kept in EEPROM
+struct S_EnergyLedger
+{
+    uint16_t Magic;
+    uint32_t Current[ENERGY_STATES]; // Current of each state in microampere
+    uint32_t Seconds[ENERGY_STATES]; // Time spent in each state, a relay state counts once per energized relay
+};
+
+static S_EnergyLedger Ledger;
+static uint16_t Millis[ENERGY_STATES]; // Milliseconds not yet added to Seconds
+static uint8_t Active[ENERGY_STATES];  // Number of times each state is on, 0 when off
+static unsigned long LastUpdate;       // millis() when the time up to now was last added
+static uint32_t SavedAt;               // Seconds of MCU time, awake and asleep, in the ledger when it was last saved
+
+static const uint32_t DefaultCurrents[ENERGY_STATES] PROGMEM = {ENERGY_CURRENT_MCU, ENERGY_CURRENT_SLEEP, ENERGY_CURRENT_GPS,
+                                                                 ENERGY_CURRENT_SI5351, ENERGY_CURRENT_TX, ENERGY_CURRENT_RELAY};
+
+static void AddTime(uint8_t State, uint32_t Time)
+{
+    Time += Millis[State];
+    Ledger.Seconds[State] += Time / 1000;
+    Millis[State] = Time % 1000;
+}
+
+// Adds the time since the last update to every state that is on
+static void Account()
+{
+    unsigned long Elapsed = millis() - LastUpdate;
+
+    LastUpdate += Elapsed;
+    for (uint8_t i = 0; i < ENERGY_STATES; i++)
+    {
+        if (Active[i] != 0)
+        {
+            AddTime(i, Elapsed * Active[i]);
+        }
+    }
+}
+
+// Loads the ledger from EEPROM, or starts an empty one with the default currents. The MCU, GPS and Si5351 are on after a reset
+void EnergyInit()
+{
+    EEPROM.get(ENERGY_EEPROM, Ledger);
+    if (Ledger.Magic != ENERGY_MAGIC)
+    {
+        Ledger.Magic = ENERGY_MAGIC;
+        memcpy_P(Ledger.Current, DefaultCurrents, sizeof(Ledger.Current));
+        EnergyClear();
+    }
+    SavedAt = Ledger.Seconds[ENERGY_MCU] + Ledger.Seconds[ENERGY_SLEEP];
+    Active[ENERGY_MCU] = 1;
+    Active[ENERGY_GPS] = 1;
+    Active[ENERGY_SI5351] = 1;
+    LastUpdate = millis();
+}
+
+// Turns a state on or off, Count is the number of relays for ENERGY_RELAY and 1 for on otherwise. Cheap enough to call on every change
+void EnergyState(uint8_t State, uint8_t Count)
+{
+    if (Active[State] != Count)
+    {
+        Account();
+        Active[State] = Count;
+    }
+}
+
+// Books a power down of Millis milliseconds, millis() does not count while the MCU sleeps.
+// States left on, like a Si5351 without power switch, go on drawing current. The relays do not, AllIOtoLow drives
+// their pins low for the sleep and they are energized again when the pins are restored
+void EnergySlept(uint32_t Millis)
+{
+    Account();
+    AddTime(ENERGY_SLEEP, Millis);
+    for (uint8_t i = ENERGY_SLEEP + 1; i < ENERGY_STATES; i++)
+    {
+        if ((Active[i] != 0) && (i != ENERGY_RELAY))
+        {
+            AddTime(i, Millis * Active[i]);
+        }
+    }
+}
+
+// Saves the ledger once ENERGY_SAVE_INTERVAL has passed since the last save. Call it where a few ms of EEPROM writes do not matter.
+// The interval is taken from the MCU time in the ledger, which keeps the milliseconds between calls, so calling it often is fine
+void EnergySaveIfDue()
+{
+    Account();
+    if (Ledger.Seconds[ENERGY_MCU] + Ledger.Seconds[ENERGY_SLEEP] - SavedAt >= ENERGY_SAVE_INTERVAL)
+    {
+        EnergySave();
+    }
+}
+
+void EnergySave()
+{
+    Account();
+    EEPROM.put(ENERGY_EEPROM, Ledger); // Only the bytes that changed are written
+    SavedAt = Ledger.Seconds[ENERGY_MCU] + Ledger.Seconds[ENERGY_SLEEP];
+}
+
+// Starts the ledger over, the currents are kept
+void EnergyClear()
+{
+    memset(Ledger.Seconds, 0, sizeof(Ledger.Seconds));
+    memset(Millis, 0, sizeof(Millis));
+    LastUpdate = millis();
+    SavedAt = 0;
+}
+
+uint32_t EnergySeconds(uint8_t State)
+{
+    Account();
+    return Ledger.Seconds[State];
+}
+
+// Charge drawn in a state in microampere hours
+uint32_t EnergyCharge(uint8_t State)
+{
+    return ((uint64_t)EnergySeconds(State) * Ledger.Current[State] + 1800) / 3600;
+}
+
+uint32_t EnergyCurrent(uint8_t State)
+{
+    return Ledger.Current[State];
+}
+
+// Sets the current of a state in microampere, it also applies to the time already in the ledger
+void EnergySetCurrent(uint8_t State, uint32_t Current)
+{
+    Ledger.Current[State] = Current;
+}
@@ -1,6 +1,8 @@
 #include "filter_management.hpp"
 #include "defines.hpp"
-#include "state_machine.hpp"
+#include "datatypes.hpp"
+#include "telemetry.hpp"
+#include "energy.hpp"
 
 
 extern uint8_t CurrentLP;         // Keep track on what Low Pass filter is currently switched in
@@ -15,7 +17,8 @@ void DriveLPFilters()
     }
     else
     {
-        SendAPIUpdate(UMesLPF);
+        TelemetryPost(UMesLPF);
+        EnergyState(ENERGY_RELAY, (CurrentLP == LP_A) ? 0 : ((CurrentLP == LP_D) ? 2 : 1)); // Filter A has all relays at rest, D needs two of them
         // Product model 1011 E.g WSPR-TX LP1, this will drive the relays on the optional Mezzanine LP4 and Mezzanine BLP4 cards
         if ((Product_Model == 1011) || (Product_Model == 1020) || (Product_Model == 1029))
         {
@@ -1,28 +1,195 @@
 #include "geofence.hpp"
 
-// GeoFence grids by Matt Downs - 2E1GYP and Harry Zachrisson - SM7PNV , save some RAM by putting the string in program memmory
-const char NoTXGrids[] PROGMEM = {"IO78 IO88 IO77 IO87 IO76 IO86 IO75 IO85 IO84 IO94 IO83 IO93 IO82 IO92 JO02 IO81 IO91 JO01 IO70 IO80 IO90 IO64 PN31 PN41 PN20 PN30 PN40 PM29 PM39 PM28 PM38 LK16 LK15 LK14 LK13 LK23 LK24 LK25 LK26 LK36 LK35 LK34 LK33 LK44 LK45 LK46 LK47 LK48 LK58 LK57 LK56 LK55"}; // Airborne transmissions of this sort are not legal over the UK, North Korea, or Yemen.
+// GeoFence grids by Matt Downs - 2E1GYP and Harry Zachrisson - SM7PNV. Airborne transmissions of this sort are not legal over the UK, North Korea, or Yemen.
+// The grids can be listed in any order, at compile time they are turned in to a sorted table of grid codes in program memory
+constexpr const char *NoTXGrids[] = {
+    "IO78", "IO88", "IO77", "IO87", "IO76", "IO86", "IO75", "IO85", "IO84", "IO94", "IO83", "IO93", "IO82", "IO92", "JO02", "IO81", "IO91", "JO01", "IO70", "IO80", "IO90", "IO64", // UK
+    "PN31", "PN41", "PN20", "PN30", "PN40", "PM29", "PM39", "PM28", "PM38",                                                                                                         // North Korea
+    "LK16", "LK15", "LK14", "LK13", "LK23", "LK24", "LK25", "LK26", "LK36", "LK35", "LK34", "LK33", "LK44", "LK45", "LK46", "LK47", "LK48", "LK58", "LK57", "LK56", "LK55"};        // Yemen
+
+#define NO_TX_GRID_COUNT (sizeof(NoTXGrids) / sizeof(NoTXGrids[0]))
+
+// Polygon fences for borders that do not follow the grid lines, checked against the GPS position when it is in a grid that a polygon reaches in to.
+// Example:
+//   const S_GeoPoint ExampleFence[] PROGMEM = {{515000000, -1000000}, {515000000, 1000000}, {505000000, 0}};
+// and add {ExampleFence, 3} to the list below
+const S_GeoPolygon NoTXPolygons[] PROGMEM = {
+    {NULL, 0}}; // End of list
+
+// Four character Maidenhead grid as a number 0-32399, ordered the same way as the grid names sort
+constexpr uint16_t GridCodeOf(const char *Grid)
+{
+    return (((Grid[0] - 'A') * 18 + (Grid[1] - 'A')) * 10 + (Grid[2] - '0')) * 10 + (Grid[3] - '0');
+}
+
+uint16_t GridCode(const char *Grid)
+{
+    return GridCodeOf(Grid);
+}
+
+// The helpers below split the list in halves so the constexpr recursion depth only grows with log2 of the number of grids
+
+// Number of fenced grids in the list range Low to High - 1 with a lower grid code than grid i
+constexpr uint16_t GridRank(uint16_t i, uint16_t Low = 0, uint16_t High = NO_TX_GRID_COUNT)
+{
+    return (High - Low == 1) ? (GridCodeOf(NoTXGrids[Low]) < GridCodeOf(NoTXGrids[i])) : GridRank(i, Low, (Low + High) / 2) + GridRank(i, (Low + High) / 2, High);
+}
+
+// Number of grids in the list range Low to High - 1 with the same grid code as grid i
+constexpr uint16_t GridMatches(uint16_t i, uint16_t Low = 0, uint16_t High = NO_TX_GRID_COUNT)
+{
+    return (High - Low == 1) ? (GridCodeOf(NoTXGrids[Low]) == GridCodeOf(NoTXGrids[i])) : GridMatches(i, Low, (Low + High) / 2) + GridMatches(i, (Low + High) / 2, High);
+}
+
+// True if no grid is listed twice, a duplicate would leave a hole in the sorted table
+constexpr boolean GridsUnique(uint16_t Low = 0, uint16_t High = NO_TX_GRID_COUNT)
+{
+    return (High - Low == 1) ? (GridMatches(Low) == 1) : GridsUnique(Low, (Low + High) / 2) && GridsUnique((Low + High) / 2, High);
+}
+
+// Grid code at position k of the sorted table, the one grid with rank k is found in the list range Low to High - 1
+constexpr uint16_t SortedGridCode(uint16_t k, uint16_t Low = 0, uint16_t High = NO_TX_GRID_COUNT)
+{
+    return (High - Low == 1) ? ((GridRank(Low) == k) ? GridCodeOf(NoTXGrids[Low]) : 0) : SortedGridCode(k, Low, (Low + High) / 2) | SortedGridCode(k, (Low + High) / 2, High);
+}
+
+static_assert(GridsUnique(), "A grid is listed more than once in NoTXGrids");
+
+// The sorted table, SortedGridCode(0) to SortedGridCode(NO_TX_GRID_COUNT - 1) expanded by the compiler
+template <uint16_t... K>
+struct S_GridTable
+{
+    static const uint16_t Codes[sizeof...(K)];
+};
+template <uint16_t... K>
+const uint16_t S_GridTable<K...>::Codes[sizeof...(K)] PROGMEM = {SortedGridCode(K)...};
+template <uint16_t N, uint16_t... K>
+struct S_MakeGridTable : S_MakeGridTable<N - 1, N - 1, K...>
+{
+};
+template <uint16_t... K>
+struct S_MakeGridTable<0, K...> : S_GridTable<K...>
+{
+};
+
+#define NoTXGridTable S_MakeGridTable<NO_TX_GRID_COUNT>::Codes
+
+// Binary search for a grid code in the sorted table
+static boolean GridFenced(uint16_t Code)
+{
+    uint16_t Low = 0;
+    uint16_t High = NO_TX_GRID_COUNT;
+    uint16_t Mid, MidCode;
+
+    while (Low < High)
+    {
+        Mid = (Low + High) / 2;
+        MidCode = pgm_read_word(&NoTXGridTable[Mid]);
+        if (MidCode == Code)
+        {
+            return true;
+        }
+        if (MidCode < Code)
+        {
+            Low = Mid + 1;
+        }
+        else
+        {
+            High = Mid;
+        }
+    }
+    return false;
+}
+
+// True if the bounding box of a polygon overlaps the grid square (2 by 1 degrees) with the given grid code
+static boolean PolygonNearGrid(const S_GeoPolygon &Polygon, uint16_t Code)
+{
+    S_GeoPoint Point;
+    int32_t MinLat, MaxLat, MinLon, MaxLon;
+    int32_t GridLat = ((Code / 100) % 18 * 10 + Code % 10 - 90) * 10000000L;         // South edge of the grid
+    int32_t GridLon = ((Code / 1800) * 20 + (Code / 10) % 10 * 2 - 180) * 10000000L; // West edge of the grid
+
+    memcpy_P(&Point, &Polygon.Points[0], sizeof(Point));
+    MinLat = MaxLat = Point.Lat;
+    MinLon = MaxLon = Point.Lon;
+    for (uint8_t i = 1; i < Polygon.Count; i++)
+    {
+        memcpy_P(&Point, &Polygon.Points[i], sizeof(Point));
+        if (Point.Lat < MinLat)
+            MinLat = Point.Lat;
+        if (Point.Lat > MaxLat)
+            MaxLat = Point.Lat;
+        if (Point.Lon < MinLon)
+            MinLon = Point.Lon;
+        if (Point.Lon > MaxLon)
+            MaxLon = Point.Lon;
+    }
+    return (MaxLat >= GridLat) && (MinLat <= GridLat + 10000000L) && (MaxLon >= GridLon) && (MinLon <= GridLon + 20000000L);
+}
+
+// Crossing number point in polygon test in integer math, a ray is sent east from the point and the edges it crosses are counted
+boolean InsidePolygon(const S_GeoPolygon &Polygon, int32_t Lat, int32_t Lon)
+{
+    S_GeoPoint A, B;
+    boolean Inside = false;
+    int64_t Left, Right;
+
+    memcpy_P(&A, &Polygon.Points[Polygon.Count - 1], sizeof(A));
+    for (uint8_t i = 0; i < Polygon.Count; i++)
+    {
+        memcpy_P(&B, &Polygon.Points[i], sizeof(B));
+        if ((A.Lat > Lat) != (B.Lat > Lat)) // The edge spans the latitude of the point
+        {
+            // The point is west of the edge if (Lon - A.Lon) < (Lat - A.Lat) * (B.Lon - A.Lon) / (B.Lat - A.Lat), multiplied out to stay in integers
+            Left = ((int64_t)Lon - A.Lon) * ((int64_t)B.Lat - A.Lat);
+            Right = ((int64_t)Lat - A.Lat) * ((int64_t)B.Lon - A.Lon);
+            if ((B.Lat > A.Lat) ? (Left < Right) : (Left > Right))
+            {
+                Inside = !Inside;
+            }
+        }
+        A = B;
+    }
+    return Inside;
+}
 
 // GeoFence, do not transmit over Yemen, North Korea and the UK
 // GeoFence code by Matt Downs - 2E1GYP and Harry Zachrisson - SM7PNV
-// Defined by the NoTXGrids that holds all the Maidehead grids for these locations
-boolean OutsideGeoFence(S_WSPRData WSPRData)
+// The grid lookup only runs when MaidenHead4 changes, the result is kept together with a flag telling if any polygon
+// reaches in to the grid. Only then is the position (Lat and Lon in 1e-7 degrees) tested against the polygons
+boolean OutsideGeoFence(const S_WSPRData &WSPRData, int32_t Lat, int32_t Lon)
 {
-    char TestGrid[4];
-    boolean Outside;
+    static uint16_t CachedCode = 0xFFFF; // Grid code the cached result is for, 0xFFFF is no grid
+    static boolean CachedGridFenced;     // The grid is in the NoTXGrids list
+    static boolean CachedPolygonNear;    // At least one polygon overlaps the grid
+    S_GeoPolygon Polygon;
+    uint16_t Code = GridCodeOf(WSPRData.MaidenHead4);
 
-    Outside = true;
-    for (uint16_t GridLoop = 0; GridLoop < strlen_P(NoTXGrids); GridLoop = GridLoop + 5)
-    { // Itterate between Geo-Fenced grids
-        for (uint16_t CharLoop = 0; CharLoop < 4; CharLoop++)
+    if (Code != CachedCode)
+    {
+        CachedCode = Code;
+        CachedGridFenced = GridFenced(Code);
+        CachedPolygonNear = false;
+        for (uint8_t i = 0; pgm_read_byte(&NoTXPolygons[i].Count) != 0; i++)
         {
-            TestGrid[CharLoop] = pgm_read_byte_near(NoTXGrids + CharLoop + GridLoop); // Copy a Grid string from program memory to RAM variable.
+            memcpy_P(&Polygon, &NoTXPolygons[i], sizeof(Polygon));
+            CachedPolygonNear |= PolygonNearGrid(Polygon, Code);
         }
-        if ((WSPRData.MaidenHead4[0] == TestGrid[0]) && (WSPRData.MaidenHead4[1] == TestGrid[1]) && (WSPRData.MaidenHead4[2] == TestGrid[2]) && (WSPRData.MaidenHead4[3] == TestGrid[3]))
+    }
+    if (CachedGridFenced)
+    {
+        return false; // We are in a Geo-Fenced Grid
+    }
+    if (CachedPolygonNear)
+    {
+        for (uint8_t i = 0; pgm_read_byte(&NoTXPolygons[i].Count) != 0; i++)
         {
-            Outside = false; // We found a match between the current location and a Geo-Fenced Grid
+            memcpy_P(&Polygon, &NoTXPolygons[i], sizeof(Polygon));
+            if (InsidePolygon(Polygon, Lat, Lon))
+            {
+                return false;
+            }
         }
     }
-
-    return Outside;
-}
\ No newline at end of file
+    return true;
+}
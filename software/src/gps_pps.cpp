@@ -0,0 +1,157 @@
+#include "gps_pps.hpp"
+#include "defines.hpp"
+#include "datatypes.hpp"
+#include "Si5351.hpp"
+#include <avr/sleep.h>
+#include <util/atomic.h>
+
+extern S_FactoryData FactoryData; // TODO: replace with getters and setters
+
+// GPS PPS on the Timer1 input capture pin (ICP1)
+// When waiting for a transmission start Timer1 runs from F_CPU/256, the same timebase as the symbol clock,
+// so the PPS capture can be used directly as the start time of the first WSPR symbol.
+// When calibrating, Timer1 is instead clocked by the Si5351 CLK2 on the T1 pin and the captures of
+// consecutive PPS edges give the number of CLK2 cycles per GPS second.
+
+volatile uint16_t PPSOverflows;    // Timer1 overflows, extends the Timer1 count to 32 bits while calibrating
+volatile uint32_t PPSCapture;      // Extended Timer1 count at the last PPS edge
+volatile uint32_t PPSFirstCapture; // Extended Timer1 count at the first PPS edge after arming
+volatile uint8_t PPSCount;         // Number of PPS edges since arming
+
+uint32_t RefCal;          // Measured reference oscillator frequency in Hz
+boolean RefCalValid;      // True when RefCal holds at least one good measurement
+boolean RefCalDue = true; // Set after each transmission so a new measurement is done while waiting for the next one
+
+ISR(TIMER1_CAPT_vect)
+{
+    uint16_t Capture = ICR1;
+    uint16_t Overflows = PPSOverflows;
+
+    if ((TIFR1 & (1 << TOV1)) && (Capture < 0x8000)) // Timer1 overflowed just before the capture but the overflow interrupt has not run yet
+    {
+        Overflows++;
+    }
+    PPSCapture = ((uint32_t)Overflows << 16) | Capture;
+    if (PPSCount == 0)
+    {
+        PPSFirstCapture = PPSCapture;
+    }
+    PPSCount++;
+}
+
+ISR(TIMER1_OVF_vect)
+{
+    PPSOverflows++;
+}
+
+void PPSInit()
+{
+    pinMode(GPSPPS, INPUT);
+    pinMode(SiCalInput, INPUT);
+}
+
+// Arm the input capture and clear the counters, TCCR1BClock selects the Timer1 clock source
+static void PPSArm(uint8_t TCCR1BClock, uint8_t Interrupts)
+{
+    TIMSK1 = 0;
+    TCCR1A = 0;                                         // Normal mode, no output compare pins
+    TCCR1B = (1 << ICNC1) | (1 << ICES1) | TCCR1BClock; // Capture on the rising PPS edge with the noise canceler on
+    PPSOverflows = 0;
+    PPSCount = 0;
+    TIFR1 = (1 << ICF1) | (1 << TOV1); // Clear any pending capture or overflow
+    TIMSK1 = Interrupts;
+}
+
+// Idle-sleep until at least Edges PPS edges have been captured, returns false on timeout (in milliseconds)
+// Service, if not NULL, is called every time the CPU wakes up. Any interrupt wakes it, so the GPS receive interrupt does too
+static boolean PPSWaitForCount(uint8_t Edges, uint16_t Timeout, PPSService Service)
+{
+    uint32_t StartTime = millis();
+
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    while (PPSCount < Edges)
+    {
+        if (Service != NULL)
+        {
+            Service();
+        }
+        if ((millis() - StartTime) > Timeout)
+        {
+            return false;
+        }
+        cli();
+        if (PPSCount < Edges)
+        {
+            sleep_enable();
+            sei(); // The instruction after sei is always executed so the capture interrupt can not sneak in before we sleep
+            sleep_cpu();
+            sleep_disable();
+        }
+        sei();
+    }
+    return true;
+}
+
+// Wait for the next PPS edge and return its Timer1 time in CaptureTime
+// Timer1 is left free running at F_CPU/256 so the symbol clock can be started from the capture
+boolean PPSWaitForEdge(uint16_t Timeout, uint16_t *CaptureTime)
+{
+    boolean Result;
+
+    PPSArm((1 << CS12), (1 << ICIE1)); // Prescaler 256, same as the symbol clock
+    Result = PPSWaitForCount(1, Timeout, NULL);
+    TIMSK1 &= ~(1 << ICIE1);
+    *CaptureTime = (uint16_t)PPSCapture;
+    return Result;
+}
+
+// Measure the Si5351 reference oscillator against GPS time by counting CLK2 cycles over Seconds PPS intervals
+// The result is averaged in to a running correction that CalibratedRefFreq returns
+// Needs a GPS fix as the GPS only outputs the PPS when it has one
+// The measurement takes Seconds+1 seconds, far longer than the GPS receive buffer lasts, so Service has to empty it while we wait
+boolean PPSCalibrateRef(uint8_t Seconds, PPSService Service)
+{
+    uint32_t Counts;
+    uint32_t Measured;
+    boolean Result = false;
+
+    RefCalDue = false; // Do not retry until after the next transmission, even if this measurement fails
+    si5351aCalibrationOutput(true);
+    PPSArm((1 << CS12) | (1 << CS11) | (1 << CS10), (1 << ICIE1) | (1 << TOIE1)); // Timer1 clocked from CLK2 on the T1 pin, rising edge
+    if (PPSWaitForCount(Seconds + 1, (Seconds + 2) * 1000U, Service))
+    {
+        TIMSK1 = 0;
+        Counts = PPSCapture - PPSFirstCapture;                                                  // CLK2 cycles in Seconds GPS seconds
+        Measured = ((uint64_t)Counts * SI_CAL_DIVIDER) / (SI_CAL_PLL_MULT * (uint32_t)Seconds); // CLK2 is RefFreq*SI_CAL_PLL_MULT/SI_CAL_DIVIDER
+        // Reject anything more than 500ppm from the factory value, likely a missed PPS edge
+        if (labs((int32_t)(Measured - FactoryData.RefFreq)) < (int32_t)(FactoryData.RefFreq / 2000))
+        {
+            if (RefCalValid)
+            {
+                RefCal += (int32_t)(Measured - RefCal) / 4; // Running average to smooth out the PPS jitter while still tracking temperature drift
+            }
+            else
+            {
+                RefCal = Measured;
+                RefCalValid = true;
+            }
+            Result = true;
+            Serial.print(F("{MIN} Reference oscillator "));
+            Serial.println(RefCal);
+        }
+    }
+    TIMSK1 = 0;
+    TCCR1B = (1 << CS12); // Back to F_CPU/256
+    si5351aCalibrationOutput(false);
+    return Result;
+}
+
+// Reference oscillator frequency to use when setting up the Si5351
+uint32_t CalibratedRefFreq()
+{
+    if (PPS_Mode && RefCalValid)
+    {
+        return RefCal;
+    }
+    return FactoryData.RefFreq;
+}
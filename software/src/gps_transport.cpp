@@ -0,0 +1,323 @@
+#include "gps_transport.hpp"
+#include "defines.hpp"
+#include <util/atomic.h>
+
+GPSTransport GPSSerial; // GPS Serial port
+
+#if GPS_Transport == GPS_TRANSPORT_UART
+
+// The GPS is wired to a hardware UART, just pass everything through
+void GPSTransport::begin(unsigned long Baud)
+{
+    GPS_UART.begin(Baud);
+}
+
+void GPSTransport::end()
+{
+    GPS_UART.end();
+}
+
+int GPSTransport::available()
+{
+    return GPS_UART.available();
+}
+
+int GPSTransport::read()
+{
+    return GPS_UART.read();
+}
+
+int GPSTransport::peek()
+{
+    return GPS_UART.peek();
+}
+
+size_t GPSTransport::write(uint8_t Data)
+{
+    return GPS_UART.write(Data);
+}
+
+void GPSTransport::flush()
+{
+    GPS_UART.flush();
+}
+
+uint16_t GPSTransportFeed(const uint8_t *Data, uint16_t Length) // The UART has its own buffer, nothing can be fed in
+{
+    (void)Data;
+    (void)Length;
+    return 0;
+}
+
+uint16_t GPSTransportOverruns() // Not counted by the Arduino core
+{
+    return 0;
+}
+
+#else
+
+// Receive ring buffer, written from the receiver interrupt (or GPSTransportFeed) and read by the NMEA parser
+volatile uint8_t RxBuffer[GPS_RX_BUFFER_SIZE];
+volatile uint8_t RxHead;      // Next position to write
+volatile uint8_t RxTail;      // Next position to read
+volatile uint16_t RxOverruns; // Bytes received while the buffer was full, stops at 0xFFFF
+
+// Returns false if the buffer is full and the byte was not stored
+static inline boolean RxPut(uint8_t Data)
+{
+    uint8_t Next = (RxHead + 1) & (GPS_RX_BUFFER_SIZE - 1);
+
+    if (Next == RxTail)
+    {
+        return false;
+    }
+    RxBuffer[RxHead] = Data;
+    RxHead = Next;
+    return true;
+}
+
+#if GPS_Transport == GPS_TRANSPORT_REPLAY
+static void RxRefill();
+#else
+static inline void RxRefill() // Only the receiver interrupt fills the buffer
+{
+}
+#endif
+
+int GPSTransport::available()
+{
+    RxRefill();
+    return (RxHead - RxTail) & (GPS_RX_BUFFER_SIZE - 1);
+}
+
+int GPSTransport::read()
+{
+    uint8_t Data;
+
+    RxRefill();
+    if (RxHead == RxTail)
+    {
+        return -1;
+    }
+    Data = RxBuffer[RxTail];
+    RxTail = (RxTail + 1) & (GPS_RX_BUFFER_SIZE - 1);
+    return Data;
+}
+
+int GPSTransport::peek()
+{
+    RxRefill();
+    if (RxHead == RxTail)
+    {
+        return -1;
+    }
+    return RxBuffer[RxTail];
+}
+
+// Put recorded NMEA data in to the receive buffer as if it came from the GPS. Returns the number of bytes taken, less than
+// Length when the buffer is full. The rest must be fed again once the parser has read some, nothing is dropped
+uint16_t GPSTransportFeed(const uint8_t *Data, uint16_t Length)
+{
+    uint16_t Taken = 0;
+
+    while ((Taken < Length) && RxPut(Data[Taken]))
+    {
+        Taken++;
+    }
+    return Taken;
+}
+
+// Bytes the receiver lost because the parser did not keep up, since begin(). A broken sentence is then rejected by its checksum
+uint16_t GPSTransportOverruns()
+{
+    uint16_t Overruns;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        Overruns = RxOverruns;
+    }
+    return Overruns;
+}
+
+#if GPS_Transport == GPS_TRANSPORT_SOFT
+
+// Soft UART on pin 2 (RX) and pin 3 (TX), 8N1
+// The falling edge of the start bit triggers INT0, the data bits are then sampled in the middle by the Timer2 compare A interrupt.
+// TX bits are shifted out by the Timer2 compare B interrupt. Timer2 is free running at F_CPU/8 while the port is open.
+// Unlike SoftwareSerial, interrupts are never disabled for a whole character so the Timer1 symbol clock and the TWI driver keep running.
+#define GPS_RX_ISR_TICKS 3 // Cycles from the start bit edge to reading TCNT2 in the INT0 interrupt, in Timer2 ticks
+
+uint8_t BitTicks;                              // Timer2 ticks per bit
+volatile uint8_t RxBit;                        // Number of data bits received of the current character
+volatile uint8_t RxShift;                      // Current character being received
+volatile uint8_t TxBuffer[GPS_TX_BUFFER_SIZE]; // Characters waiting to be sent
+volatile uint8_t TxHead;                       // Next position to write
+volatile uint8_t TxTail;                       // Next position to send
+volatile uint16_t TxShift;                     // Start, data and stop bits of the character currently being sent
+volatile uint8_t TxBit;                        // Number of bits left to send of the current character
+
+ISR(INT0_vect)
+{
+    OCR2A = TCNT2 + BitTicks + (BitTicks >> 1) - GPS_RX_ISR_TICKS; // Middle of the first data bit
+    EIMSK &= ~(1 << INT0);                                         // No more edges until the stop bit
+    RxBit = 0;
+    TIFR2 = (1 << OCF2A);
+    TIMSK2 |= (1 << OCIE2A);
+}
+
+ISR(TIMER2_COMPA_vect)
+{
+    OCR2A += BitTicks;
+    if (RxBit < 8)
+    {
+        RxShift >>= 1;
+        if (PIND & (1 << PIND2))
+        {
+            RxShift |= 0x80;
+        }
+        RxBit++;
+    }
+    else // Middle of the stop bit
+    {
+        TIMSK2 &= ~(1 << OCIE2A);
+        if (PIND & (1 << PIND2)) // Only keep the character if the stop bit is valid
+        {
+            if (!RxPut(RxShift) && (RxOverruns != 0xFFFF))
+            {
+                RxOverruns++;
+            }
+        }
+        EIFR = (1 << INTF0); // Forget edges from the data bits
+        EIMSK |= (1 << INT0);
+    }
+}
+
+ISR(TIMER2_COMPB_vect)
+{
+    OCR2B += BitTicks;
+    if (TxBit == 0)
+    {
+        if (TxHead == TxTail) // Nothing more to send
+        {
+            TIMSK2 &= ~(1 << OCIE2B);
+            return;
+        }
+        TxShift = ((uint16_t)TxBuffer[TxTail] << 1) | 0x200; // Start bit low, stop bit high
+        TxTail = (TxTail + 1) & (GPS_TX_BUFFER_SIZE - 1);
+        TxBit = 10;
+    }
+    if (TxShift & 1)
+    {
+        PORTD |= (1 << PORTD3);
+    }
+    else
+    {
+        PORTD &= ~(1 << PORTD3);
+    }
+    TxShift >>= 1;
+    TxBit--;
+}
+
+void GPSTransport::begin(unsigned long Baud)
+{
+    BitTicks = (F_CPU / 8) / Baud;
+    RxHead = RxTail = 0;
+    RxOverruns = 0;
+    TxHead = TxTail = 0;
+    TxBit = 0;
+    pinMode(2, INPUT_PULLUP);
+    pinMode(3, OUTPUT);
+    digitalWrite(3, HIGH); // Idle level
+    TCCR2A = 0;            // Normal mode, no output compare pins
+    TCCR2B = (1 << CS21);  // Prescaler 8
+    TIMSK2 = 0;
+    EICRA = (EICRA & ~((1 << ISC01) | (1 << ISC00))) | (1 << ISC01); // INT0 on falling edge
+    EIFR = (1 << INTF0);
+    EIMSK |= (1 << INT0);
+}
+
+void GPSTransport::end()
+{
+    flush();
+    EIMSK &= ~(1 << INT0);
+    TIMSK2 = 0;
+    TCCR2B = 0; // Stop Timer2
+}
+
+// Queue a character for sending, only waits if the TX buffer is full
+size_t GPSTransport::write(uint8_t Data)
+{
+    uint8_t Next = (TxHead + 1) & (GPS_TX_BUFFER_SIZE - 1);
+
+    while (Next == TxTail)
+        ; // Buffer full, wait for the compare B interrupt to make room
+    TxBuffer[TxHead] = Data;
+    TxHead = Next;
+    if (!(TIMSK2 & (1 << OCIE2B))) // Transmitter idle, start it
+    {
+        cli();
+        OCR2B = TCNT2 + 2;
+        TIFR2 = (1 << OCF2B);
+        TIMSK2 |= (1 << OCIE2B);
+        sei();
+    }
+    return 1;
+}
+
+// Wait until everything in the TX buffer has been sent
+void GPSTransport::flush()
+{
+    while (TIMSK2 & (1 << OCIE2B))
+        ;
+}
+
+#else // GPS_TRANSPORT_REPLAY
+
+static GPSReplaySource ReplaySource; // Asked for more data whenever the parser looks at the receive buffer
+static GPSReplaySink ReplaySink;     // Gets the commands sent to the GPS
+
+// Takes as much from the source as the buffer has room for, so a replay runs as fast as it is parsed and never overruns
+static void RxRefill()
+{
+    uint8_t Data[GPS_RX_BUFFER_SIZE];
+    uint8_t Room = (RxTail - RxHead - 1) & (GPS_RX_BUFFER_SIZE - 1);
+
+    if ((ReplaySource != NULL) && (Room > 0))
+    {
+        GPSTransportFeed(Data, ReplaySource(Data, Room));
+    }
+}
+
+// Connects the replay backend to a recorded log or a model of the GPS, either may be NULL
+void GPSTransportReplay(GPSReplaySource Source, GPSReplaySink Sink)
+{
+    ReplaySource = Source;
+    ReplaySink = Sink;
+}
+
+void GPSTransport::begin(unsigned long Baud)
+{
+    (void)Baud;
+    RxHead = RxTail = 0;
+    RxOverruns = 0;
+}
+
+void GPSTransport::end()
+{
+}
+
+size_t GPSTransport::write(uint8_t Data) // Commands to the GPS are dropped unless a sink is connected
+{
+    if (ReplaySink != NULL)
+    {
+        ReplaySink(Data);
+    }
+    return 1;
+}
+
+void GPSTransport::flush()
+{
+}
+
+#endif
+#endif
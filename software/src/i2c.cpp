@@ -1,5 +1,18 @@
 #include "i2c.hpp"
 #include "defines.hpp"
+#include <avr/sleep.h>
+#include <util/atomic.h>
+
+// Interrupt driven TWI (I2C) engine
+// Transactions are put in a small queue and clocked out by the TWI interrupt, the CPU can idle-sleep while it waits.
+// A transaction that holds the bus longer than I2C_TIMEOUT is aborted and the bus is recovered so a stuck slave can not hang the firmware.
+S_I2CTransaction I2CQueue[I2C_QUEUE_SIZE]; // Queued transactions, I2CQueueHead is the one currently on the bus
+volatile uint8_t I2CQueueHead;             // Index of the transaction currently on the bus
+volatile uint8_t I2CQueueCount;            // Number of transactions in the queue, including the one on the bus
+volatile uint8_t I2CIndex;                 // Next data byte to write or read in the current transaction
+volatile boolean I2CRegSent;               // The register address of the current transaction has been sent
+volatile uint8_t I2CLastResult;            // Result of the last completed transaction
+volatile unsigned long I2CStartTime;       // millis() when the current transaction got the bus
 
 // Init TWI (I2C)
 //
@@ -9,101 +22,301 @@ void i2cInit()
     TWSR = 0;
     TWDR = 0xFF;
     PRR = 0;
+    I2CQueueHead = 0;
+    I2CQueueCount = 0;
+    I2CLastResult = I2C_RESULT_OK;
+    TWCR = (1 << TWEN);
 }
 
-uint8_t i2cSendRegister(uint8_t reg, uint8_t data, uint8_t i2c_address)
+// Issue a START for the transaction at the head of the queue, the TWI interrupt takes it from there
+static void i2cStartHead(uint8_t TWCRStop)
 {
-    uint8_t stts;
+    I2CIndex = 0;
+    I2CRegSent = false;
+    I2CStartTime = millis();
+    TWCR = (1 << TWINT) | (1 << TWSTA) | (1 << TWEN) | (1 << TWIE) | TWCRStop;
+}
 
-    stts = i2cStart();
-    if (stts != I2C_START)
-        return 1;
+// Complete the transaction at the head of the queue and start the next one if there is one waiting
+static void i2cFinish(uint8_t Result, boolean SendStop)
+{
+    I2CCallback Callback = I2CQueue[I2CQueueHead].Callback;
+    uint8_t TWCRStop = SendStop ? (1 << TWSTO) : 0;
 
-    stts = i2cByteSend(i2c_address << 1);
-    if (stts != I2C_SLA_W_ACK)
-        return 2;
+    I2CLastResult = Result;
+    I2CQueueHead = (I2CQueueHead + 1) % I2C_QUEUE_SIZE;
+    I2CQueueCount--;
+    if (I2CQueueCount > 0)
+    {
+        i2cStartHead(TWCRStop); // STOP followed by a START for the next transaction
+    }
+    else
+    {
+        TWCR = (1 << TWINT) | (1 << TWEN) | TWCRStop;
+    }
+    if (Callback != NULL)
+    {
+        Callback(Result);
+    }
+}
 
-    stts = i2cByteSend(reg);
-    if (stts != I2C_DATA_ACK)
-        return 3;
+// The TWI state machine, called with the TWI status every time the TWI hardware has completed a bus action
+void i2cStateMachine(uint8_t Status)
+{
+    S_I2CTransaction *Transaction = &I2CQueue[I2CQueueHead];
 
-    stts = i2cByteSend(data);
-    if (stts != I2C_DATA_ACK)
-        return 4;
+    switch (Status)
+    {
+    case I2C_START:
+    case I2C_START_RPT:
+        if (I2CRegSent) // Repeated start of a read, address the slave for reading
+        {
+            TWDR = (Transaction->Address << 1) + 1;
+        }
+        else
+        {
+            TWDR = Transaction->Address << 1;
+        }
+        TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWIE);
+        break;
 
-    i2cStop();
+    case I2C_SLA_W_ACK:
+        if (Transaction->Probe) // Only the address is sent, the ACK is all that was asked for
+        {
+            i2cFinish(I2C_RESULT_OK, true);
+            break;
+        }
+        TWDR = Transaction->Reg;
+        I2CRegSent = true;
+        TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWIE);
+        break;
 
-    return 0;
-}
+    case I2C_DATA_ACK:
+        if (Transaction->Read)
+        {
+            TWCR = (1 << TWINT) | (1 << TWSTA) | (1 << TWEN) | (1 << TWIE); // Repeated start
+        }
+        else if (I2CIndex < Transaction->Length)
+        {
+            TWDR = Transaction->Data[I2CIndex++];
+            TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWIE);
+        }
+        else
+        {
+            i2cFinish(I2C_RESULT_OK, true);
+        }
+        break;
 
-uint8_t i2cReadRegister(uint8_t reg, uint8_t *data, uint8_t i2c_address)
-{
-    uint8_t stts;
+    case I2C_SLA_R_ACK:
+        if (Transaction->Length > 1)
+        {
+            TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWIE) | (1 << TWEA); // ACK the coming byte, there are more to read
+        }
+        else
+        {
+            TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWIE); // NACK the coming byte, it is the last one
+        }
+        break;
+
+    case I2C_DATA_R_ACK:
+        Transaction->Data[I2CIndex++] = TWDR;
+        if (I2CIndex < (Transaction->Length - 1))
+        {
+            TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWIE) | (1 << TWEA);
+        }
+        else
+        {
+            TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWIE);
+        }
+        break;
+
+    case I2C_DATA_R_NACK:
+        Transaction->Data[I2CIndex++] = TWDR;
+        i2cFinish(I2C_RESULT_OK, true);
+        break;
+
+    case I2C_SLA_W_NACK:
+        i2cFinish(I2C_RESULT_ADDRESS_NACK, true);
+        break;
 
-    stts = i2cStart();
-    if (stts != I2C_START)
-        return 1;
+    case I2C_SLA_R_NACK:
+        i2cFinish(I2C_RESULT_READ_NACK, true);
+        break;
 
-    stts = i2cByteSend((i2c_address << 1));
-    if (stts != I2C_SLA_W_ACK)
-        return 2;
+    case I2C_DATA_NACK:
+        if (I2CIndex == 0)
+        {
+            i2cFinish(I2C_RESULT_REG_NACK, true);
+        }
+        else
+        {
+            i2cFinish(I2C_RESULT_DATA_NACK, true);
+        }
+        break;
 
-    stts = i2cByteSend(reg);
-    if (stts != I2C_DATA_ACK)
-        return 3;
+    case I2C_ARB_LOST:
+        i2cFinish(I2C_RESULT_BUS_ERROR, false); // The bus is released by the hardware
+        break;
 
-    stts = i2cStart();
-    if (stts != I2C_START_RPT)
-        return 4;
+    default: // Bus error or an unexpected state
+        i2cFinish(I2C_RESULT_BUS_ERROR, true);
+        break;
+    }
+}
+
+ISR(TWI_vect)
+{
+    i2cStateMachine(TWSR & 0xF8);
+}
 
-    stts = i2cByteSend((i2c_address << 1) + 1);
-    if (stts != I2C_SLA_R_ACK)
-        return 5;
+// Put a transaction in the queue and start it if the bus is free. Returns without waiting for the transaction to complete.
+// If the queue is full this waits for a free slot
+static uint8_t i2cQueue(uint8_t i2c_address, uint8_t reg, uint8_t *data, uint8_t len, boolean Read, boolean Probe, I2CCallback Callback)
+{
+    S_I2CTransaction *Transaction;
+    unsigned long WaitStart = millis();
+    boolean Queued = false;
 
-    *data = i2cByteRead();
+    while (!Queued)
+    {
+        // The TWI interrupt moves the head on and then lowers the count when a transaction completes. Both are read, and the
+        // free slot behind the last transaction filled and taken, with the interrupt held so a pending transaction is never overwritten
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            if (I2CQueueCount < I2C_QUEUE_SIZE)
+            {
+                Transaction = &I2CQueue[(I2CQueueHead + I2CQueueCount) % I2C_QUEUE_SIZE];
+                Transaction->Address = i2c_address;
+                Transaction->Reg = reg;
+                Transaction->Data = data;
+                Transaction->Length = len;
+                Transaction->Read = Read;
+                Transaction->Probe = Probe;
+                Transaction->Callback = Callback;
+                I2CQueueCount++;
+                if (I2CQueueCount == 1) // Bus is idle, start right away
+                {
+                    i2cStartHead(0);
+                }
+                Queued = true;
+            }
+        }
+        if (!Queued)
+        {
+            i2cService();
+            if ((millis() - WaitStart) > (I2C_TIMEOUT * I2C_QUEUE_SIZE))
+            {
+                return I2C_RESULT_QUEUE_FULL;
+            }
+        }
+    }
+    return I2C_RESULT_OK;
+}
 
-    i2cStop();
+uint8_t i2cQueueTransaction(uint8_t i2c_address, uint8_t reg, uint8_t *data, uint8_t len, boolean Read, I2CCallback Callback)
+{
+    return i2cQueue(i2c_address, reg, data, len, Read, false, Callback);
+}
 
-    return 0;
+boolean i2cBusy()
+{
+    return (I2CQueueCount > 0);
 }
 
-// I2C and PLL routines from Hans Summer demo code https://www.qrp-labs.com/images/uarduino/uard_demo.ino
-uint8_t i2cStart()
+// Checks for a transaction that has held the bus for too long, recovers the bus and fails that transaction
+// Must be called regularly while transactions are queued, the blocking functions in this file do it while they wait
+void i2cService()
 {
-    TWCR = (1 << TWINT) | (1 << TWSTA) | (1 << TWEN);
+    // Tested and acted on with the TWI interrupt held, so the transaction can not complete (or the next one start) in between
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if ((I2CQueueCount > 0) && ((millis() - I2CStartTime) > I2C_TIMEOUT))
+        {
+            i2cRecoverBus();
+            i2cFinish(I2C_RESULT_TIMEOUT, false);
+        }
+    }
+}
 
-    while (!(TWCR & (1 << TWINT)))
-        ;
+// Wait in idle sleep until all queued transactions have completed, returns the result of the last one
+uint8_t i2cWait()
+{
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    while (i2cBusy())
+    {
+        i2cService();
+        cli();
+        if (i2cBusy())
+        {
+            sleep_enable();
+            sei(); // The instruction after sei is always executed so the TWI interrupt can not sneak in before we sleep
+            sleep_cpu();
+            sleep_disable();
+        }
+        sei();
+    }
+    return I2CLastResult;
+}
 
-    return (TWSR & 0xF8);
+// Free a bus that is held by a slave, e.g after a reset or a glitch in the middle of a byte
+// Clocks SCL until the slave releases SDA and then generates a STOP condition
+void i2cRecoverBus()
+{
+    TWCR = 0; // Disconnect the TWI hardware from the pins
+    pinMode(SDA, INPUT_PULLUP);
+    for (uint8_t i = 0; i < 9; i++)
+    {
+        digitalWrite(SCL, LOW);
+        pinMode(SCL, OUTPUT);
+        delayMicroseconds(5);
+        pinMode(SCL, INPUT_PULLUP);
+        delayMicroseconds(5);
+    }
+    // STOP condition, SDA goes high while SCL is high
+    digitalWrite(SDA, LOW);
+    pinMode(SDA, OUTPUT);
+    delayMicroseconds(5);
+    pinMode(SDA, INPUT_PULLUP);
+    delayMicroseconds(5);
+    TWCR = (1 << TWEN);
 }
 
-void i2cStop()
+// Returns I2C_RESULT_OK if a slave acknowledges the address. Only START, SLA+W and STOP go on the bus, nothing is written to the slave
+uint8_t i2cProbe(uint8_t i2c_address)
 {
-    TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWSTO);
+    uint8_t Result;
 
-    while ((TWCR & (1 << TWSTO)))
-        ;
+    Result = i2cQueue(i2c_address, 0, NULL, 0, false, true, NULL);
+    if (Result != I2C_RESULT_OK)
+        return Result;
+
+    return i2cWait();
 }
 
-uint8_t i2cByteSend(uint8_t data)
+uint8_t i2cSendRegister(uint8_t reg, uint8_t data, uint8_t i2c_address)
 {
-    TWDR = data;
+    return i2cSendRegisters(reg, &data, 1, i2c_address);
+}
 
-    TWCR = (1 << TWINT) | (1 << TWEN);
+// Write len consecutive registers starting at reg in one transaction, the Si5351 auto-increments the register address
+uint8_t i2cSendRegisters(uint8_t reg, const uint8_t *data, uint8_t len, uint8_t i2c_address)
+{
+    uint8_t Result;
 
-    while (!(TWCR & (1 << TWINT)))
-        ;
+    Result = i2cQueueTransaction(i2c_address, reg, (uint8_t *)data, len, false, NULL);
+    if (Result != I2C_RESULT_OK)
+        return Result;
 
-    return (TWSR & 0xF8);
+    return i2cWait();
 }
 
-uint8_t i2cByteRead()
+uint8_t i2cReadRegister(uint8_t reg, uint8_t *data, uint8_t i2c_address)
 {
-    TWCR = (1 << TWINT) | (1 << TWEN);
+    uint8_t Result;
 
-    while (!(TWCR & (1 << TWINT)))
-        ;
+    Result = i2cQueueTransaction(i2c_address, reg, data, 1, true, NULL);
+    if (Result != I2C_RESULT_OK)
+        return Result;
 
-    return (TWDR);
+    return i2cWait();
 }
@@ -5,17 +5,17 @@
 
   Hardware connections:
   --------------------------
-  pin 2 and 3 is Sofware serial port to GPS module
+  pin 2 and 3 is Sofware serial port to GPS module (INT0 and Timer2 based receiver in gps_transport.cpp)
   pin 4 is Status LED, except on Mini and Pico models- they use pin A2. This Led is Used as StatusIndicator to display what state the software is currently in, Yellow LED on all models except Pico that has a white LED
   pin 5,6 and 7 are Relay control pins on the Desktop and LP1 products
   pin 8 is Red TX LED next to RF out SMA connector on the Desktop and LP1 products. Used as Indicator to display when there is RF out.
   pin A1 Hardware Sleep signal of the GPS on the WSPR-TX Pico, The Mini is using Serial command to put GPS to sleep.
   pin A3 Power-down the Si5351 from this pin on the WSPR-TX Mini
+  When PPS_Mode is set the GPS PPS output is connected to pin 8 and the Si5351 CLK2 output to pin 5 instead
 
 */
 
 #include <Arduino.h>
-#include <SoftwareSerial.h>
 #include <NMEAGPS.h>
 #include <defines.hpp>
 #include <i2c.hpp>
@@ -29,6 +29,17 @@
 #include "eeprom.hpp"
 #include "filter_management.hpp"
 #include "adc.hpp"
+#include "symbol_clock.hpp"
+#include "gps_pps.hpp"
+#include "gps_transport.hpp"
+#include "ubx.hpp"
+#include "ubx_nav.hpp"
+#include "binary_protocol.hpp"
+#include "telemetry.hpp"
+#include "sleep.hpp"
+#include "energy.hpp"
+#include "policy.hpp"
+#include "timeslot.hpp"
 
 NMEAGPS gps; // This parses the GPS characters
 gps_fix fix; // This holds on to the latest values
@@ -74,17 +85,22 @@ int GPSM;      // GPS Minutes
 int GPSS;      // GPS Seconds
 int fixstate;  // GPS Fix state-machine. 0=Init, 1=wating for fix,2=fix accuired
 boolean PCConnected;
-uint16_t LoopGPSNoReceiveCount; // If GPS stops working while in ídle mode this will increment
-char LastMaidenHead6[7];        // Holds the Maidenhead position from last transmission, used when GadgetData.WSPRData.TimeSlotCode=17 to determine if the transmitter has moved since last TX
-// The serial connection to the GPS device
-SoftwareSerial GPSSerial(2, 3); // GPS Serial port, RX on pin 2, TX on pin 3
+uint8_t SlotStartMinute;                        // GPS minute the last transmission started on
+unsigned long SlotStartMillis;                  // millis() at the start of the last transmission
+unsigned long GPSWakeMillis;                    // millis() when the GPS was woken after a sleep, 0 when its time to a fix has been measured
+unsigned long LastFixMillis;                    // millis() when GPSH, GPSM and GPSS were last set from a fix
+uint32_t SleepStartTime;                        // GPS time of day in milliseconds when the last sleep started
+uint16_t GPSReacquireTime = GPS_REACQUIRE_TIME; // Seconds the GPS needs for a fix after a sleep
+uint16_t LoopGPSNoReceiveCount;                 // If GPS stops working while in ídle mode this will increment
+uint8_t CycleBands;                             // Bands transmitted on so far in this cycle, the power policy can end a cycle early
+char LastMaidenHead6[7];                        // Holds the Maidenhead position from last transmission, used when GadgetData.WSPRData.TimeSlotCode=17 to determine if the transmitter has moved since last TX
 
 // function declarations
 
 uint8_t BandNumOfHigestLP();
 void NextFreq(void);
 void PickLP(uint8_t TXBand);
-boolean CorrectTimeslot();
+boolean CorrectTimeslot(uint8_t TestMinute);
 
 void DoSerialHandling();
 
@@ -94,12 +110,13 @@ void DoIdle();
 void DoWSPR();
 
 // wspr related
-int SendWSPRMessage(uint8_t WSPRMessageType);
+int SendWSPRMessage(uint8_t WSPRMessageType, boolean SendType3);
 
 boolean NewPosition();
 void StorePosition();
 
 static void smartdelay(unsigned long delay_ms);
+static void GPSFeed();
 
 unsigned long RandomSeed(void);
 boolean NoBandEnabled(void);
@@ -120,11 +137,14 @@ void PowerSaveON();
 void GPSGoToSleep();
 void GPSWakeUp();
 void GPSReset();
+boolean GPSAvailable();
+gps_fix GPSRead();
 
-void SendSatData();
 uint8_t EncodeChar(char Character);
 
-boolean CorrectTimeslot();
+boolean CorrectTimeslot(uint8_t TestMinute);
+void SleepUntilSlot(uint32_t MinPause);
+void LowVoltageLockout();
 
 // Implementation of functions
 
@@ -135,17 +155,26 @@ void DoSerialHandling()
     static char SerialLine[SerCMDLength]; // A single line of incoming serial command and data
     static uint8_t input_pos = 0;
     char InChar;
+    if (GPS_UBlox && !PCConnected) // Satellite data is only of use when it can be sent on to the PC
+    {
+        UBXSetSatelliteData(true);
+    }
     PCConnected = true;
     while (Serial.available() > 0)
     {
         InChar = Serial.read();
+        if (BinaryMode)
+        {
+            BinReceiveByte(InChar);
+            continue;
+        }
         switch (InChar)
         {
         case '\n': // end of text
         {
             SerialLine[input_pos] = 0; // terminating null byte
             // terminator reached, process Command
-            DecodeSerialCMD(SerialLine, GadgetData);
+            DecodeSerialCMD(SerialLine);
             // reset buffer for next time
             input_pos = 0;
             break;
@@ -181,10 +210,10 @@ void DoSignalGen()
         CurrentMode = SignalGen;
         freq = GadgetData.GeneratorFreq;
         PickLP(FreqToBand()); // Use the correct low pass filter
-        si5351aSetFrequency(freq, FactoryData.RefFreq);
+        si5351aSetFrequency(freq, CalibratedRefFreq());
         digitalWrite(StatusLED, HIGH);
-        SendAPIUpdate(UMesCurrentMode);
-        SendAPIUpdate(UMesFreq);
+        TelemetryPost(UMesCurrentMode);
+        TelemetryPost(UMesFreq);
     }
 }
 
@@ -194,7 +223,7 @@ void DoIdle()
     CurrentMode = Idle;
     digitalWrite(StatusLED, LOW);
     si5351aOutputOff(SI_CLK0_CONTROL);
-    SendAPIUpdate(UMesCurrentMode);
+    TelemetryPost(UMesCurrentMode);
 }
 
 void DoWSPR()
@@ -202,6 +231,12 @@ void DoWSPR()
     uint8_t pwr1, pwr2; // Used in Altitude to power reporting (balloon coding)
     uint32_t AltitudeInMeter;
     boolean ConfigError;
+    boolean StartTX;
+    boolean CycleComplete;
+    uint16_t Reacquire; // Seconds the GPS needed for a fix after a sleep
+    uint32_t Slept;     // Milliseconds the last sleep lasted by GPS time
+    uint32_t Pause;     // Seconds to pause after a cycle
+    boolean SendType3;  // A Type 3 message follows the Type 1 or Type 2 message this cycle
     // uint32_t GPSNoReceiveCount; //If GPS stops working in WSPR Beacon mode this will increment
     int WSPRMessageTypeToUse;
 
@@ -247,16 +282,20 @@ void DoWSPR()
             NextFreq();                                 // Cycle to next enabled band to transmit on
             freq = freq + (100ULL * random(-100, 100)); // modify TX frequency with a random value beween -100 and +100 Hz
             si5351aOutputOff(SI_CLK0_CONTROL);
-            SendAPIUpdate(UMesCurrentMode);
+            TelemetryPost(UMesCurrentMode);
+            if ((PolicyUpdate(false) == POLICY_LOCKOUT) && !PCConnected) // Do not start the GPS on a flat battery, e.g after a brown-out reset
+            {
+                LowVoltageLockout();
+            }
 
             // LOOP HERE FOREVER OR UNTIL INTERRUPTED BY A SERIAL COMMAND
             while (!Serial.available())
             { // Do until incoming serial command
-                while (gps.available(GPSSerial))
+                while (GPSAvailable())
                 { // If GPS data is available - process it
                     LoopGPSNoReceiveCount = 0;
-                    fix = gps.read();
-                    SendAPIUpdate(UMesTime);
+                    fix = GPSRead();
+                    TelemetryPost(UMesTime);
                     if (Serial.available())
                     { // If serialdata was received on control port then handle command
                         return;
@@ -266,15 +305,39 @@ void DoWSPR()
                         GPSH = fix.dateTime.hours;
                         GPSM = fix.dateTime.minutes;
                         GPSS = fix.dateTime.seconds;
+                        LastFixMillis = millis();
+                        if (GPSWakeMillis != 0) // First fix after a sleep, learn how long the GPS needs. Follow a slower GPS at once and a faster one slowly
+                        {
+                            Reacquire = (millis() - GPSWakeMillis) / 1000;
+                            GPSReacquireTime = (Reacquire > GPSReacquireTime) ? Reacquire : (GPSReacquireTime * 3 + Reacquire) / 4;
+                            Slept = ((GPSH * 3600UL + GPSM * 60 + GPSS) * 1000 + 86400000UL - SleepStartTime) % 86400000UL - (millis() - GPSWakeMillis);
+                            WDTCalibrate(Slept); // Also learn how long the watchdog periods really are
+                            GPSWakeMillis = 0;
+                        }
                         if (GadgetData.WSPRData.LocatorOption == GPS)
                         { // If GPS should update the Maidenhead locator
-                            calcLocator(fix.latitude(), fix.longitude(), &GadgetData.WSPRData);
+                            calcLocator(fix.latitudeL(), fix.longitudeL(), &GadgetData.WSPRData);
                         }
-                        if ((GPSS == 00) && (CorrectTimeslot())) // If second is zero at even minute then start WSPR transmission. The function CorrectTimeSlot can hold of transmision depending on several user settings. The GadgetData.WSPRData.TimeSlotCode value will influense the behaviour
+                        if (PPS_Mode) // Get ready one second early, SendWSPRMessage then starts the transmission on the PPS edge at the top of the minute
                         {
-                            if ((PCConnected) || (Product_Model != 1028) || ((Product_Model == 1028) && OutsideGeoFence())) // On the WSPR-TX Pico make sure were are outside the territory of UK, Yemen and North Korea before the transmitter is started but allow tranmissions inside the Geo-Fence if a PC is connected so UK users can make test tranmissions on the ground before relase of Picos
+                            StartTX = (GPSS == 59) && CorrectTimeslot((GPSM + 1) % 60);
+                        }
+                        else
+                        {
+                            StartTX = (GPSS == 00) && CorrectTimeslot(GPSM);
+                        }
+                        // The last 3 seconds before a transmission we want to do as little as possible so we can time the start exactly on the mark, SendWSPRMessage lifts the hold
+                        TelemetryHold(StartTX || (GPSS >= 57));
+                        if (StartTX) // If second is zero at even minute then start WSPR transmission. The function CorrectTimeSlot can hold of transmision depending on several user settings. The GadgetData.WSPRData.TimeSlotCode value will influense the behaviour
+                        {
+                            if ((PCConnected) || (Product_Model != 1028) || ((Product_Model == 1028) && OutsideGeoFence(GadgetData.WSPRData, fix.latitudeL(), fix.longitudeL()))) // On the WSPR-TX Pico make sure were are outside the territory of UK, Yemen and North Korea before the transmitter is started but allow tranmissions inside the Geo-Fence if a PC is connected so UK users can make test tranmissions on the ground before relase of Picos
                             {
-                                GPSGoToSleep(); // Put GPS to sleep to save power
+                                if (!PPS_Mode) // In PPS mode the GPS is put to sleep by SendWSPRMessage once the PPS edge has been captured
+                                {
+                                    GPSGoToSleep(); // Put GPS to sleep to save power
+                                }
+                                SlotStartMinute = PPS_Mode ? (GPSM + 1) % 60 : GPSM; // Keep the time of the slot, the GPS is asleep when the next one is planned
+                                SlotStartMillis = millis() + (PPS_Mode ? 1000 : 0);
                                 // -------------------- Altitude coding to Power ------------------------------------
                                 if (GadgetData.WSPRData.PowerOption == Altitude) // If Power field should be used for Altitude coding
                                 {
@@ -284,55 +347,68 @@ void DoWSPR()
                                     GadgetData.WSPRData.TXPowerdBm = pwr1;
                                 }
 
-                                if (SendWSPRMessage(WSPRMessageTypeToUse) != 0) // Send a WSPR Type 1 or Type 2 message for 1 minute and 50 seconds
+                                SendType3 = (GadgetData.WSPRData.LocationPrecision == 6) && PolicyType3(); // If higher position precision is set then a Type 3 message follows, unless the battery is too low for it
+                                if (SendWSPRMessage(WSPRMessageTypeToUse, SendType3) != 0)                 // Send a WSPR Type 1 or Type 2 message for 1 minute and 50 seconds
                                 {
                                     // there was a serial command that interrupted the WSPR Block so go and handle it
                                     return;
                                 }
-                                if (GadgetData.WSPRData.LocationPrecision == 6) // If higher position precision is set then start a new WSPR tranmission of Type 3
+                                if (SendType3) // Start a new WSPR tranmission of Type 3
                                 {
                                     delay(9000);                                     // wait 9 seconds so we are at the top of an even minute again
                                     if (GadgetData.WSPRData.PowerOption == Altitude) // If Power field should be used for Altitude coding
                                     {
                                         GadgetData.WSPRData.TXPowerdBm = pwr2;
                                     }
-                                    if (SendWSPRMessage(3) != 0) // Send a WSPR Type 3 message for 1 minute and 50 seconds
+                                    if (SendWSPRMessage(3, true) != 0) // Send a WSPR Type 3 message for 1 minute and 50 seconds
                                     {
                                         // there was a serial command that interrupted the WSPR Block so go and handle it
                                         return;
                                     }
                                 }
-                                StorePosition(); // Save the current position;
-                                if (LastFreq())  // If all bands have been transmitted on then pause for user defined time and after that start over on the first band again
+                                RefCalDue = true;
+                                StorePosition();                            // Save the current position;
+                                CycleComplete = LastFreq();                 // If all bands have been transmitted on then pause for user defined time and after that start over on the first band again
+                                NextFreq();                                 // get the frequency for the next HAM band that we will transmit on, before the pause so a sleep can be planned for the slots of that band
+                                freq = freq + (100ULL * random(-100, 100)); // modify the TX frequency with a random value beween -100 and +100 Hz to avoid possible lengthy colisions with other users on the band
+                                CycleBands++;
+                                if (CycleBands >= PolicyMaxBands()) // As many bands as the power level allows, the next cycle goes on with the band after this one
                                 {
-                                    if ((GadgetData.TXPause > 60) && ((Product_Model == 1017) || (Product_Model == 1028)) && (!PCConnected)) // If the PC is not connected and the TXdelay is longer than a 60 sec then put the MCU to sleep to save current during this long pause (Mini and Pico models only)
+                                    CycleComplete = true;
+                                }
+                                if (CycleComplete)
+                                {
+                                    CycleBands = 0;
+                                    PolicyUpdate(!PCConnected);              // Pick the power level for the next cycle from the supply voltage, the GPS is asleep
+                                    Pause = PolicyPause(GadgetData.TXPause); // The user set pause, or longer if the battery is low
+                                    if ((PolicyLevel() == POLICY_LOCKOUT) && !PCConnected)
+                                    {
+                                        LowVoltageLockout(); // Sleep until the battery has recovered
+                                    }
+                                    else if ((Pause > 60) && ((Product_Model == 1017) || (Product_Model == 1028) || Power_Policy) && (!PCConnected)) // If the PC is not connected and the TXdelay is longer than a 60 sec then put the MCU to sleep to save current during this long pause (Mini and Pico models, or any battery powered one)
                                     {
-                                        delay(600);       // Let the serial port send data from its buffer before we go to sleep
-                                        Si5351PowerOff(); // Turn off the PLL to save power (Mini Only)
-                                        // MCUGoToSleep (GadgetData.TXPause - 10);        //Set MCU in sleep mode until there is 10 seconds left of delay
-                                        PowerSaveOFF();   // We are back from sleep - turn on GPS and PLL again
-                                        smartdelay(2000); // let the smartdelay routine read a few GPS lines so we can get the new GPS time after our sleep
+                                        SleepUntilSlot(Pause); // Power down MCU, GPS and PLL until the GPS has to wake up for the next slot
                                     }
                                     else
-                                    {                                            // Regular pause if we did not go to sleep then do a regular pause and send updates to the GUI for the duration
-                                        smartdelay(GadgetData.TXPause * 1000UL); // Pause for the time set by the user
+                                    {                                // Regular pause if we did not go to sleep then do a regular pause and send updates to the GUI for the duration
+                                        smartdelay(Pause * 1000UL); // Pause for the time set by the user
                                     }
-                                    SendAPIUpdate(UMesWSPRBandCycleComplete); // Inform PC that we have transmitted on the last enabled WSPR band and will start over
+                                    TelemetryPost(UMesWSPRBandCycleComplete); // Inform PC that we have transmitted on the last enabled WSPR band and will start over
                                 }
                                 GPSWakeUp();
-                                NextFreq();                                 // get the frequency for the next HAM band that we will transmit on
-                                freq = freq + (100ULL * random(-100, 100)); // modify the TX frequency with a random value beween -100 and +100 Hz to avoid possible lengthy colisions with other users on the band
+                                PolicyGPSSetup(); // Fix rate of a new power level
                                 smartdelay(3000);
                             }
                         }
                         else // We have GPS fix but it is not top of even minute so dubble-blink to indicate waiting for top of minute
                         {
                             // SendAPIUpdate(UMesTime);
-                            if (GPSS < 57) // Send some nice-to-have info only if the WSPR start is at least 3 seconds away. The last 3 seconds we want to do as little as possible so we can time the start of transmission exactly on the mark
+                            TelemetryPost(UMesGPSLock);               // Send Locked status
+                            TelemetryPost(UMesLocator);               // Send position
+                            TelemetryPost(UMesSatData);               // Send Satellite postion and SNR information to the PC GUI
+                            if (PPS_Mode && RefCalDue && (GPSS < 50)) // Measure the reference oscillator against the PPS while the next transmission is still far enough away
                             {
-                                SendAPIUpdate(UMesGPSLock); // Send Locked status
-                                SendAPIUpdate(UMesLocator); // Send position
-                                SendSatData();              // Send Satellite postion and SNR information to the PC GUI
+                                PPSCalibrateRef(PPS_CAL_SECONDS, GPSFeed); // Keeps parsing the GPS data during the measurement
                             }
                             LEDBlink(2);
                             smartdelay(100);
@@ -340,9 +416,9 @@ void DoWSPR()
                     }
                     else
                     {                                 // Waiting for GPS location fix
-                        SendSatData();                // Send Satellite postion and SNR information to the PC GUI while we wait for the GPS location fix
+                        TelemetryPost(UMesSatData);   // Send Satellite postion and SNR information to the PC GUI while we wait for the GPS location fix
                         LEDBlink(1);                  // singleblink to indicate waiting for GPS Lock
-                        SendAPIUpdate(UMesNoGPSLock); // Send No lock status
+                        TelemetryPost(UMesNoGPSLock); // Send No lock status
                         smartdelay(400);
                     }
                 } // GPS serial data loop
@@ -360,80 +436,67 @@ void DoWSPR()
 }
 
 // Transmitt a WSPR message for 1 minute 50 seconds on frequency freq
-int SendWSPRMessage(uint8_t WSPRMessageType)
+// SendType3 is set for both messages when a Type 1 or Type 2 message is followed by a Type 3 message
+int SendWSPRMessage(uint8_t WSPRMessageType, boolean SendType3)
 {
     uint8_t i;
     uint8_t Indicator;
-    unsigned long startmillis;
-    unsigned long endmillis;
     boolean TXEnabled = true;
     int errcode;
+    uint16_t StartTime;
     errcode = 0;
-    boolean blinked;
 
     uint8_t *tx_buffer = get_tx_buffer_ptr();
-    memset(tx_buffer, 0, get_tx_buffer_size());                                                                                                         // clear WSPR symbol buffer
     wspr_encode(GadgetData.WSPRData.CallSign, GadgetData.WSPRData.MaidenHead4, GadgetData.WSPRData.TXPowerdBm, tx_buffer, WSPRMessageType, GadgetData); // Send a WSPR message for 2 minutes
     // PrintBuffer ('B');
     //  Send WSPR for two minutes
     digitalWrite(StatusLED, HIGH);
-    startmillis = millis();
+    if (TXEnabled)
+        si5351aStartToneTable(freq, CalibratedRefFreq(), get_tx_symbol(0)); // Calculate the PLL settings for the four WSPR tones once for the whole transmission and preload the first one
+    // Symbol edges are paced by Timer1, intersymbol delay in WSPR is 682.667 milliseconds (1.4648 baud)
+    if (PPS_Mode && PPSWaitForEdge(1500, &StartTime))
+    {
+        SymbolClockStartAt(StartTime); // The first symbol starts on the PPS edge, the tone switch below only adds the time of one I2C register write
+    }
+    else
+    {
+        SymbolClockStart();
+    }
+    TelemetryHold(false);     // Updates are sent after each tone change from here on
     for (i = 0; i < 162; i++) // 162 WSPR symbols to transmit
     {
-        blinked = false;
-        endmillis = startmillis + ((i + 1) * (unsigned long)683); // intersymbol delay in WSPR is 682.687 milliseconds (1.4648 baud)
-        uint64_t tonefreq;
-        tonefreq = freq + ((tx_buffer[i] * 146)); // 146 centiHz (Tone spacing is 1.4648Hz in WSPR)
         if (TXEnabled)
-            si5351aSetFrequency(tonefreq, FactoryData.RefFreq);
-        // wait untill tone is transmitted for the correct amount of time
-        while ((millis() < endmillis) && (!Serial.available()))
-            ; // Until time is up or there is serial data received on the control Serial port
+            si5351aSetTone(get_tx_symbol(i));
+
+        // Send Status updates to the PC, this is done after the tone change so it can not delay the symbol edge
+        Indicator = i;
+        if (SendType3)
         {
-            if (!blinked)
-            { // do pulsing blinks on Status LED every WSPR symbol to indicate WSPR Beacon transmission
-                // Send Status updates to the PC
-                Indicator = i;
-                Serial.print(F("{TWS} "));
-                if (CurrentBand < 10)
-                {
-                    SerialPrintZero();
-                }
-                Serial.print(CurrentBand);
-                Serial.print(" ");
-                if (GadgetData.WSPRData.LocationPrecision == 6)
-                {
-                    Indicator = Indicator / 2; // If four minutes TX time then halve the indicator value so it will be full after four minutes instead of 2 minutes
-                }
-                if (WSPRMessageType == 3)
-                {
-                    Indicator = Indicator + 81; // If this is the second 2 minute transmission then start to from 50%
-                }
-                if (Indicator < 10)
-                {
-                    SerialPrintZero();
-                }
-                if (Indicator < 100)
-                {
-                    SerialPrintZero();
-                }
-                Serial.println(Indicator);
-                for (int BlinkCount = 0; BlinkCount < 6; BlinkCount++)
-                {
-                    digitalWrite(StatusLED, HIGH);
-                    delay(5);
-                    digitalWrite(StatusLED, LOW);
-                    delay(50);
-                }
-                blinked = true;
-            }
+            Indicator = Indicator / 2; // If four minutes TX time then halve the indicator value so it will be full after four minutes instead of 2 minutes
         }
-        if (Serial.available()) // If serialdata was received on Control port then abort and handle command
+        if (WSPRMessageType == 3)
+        {
+            Indicator = Indicator + 81; // If this is the second 2 minute transmission then start to from 50%
+        }
+        TelemetryPostValue(UMesTXProgress, Indicator);
+        TelemetryDrain();
+        // Short blink on Status LED every WSPR symbol to indicate WSPR Beacon transmission
+        digitalWrite(StatusLED, HIGH);
+        delay(5);
+        digitalWrite(StatusLED, LOW);
+        if ((i == 0) && PPS_Mode && ((WSPRMessageType == 3) || !SendType3))
+        {
+            GPSGoToSleep(); // Put GPS to sleep to save power, unless a Type 3 message follows that also needs the PPS to start
+        }
+
+        // Sleep untill tone is transmitted for the correct amount of time
+        if (!SymbolClockWait(i + 1)) // If serialdata was received on Control port then abort and handle command
         {
             errcode = 1;
             break;
         }
     }
+    SymbolClockStop();
     // Switches off Si5351a output
     si5351aOutputOff(SI_CLK0_CONTROL);
     digitalWrite(StatusLED, LOW);
@@ -460,6 +523,13 @@ void StorePosition() // Saves the current position
     }
 }
 
+// Pass what the GPS has sent so far to the parser, for loops that wait without smartdelay
+static void GPSFeed()
+{
+    while (GPSAvailable())
+        fix = GPSRead();
+}
+
 // Part of the code from the TinyGPS example but here used for the NeoGPS
 // Delay loop that checks if the GPS serial port is sending data and in that case passes it of to the GPS object
 static void smartdelay(unsigned long delay_ms)
@@ -475,15 +545,16 @@ static void smartdelay(unsigned long delay_ms)
 
     do
     {
-        while (gps.available(GPSSerial))
-            fix = gps.read(); // If GPS data available - process it
+        while (GPSAvailable())
+            fix = GPSRead(); // If GPS data available - process it
+        TelemetryDrain();
         TimeLeft = EndTime - millis();
 
         if ((TimeLeft > 4000))
         {
             // Send API update
-            Serial.print(F("{MPS} "));
-            Serial.println(TimeLeft / 1000);
+            TelemetryPostValue(UMesPause, TimeLeft / 1000);
+            EnergySaveIfDue();
             delay(1000);
             if (Blink)
             {
@@ -497,7 +568,7 @@ static void smartdelay(unsigned long delay_ms)
         }
     } while ((TimeLeft > 0) && (!Serial.available())); // Until time is up or there is serial data received from the computer, in that case end early
     if (delay_ms > 4000)
-        Serial.println(F("{MPS} 0")); // When pause is complete send Pause 0 to the GUI so it looks neater. But only if it was at least a four second delay
+        TelemetryPostValue(UMesPause, 0); // When pause is complete send Pause 0 to the GUI so it looks neater. But only if it was at least a four second delay
 }
 
 // Create a random seed by doing CRC32 on 100 analog values from port A0
@@ -593,12 +664,7 @@ void NextFreq(void)
         case 12:
             freq = WSPR_FREQ4m;
         }
-        Serial.print("{TBN} "); // Send API update to inform what band we are using at the moment
-        if (CurrentBand < 10)
-        {
-            SerialPrintZero();
-        }
-        Serial.println(CurrentBand);
+        TelemetryPost(UMesBand); // Send API update to inform what band we are using at the moment
         // We have found what band to use, now pick the right low pass filter for this band
         PickLP(CurrentBand);
     }
@@ -833,30 +899,46 @@ void PowerSaveON()
     Si5351PowerOff();
 }
 
+// The energy ledger only books the GPS as off on the units where it is really switched, on the others it keeps running
 void GPSGoToSleep()
 {
+    if (GPS_UBlox) // Backup mode, the receiver keeps its time and satellite data for a hot start when woken
+    {
+        UBXBackup(0);
+        EnergyState(ENERGY_GPS, 0);
+        return;
+    }
     switch (Product_Model)
     {
     case 1017: // Mini
         // If its the WSPR-TX Mini, send the Sleep string to it
         GPSSerial.println(F("$PMTK161,0*28"));
         // GPSSleep = true;
+        EnergyState(ENERGY_GPS, 0);
         break;
 
     case 1028: // Pico
         // If it is the WSPR-TX Pico it has a hardware line for sleep/wake
         pinMode(GPSPower, OUTPUT);
         digitalWrite(GPSPower, LOW);
+        EnergyState(ENERGY_GPS, 0);
         break;
     }
 }
 
 void GPSWakeUp()
 {
+    if (GPS_UBlox)
+    {
+        EnergyState(ENERGY_GPS, 1);
+        UBXWakeUp();
+        return;
+    }
     switch (Product_Model)
     {
     case 1017: // Mini
         // Send anything on the GPS serial line to wake it up
+        EnergyState(ENERGY_GPS, 1);
         GPSSerial.println(" ");
         // GPSSleep = false;
         delay(100); // Give the GPS some time to wake up and send its serial data back to us
@@ -864,6 +946,7 @@ void GPSWakeUp()
 
     case 1028: // Pico
         // If it is the WSPR-TX Pico it has a hardware line for sleep/wake
+        EnergyState(ENERGY_GPS, 1);
         pinMode(GPSPower, OUTPUT);
         digitalWrite(GPSPower, HIGH);
         delay(200);
@@ -880,145 +963,104 @@ void GPSWakeUp()
 void GPSReset()
 {
     GPSWakeUp();
+    if (GPS_UBlox)
+    {
+        UBXReset();
+        return;
+    }
     // Send GPS reset string
     GPSSerial.println(F("$PCAS10,3*1F"));
 }
 
-// Sends the Sattelite data like Elevation, Azimuth SNR and ID using the Serial API {GSI} format
-void SendSatData()
+// Feeds what the GPS has sent to the parser, true when there is a new fix for GPSRead.
+// NMEA through NeoGPS, or UBX NAV-PVT when GPS_UBX_Nav is set
+boolean GPSAvailable()
 {
-    uint8_t SNR;
-    for (uint8_t i = 0; i < gps.sat_count; i++)
+    if (GPS_UBX_Nav)
     {
-        Serial.print(F("{GSI} "));
-        if (gps.satellites[i].id < 10)
-        {
-            SerialPrintZero();
-        }
-        Serial.print(gps.satellites[i].id);
-        Serial.print(" ");
-        if (gps.satellites[i].azimuth < 100)
-        {
-            SerialPrintZero();
-        }
-        if (gps.satellites[i].azimuth < 10)
-        {
-            SerialPrintZero();
-        }
-        Serial.print(gps.satellites[i].azimuth);
-        Serial.print(" ");
-        if (gps.satellites[i].elevation < 10)
-        {
-            SerialPrintZero();
-        }
-        Serial.print(gps.satellites[i].elevation);
-        Serial.print((" "));
-        SNR = 0;
-        if (gps.satellites[i].tracked)
-        {
-            SNR = gps.satellites[i].snr;
-        }
-        else
-        {
-            SNR = 0;
-        }
-        if (SNR < 10)
-        {
-            SerialPrintZero();
-        }
-        Serial.println(SNR);
+        return UBXNavAvailable();
+    }
+    return gps.available(GPSSerial);
+}
+
+gps_fix GPSRead()
+{
+    if (GPS_UBX_Nav)
+    {
+        return UBXNavRead();
     }
-    Serial.println();
+    return gps.read();
 }
 
 // Only transmit on specific times
-boolean CorrectTimeslot()
+boolean CorrectTimeslot(uint8_t TestMinute) // TestMinute is the GPS minute the transmission would start on
 {
-    boolean CorrectSlot = false;
-    uint8_t TestMinute;
-    uint8_t ScheduleLenght;
-    uint8_t SlotCode;
-    TestMinute = GPSM;         // Test the Minute variable from the GPS time
-    if ((TestMinute % 2) == 0) // First check that it an even minute as WSPR transmissions only start on even minute
-    {
-        if (GadgetData.WSPRData.TimeSlotCode == 17) // Tracker mode, only transmit when the transmitter is moving
-        {
-            CorrectSlot = (NewPosition() || (TestMinute == 0)); // Transmit only if the tracker has moved since last transmisson or at top of an Hour
-        }
-        else if (GadgetData.WSPRData.TimeSlotCode == 16) // No scheduling
-        {
-            CorrectSlot = true;
-        }
-        else if (GadgetData.WSPRData.TimeSlotCode == 15) // Band coordinated scheduling
-        {
-            switch (CurrentBand)
-            {
-            case 2: // 160m band
-                CorrectSlot = (TestMinute == 0 || TestMinute == 20 || TestMinute == 40);
-                break;
-            case 3: // 80m band
-                CorrectSlot = (TestMinute == 2 || TestMinute == 22 || TestMinute == 42);
-                break;
-            case 4: // 40m band
-                CorrectSlot = (TestMinute == 6 || TestMinute == 26 || TestMinute == 46);
-                break;
-            case 5: // 30m band
-                CorrectSlot = (TestMinute == 8 || TestMinute == 28 || TestMinute == 48);
-                break;
-            case 6: // 20m band
-                CorrectSlot = (TestMinute == 10 || TestMinute == 30 || TestMinute == 50);
-                break;
-            case 7: // 17m band
-                CorrectSlot = (TestMinute == 12 || TestMinute == 32 || TestMinute == 52);
-                break;
-            case 8: // 15m band
-                CorrectSlot = (TestMinute == 14 || TestMinute == 34 || TestMinute == 54);
-                break;
-            case 9: // 12m band
-                CorrectSlot = (TestMinute == 16 || TestMinute == 36 || TestMinute == 56);
-                break;
-            case 10: // 10m band
-                CorrectSlot = (TestMinute == 18 || TestMinute == 38 || TestMinute == 58);
-                break;
-            default:
-                CorrectSlot = true; // band does not have schedule, allow it to transmit right now, this applies to 1290m,630m and all bands above 10m
-                break;
-            }                                           // switch
-        }                                               // else if
-        else if (GadgetData.WSPRData.TimeSlotCode < 15) // Schedule is on the minute set on Timeslotcode * 2  E.g if Timeslotcode is 3 then minute 06,16,26,36,46 and 56 is used for transmissions.
-        {
-            if (GadgetData.WSPRData.TimeSlotCode < 5)
-            {
-                ScheduleLenght = 10;
-                SlotCode = GadgetData.WSPRData.TimeSlotCode;
-            }
-            else
-            {
-                ScheduleLenght = 20;
-                SlotCode = GadgetData.WSPRData.TimeSlotCode - 5;
-            }  // if TimeSlotCode <5
-            do // Remove the ten minute digit and just leave the minute digit
-            {
-                if (TestMinute > ScheduleLenght - 1)
-                    TestMinute = TestMinute - ScheduleLenght;
-            } while (TestMinute > ScheduleLenght - 1);
-            CorrectSlot = (TestMinute == (SlotCode * 2)); // if the TimeSlotcode multiplied with 2 (only even minutes) is matching the current minute digit then transmit
-        }                                                 // else if
+    if (!TimeslotMinute(GadgetData.WSPRData.TimeSlotCode, CurrentBand, TestMinute))
+    {
+        return false;
+    }
+    if (GadgetData.WSPRData.TimeSlotCode == TIMESLOT_TRACKER) // Tracker mode, only transmit when the transmitter is moving
+    {
+        return (NewPosition() || (TestMinute == 0)); // Transmit only if the tracker has moved since last transmisson or at top of an Hour
+    }
+    return true;
+}
+
+// Pause of at least MinPause seconds with MCU, GPS and Si5351 powered down. Wakes up in time for the GPS to get a fix before the next slot,
+// based on how long it took after earlier sleeps. Does a regular pause if the slot is too close to be worth powering down for
+void SleepUntilSlot(uint32_t MinPause)
+{
+    uint16_t HourSecond = (SlotStartMinute * 60UL + (millis() - SlotStartMillis) / 1000) % 3600; // The GPS is asleep since the transmission so count from its start
+    uint32_t SlotIn = SecondsToNextSlot(GadgetData.WSPRData.TimeSlotCode, CurrentBand, HourSecond, MinPause);
+    uint16_t WakeLead = GPSReacquireTime + GPS_WAKE_MARGIN;
+
+    if (SlotIn < (uint32_t)WakeLead + SLEEP_MIN_TIME)
+    {
+        smartdelay(MinPause * 1000UL);
+        return;
     }
-    return CorrectSlot;
+    Serial.flush(); // Let the serial port send data from its buffer before we go to sleep
+    PowerSaveON();
+    SleepStartTime = ((GPSH * 3600UL + GPSM * 60 + GPSS) * 1000 + millis() - LastFixMillis) % 86400000UL;
+    MCUGoToSleep(SlotIn - WakeLead);
+    GPSWakeMillis = millis();
+    PowerSaveOFF(); // We are back from sleep - turn on GPS and PLL again
+}
+
+// Parks the unit with MCU, GPS and PLL powered down until the supply voltage has recovered, checked every POLICY_LOCKOUT_SLEEP seconds.
+// The GPS then needs a new fix before the next transmission
+void LowVoltageLockout()
+{
+    Serial.println(F("{MIN} Low battery, transmissions stopped"));
+    Serial.flush();
+    PowerSaveON();
+    do
+    {
+        MCUGoToSleep(POLICY_LOCKOUT_SLEEP);
+    } while (PolicyUpdate(true) == POLICY_LOCKOUT);
+    PowerSaveOFF();
+    PolicyGPSSetup();
 }
 
 void setup()
 {
     // bool i2c_found;
     i2cInit();
+    EnergyInit();
     PCConnected = false;
     fixstate = 0; // GPS fixstate=No location fix
     // Initialize the serial ports, The hardware port is used for communicating with a PC.
     // The Soft Serial is for communcating with the GPS
     Serial.begin(9600); // USB Serial port
     Serial.setTimeout(2000);
-    GPSSerial.begin(9600); // Init software serial port to communicate with the on-board GPS module
+    GPSSerial.begin(9600); // Init serial port to communicate with the on-board GPS module
+    if (GPS_UBlox)
+    {
+        if (!UBXSetupReceiver(false))
+        {
+            Serial.println(F("{MIN} GPS did not accept its power save setup"));
+        }
+    }
     // Read all the Factory data from EEPROM at position 400
     if (LoadFromEPROM(FactorySpace)) // Read all Factory data from EEPROM
     {
@@ -1029,6 +1071,7 @@ void setup()
         Serial.println(F("{MIN} You need to run factory setup to complete the configuration, guessing on calibration values for now"));
         FactoryData.HW_Version = 1;     // Hardware version
         FactoryData.RefFreq = 24999980; // Reference Oscillator frequency
+        FactoryData.Bandgap = ADC_BANDGAP_DEFAULT;
         if (Product_Model == 1011)      // LP1 Model, set some defaults
         {
             FactoryData.HW_Revision = 17;  // Hardware revision
@@ -1238,7 +1281,14 @@ void setup()
 
     // Use the Red LED as a Transmitt indicator and the Yellow LED as Status indicator
     pinMode(StatusLED, OUTPUT);
-    pinMode(TransmitLED, OUTPUT);
+    if (PPS_Mode)
+    {
+        PPSInit(); // The TX LED pin is used as PPS input
+    }
+    else
+    {
+        pinMode(TransmitLED, OUTPUT);
+    }
 
     Serial.print(F("{MIN} Firmware version "));
     Serial.print(SoftwareVersion);
@@ -1273,7 +1323,9 @@ void setup()
 
 void loop()
 {
-
+    TelemetryHold(false); // Only DoWSPR holds back the updates, it may have returned in its last seconds before a transmission
+    TelemetryDrain();
+    EnergySaveIfDue();
     if (Serial.available())
     { // Handle  Serial API request from the PC
         DoSerialHandling();
@@ -1282,28 +1334,28 @@ void loop()
     {
         DoWSPR(); // If in WSPR beacon mode but it broke out of beacon loop to handle a Serial data from the PC then go back to the WSPR routine
     }
-    while (gps.available(GPSSerial))
+    while (GPSAvailable())
     { // Handle Serial data from the GPS as they arrive
-        fix = gps.read();
-        SendAPIUpdate(UMesTime);
+        fix = GPSRead();
+        TelemetryPost(UMesTime);
         LoopGPSNoReceiveCount = 0;
         if ((GPSS % 4) == 0) // Send some nice-to-have info every 4 seconds, this is a lot of data so we dont want to send it to often to risk choke the Serial output buffer
         {
-            SendSatData();                  // Send Satellite position and SNR information to the PC GUI
-            SendAPIUpdate(UMesVCC);         // Send power supply voltage at the MCU to the PC GUI
-            SendAPIUpdate(UMesCurrentMode); // Send info of what routine is running to the PC GUI
+            TelemetryPost(UMesSatData);     // Send Satellite position and SNR information to the PC GUI
+            TelemetryPost(UMesVCC);         // Send power supply voltage at the MCU to the PC GUI
+            TelemetryPost(UMesCurrentMode); // Send info of what routine is running to the PC GUI
             if (fix.valid.location && fix.valid.time)
             {
-                SendAPIUpdate(UMesGPSLock);
+                TelemetryPost(UMesGPSLock);
                 if (GadgetData.WSPRData.LocatorOption == GPS)
                 { // If GPS should update the Maidenhead locator
-                    calcLocator(fix.latitude(), fix.longitude(), &GadgetData.WSPRData);
+                    calcLocator(fix.latitudeL(), fix.longitudeL(), &GadgetData.WSPRData);
                 }
-                SendAPIUpdate(UMesLocator);
+                TelemetryPost(UMesLocator);
             }
             else
             {
-                SendAPIUpdate(UMesNoGPSLock);
+                TelemetryPost(UMesNoGPSLock);
             }
         }
         smartdelay(200);
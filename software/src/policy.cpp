@@ -0,0 +1,112 @@
+#include "policy.hpp"
+#include "defines.hpp"
+#include "adc.hpp"
+#include "ubx.hpp"
+
+struct S_PowerLevel
+{
+    uint16_t MinVCC;    // Supply voltage in mV the level holds down to
+    uint16_t MinPause;  // Shortest pause in seconds after a cycle, a longer TXPause set by the user is kept
+    uint8_t MaxBands;   // Bands transmitted on per cycle, the next cycle goes on with the band after the last one
+    boolean Type3;      // Type 3 messages for the six character locator are sent
+    uint16_t GPSUpdate; // Milliseconds between fixes of a u-blox GPS in cyclic tracking
+};
+
+// Lowest level first, for a single Li-ion cell. The last level has no limits and is the one used when Power_Policy is not set
+const S_PowerLevel PowerLevels[] PROGMEM = {
+    {0, 0, 0, false, 0}, // Lockout
+    {3450, 1800, 1, false, 10000},
+    {3650, 600, 2, true, 5000},
+    {3850, 0, 16, true, 1000}};
+
+#define POWER_LEVELS (sizeof(PowerLevels) / sizeof(PowerLevels[0]))
+
+static uint8_t Level = POWER_LEVELS - 1;
+static uint16_t VCC;    // Supply voltage in mV at the last update
+static int16_t Trend;   // Smoothed change of the supply voltage per update in mV, above zero when charging
+static boolean GPSDue;  // The GPS update period of a new level has not been sent to the GPS yet
+static boolean Started; // False until the first update has picked a level
+
+static uint16_t LevelMinVCC(uint8_t Index)
+{
+    return pgm_read_word(&PowerLevels[Index].MinVCC);
+}
+
+// Reads the supply voltage and moves to the level it calls for, returns the level. Call once per cycle.
+// Quiet measures in ADC noise reduction sleep, see adc.hpp
+uint8_t PolicyUpdate(boolean Quiet)
+{
+    uint16_t NewVCC;
+    uint8_t NewLevel = Level;
+
+    if (!Power_Policy)
+    {
+        return Level;
+    }
+    NewVCC = GetVCC(Quiet);
+    if (!Started) // The highest level the voltage is good for, without hysteresis
+    {
+        Started = true;
+        VCC = NewVCC;
+        NewLevel = POWER_LEVELS - 1;
+    }
+    Trend = (Trend * 3 + (int16_t)(NewVCC - VCC)) / 4;
+    VCC = NewVCC;
+    while ((NewLevel > 0) && (VCC < LevelMinVCC(NewLevel)))
+    {
+        NewLevel--;
+    }
+    // Up only with some margin so the level does not flip with every cycle, and out of the lockout only while charging
+    while ((NewLevel < POWER_LEVELS - 1) && (VCC >= LevelMinVCC(NewLevel + 1) + POLICY_HYSTERESIS) && ((NewLevel != POLICY_LOCKOUT) || (Trend >= 0)))
+    {
+        NewLevel++;
+    }
+    if (NewLevel != Level)
+    {
+        Level = NewLevel;
+        GPSDue = true;
+    }
+    return Level;
+}
+
+uint8_t PolicyLevel()
+{
+    return Level;
+}
+
+uint16_t PolicyVCC()
+{
+    return VCC;
+}
+
+int16_t PolicyTrend()
+{
+    return Trend;
+}
+
+// The pause after a cycle, at least the user set TXPause
+uint32_t PolicyPause(uint32_t TXPause)
+{
+    uint16_t MinPause = pgm_read_word(&PowerLevels[Level].MinPause);
+
+    return (TXPause > MinPause) ? TXPause : MinPause;
+}
+
+uint8_t PolicyMaxBands()
+{
+    return pgm_read_byte(&PowerLevels[Level].MaxBands);
+}
+
+boolean PolicyType3()
+{
+    return pgm_read_byte(&PowerLevels[Level].Type3);
+}
+
+// Sends the fix rate of the level to a u-blox GPS after a level change. The GPS must be awake
+void PolicyGPSSetup()
+{
+    if (GPS_UBlox && GPSDue && (Level != POLICY_LOCKOUT))
+    {
+        GPSDue = !UBXSetCyclicTracking(pgm_read_word(&PowerLevels[Level].GPSUpdate), 10000);
+    }
+}
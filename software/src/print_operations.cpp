@@ -1,6 +1,11 @@
 #include "print_operations.hpp"
+#include "string_operations.hpp"
 
-void SerialPrintZero()
+// Prints Value with leading zeros to at least Width digits, Width 0 prints it without padding
+void SerialPrintPadded(uint64_t Value, uint8_t Width)
 {
-    Serial.print("0");
-}
\ No newline at end of file
+    char Buffer[UINT64_DIGITS + 1];
+
+    uint64ToStr(Value, Buffer, (Width > UINT64_DIGITS) ? UINT64_DIGITS : Width);
+    Serial.print(Buffer);
+}
@@ -1,8 +1,10 @@
 #include "sleep.hpp"
-#include "SoftwareSerial.h"
-
-extern int StatusLED;            // LED that indicates current status. Yellow on LP1, Desktop and Mini models, white on Pico
-extern SoftwareSerial GPSSerial; // GPS Serial port, RX on pin 2, TX on pin 3
+#include <avr/sleep.h>
+#include <avr/wdt.h>
+#include <EEPROM.h>
+#include "defines.hpp"
+#include "adc.hpp"
+#include "energy.hpp"
 
 // Sleep code from Kevin Darrah https://www.youtube.com/watch?v=urLSDi7SD8M
 ISR(WDT_vect)
@@ -10,38 +12,148 @@ ISR(WDT_vect)
     // DON'T FORGET THIS!  Needed for the watch dog timer.  This is called after a watch dog timer timeout - this is the interrupt function called after waking up
 } // watchdog interrupt
 
+// Watchdog periods used for sleeping, longest first. Nominal length in milliseconds and the WDTCSR prescaler bits
+static const uint16_t WDTPeriods[] = {8000, 4000, 2000, 1000, 500, 250};
+static const uint8_t WDTPrescalers[] = {(1 << WDP3) | (1 << WDP0), (1 << WDP3), (1 << WDP2) | (1 << WDP1) | (1 << WDP0), (1 << WDP2) | (1 << WDP1), (1 << WDP2) | (1 << WDP0), (1 << WDP2)};
+
+// The 128kHz watchdog oscillator is off by up to some ten percent and drifts with supply voltage and temperature.
+// Its period is measured against GPS time after each long sleep and kept in EEPROM for the conditions it was measured in
+struct S_WDTCalibration
+{
+    uint16_t Period;    // Length in milliseconds of the nominal 8 second period, an erased EEPROM entry is out of range
+    uint8_t VCC;        // Supply voltage in 1/10 Volt
+    int8_t Temperature; // Chip temperature in steps of 5 degrees
+};
+
+static S_WDTCalibration SleepConditions; // Voltage and temperature at the start of the last sleep
+static uint32_t SleptNominal;            // Nominal length in milliseconds of the watchdog periods of the last sleep, 0 once it has been measured
+
+// Index of the stored measurement made in the conditions closest to Conditions, WDT_CAL_ENTRIES if there are none
+static uint8_t ClosestWDTCalibration(const S_WDTCalibration *Conditions, S_WDTCalibration *Closest)
+{
+    S_WDTCalibration Entry;
+    uint8_t Index = WDT_CAL_ENTRIES;
+    int Distance;
+    int BestDistance = 0x7FFF;
+
+    for (uint8_t i = 0; i < WDT_CAL_ENTRIES; i++)
+    {
+        EEPROM.get(WDT_CAL_EEPROM + i * sizeof(Entry), Entry);
+        if ((Entry.Period < WDT_PERIOD_MIN) || (Entry.Period > WDT_PERIOD_MAX))
+        {
+            continue; // Unused
+        }
+        Distance = abs((int)Entry.VCC - Conditions->VCC) + abs(Entry.Temperature - Conditions->Temperature);
+        if (Distance < BestDistance)
+        {
+            BestDistance = Distance;
+            Index = i;
+            *Closest = Entry;
+        }
+    }
+    return Index;
+}
+
+// Measures the watchdog period from how long the last sleep really lasted, SleptMillis is taken from the GPS time before and after.
+// Only sleeps that really lasted at least WDT_CAL_MIN_TIME are used, with a slow watchdog the nominal length is shorter.
+// The result is averaged with earlier measurements in the same conditions
+void WDTCalibrate(uint32_t SleptMillis)
+{
+    S_WDTCalibration Entry;
+    uint32_t Units = SleptNominal / 250; // The nominal length is always a whole number of the shortest period
+    uint32_t Period;
+    uint8_t Index;
+
+    if ((Units == 0) || (SleptMillis < WDT_CAL_MIN_TIME * 1000UL) || (SleptNominal > 86400000UL)) // The GPS time wraps after a day
+    {
+        return;
+    }
+    SleptNominal = 0;
+    Period = SleptMillis / Units * 32 + (SleptMillis % Units) * 32 / Units; // 32 periods of 250ms in the 8 second period
+    if ((Period < WDT_PERIOD_MIN) || (Period > WDT_PERIOD_MAX))
+    {
+        return; // Not a sensible measurement, e.g the GPS time was not right yet
+    }
+    Index = ClosestWDTCalibration(&SleepConditions, &Entry);
+    if ((Index < WDT_CAL_ENTRIES) && (Entry.VCC == SleepConditions.VCC) && (Entry.Temperature == SleepConditions.Temperature))
+    {
+        Period = (Entry.Period * 3UL + Period + 2) / 4;
+    }
+    else
+    {
+        for (uint8_t i = 0; i < WDT_CAL_ENTRIES; i++) // New conditions, use a free entry or else replace the closest one
+        {
+            EEPROM.get(WDT_CAL_EEPROM + i * sizeof(Entry), Entry);
+            if ((Entry.Period < WDT_PERIOD_MIN) || (Entry.Period > WDT_PERIOD_MAX))
+            {
+                Index = i;
+                break;
+            }
+        }
+    }
+    Entry = SleepConditions;
+    Entry.Period = Period;
+    EEPROM.put(WDT_CAL_EEPROM + Index * sizeof(Entry), Entry);
+}
+
+// Power down until the watchdog interrupt after one period
+static void WDTSleep(uint8_t Prescaler)
+{
+    cli();
+    wdt_reset();
+    WDTCSR = (1 << WDCE) | (1 << WDE); // Timed sequence to change the watchdog setup
+    WDTCSR = (1 << WDIE) | Prescaler;  // Interrupt mode only, no reset
+    sleep_enable();
+    sleep_bod_disable(); // BOD DISABLE - this must be called right before the sleep instruction
+    sei();               // The instruction after sei is always executed so the watchdog can not sneak in before we sleep
+    sleep_cpu();
+    sleep_disable();
+}
+
 // Sleep code from Kevin Darrah https://www.youtube.com/watch?v=urLSDi7SD8M
-void MCUGoToSleep(int SleepTime) // Sleep time in seconds, accurate to the nearest 8 seconds
+// Powers down for SleepTime seconds with the longest watchdog periods that fit, the IO pins are restored afterwards.
+// The periods are planned with the watchdog period measured closest to the present voltage and temperature
+void MCUGoToSleep(uint32_t SleepTime)
 {
-    int SleepLoop;
-    SleepLoop = SleepTime / 8.8; // every sleep period is 8.8 seconds
-    GPSSerial.end();             // Must turn off software serialport or sleep will not work
-    // Serial.end(); //Turn off Hardware serial port as well as we will temporary change all ports to outputs
+    uint32_t TimeLeft = SleepTime * 1000; // Milliseconds
+    uint32_t Period;
+    uint16_t Period8s;
+    S_WDTCalibration Closest;
+    uint8_t SavedDDR[3] = {DDRB, DDRC, DDRD};
+    uint8_t SavedPORT[3] = {PORTB, PORTC, PORTD};
+
+    SleepConditions.VCC = GetVCC(true) / 100;                            // GPS and PC are quiet, measured in ADC noise reduction sleep
+    SleepConditions.Temperature = (GetTemperature(true) + 200) / 5 - 40; // Round down also below zero
+    SleepConditions.Period = 0;
+    Period8s = (ClosestWDTCalibration(&SleepConditions, &Closest) < WDT_CAL_ENTRIES) ? Closest.Period : WDT_PERIOD_DEFAULT;
+    SleptNominal = 0;
+    EnergySaveIfDue(); // A good time for the EEPROM writes, nothing is waiting
+
+    // The GPS port can stay open, its INT0 edge interrupt can not wake the MCU from power down
     AllIOtoLow(); // Set all IO pins to outputs to save power
     DisableADC(); // Turn off ADC to save power
-
-    // SETUP WATCHDOG TIMER
-    WDTCSR = (24);      // change enable and WDE - also resets
-    WDTCSR = (33);      // prescalers only - get rid of the WDE and WDCE bit
-    WDTCSR |= (1 << 6); // enable interrupt mode
-
-    // ENABLE SLEEP - this enables the sleep mode
-    SMCR |= (1 << 2);                   // power down mode
-    SMCR |= 1;                          // enable sleep
-    for (int i = 0; i < SleepLoop; i++) // sleep for eight second intervals untill SleepTime is reached
+    set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+    for (uint8_t i = 0; i < sizeof(WDTPeriods) / sizeof(WDTPeriods[0]); i++)
     {
-        // BOD DISABLE - this must be called right before the __asm__ sleep instruction
-        MCUCR |= (3 << 5);                      // set both BODS and BODSE at the same time
-        MCUCR = (MCUCR & ~(1 << 5)) | (1 << 6); // then set the BODS bit and clear the BODSE bit at the same time
-        __asm__ __volatile__("sleep");          // in line assembler to go to sleep
-        // Just woke upp after 8 seconds of sleep, do a short blink to indicate that I'm still running
-        digitalWrite(StatusLED, HIGH);
-        delay(30);
-        digitalWrite(StatusLED, LOW);
+        Period = ((uint32_t)WDTPeriods[i] * Period8s + 4000) / 8000;
+        while (TimeLeft >= Period)
+        {
+            WDTSleep(WDTPrescalers[i]);
+            TimeLeft -= Period;
+            SleptNominal += WDTPeriods[i];
+        }
     }
+    wdt_disable();
+    EnergySlept(SleepTime * 1000 - TimeLeft); // millis() has not counted the sleep, book it as planned with the measured watchdog period
+
     // Restore everything
+    PORTB = SavedPORT[0];
+    PORTC = SavedPORT[1];
+    PORTD = SavedPORT[2];
+    DDRB = SavedDDR[0];
+    DDRC = SavedDDR[1];
+    DDRD = SavedDDR[2];
     EnableADC();
-    GPSSerial.begin(9600); // Init software serial port to communicate with the on-board GPS module
 }
 
 // Sleep code from Kevin Darrah https://www.youtube.com/watch?v=urLSDi7SD8M
@@ -82,8 +194,11 @@ void AllIOtoLow()
     pinMode(7, OUTPUT);
     digitalWrite(7, LOW);
 
-    pinMode(8, OUTPUT);
-    digitalWrite(8, LOW);
+    if (!PPS_Mode) // Pin 8 is then the GPS PPS input and must not be driven
+    {
+        pinMode(8, OUTPUT);
+        digitalWrite(8, LOW);
+    }
 
     pinMode(9, OUTPUT);
     digitalWrite(9, LOW);
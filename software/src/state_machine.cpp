@@ -8,6 +8,10 @@
 #include "filter_management.hpp"
 #include "wspr_packet_formatting.hpp"
 #include "adc.hpp"
+#include "binary_protocol.hpp"
+#include "energy.hpp"
+#include "policy.hpp"
+#include <stddef.h>
 
 extern E_Mode CurrentMode;        // TODO: replace with getters and setters
 extern S_FactoryData FactoryData; // TODO: replace with getters and setters
@@ -21,8 +25,69 @@ extern uint8_t CurrentLP; // Keep track on what Low Pass filter is currently swi
 extern uint64_t freq;     // Holds the Output frequency when we are in signal generator mode or in WSPR mode
 extern gps_fix fix;       // This holds on to the latest values
 
+// Binary mode versions of the API updates
+void BinSendAPIUpdate(uint8_t UpdateType)
+{
+    uint8_t Payload[3];
+    uint16_t VCC;
+
+    switch (UpdateType)
+    {
+    case UMesCurrentMode:
+        BinSendByte(BIN_MSG_MODE, CurrentMode);
+        BinSendByte(BIN_MSG_TX_ON, CurrentMode == SignalGen);
+        break;
+
+    case UMesLocator:
+        BinSend(BIN_MSG_LOCATOR, GadgetData.WSPRData.MaidenHead6, 6);
+        break;
+
+    case UMesTime:
+        GPSH = fix.dateTime.hours;
+        GPSM = fix.dateTime.minutes;
+        GPSS = fix.dateTime.seconds;
+        Payload[0] = GPSH;
+        Payload[1] = GPSM;
+        Payload[2] = GPSS;
+        BinSend(BIN_MSG_TIME, Payload, 3);
+        break;
+
+    case UMesGPSLock:
+    case UMesNoGPSLock:
+        BinSendByte(BIN_MSG_GPS_LOCK, UpdateType == UMesGPSLock);
+        break;
+
+    case UMesFreq:
+        BinSend(BIN_MSG_FREQUENCY, &freq, 8);
+        break;
+
+    case UMesTXOn:
+    case UMesTXOff:
+        BinSendByte(BIN_MSG_TX_ON, UpdateType == UMesTXOn);
+        break;
+
+    case UMesWSPRBandCycleComplete:
+        BinSend(BIN_MSG_CYCLE_DONE, NULL, 0);
+        break;
+
+    case UMesVCC:
+        VCC = GetVCC(false);
+        BinSend(BIN_MSG_VCC, &VCC, 2);
+        break;
+
+    case UMesLPF:
+        BinSendByte(BIN_MSG_LPF, CurrentLP);
+        break;
+    }
+}
+
 void SendAPIUpdate(uint8_t UpdateType)
 {
+    if (BinaryMode)
+    {
+        BinSendAPIUpdate(UpdateType);
+        return;
+    }
     switch (UpdateType)
     {
     case UMesCurrentMode:
@@ -71,23 +136,12 @@ void SendAPIUpdate(uint8_t UpdateType)
         GPSM = fix.dateTime.minutes;
         GPSS = fix.dateTime.seconds;
         Serial.print(F("{GTM} "));
-        if (GPSH < 10)
-        {
-            SerialPrintZero();
-        }
-        Serial.print(GPSH);
-        Serial.print(":");
-        if (GPSM < 10)
-        {
-            SerialPrintZero();
-        }
-        Serial.print(GPSM);
-        Serial.print(":");
-        if (GPSS < 10)
-        {
-            SerialPrintZero();
-        }
-        Serial.println(GPSS);
+        SerialPrintPadded(GPSH, 2);
+        Serial.print(':');
+        SerialPrintPadded(GPSM, 2);
+        Serial.print(':');
+        SerialPrintPadded(GPSS, 2);
+        Serial.println();
         break;
 
     case UMesGPSLock:
@@ -100,7 +154,8 @@ void SendAPIUpdate(uint8_t UpdateType)
 
     case UMesFreq:
         Serial.print(F("{TFQ} "));
-        Serial.println(uint64ToStr(freq, false));
+        SerialPrintPadded(freq, 0);
+        Serial.println();
         break;
 
     case UMesTXOn:
@@ -117,7 +172,7 @@ void SendAPIUpdate(uint8_t UpdateType)
 
     case UMesVCC:
         Serial.print(F("{MVC} "));
-        Serial.println(GetVCC());
+        Serial.println(GetVCC(false));
         break;
 
     case UMesLPF:
@@ -142,720 +197,551 @@ void SendAPIUpdate(uint8_t UpdateType)
 }
 
 // Serial API commands and data decoding
-void DecodeSerialCMD(const char *InputCMD, S_GadgetData GadgetData)
+// Every command is described by an entry in SerialCommands, one generic parser and formatter then works on the live
+// GadgetData and FactoryData. Commands are on the form "[XXX] S data" to set and "[XXX] G" to get, replies are "{XXX} data"
+
+#define CMD_NUMBER 0  // Unsigned number, set with up to InDigits digits and replied with OutDigits digits including leading zeros
+#define CMD_STRING 1  // Zero terminated string of up to Size - 1 characters
+#define CMD_LETTER 2  // Enum or option with one letter per value, Letters holds the letter for value 0, 1, 2...
+#define CMD_HANDLER 3 // The Handler does the whole command
+
+#define CMD_GADGET 0   // Field is in GadgetData
+#define CMD_FACTORY 1  // Field is in FactoryData
+#define CMD_CONSTANT 2 // Read only, the value is held in Max
+
+#define GADGET_FIELD(Member) CMD_GADGET, offsetof(S_GadgetData, Member), sizeof(((S_GadgetData *)0)->Member)
+#define FACTORY_FIELD(Member) CMD_FACTORY, offsetof(S_FactoryData, Member), sizeof(((S_FactoryData *)0)->Member)
+#define CONSTANT_FIELD CMD_CONSTANT, 0, 0
+#define NO_FIELD CMD_CONSTANT, 0, 0
+
+typedef void (*CmdHandler)(const char *Data, boolean Set); // Data points to the data after "[XXX] S "
+
+struct S_SerialCommand
 {
-    char CharInt[13];
-    bool EnabDisab;
-    uint32_t i;
-    if ((InputCMD[0] == '[') && (InputCMD[4] == ']'))
-    { // A Command,Option or Data input
+    char Code[3];        // The three letters between the brackets
+    uint8_t Type;        // CMD_NUMBER, CMD_STRING, CMD_LETTER or CMD_HANDLER
+    uint8_t Space;       // CMD_GADGET, CMD_FACTORY or CMD_CONSTANT
+    uint8_t Offset;      // Offset of the field in its struct
+    uint8_t Size;        // Size of the field in bytes
+    uint8_t InDigits;    // Number of digits read on a set
+    uint8_t OutDigits;   // Number of digits in the reply
+    uint32_t Max;        // Highest value accepted on a set, or the value of a constant
+    const char *Letters; // Letters for a CMD_LETTER, in program memory
+    CmdHandler Handler;  // Does the command for a CMD_HANDLER, for the others it is called after a set if not NULL
+};
+
+const char ModeLetters[] PROGMEM = "WSN";      // E_Mode
+const char SuPreFixLetters[] PROGMEM = "SPN";  // E_SufixPreFixOption
+const char PowerLetters[] PROGMEM = "NA";      // E_PowerOption
+const char LocatorLetters[] PROGMEM = "MG";    // E_LocatorOption
+const char LPLetters[] PROGMEM = "ABCD";       // Low pass filters LP_A to LP_D
+const char EnergyLetters[] PROGMEM = "MSGPTR"; // Energy ledger states ENERGY_MCU to ENERGY_RELAY
+
+// Reads up to Digits digits, stops at the first character that is not a digit
+uint64_t ParseDigits(const char *Data, uint8_t Digits)
+{
+    uint64_t Value = 0;
 
-        if (InputCMD[1] == 'C')
-        { // Commmand
+    for (uint8_t i = 0; (i < Digits) && (Data[i] >= '0') && (Data[i] <= '9'); i++)
+    {
+        Value = Value * 10 + (Data[i] - '0');
+    }
+    return Value;
+}
 
-            // Current Mode
-            if ((InputCMD[2] == 'C') && (InputCMD[3] == 'M'))
-            {
-                if (InputCMD[6] == 'S')
-                { // Set option
-                    if (InputCMD[8] == 'S')
-                    {
-                        // DoSignalGen(); // UNDO LATER
-                    }
-                    if (InputCMD[8] == 'W')
-                    {
-                        // CurrentBand = 0;
-                        // DoWSPR(); // UNDO LATER
-                    }
-                    if (InputCMD[8] == 'N')
-                    {
-                        // DoIdle(); // UNDO LATER
-                    }
-                }    // Set Current Mode
-                else // Get
-                {
-                    SendAPIUpdate(UMesCurrentMode);
-                } // Get Current Mode
-            }     // CurrentMode
-
-            // Store Current configuration data to EEPROM
-            if ((InputCMD[2] == 'S') && (InputCMD[3] == 'E'))
-            {
-                if (InputCMD[6] == 'S')
-                { // Set option
-                    SaveToEEPROM(UserSpace);
-                    Serial.println(F("{MIN} Configuration saved"));
-                }
-            }
+// Current Mode [CCM], setting the mode from the PC is not implemented
+void CmdCurrentMode(const char *Data, boolean Set)
+{
+    if (!Set)
+    {
+        SendAPIUpdate(UMesCurrentMode);
+    }
+}
 
-            // Set Low Pass filter (LP filters are automatically set by the WSPR Beacon and Signal Gen. routines but can be temporarily overrided by this command for testing purposes)
-            if ((InputCMD[2] == 'S') && (InputCMD[3] == 'L'))
-            {
-                if (InputCMD[6] == 'S')
-                { // Set option
-                    if (InputCMD[8] == 'A')
-                    {
-                        CurrentLP = 0;
-                    }
-                    if (InputCMD[8] == 'B')
-                    {
-                        CurrentLP = 1;
-                    }
-                    if (InputCMD[8] == 'C')
-                    {
-                        CurrentLP = 2;
-                    }
-                    if (InputCMD[8] == 'D')
-                    {
-                        CurrentLP = 3;
-                    }
-                    DriveLPFilters();
-                }
-            }
+// Store current configuration data to EEPROM [CSE]
+void CmdSaveUser(const char *Data, boolean Set)
+{
+    if (Set)
+    {
+        SaveToEEPROM(UserSpace);
+        Serial.println(F("{MIN} Configuration saved"));
+    }
+}
+
+// Set Low Pass filter [CSL] (LP filters are automatically set by the WSPR Beacon and Signal Gen. routines but can be temporarily overrided by this command for testing purposes)
+void CmdSetLP(const char *Data, boolean Set)
+{
+    const char *Letter = strchr_P(LPLetters, Data[0]);
+
+    if (Set && (Data[0] != 0) && (Letter != NULL))
+    {
+        CurrentLP = Letter - LPLetters;
+        DriveLPFilters();
+    }
+}
+
+// Band TX enable [OBD], "NN E" or "NN D" where NN is the band number
+void CmdBand(const char *Data, boolean Set)
+{
+    uint8_t Band = (Data[0] - '0') * 10 + (Data[1] - '0');
+
+    if (Band >= sizeof(GadgetData.TXOnBand))
+    {
+        return;
+    }
+    if (Set)
+    {
+        GadgetData.TXOnBand[Band] = (Data[3] == 'E'); // Enable or disable on this band
+    }
+    else
+    {
+        Serial.print(F("{OBD} "));
+        SerialPrintPadded(Band, 2);
+        Serial.println(GadgetData.TXOnBand[Band] ? F(" E") : F(" D"));
+    }
+}
+
+// Location Option [OLC], after a change to GPS the position is sent to the PC if it is known
+void CmdLocationSet(const char *Data, boolean Set)
+{
+    if (GadgetData.WSPRData.LocatorOption == GPS)
+    {
+        Serial.println(F("{OLC G} "));            // Echo back setting
+        if (fix.valid.location && fix.valid.time) // If position is known then send it to the PC
+        {
+            GPSH = fix.dateTime.hours;
+            GPSM = fix.dateTime.minutes;
+            GPSS = fix.dateTime.seconds;
+            calcLocator(fix.latitudeL(), fix.longitudeL(), &GadgetData.WSPRData);
+            Serial.print(F("{DL4} "));
+            Serial.println(GadgetData.WSPRData.MaidenHead4);
+            Serial.print(F("{DL6} "));
+            Serial.println(GadgetData.WSPRData.MaidenHead6);
         }
+    }
+}
 
-        if (InputCMD[1] == 'O')
-        { // Option
+// Locator Precision [OLP], 6 or 4
+void CmdLocatorPrecision(const char *Data, boolean Set)
+{
+    if (Set)
+    {
+        GadgetData.WSPRData.LocationPrecision = (Data[0] == '6') ? 6 : 4;
+    }
+    Serial.print(F("{OLP} ")); // Echo back setting on a set
+    Serial.println(GadgetData.WSPRData.LocationPrecision);
+}
 
-            // TX Pause
-            if ((InputCMD[2] == 'T') && (InputCMD[3] == 'P'))
-            {
-                if (InputCMD[6] == 'S')
-                { // Set option
-                    CharInt[0] = InputCMD[8];
-                    CharInt[1] = InputCMD[9];
-                    CharInt[2] = InputCMD[10];
-                    CharInt[3] = InputCMD[11];
-                    CharInt[4] = InputCMD[12];
-                    CharInt[5] = 0;
-                    // GadgetData.TXPause = atoi(CharInt);
-                    GadgetData.TXPause = StrTouint64_t(CharInt);
-                }
-                else // Get Option
-                {
-                    Serial.print(F("{OTP} "));
-                    if (GadgetData.TXPause < 10000)
-                    {
-                        SerialPrintZero();
-                    }
-                    if (GadgetData.TXPause < 1000)
-                    {
-                        SerialPrintZero();
-                    }
-                    if (GadgetData.TXPause < 100)
-                    {
-                        SerialPrintZero();
-                    }
-                    if (GadgetData.TXPause < 10)
-                    {
-                        SerialPrintZero();
-                    }
-                    Serial.println(GadgetData.TXPause);
-                }
-            } // TX Pause
-
-            // StartMode [OSM]
-            if ((InputCMD[2] == 'S') && (InputCMD[3] == 'M'))
-            {
-                if (InputCMD[6] == 'S')
-                { // Set option
-                    if (InputCMD[8] == 'S')
-                    {
-                        GadgetData.StartMode = SignalGen;
-                    }
-                    if (InputCMD[8] == 'W')
-                    {
-                        GadgetData.StartMode = WSPRBeacon;
-                    }
-                    if (InputCMD[8] == 'N')
-                    {
-                        GadgetData.StartMode = Idle;
-                    }
-                }    // Set Start Mode
-                else // Get
-                {
-                    Serial.print(F("{OSM} "));
-                    switch (GadgetData.StartMode)
-                    {
-                    case Idle:
-                        Serial.println(("N"));
-                        break;
-                    case WSPRBeacon:
-                        Serial.println(("W"));
-                        break;
-                    case SignalGen:
-                        Serial.println(("S"));
-                        break;
-                    }
-                } // Get Start Mode
-            }     // StartMode
-
-            // Band TX enable
-            if ((InputCMD[2] == 'B') && (InputCMD[3] == 'D'))
-            {
-                if (InputCMD[6] == 'S')
-                { // Set option
-                    CharInt[0] = InputCMD[8];
-                    CharInt[1] = InputCMD[9];
-                    CharInt[2] = 0;
-                    CharInt[3] = 0; // What band to set/clear
-                    EnabDisab = false;
-                    if (InputCMD[11] == 'E')
-                        EnabDisab = true;
-                    GadgetData.TXOnBand[atoi(CharInt)] = EnabDisab; // Enable or disable on this band
-                }                                                   // Set Band TX enable
-                else                                                // Get
-                {
-                    // Get Option
-                    CharInt[0] = InputCMD[8];
-                    CharInt[1] = InputCMD[9];
-                    CharInt[2] = 0;
-                    CharInt[3] = 0; // What band is requested
-                    Serial.print(F("{OBD} "));
-                    i = atoi(CharInt);
-                    if (i < 10)
-                    {
-                        SerialPrintZero();
-                    }
-                    Serial.print(i);
-                    if (GadgetData.TXOnBand[i])
-                    {
-                        Serial.println((" E"));
-                    }
-                    else
-                    {
-                        Serial.println((" D"));
-                    }
-                } // Get Band TX enable
-            }     // Band TX enable
-
-            // Location Option
-            if ((InputCMD[2] == 'L') && (InputCMD[3] == 'C'))
-            {
-                if (InputCMD[6] == 'S')
-                { // Set Location Option
-                    if (InputCMD[8] == 'G')
-                    {
-                        GadgetData.WSPRData.LocatorOption = GPS;
-                        Serial.println(F("{OLC G} "));            // Echo back setting
-                        if (fix.valid.location && fix.valid.time) // If position is known then send it to the PC
-                        {
-                            GPSH = fix.dateTime.hours;
-                            GPSM = fix.dateTime.minutes;
-                            GPSS = fix.dateTime.seconds;
-                            calcLocator(fix.latitude(), fix.longitude(), &GadgetData.WSPRData);
-                            Serial.print(F("{DL4} "));
-                            Serial.println(GadgetData.WSPRData.MaidenHead4);
-                            Serial.print(F("{DL6} "));
-                            Serial.println(GadgetData.WSPRData.MaidenHead6);
-                        }
-                    }
-                    if (InputCMD[8] == 'M')
-                    {
-                        GadgetData.WSPRData.LocatorOption = Manual;
-                    }
-                }    // Set Location Option
-                else // Get Location Option
-                {
-                    Serial.print(F("{OLC} "));
-                    if (GadgetData.WSPRData.LocatorOption == GPS)
-                    {
-                        Serial.println(("G"));
-                    }
-                    else
-                    {
-                        Serial.println(("M"));
-                    }
-                } // Get Location Option
-            }     // Location Option
-
-            // Locator Precision [OLP]
-            if ((InputCMD[2] == 'L') && (InputCMD[3] == 'P'))
-            {
-                if (InputCMD[6] == 'S')
-                { // Set Locator Precision
-                    if (InputCMD[8] == '6')
-                    {
-                        GadgetData.WSPRData.LocationPrecision = 6;
-                    }
-                    else
-                    {
-                        GadgetData.WSPRData.LocationPrecision = 4;
-                    }
-                    // Echo back setting
-                    Serial.print(F("{OLP} "));
-                    Serial.println(GadgetData.WSPRData.LocationPrecision);
-                }    // Set Locator Precision
-                else // Get Locator Precision
-                {
-                    Serial.print(F("{OLP} "));
-                    Serial.println(GadgetData.WSPRData.LocationPrecision);
-                } // Get Locator Precision
-            }     // Locator Precision
-
-            // Power encoding Option
-            if ((InputCMD[2] == 'P') && (InputCMD[3] == 'W'))
-            {
-                if (InputCMD[6] == 'S')
-                { // Set Location Option
-                    if (InputCMD[8] == 'N')
-                    {
-                        GadgetData.WSPRData.PowerOption = Normal;
-                    }
-                    if (InputCMD[8] == 'A')
-                    {
-                        GadgetData.WSPRData.PowerOption = Altitude;
-                    }
-                }    // Set Power Encoding Option
-                else // Get Location Option
-                {
-                    Serial.print(F("{OPW} "));
-                    if (GadgetData.WSPRData.PowerOption == Normal)
-                    {
-                        Serial.println(("N"));
-                    }
-                    else
-                    {
-                        Serial.println(("A"));
-                    }
-                } // Get Power Encoding Option
-            }     // Power encoding Option
-
-            // Time slot  [OTS]
-            if ((InputCMD[2] == 'T') && (InputCMD[3] == 'S'))
-            {
-                if (InputCMD[6] == 'S')
-                { // Set option
-                    CharInt[0] = InputCMD[8];
-                    CharInt[1] = InputCMD[9];
-                    CharInt[2] = 0;
-                    CharInt[3] = 0;
-                    GadgetData.WSPRData.TimeSlotCode = atoi(CharInt);
-                }
-                else // Get
-                {
-                    Serial.print(F("{OTS} "));
-                    if (GadgetData.WSPRData.TimeSlotCode < 10)
-                    {
-                        SerialPrintZero();
-                    }
-                    Serial.println(GadgetData.WSPRData.TimeSlotCode);
-                }
-            } // Time slot
-
-            // PreFix/Sufix [OPS]
-            if ((InputCMD[2] == 'P') && (InputCMD[3] == 'S'))
-            {
-                if (InputCMD[6] == 'S')
-                { // Set option
-                    if (InputCMD[8] == 'P')
-                    {
-                        GadgetData.WSPRData.SuPreFixOption = Prefix;
-                    }
-                    if (InputCMD[8] == 'S')
-                    {
-                        GadgetData.WSPRData.SuPreFixOption = Sufix;
-                    }
-                    if (InputCMD[8] == 'N')
-                    {
-                        GadgetData.WSPRData.SuPreFixOption = None;
-                    }
-                }    // Set Start Mode
-                else // Get
-                {
-                    Serial.print(F("{OPS} "));
-                    switch (GadgetData.WSPRData.SuPreFixOption)
-                    {
-                    case Prefix:
-                        Serial.println(("P"));
-                        break;
-                    case Sufix:
-                        Serial.println(("S"));
-                        break;
-                    case None:
-                        Serial.println(("N"));
-                        break;
-                    }
-                } // Get Start Mode
-            }     // StartMode
-
-        } // All Options
-
-        // Data
-        if (InputCMD[1] == 'D')
+// Prints a low pass filter band as "{FLP} X NN"
+void PrintLPBand(char Filter, uint8_t Band)
+{
+    Serial.print(F("{FLP} "));
+    Serial.print(Filter);
+    Serial.print(' ');
+    SerialPrintPadded(Band, 2);
+    Serial.println();
+}
+
+// Low pass filter config [FLP], set with "X NN" where X is the filter (A-D) and NN the band number
+void CmdLPConfig(const char *Data, boolean Set)
+{
+    uint8_t *BandNum = &FactoryData.LP_A_BandNum; // LP_A_BandNum to LP_D_BandNum follow each other
+    const char *Letter = strchr_P(LPLetters, Data[0]);
+
+    if (Set)
+    {
+        if ((Data[0] != 0) && (Letter != NULL))
+        {
+            BandNum[Letter - LPLetters] = atoi(&Data[2]);
+        }
+        return;
+    }
+    // If Hardvare is V1 R10 and higher on LP1 and Desktop it has some filters that can do more than one band, indicate by sending out these extra bands to the PC config software
+    // The same goes for the Pico and the LP1 with Mezzanine BLP4 regardless of hardware version
+    // The PC will indicate these bands with the little green square in the GUI
+    if (((Product_Model == 1012) & (FactoryData.HW_Version == 1) & (FactoryData.HW_Revision > 9)) || (Product_Model == 1028) || (Product_Model == 1029))
+    {
+        // If 10m LP filter is fitted then indicate it can do 15m and 12m as well
+        if ((FactoryData.LP_A_BandNum == 10) || (FactoryData.LP_B_BandNum == 10) || (FactoryData.LP_C_BandNum == 10) || (FactoryData.LP_D_BandNum == 10))
+        {
+            Serial.println(F("{FLP} A 09")); // Indicate 12m band
+            Serial.println(F("{FLP} A 08")); // Indicate 15m band
+            Serial.println(F("{FLP} A 07")); // Indicate 17m band
+        }
+        // If 20m LP filter is fitted then indicate it can do 30m as well
+        if ((FactoryData.LP_A_BandNum == 6) || (FactoryData.LP_B_BandNum == 6) || (FactoryData.LP_C_BandNum == 6) || (FactoryData.LP_D_BandNum == 6))
         {
+            Serial.println(F("{FLP} A 05")); // Indicate 30m band
+        }
+    }
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        PrintLPBand(pgm_read_byte(&LPLetters[i]), BandNum[i]);
+    }
+}
 
-            // Callsign [DCS]
-            if ((InputCMD[2] == 'C') && (InputCMD[3] == 'S'))
-            {
-                if (InputCMD[6] == 'S')
-                { // Set option
-                    for (int i = 0; i <= 5; i++)
-                    {
-                        GadgetData.WSPRData.CallSign[i] = InputCMD[i + 8];
-                    }
-                    GadgetData.WSPRData.CallSign[6] = 0;
-                }
-                else // Get
-                {
-                    Serial.print(F("{DCS} "));
-                    Serial.println(GadgetData.WSPRData.CallSign);
-                }
-            } // Callsign
-
-            // Callsign Sufix [DSF]
-            if ((InputCMD[2] == 'S') && (InputCMD[3] == 'F'))
-            {
-                if (InputCMD[6] == 'S')
-                { // Set option
-                    CharInt[0] = InputCMD[8];
-                    CharInt[1] = InputCMD[9];
-                    CharInt[2] = InputCMD[10];
-                    CharInt[3] = 0;
-                    GadgetData.WSPRData.Sufix = atoi(CharInt);
-                }
-                else // Get
-                {
-                    Serial.print(F("{DSF} "));
-                    if (GadgetData.WSPRData.Sufix < 100)
-                    {
-                        SerialPrintZero();
-                    }
-                    if (GadgetData.WSPRData.Sufix < 10)
-                    {
-                        SerialPrintZero();
-                    }
-                    Serial.println(GadgetData.WSPRData.Sufix);
-                }
-            } // Callsign Sufix
-
-            // Callsing Prefix  [DPF]
-            if ((InputCMD[2] == 'P') && (InputCMD[3] == 'F'))
-            {
-                if (InputCMD[6] == 'S')
-                { // Set option
-                    for (int i = 0; i <= 2; i++)
-                    {
-                        GadgetData.WSPRData.Prefix[i] = InputCMD[i + 8];
-                    }
-                    GadgetData.WSPRData.Prefix[3] = 0;
-                }
-                else // Get
-                {
-                    Serial.print(F("{DPF} "));
-                    Serial.println(GadgetData.WSPRData.Prefix);
-                }
-            } // Callsign Prefix
-
-            // Locator 4
-            if ((InputCMD[2] == 'L') && (InputCMD[3] == '4'))
-            {
-                if (InputCMD[6] == 'S')
-                { // Set option
-                    for (int i = 0; i <= 3; i++)
-                    {
-                        GadgetData.WSPRData.MaidenHead4[i] = InputCMD[i + 8];
-                    }
-                    GadgetData.WSPRData.MaidenHead4[4] = 0;
-                }
-                else // Get
-                {
-                    Serial.print(F("{DL4} "));
-                    Serial.println(GadgetData.WSPRData.MaidenHead4);
-                }
-            } // Locator 4
-
-            // Locator 6
-            if ((InputCMD[2] == 'L') && (InputCMD[3] == '6'))
-            {
-                if (InputCMD[6] == 'S')
-                { // Set option
-                    for (int i = 0; i <= 5; i++)
-                    {
-                        GadgetData.WSPRData.MaidenHead6[i] = InputCMD[i + 8];
-                    }
-                    GadgetData.WSPRData.MaidenHead6[6] = 0;
-                }
-                else // Get
-                {
-                    Serial.print(F("{DL6} "));
-                    Serial.println(GadgetData.WSPRData.MaidenHead6);
-                }
-            } // Locator 6
-
-            // Name
-            if ((InputCMD[2] == 'N') && (InputCMD[3] == 'M'))
-            {
-                if (InputCMD[6] == 'S')
-                { // Set option
-                    for (int i = 0; i <= 38; i++)
-                    {
-                        GadgetData.Name[i] = InputCMD[i + 8];
-                    }
-                    GadgetData.Name[39] = 0;
-                }
-                else // Get
-                {
-                    Serial.print(F("{DNM} "));
-                    Serial.println(GadgetData.Name);
-                }
-            } // Name
-
-            // Power data
-            if ((InputCMD[2] == 'P') && (InputCMD[3] == 'D'))
-            {
-                if (InputCMD[6] == 'S')
-                { // Set option
-                    CharInt[0] = InputCMD[8];
-                    CharInt[1] = InputCMD[9];
-                    CharInt[2] = 0;
-                    CharInt[3] = 0;
-                    GadgetData.WSPRData.TXPowerdBm = atoi(CharInt);
-                }
-                else // Get
-                {
-                    Serial.print(F("{DPD} "));
-                    if (GadgetData.WSPRData.TXPowerdBm < 10)
-                    {
-                        SerialPrintZero();
-                    }
-                    Serial.println(GadgetData.WSPRData.TXPowerdBm);
-                }
-            } // Power Data
-
-            // Generator Frequency
-            if ((InputCMD[2] == 'G') && (InputCMD[3] == 'F'))
-            {
-                if (InputCMD[6] == 'S')
-                { // Set option
-                    for (int i = 0; i <= 11; i++)
-                    {
-                        CharInt[i] = InputCMD[i + 8];
-                    }
-                    CharInt[12] = 0;
-                    GadgetData.GeneratorFreq = StrTouint64_t(CharInt);
-                    if (CurrentMode == SignalGen)
-                    {
-                        // DoSignalGen(); // UNDO LATER
-                    }
-                }
-                else // Get
-                {
-                    Serial.print(F("{DGF} "));
-                    Serial.println(uint64ToStr(GadgetData.GeneratorFreq, true));
-                }
-            } // Generator Frequency
-
-        } // Data
-
-        // Factory data
-        if (InputCMD[1] == 'F')
+// Store Current Factory configuration data to EEPROM [FSE]
+void CmdSaveFactory(const char *Data, boolean Set)
+{
+    if (Set)
+    {
+        SaveToEEPROM(FactorySpace);
+        Serial.println(F("{MIN} Factory data saved"));
+    }
+}
+
+// Supply voltage calibration [FVC], "[FVC] S NNNN" with the supply voltage in mV as measured with a meter calibrates
+// the internal ADC reference. The result is echoed as {FBG}, save it with [FSE]
+void CmdVCCCalibrate(const char *Data, boolean Set)
+{
+    uint16_t Calibrated;
+
+    if (Set)
+    {
+        Calibrated = ADCCalibrateBandgap(ParseDigits(Data, 4));
+        if ((Calibrated < ADC_BANDGAP_MIN) || (Calibrated > ADC_BANDGAP_MAX))
         {
+            Serial.println(F("{MIN} Value out of range"));
+            return;
+        }
+    }
+    Serial.print(F("{FBG} "));
+    SerialPrintPadded(FactoryData.Bandgap, 5);
+    Serial.println();
+}
 
-            // Product model Number
-            if ((InputCMD[2] == 'P') && (InputCMD[3] == 'N'))
-            {
-                if (InputCMD[6] == 'G')
-                { // Get option
-                    Serial.print(F("{FPN} "));
-                    if (Product_Model < 10000)
-                    {
-                        SerialPrintZero();
-                    }
-                    Serial.println(Product_Model);
-                }
-            } // Product model Number
-
-            // Hardware Version
-            if ((InputCMD[2] == 'H') && (InputCMD[3] == 'V'))
-            {
-                if (InputCMD[6] == 'S')
-                { // Set option
-                    CharInt[0] = InputCMD[8];
-                    CharInt[1] = InputCMD[9];
-                    CharInt[2] = InputCMD[10];
-                    CharInt[3] = 0;
-                    FactoryData.HW_Version = atoi(CharInt);
-                }    // Set
-                else // Get Option
-                {
-                    Serial.print(F("{FHV} "));
-                    if (FactoryData.HW_Version < 100)
-                    {
-                        SerialPrintZero();
-                    }
-                    if (FactoryData.HW_Version < 10)
-                    {
-                        SerialPrintZero();
-                    }
-                    Serial.println(FactoryData.HW_Version);
-                }
-            } // Hardware Version
-
-            // Hardware Revision
-            if ((InputCMD[2] == 'H') && (InputCMD[3] == 'R'))
-            {
-                if (InputCMD[6] == 'S')
-                { // Set option
-                    CharInt[0] = InputCMD[8];
-                    CharInt[1] = InputCMD[9];
-                    CharInt[2] = InputCMD[10];
-                    CharInt[3] = 0;
-                    FactoryData.HW_Revision = atoi(CharInt);
-                    Serial.println(' ');
-                }    // Set
-                else // Get Option
-                {
-                    Serial.print(F("{FHR} "));
-                    if (FactoryData.HW_Revision < 100)
-                    {
-                        SerialPrintZero();
-                    }
-                    if (FactoryData.HW_Revision < 10)
-                    {
-                        SerialPrintZero();
-                    }
-                    Serial.println(FactoryData.HW_Revision);
-                }
-            } // Hardware Revision
-
-            // Software Version
-            if ((InputCMD[2] == 'S') && (InputCMD[3] == 'V'))
-            {
-                if (InputCMD[6] == 'G')
-                { // Get option
-                    Serial.print(F("{FSV} "));
-                    if (SoftwareVersion < 100)
-                    {
-                        SerialPrintZero();
-                    }
-                    if (SoftwareVersion < 10)
-                    {
-                        SerialPrintZero();
-                    }
-                    Serial.println(SoftwareVersion);
-                }
-            } // Software Version
-
-            // Software Revision
-            if ((InputCMD[2] == 'S') && (InputCMD[3] == 'R'))
-            {
-                if (InputCMD[6] == 'G')
-                { // Get option
-                    Serial.print(F("{FSR} "));
-                    if (SoftwareRevision < 100)
-                    {
-                        SerialPrintZero();
-                    }
-                    if (SoftwareRevision < 10)
-                    {
-                        SerialPrintZero();
-                    }
-                    Serial.println(SoftwareRevision);
-                }
-            } // Software Revision
-
-            // Low pass filter config
-            if ((InputCMD[2] == 'L') && (InputCMD[3] == 'P'))
+// Chip temperature [CTM] in degrees Celsius from the internal sensor
+void CmdTemperature(const char *Data, boolean Set)
+{
+    if (Set)
+    {
+        return;
+    }
+    Serial.print(F("{CTM} "));
+    Serial.println(GetTemperature(false));
+}
+
+// Binary mode [CBM], "[CBM] S" switches the PC link to binary packets, see binary_protocol.hpp
+void CmdBinaryMode(const char *Data, boolean Set)
+{
+    Serial.println(Set ? F("{CBM} T") : F("{CBM} F"));
+    if (Set)
+    {
+        Serial.flush(); // Let the text reply go out before the first packet
+        BinaryMode = true;
+    }
+}
+
+// Prints microampere hours as mAh with three decimals
+void PrintCharge(uint32_t Charge)
+{
+    SerialPrintPadded(Charge / 1000, 0);
+    Serial.print('.');
+    SerialPrintPadded(Charge % 1000, 3);
+}
+
+// Energy ledger [CEL], a get gives "{CEL} X seconds mAh" for each state, then "{CEL} = mAh averagecurrent hours" with the
+// total charge, the average current in microampere and the hours a full battery lasts at that current. A set clears the ledger
+void CmdEnergyLedger(const char *Data, boolean Set)
+{
+    uint32_t Charge = 0;
+    uint32_t Seconds;
+    uint32_t Average = 0;
+
+    if (Set)
+    {
+        EnergyClear();
+        EnergySave();
+        Serial.println(F("{MIN} Energy ledger cleared"));
+        return;
+    }
+    for (uint8_t i = 0; i < ENERGY_STATES; i++)
+    {
+        Serial.print(F("{CEL} "));
+        Serial.print((char)pgm_read_byte(&EnergyLetters[i]));
+        Serial.print(' ');
+        SerialPrintPadded(EnergySeconds(i), 10);
+        Serial.print(' ');
+        PrintCharge(EnergyCharge(i));
+        Serial.println();
+        Charge += EnergyCharge(i);
+    }
+    Seconds = EnergySeconds(ENERGY_MCU) + EnergySeconds(ENERGY_SLEEP);
+    if (Seconds != 0)
+    {
+        Average = (uint64_t)Charge * 3600 / Seconds;
+    }
+    Serial.print(F("{CEL} = "));
+    PrintCharge(Charge);
+    Serial.print(' ');
+    SerialPrintPadded(Average, 0);
+    Serial.print(' ');
+    SerialPrintPadded((Average != 0) ? ENERGY_BATTERY_CAPACITY * 1000ULL / Average : 0, 0);
+    Serial.println();
+}
+
+// Energy ledger currents [CEC], set with "X NNNNNN" where X is the state letter and NNNNNN the current in microampere
+void CmdEnergyCurrent(const char *Data, boolean Set)
+{
+    const char *Letter = strchr_P(EnergyLetters, Data[0]);
+
+    if (Set)
+    {
+        if ((Data[0] != 0) && (Letter != NULL))
+        {
+            EnergySetCurrent(Letter - EnergyLetters, ParseDigits(&Data[2], 6));
+            EnergySave();
+        }
+        return;
+    }
+    for (uint8_t i = 0; i < ENERGY_STATES; i++)
+    {
+        Serial.print(F("{CEC} "));
+        Serial.print((char)pgm_read_byte(&EnergyLetters[i]));
+        Serial.print(' ');
+        SerialPrintPadded(EnergyCurrent(i), 6);
+        Serial.println();
+    }
+}
+
+// Power level [CPL], "{CPL} L VVVV T" with the power policy level (0 is the low voltage lockout), the supply voltage in mV
+// it was picked with and the voltage trend in mV per cycle
+void CmdPowerLevel(const char *Data, boolean Set)
+{
+    int16_t Trend = PolicyTrend();
+
+    if (Set)
+    {
+        return;
+    }
+    Serial.print(F("{CPL} "));
+    Serial.print(PolicyLevel());
+    Serial.print(' ');
+    SerialPrintPadded(PolicyVCC(), 4);
+    Serial.print(' ');
+    if (Trend < 0)
+    {
+        Serial.print('-');
+        Trend = -Trend;
+    }
+    SerialPrintPadded(Trend, 0);
+    Serial.println();
+}
+
+const S_SerialCommand SerialCommands[] PROGMEM = {
+    // Commands
+    {{'C', 'C', 'M'}, CMD_HANDLER, NO_FIELD, 0, 0, 0, NULL, CmdCurrentMode},
+    {{'C', 'S', 'E'}, CMD_HANDLER, NO_FIELD, 0, 0, 0, NULL, CmdSaveUser},
+    {{'C', 'S', 'L'}, CMD_HANDLER, NO_FIELD, 0, 0, 0, NULL, CmdSetLP},
+    {{'C', 'B', 'M'}, CMD_HANDLER, NO_FIELD, 0, 0, 0, NULL, CmdBinaryMode},
+    {{'C', 'E', 'L'}, CMD_HANDLER, NO_FIELD, 0, 0, 0, NULL, CmdEnergyLedger},
+    {{'C', 'E', 'C'}, CMD_HANDLER, NO_FIELD, 0, 0, 0, NULL, CmdEnergyCurrent},
+    {{'C', 'P', 'L'}, CMD_HANDLER, NO_FIELD, 0, 0, 0, NULL, CmdPowerLevel},
+    {{'C', 'T', 'M'}, CMD_HANDLER, NO_FIELD, 0, 0, 0, NULL, CmdTemperature},
+    // Options
+    {{'O', 'T', 'P'}, CMD_NUMBER, GADGET_FIELD(TXPause), 5, 5, 99999, NULL, NULL},
+    {{'O', 'S', 'M'}, CMD_LETTER, GADGET_FIELD(StartMode), 0, 0, 0, ModeLetters, NULL},
+    {{'O', 'B', 'D'}, CMD_HANDLER, NO_FIELD, 0, 0, 0, NULL, CmdBand},
+    {{'O', 'L', 'C'}, CMD_LETTER, GADGET_FIELD(WSPRData.LocatorOption), 0, 0, 0, LocatorLetters, CmdLocationSet},
+    {{'O', 'L', 'P'}, CMD_HANDLER, NO_FIELD, 0, 0, 0, NULL, CmdLocatorPrecision},
+    {{'O', 'P', 'W'}, CMD_LETTER, GADGET_FIELD(WSPRData.PowerOption), 0, 0, 0, PowerLetters, NULL},
+    {{'O', 'T', 'S'}, CMD_NUMBER, GADGET_FIELD(WSPRData.TimeSlotCode), 2, 2, 17, NULL, NULL},
+    {{'O', 'P', 'S'}, CMD_LETTER, GADGET_FIELD(WSPRData.SuPreFixOption), 0, 0, 0, SuPreFixLetters, NULL},
+    // Data
+    {{'D', 'C', 'S'}, CMD_STRING, GADGET_FIELD(WSPRData.CallSign), 0, 0, 0, NULL, NULL},
+    {{'D', 'S', 'F'}, CMD_NUMBER, GADGET_FIELD(WSPRData.Sufix), 3, 3, 125, NULL, NULL},
+    {{'D', 'P', 'F'}, CMD_STRING, GADGET_FIELD(WSPRData.Prefix), 0, 0, 0, NULL, NULL},
+    {{'D', 'L', '4'}, CMD_STRING, GADGET_FIELD(WSPRData.MaidenHead4), 0, 0, 0, NULL, NULL},
+    {{'D', 'L', '6'}, CMD_STRING, GADGET_FIELD(WSPRData.MaidenHead6), 0, 0, 0, NULL, NULL},
+    {{'D', 'N', 'M'}, CMD_STRING, GADGET_FIELD(Name), 0, 0, 0, NULL, NULL},
+    {{'D', 'P', 'D'}, CMD_NUMBER, GADGET_FIELD(WSPRData.TXPowerdBm), 2, 2, 60, NULL, NULL},
+    {{'D', 'G', 'F'}, CMD_NUMBER, GADGET_FIELD(GeneratorFreq), 12, 12, 0xFFFFFFFF, NULL, NULL}, // Max is not checked for 64 bit fields
+    // Factory data
+    {{'F', 'P', 'N'}, CMD_NUMBER, CONSTANT_FIELD, 0, 5, Product_Model, NULL, NULL},
+    {{'F', 'H', 'V'}, CMD_NUMBER, FACTORY_FIELD(HW_Version), 3, 3, 255, NULL, NULL},
+    {{'F', 'H', 'R'}, CMD_NUMBER, FACTORY_FIELD(HW_Revision), 3, 3, 255, NULL, NULL},
+    {{'F', 'S', 'V'}, CMD_NUMBER, CONSTANT_FIELD, 0, 3, SoftwareVersion, NULL, NULL},
+    {{'F', 'S', 'R'}, CMD_NUMBER, CONSTANT_FIELD, 0, 3, SoftwareRevision, NULL, NULL},
+    {{'F', 'L', 'P'}, CMD_HANDLER, NO_FIELD, 0, 0, 0, NULL, CmdLPConfig},
+    {{'F', 'R', 'F'}, CMD_NUMBER, FACTORY_FIELD(RefFreq), 9, 12, 999999999, NULL, NULL},
+    {{'F', 'B', 'G'}, CMD_NUMBER, FACTORY_FIELD(Bandgap), 5, 5, ADC_BANDGAP_MAX, NULL, NULL},
+    {{'F', 'V', 'C'}, CMD_HANDLER, NO_FIELD, 0, 0, 0, NULL, CmdVCCCalibrate},
+    {{'F', 'S', 'E'}, CMD_HANDLER, NO_FIELD, 0, 0, 0, NULL, CmdSaveFactory}};
+
+// Looks up a three letter command code in SerialCommands and copies its entry to Cmd
+boolean FindSerialCommand(const char *Code, S_SerialCommand *Cmd)
+{
+    for (uint8_t i = 0; i < sizeof(SerialCommands) / sizeof(SerialCommands[0]); i++)
+    {
+        if (memcmp_P(Code, SerialCommands[i].Code, 3) == 0)
+        {
+            memcpy_P(Cmd, &SerialCommands[i], sizeof(S_SerialCommand));
+            return true;
+        }
+    }
+    return false;
+}
+
+// The field in GadgetData or FactoryData that a command works on
+uint8_t *CommandField(const S_SerialCommand &Cmd)
+{
+    return ((Cmd.Space == CMD_FACTORY) ? (uint8_t *)&FactoryData : (uint8_t *)&GadgetData) + Cmd.Offset;
+}
+
+// Range checks and stores the value of a CMD_NUMBER or CMD_LETTER field
+boolean StoreCommandValue(const S_SerialCommand &Cmd, uint64_t Value)
+{
+    if ((Cmd.Type == CMD_NUMBER) && (Cmd.Size < 8) && (Value > Cmd.Max))
+    {
+        return false;
+    }
+    if ((Cmd.Type == CMD_LETTER) && (Value >= strlen_P(Cmd.Letters)))
+    {
+        return false;
+    }
+    memcpy(CommandField(Cmd), &Value, Cmd.Size); // Little endian, the low bytes of Value
+    return true;
+}
+
+// Copies the value of a setting to Value as it is stored, a constant is four bytes. Returns the size, 0 if there is no such setting
+uint8_t GetConfigField(const char *Code, uint8_t *Value)
+{
+    S_SerialCommand Cmd;
+
+    if (!FindSerialCommand(Code, &Cmd) || (Cmd.Type == CMD_HANDLER))
+    {
+        return 0;
+    }
+    if (Cmd.Space == CMD_CONSTANT)
+    {
+        memcpy(Value, &Cmd.Max, 4);
+        return 4;
+    }
+    memcpy(Value, CommandField(Cmd), Cmd.Size);
+    return Cmd.Size;
+}
+
+// Sets a setting from a binary value of the stored size, strings may be shorter. Returns false if it was not accepted
+boolean SetConfigField(const char *Code, const uint8_t *Value, uint8_t Length)
+{
+    S_SerialCommand Cmd;
+    uint64_t Number = 0;
+
+    if (!FindSerialCommand(Code, &Cmd) || (Cmd.Type == CMD_HANDLER) || (Cmd.Space == CMD_CONSTANT))
+    {
+        return false;
+    }
+    if (Cmd.Type == CMD_STRING)
+    {
+        if (Length >= Cmd.Size)
+        {
+            return false;
+        }
+        memcpy(CommandField(Cmd), Value, Length);
+        memset(CommandField(Cmd) + Length, 0, Cmd.Size - Length);
+        return true;
+    }
+    if (Length != Cmd.Size)
+    {
+        return false;
+    }
+    memcpy(&Number, Value, Length);
+    return StoreCommandValue(Cmd, Number);
+}
+
+void DecodeSerialCMD(const char *InputCMD)
+{
+    S_SerialCommand Cmd;
+    uint8_t *Field;
+    const char *Data = &InputCMD[8];
+    const char *Letter;
+    uint64_t Value = 0;
+    boolean Set = (InputCMD[6] == 'S');
+    uint8_t i;
+
+    if ((InputCMD[0] != '[') || (InputCMD[4] != ']') || !FindSerialCommand(&InputCMD[1], &Cmd))
+    {
+        return;
+    }
+    if (Cmd.Type == CMD_HANDLER)
+    {
+        Cmd.Handler(Data, Set);
+        return;
+    }
+    Field = CommandField(Cmd);
+
+    if (Set)
+    {
+        if (Cmd.Space == CMD_CONSTANT)
+        {
+            return; // Read only
+        }
+        switch (Cmd.Type)
+        {
+        case CMD_NUMBER:
+            if (!StoreCommandValue(Cmd, ParseDigits(Data, Cmd.InDigits)))
             {
-                if (InputCMD[6] == 'S')
-                { // Set option
-                    CharInt[0] = InputCMD[10];
-                    CharInt[1] = InputCMD[11];
-                    CharInt[2] = 0;
-                    switch (InputCMD[8])
-                    {
-                    case 'A':
-                        FactoryData.LP_A_BandNum = atoi(CharInt);
-                        break;
-                    case 'B':
-                        FactoryData.LP_B_BandNum = atoi(CharInt);
-                        break;
-                    case 'C':
-                        FactoryData.LP_C_BandNum = atoi(CharInt);
-                        break;
-                    case 'D':
-                        FactoryData.LP_D_BandNum = atoi(CharInt);
-                        break;
-                    }
-
-                }    // Set
-                else // Get Option
-                {
-                    // If Hardvare is V1 R10 and higher on LP1 and Desktop it has some filters that can do more than one band, indicate by sending out these extra bands to the PC config software
-                    // The same goes for the Pico and the LP1 with Mezzanine BLP4 regardless of hardware version
-                    // The PC will indicate these bands with the little green square in the GUI
-                    if (((Product_Model == 1012) & (FactoryData.HW_Version == 1) & (FactoryData.HW_Revision > 9)) || (Product_Model == 1028) || (Product_Model == 1029))
-                    {
-                        // If 10m LP filter is fitted then indicate it can do 15m and 12m as well
-                        if ((FactoryData.LP_A_BandNum == 10) || (FactoryData.LP_B_BandNum == 10) || (FactoryData.LP_C_BandNum == 10) || (FactoryData.LP_D_BandNum == 10))
-                        {
-                            Serial.println(F("{FLP} A 09")); // Indicate 12m band
-                            Serial.println(F("{FLP} A 08")); // Indicate 15m band
-                            Serial.println(F("{FLP} A 07")); // Indicate 17m band
-                        }
-                        // If 20m LP filter is fitted then indicate it can do 30m as well
-                        if ((FactoryData.LP_A_BandNum == 6) || (FactoryData.LP_B_BandNum == 6) || (FactoryData.LP_C_BandNum == 6) || (FactoryData.LP_D_BandNum == 6))
-                        {
-                            Serial.println(F("{FLP} A 05")); // Indicate 30m band
-                        }
-                    }
-                    Serial.print(F("{FLP} A "));
-                    if (FactoryData.LP_A_BandNum < 10)
-                    {
-                        SerialPrintZero();
-                    }
-                    Serial.println(FactoryData.LP_A_BandNum);
-                    Serial.print(F("{FLP} B "));
-                    if (FactoryData.LP_B_BandNum < 10)
-                    {
-                        SerialPrintZero();
-                    }
-                    Serial.println(FactoryData.LP_B_BandNum);
-                    Serial.print(F("{FLP} C "));
-                    if (FactoryData.LP_C_BandNum < 10)
-                    {
-                        SerialPrintZero();
-                    }
-                    Serial.println(FactoryData.LP_C_BandNum);
-                    Serial.print(F("{FLP} D "));
-                    if (FactoryData.LP_D_BandNum < 10)
-                    {
-                        SerialPrintZero();
-                    }
-                    Serial.println(FactoryData.LP_D_BandNum);
-                }
-            } // Low pass filter config
-
-            // Reference Oscillator Frequency
-            if ((InputCMD[2] == 'R') && (InputCMD[3] == 'F'))
+                Serial.println(F("{MIN} Value out of range"));
+                return;
+            }
+            break;
+
+        case CMD_STRING:
+            for (i = 0; (i < Cmd.Size - 1) && (Data[i] != 0); i++)
             {
-                if (InputCMD[6] == 'S')
-                { // Set option
-                    for (int i = 0; i <= 8; i++)
-                    {
-                        CharInt[i] = InputCMD[i + 8];
-                    }
-                    CharInt[9] = 0;
-                    FactoryData.RefFreq = StrTouint64_t(CharInt);
-                }
-                else // Get
-                {
-                    Serial.print(F("{FRF} "));
-                    Serial.println(uint64ToStr(FactoryData.RefFreq, true));
-                }
-            } // Reference Oscillator Frequency
-
-            // Store Current Factory configuration data to EEPROM
-            if ((InputCMD[2] == 'S') && (InputCMD[3] == 'E'))
+                Field[i] = Data[i];
+            }
+            memset(&Field[i], 0, Cmd.Size - i);
+            break;
+
+        case CMD_LETTER:
+            Letter = strchr_P(Cmd.Letters, Data[0]);
+            if ((Data[0] == 0) || (Letter == NULL))
             {
-                if (InputCMD[6] == 'S')
-                { // Set option
-                    SaveToEEPROM(FactorySpace);
-                    Serial.println(F("{MIN} Factory data saved"));
-                }
+                return; // Not one of the letters, leave the setting as is
             }
+            StoreCommandValue(Cmd, Letter - Cmd.Letters);
+            break;
+        }
+        if (Cmd.Handler != NULL)
+        {
+            Cmd.Handler(Data, Set);
+        }
+        return;
+    }
+
+    // Get
+    Serial.print('{');
+    Serial.write((const uint8_t *)&InputCMD[1], 3);
+    Serial.print(F("} "));
+    if (Cmd.Space == CMD_CONSTANT)
+    {
+        Value = Cmd.Max;
+    }
+    else if (Cmd.Type != CMD_STRING)
+    {
+        memcpy(&Value, Field, Cmd.Size);
+    }
+    switch (Cmd.Type)
+    {
+    case CMD_NUMBER:
+        SerialPrintPadded(Value, Cmd.OutDigits);
+        Serial.println();
+        break;
 
-        } // Factory
+    case CMD_STRING:
+        Serial.println((const char *)Field);
+        break;
+
+    case CMD_LETTER:
+        if (Value < strlen_P(Cmd.Letters))
+        {
+            Serial.println((char)pgm_read_byte(&Cmd.Letters[Value]));
+        }
+        else
+        {
+            Serial.println();
+        }
+        break;
     }
-}
\ No newline at end of file
+}
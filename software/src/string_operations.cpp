@@ -1,49 +1,71 @@
 #include "string_operations.hpp"
 
-uint64_t StrTouint64_t(String InString)
+// Reads the decimal number at the start of InString, stops at the first character that is not a digit
+uint64_t StrTouint64_t(const char *InString)
 {
     uint64_t y = 0;
 
-    for (uint16_t i = 0; i < InString.length(); i++)
+    while ((*InString >= '0') && (*InString <= '9'))
     {
-        char c = InString.charAt(i);
-        if (c < '0' || c > '9')
-            break;
-        y *= 10;
-        y += (c - '0');
+        y = y * 10 + (*InString - '0');
+        InString++;
     }
     return y;
 }
 
-String uint64ToStr(uint64_t p_InNumber, boolean p_LeadingZeros)
+// Divides the number in Limbs, most significant 16 bits first, by 10000 in place and returns the remainder.
+// Uses only 32 by 16 bit divisions as AVR has no hardware division and the 64 bit one from libgcc is very slow
+static uint16_t DivMod10000(uint16_t *Limbs, uint8_t First)
 {
-    char l_HighBuffer[7];    // 6 digits + null terminator char
-    char l_LowBuffer[7];     // 6 digits + null terminator char
-    char l_ResultBuffer[13]; // 12 digits + null terminator char
-    String l_ResultString = "";
-    uint8_t l_Digit;
+    uint32_t Rem = 0;
 
-    sprintf(l_HighBuffer, "%06llu", p_InNumber / 1000000L); // Convert high part of 64bit unsigned integer to char array
-    sprintf(l_LowBuffer, "%06llu", p_InNumber % 1000000L);  // Convert low part of 64bit unsigned integer to char array
-    l_ResultString = l_HighBuffer;
-    l_ResultString = l_ResultString + l_LowBuffer; // Copy the 2 part result to a string
+    for (uint8_t i = First; i < 4; i++)
+    {
+        Rem = (Rem << 16) | Limbs[i];
+        Limbs[i] = Rem / 10000;
+        Rem -= (uint32_t)Limbs[i] * 10000;
+    }
+    return Rem;
+}
 
-    if (!p_LeadingZeros) // If leading zeros should be removed
+// Writes Value as a zero terminated decimal string to Buffer, zero padded to at least Width digits.
+// Buffer must hold the larger of UINT64_DIGITS and Width digits plus the zero termination. Returns the number of digits
+uint8_t uint64ToStr(uint64_t Value, char *Buffer, uint8_t Width)
+{
+    char Digits[UINT64_DIGITS];
+    uint16_t Limbs[4] = {(uint16_t)(Value >> 48), (uint16_t)(Value >> 32), (uint16_t)(Value >> 16), (uint16_t)Value};
+    uint8_t First = 0;
+    uint8_t Pos = UINT64_DIGITS;
+    uint16_t Chunk;
+    uint16_t Quotient;
+    uint8_t Length;
+
+    do
     {
-        l_ResultString.toCharArray(l_ResultBuffer, 13);
-        for (l_Digit = 0; l_Digit < 12; l_Digit++)
+        while ((First < 3) && (Limbs[First] == 0))
+        {
+            First++; // Skip the limbs that are already zero, values that fit in 16 bits need a single division
+        }
+        Chunk = DivMod10000(Limbs, First);
+        for (uint8_t i = 0; i < 4; i++)
         {
-            if (l_ResultBuffer[l_Digit] == '0')
-            {
-                l_ResultBuffer[l_Digit] = ' '; // replace zero with a space character
-            }
-            else
-            {
-                break; // We have found all the leading Zeros, exit loop
-            }
+            Quotient = ((uint32_t)Chunk * 0xCCCD) >> 19; // Chunk / 10, exact for Chunk below 81920
+            Digits[--Pos] = '0' + (Chunk - Quotient * 10);
+            Chunk = Quotient;
         }
-        l_ResultString = l_ResultBuffer;
-        l_ResultString.trim(); // Remove all leading spaces
+    } while ((First < 3) || (Limbs[3] != 0));
+
+    while ((Pos < UINT64_DIGITS - 1) && (Digits[Pos] == '0'))
+    {
+        Pos++; // Remove the leading zeros of the last chunk, keep one digit for zero
     }
-    return l_ResultString;
-}
\ No newline at end of file
+    Length = UINT64_DIGITS - Pos;
+    if (Width < Length)
+    {
+        Width = Length;
+    }
+    memset(Buffer, '0', Width - Length);
+    memcpy(Buffer + Width - Length, &Digits[Pos], Length);
+    Buffer[Width] = 0;
+    return Width;
+}
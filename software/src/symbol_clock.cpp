@@ -0,0 +1,84 @@
+#include "symbol_clock.hpp"
+#include <avr/sleep.h>
+
+// WSPR symbol clock driven by the Timer1 compare A interrupt
+// Timer1 is free running at F_CPU/256 and OCR1A is moved forward one symbol length at every compare match.
+// A WSPR symbol is 8192/12000 s, in Timer1 ticks that is F_CPU*8192/(256*12000) = F_CPU*2/750 ticks
+// The fractional part of a tick is accumulated so the symbol rate is exact and does not drift over the transmission.
+#define SYMBOL_TICKS_NUM (F_CPU * 2UL)
+#define SYMBOL_TICKS_DEN 750UL
+#define SYMBOL_TICKS_WHOLE (uint16_t)(SYMBOL_TICKS_NUM / SYMBOL_TICKS_DEN)
+#define SYMBOL_TICKS_REM (uint16_t)(SYMBOL_TICKS_NUM % SYMBOL_TICKS_DEN)
+
+volatile uint8_t SymbolCount; // Number of symbol edges since the symbol clock was started
+volatile uint16_t SymbolFrac; // Accumulated fractional Timer1 ticks, in units of 1/SYMBOL_TICKS_DEN tick
+
+ISR(TIMER1_COMPA_vect)
+{
+    uint16_t Ticks = SYMBOL_TICKS_WHOLE;
+
+    SymbolCount++;
+    SymbolFrac += SYMBOL_TICKS_REM;
+    if (SymbolFrac >= SYMBOL_TICKS_DEN)
+    {
+        SymbolFrac -= SYMBOL_TICKS_DEN;
+        Ticks++;
+    }
+    OCR1A += Ticks; // 16 bit wrap around is intended, Timer1 is free running
+}
+
+// Start the symbol clock, the first symbol edge comes one symbol length after this call
+void SymbolClockStart()
+{
+    TIMSK1 = 0;
+    TCCR1A = 0;           // Normal mode, no output compare pins
+    TCCR1B = (1 << CS12); // Prescaler 256
+    TCNT1 = 0;
+    SymbolClockStartAt(0);
+}
+
+// Start the symbol clock from an earlier Timer1 time, e.g. a GPS PPS input capture
+// Timer1 must already be free running at F_CPU/256 and StartTime must be less than a symbol length ago
+void SymbolClockStartAt(uint16_t StartTime)
+{
+    TIMSK1 &= ~(1 << OCIE1A);
+    SymbolCount = 0;
+    SymbolFrac = SYMBOL_TICKS_REM;
+    OCR1A = StartTime + SYMBOL_TICKS_WHOLE;
+    TIFR1 = (1 << OCF1A);    // Clear any pending compare match
+    TIMSK1 |= (1 << OCIE1A); // Enable compare A interrupt
+}
+
+void SymbolClockStop()
+{
+    TIMSK1 &= ~(1 << OCIE1A);
+}
+
+uint8_t SymbolClockCount()
+{
+    return SymbolCount;
+}
+
+// Idle-sleep until Symbol symbol edges have passed since the clock was started
+// Returns false if it was interrupted by serial data from the PC
+boolean SymbolClockWait(uint8_t Symbol)
+{
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    while (SymbolCount < Symbol)
+    {
+        if (Serial.available())
+        {
+            return false;
+        }
+        cli();
+        if (SymbolCount < Symbol)
+        {
+            sleep_enable();
+            sei(); // The instruction after sei is always executed so the timer interrupt can not sneak in before we sleep
+            sleep_cpu();
+            sleep_disable();
+        }
+        sei();
+    }
+    return true;
+}
@@ -0,0 +1,263 @@
+#include "telemetry.hpp"
+#include <NMEAGPS.h>
+#include "defines.hpp"
+#include "state_machine.hpp"
+#include "binary_protocol.hpp"
+#include "print_operations.hpp"
+#include "Si5351.hpp"
+
+extern NMEAGPS gps;         // This parses the GPS characters
+extern uint8_t CurrentBand; // Keeps track on what band we are currently tranmitting on
+
+struct S_TelemetryMessage
+{
+    uint8_t UpdateType;
+    uint8_t MaxBytes; // Longest the message can be, text or binary
+};
+
+// Highest priority first, a message is only sent when all messages above it have gone out
+const S_TelemetryMessage TelemetryMessages[] PROGMEM = {
+    {UMesTXOn, 9},
+    {UMesTXOff, 9},
+    {UMesTXProgress, 14},
+    {UMesCurrentMode, 18},
+    {UMesWSPRBandCycleComplete, 7},
+    {UMesGPSLock, 9},
+    {UMesNoGPSLock, 9},
+    {UMesTime, 16},
+    {UMesPause, 13},
+    {UMesBand, 10},
+    {UMesTXFreq, 20},
+    {UMesFreq, 20},
+    {UMesLPF, 9},
+    {UMesLocator, 26},
+    {UMesVCC, 12},
+    {UMesSatData, 26}};
+
+#define TELEMETRY_BIT(UpdateType) (1U << ((UpdateType) - 1))
+
+static uint16_t Pending; // One bit per posted message, a message posted twice is only sent once with the latest data
+static boolean Held;     // No sending at all, set during the last seconds before a transmission starts
+static uint16_t Budget = TELEMETRY_BYTES_PER_SECOND;
+static unsigned long LastRefill;
+static uint8_t TXIndicator;   // Value of the last UMesTXProgress
+static uint32_t PauseSeconds; // Value of the last UMesPause
+static uint8_t SatIndex;      // Next satellite to send
+
+void TelemetryPost(uint8_t UpdateType)
+{
+    // The two messages of a state replace each other so the last posted state is the one the PC sees
+    switch (UpdateType)
+    {
+    case UMesTXOn:
+        Pending &= ~TELEMETRY_BIT(UMesTXOff);
+        break;
+
+    case UMesTXOff:
+        Pending &= ~TELEMETRY_BIT(UMesTXOn);
+        break;
+
+    case UMesGPSLock:
+        Pending &= ~TELEMETRY_BIT(UMesNoGPSLock);
+        break;
+
+    case UMesNoGPSLock:
+        Pending &= ~TELEMETRY_BIT(UMesGPSLock);
+        break;
+
+    case UMesSatData:
+        if (Pending & TELEMETRY_BIT(UMesSatData))
+        {
+            return; // Carry on with the list that is already going out
+        }
+        SatIndex = 0;
+        break;
+    }
+    Pending |= TELEMETRY_BIT(UpdateType);
+}
+
+void TelemetryPostValue(uint8_t UpdateType, uint32_t Value)
+{
+    if (UpdateType == UMesTXProgress)
+    {
+        TXIndicator = Value;
+    }
+    else
+    {
+        PauseSeconds = Value;
+    }
+    TelemetryPost(UpdateType);
+}
+
+// While held, updates are only collected. Used for the last seconds before a transmission starts
+void TelemetryHold(boolean Hold)
+{
+    Held = Hold;
+}
+
+// Symbol indicator of the transmission {TWS}
+static void SendTXProgress()
+{
+    uint8_t Progress[2];
+
+    if (BinaryMode)
+    {
+        Progress[0] = CurrentBand;
+        Progress[1] = TXIndicator;
+        BinSend(BIN_MSG_TX_PROGRESS, Progress, 2);
+        return;
+    }
+    Serial.print(F("{TWS} "));
+    SerialPrintPadded(CurrentBand, 2);
+    Serial.print(' ');
+    SerialPrintPadded(TXIndicator, 3);
+    Serial.println();
+}
+
+// Seconds left of a pause {MPS}
+static void SendPause()
+{
+    if (BinaryMode)
+    {
+        BinSend(BIN_MSG_PAUSE, &PauseSeconds, 4);
+        return;
+    }
+    Serial.print(F("{MPS} "));
+    Serial.println(PauseSeconds);
+}
+
+// The band we are using at the moment {TBN}
+static void SendBand()
+{
+    if (BinaryMode)
+    {
+        BinSendByte(BIN_MSG_BAND, CurrentBand);
+        return;
+    }
+    Serial.print(F("{TBN} "));
+    SerialPrintPadded(CurrentBand, 2);
+    Serial.println();
+}
+
+// Sends the Sattelite data like Elevation, Azimuth SNR and ID using the Serial API {GSI} format.
+// One satellite, or one binary message of up to TELEMETRY_SAT_BATCH satellites, at a time. Returns true when the list is complete
+static boolean SendSatData()
+{
+    uint8_t Payload[TELEMETRY_SAT_BATCH * 5];
+    uint8_t Length = 0;
+    uint8_t SNR;
+
+    if (SatIndex >= gps.sat_count)
+    {
+        if (BinaryMode)
+        {
+            BinSend(BIN_MSG_SATELLITES, NULL, 0); // An empty message ends the list
+        }
+        else
+        {
+            Serial.println();
+        }
+        return true;
+    }
+    if (BinaryMode)
+    {
+        while ((SatIndex < gps.sat_count) && (Length < sizeof(Payload)))
+        {
+            Payload[Length++] = gps.satellites[SatIndex].id;
+            Payload[Length++] = gps.satellites[SatIndex].azimuth & 0xFF;
+            Payload[Length++] = gps.satellites[SatIndex].azimuth >> 8;
+            Payload[Length++] = gps.satellites[SatIndex].elevation;
+            Payload[Length++] = gps.satellites[SatIndex].tracked ? gps.satellites[SatIndex].snr : 0;
+            SatIndex++;
+        }
+        BinSend(BIN_MSG_SATELLITES, Payload, Length);
+        return false;
+    }
+    SNR = 0;
+    if (gps.satellites[SatIndex].tracked)
+    {
+        SNR = gps.satellites[SatIndex].snr;
+    }
+    Serial.print(F("{GSI} "));
+    SerialPrintPadded(gps.satellites[SatIndex].id, 2);
+    Serial.print(' ');
+    SerialPrintPadded(gps.satellites[SatIndex].azimuth, 3);
+    Serial.print(' ');
+    SerialPrintPadded(gps.satellites[SatIndex].elevation, 2);
+    Serial.print(' ');
+    SerialPrintPadded(SNR, 2);
+    Serial.println();
+    SatIndex++;
+    return false;
+}
+
+// Sends one posted message, returns false if there is more of it left to send
+static boolean SendTelemetry(uint8_t UpdateType)
+{
+    switch (UpdateType)
+    {
+    case UMesSatData:
+        return SendSatData();
+
+    case UMesTXProgress:
+        SendTXProgress();
+        break;
+
+    case UMesPause:
+        SendPause();
+        break;
+
+    case UMesBand:
+        SendBand();
+        break;
+
+    case UMesTXFreq:
+        si5351aSendFrequency();
+        break;
+
+    default:
+        SendAPIUpdate(UpdateType);
+    }
+    return true;
+}
+
+// Sends posted messages in priority order for as long as they fit both in the byte budget and in the free space of
+// the Serial TX buffer, so it never waits for the UART. Call it often, it returns at once when there is nothing to do
+void TelemetryDrain()
+{
+    S_TelemetryMessage Msg;
+    unsigned long Elapsed = millis() - LastRefill;
+    uint16_t Refill;
+
+    if (Elapsed >= 1000)
+    {
+        Budget = TELEMETRY_BYTES_PER_SECOND;
+        LastRefill += Elapsed;
+    }
+    else
+    {
+        Refill = Elapsed * TELEMETRY_BYTES_PER_SECOND / 1000;
+        LastRefill += (uint32_t)Refill * 1000 / TELEMETRY_BYTES_PER_SECOND; // Keep the fraction of a byte for the next refill
+        Budget = ((Budget + Refill) > TELEMETRY_BYTES_PER_SECOND) ? TELEMETRY_BYTES_PER_SECOND : Budget + Refill;
+    }
+    if (Held || (Pending == 0))
+    {
+        return;
+    }
+    for (uint8_t i = 0; i < sizeof(TelemetryMessages) / sizeof(TelemetryMessages[0]); i++)
+    {
+        memcpy_P(&Msg, &TelemetryMessages[i], sizeof(Msg));
+        while (Pending & TELEMETRY_BIT(Msg.UpdateType))
+        {
+            if ((Msg.MaxBytes > Budget) || (Msg.MaxBytes > Serial.availableForWrite()))
+            {
+                return; // Wait for room rather than let a less important message overtake this one
+            }
+            Budget -= Msg.MaxBytes;
+            if (SendTelemetry(Msg.UpdateType))
+            {
+                Pending &= ~TELEMETRY_BIT(Msg.UpdateType);
+            }
+        }
+    }
+}
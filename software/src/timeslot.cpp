@@ -0,0 +1,86 @@
+#include "timeslot.hpp"
+
+// True if the schedule lets a transmission start on Minute (0-59) of the hour. In tracker mode every even minute is
+// allowed here, the caller also checks if the unit has moved
+boolean TimeslotMinute(uint8_t TimeSlotCode, uint8_t Band, uint8_t Minute)
+{
+    boolean CorrectSlot = false;
+    uint8_t ScheduleLenght;
+    uint8_t SlotCode;
+
+    if ((Minute % 2) == 0) // First check that it an even minute as WSPR transmissions only start on even minute
+    {
+        if ((TimeSlotCode == TIMESLOT_TRACKER) || (TimeSlotCode == TIMESLOT_ANY)) // No scheduling
+        {
+            CorrectSlot = true;
+        }
+        else if (TimeSlotCode == TIMESLOT_BAND_COORDINATED) // Band coordinated scheduling
+        {
+            switch (Band)
+            {
+            case 2: // 160m band
+                CorrectSlot = (Minute == 0 || Minute == 20 || Minute == 40);
+                break;
+            case 3: // 80m band
+                CorrectSlot = (Minute == 2 || Minute == 22 || Minute == 42);
+                break;
+            case 4: // 40m band
+                CorrectSlot = (Minute == 6 || Minute == 26 || Minute == 46);
+                break;
+            case 5: // 30m band
+                CorrectSlot = (Minute == 8 || Minute == 28 || Minute == 48);
+                break;
+            case 6: // 20m band
+                CorrectSlot = (Minute == 10 || Minute == 30 || Minute == 50);
+                break;
+            case 7: // 17m band
+                CorrectSlot = (Minute == 12 || Minute == 32 || Minute == 52);
+                break;
+            case 8: // 15m band
+                CorrectSlot = (Minute == 14 || Minute == 34 || Minute == 54);
+                break;
+            case 9: // 12m band
+                CorrectSlot = (Minute == 16 || Minute == 36 || Minute == 56);
+                break;
+            case 10: // 10m band
+                CorrectSlot = (Minute == 18 || Minute == 38 || Minute == 58);
+                break;
+            default:
+                CorrectSlot = true; // band does not have schedule, allow it to transmit right now, this applies to 1290m,630m and all bands above 10m
+                break;
+            }
+        }
+        else if (TimeSlotCode < TIMESLOT_BAND_COORDINATED) // Schedule is on the minute set on Timeslotcode * 2  E.g if Timeslotcode is 3 then minute 06,16,26,36,46 and 56 is used for transmissions.
+        {
+            if (TimeSlotCode < 5)
+            {
+                ScheduleLenght = 10;
+                SlotCode = TimeSlotCode;
+            }
+            else
+            {
+                ScheduleLenght = 20;
+                SlotCode = TimeSlotCode - 5;
+            }
+            CorrectSlot = ((Minute % ScheduleLenght) == (SlotCode * 2)); // if the TimeSlotcode multiplied with 2 (only even minutes) is matching the minute within the schedule then transmit
+        }
+    }
+    return CorrectSlot;
+}
+
+// Seconds from HourSecond, the seconds past the hour, to the start of the first slot at least MinSeconds away that the schedule allows.
+// A slot starting right at HourSecond + MinSeconds counts. Returns MinSeconds if the schedule has no slot at all
+uint32_t SecondsToNextSlot(uint8_t TimeSlotCode, uint8_t Band, uint16_t HourSecond, uint32_t MinSeconds)
+{
+    uint32_t Minute = (HourSecond + MinSeconds + 59) / 60; // First whole minute far enough away, counted from the start of this hour
+
+    for (uint8_t i = 0; i < 60; i++) // All schedules repeat within the hour
+    {
+        if (TimeslotMinute(TimeSlotCode, Band, Minute % 60))
+        {
+            return Minute * 60 - HourSecond;
+        }
+        Minute++;
+    }
+    return MinSeconds;
+}
@@ -0,0 +1,191 @@
+#include "ubx.hpp"
+#include "defines.hpp"
+#include "gps_transport.hpp"
+
+// Sends one byte of a frame and adds it to the checksum
+static void UBXSendByte(uint8_t Data, uint8_t *Checksum)
+{
+    GPSSerial.write(Data);
+    Checksum[0] += Data;
+    Checksum[1] += Checksum[0];
+}
+
+// Sends a UBX frame to the GPS, the checksum is calculated on the way so no frame buffer is needed
+void UBXSend(uint8_t Class, uint8_t ID, const uint8_t *Payload, uint8_t Length)
+{
+    uint8_t Checksum[2] = {0, 0};
+
+    GPSSerial.write(UBX_SYNC_1);
+    GPSSerial.write(UBX_SYNC_2);
+    UBXSendByte(Class, Checksum);
+    UBXSendByte(ID, Checksum);
+    UBXSendByte(Length, Checksum);
+    UBXSendByte(0, Checksum); // High byte of the length, all our payloads are short
+    for (uint8_t i = 0; i < Length; i++)
+    {
+        UBXSendByte(Payload[i], Checksum);
+    }
+    GPSSerial.write(Checksum[0]);
+    GPSSerial.write(Checksum[1]);
+}
+
+// Waits for the ACK-ACK or ACK-NAK of a CFG message. Returns true on ACK-ACK, false on ACK-NAK or timeout.
+// NMEA data received meanwhile is thrown away
+static boolean UBXWaitAck(uint8_t Class, uint8_t ID)
+{
+    const uint8_t Expected[8] = {UBX_SYNC_1, UBX_SYNC_2, UBX_CLASS_ACK, UBX_ACK_ACK, 2, 0, Class, ID};
+    uint8_t Frame[10]; // ACK frames are always ten bytes
+    uint8_t Count = 0;
+    uint8_t Checksum[2];
+    unsigned long Start = millis();
+
+    while ((millis() - Start) < UBX_ACK_TIMEOUT)
+    {
+        if (!GPSSerial.available())
+        {
+            continue;
+        }
+        Frame[Count] = GPSSerial.read();
+        if ((Count < 8) && (Frame[Count] != Expected[Count]) && !((Count == 3) && (Frame[3] == UBX_ACK_NAK)))
+        {
+            Count = (Frame[Count] == UBX_SYNC_1); // Start over, the byte may begin the next frame
+            continue;
+        }
+        if (++Count == sizeof(Frame))
+        {
+            Checksum[0] = Checksum[1] = 0;
+            for (uint8_t i = 2; i < 8; i++)
+            {
+                Checksum[0] += Frame[i];
+                Checksum[1] += Checksum[0];
+            }
+            if ((Frame[8] == Checksum[0]) && (Frame[9] == Checksum[1]))
+            {
+                return (Frame[3] == UBX_ACK_ACK);
+            }
+            Count = 0;
+        }
+    }
+    return false;
+}
+
+// Sends a CFG message until it is acknowledged, at most UBX_RETRIES times. Returns false if the receiver did not accept it
+boolean UBXCommand(uint8_t Class, uint8_t ID, const uint8_t *Payload, uint8_t Length)
+{
+    for (uint8_t i = 0; i < UBX_RETRIES; i++)
+    {
+        UBXSend(Class, ID, Payload, Length);
+        if (UBXWaitAck(Class, ID))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Stores a 32 bit value little endian in a payload
+static void UBXPut32(uint8_t *Payload, uint32_t Value)
+{
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        Payload[i] = Value & 0xFF;
+        Value >>= 8;
+    }
+}
+
+// CFG-MSG, output rate of a message on the port the command is received on. Rate is in navigation solutions, 0 turns it off
+boolean UBXSetMessageRate(uint8_t Class, uint8_t ID, uint8_t Rate)
+{
+    uint8_t Payload[3] = {Class, ID, Rate};
+
+    return UBXCommand(UBX_CLASS_CFG, UBX_CFG_MSG, Payload, sizeof(Payload));
+}
+
+// CFG-RXM, power save mode or continuous mode. Power save uses the settings from UBXSetCyclicTracking
+boolean UBXSetPowerSave(boolean PowerSave)
+{
+    uint8_t Payload[2] = {8, PowerSave}; // The first byte is reserved and must be 8
+
+    return UBXCommand(UBX_CLASS_CFG, UBX_CFG_RXM, Payload, sizeof(Payload));
+}
+
+// CFG-PM2, cyclic tracking in power save mode. The receiver tracks the satellites for a fix every UpdatePeriod milliseconds
+// and sleeps in between. Without a fix it searches for SearchPeriod milliseconds at a time
+boolean UBXSetCyclicTracking(uint32_t UpdatePeriod, uint32_t SearchPeriod)
+{
+    uint8_t Payload[44];
+
+    memset(Payload, 0, sizeof(Payload));
+    Payload[0] = 1;                 // Message version
+    UBXPut32(&Payload[4], 0x21500); // Cyclic tracking, keep ephemeris up to date, wait for a time fix, limit peak current
+    UBXPut32(&Payload[8], UpdatePeriod);
+    UBXPut32(&Payload[12], SearchPeriod);
+    return UBXCommand(UBX_CLASS_CFG, UBX_CFG_PM2, Payload, sizeof(Payload));
+}
+
+// Satellite data for the PC, NMEA GSV or with GPS_UBX_Nav a NAV-SAT now and then.
+// A u-blox 7 does not know NAV-SAT and NAKs it, it sends NAV-SVINFO instead
+boolean UBXSetSatelliteData(boolean On)
+{
+    if (GPS_UBX_Nav)
+    {
+        if (UBXSetMessageRate(UBX_CLASS_NAV, UBX_NAV_SAT, On ? UBX_NAV_SAT_RATE : 0))
+        {
+            return true;
+        }
+        return UBXSetMessageRate(UBX_CLASS_NAV, UBX_NAV_SVINFO, On ? UBX_NAV_SAT_RATE : 0);
+    }
+    return UBXSetMessageRate(UBX_CLASS_NMEA, UBX_NMEA_GSV, On ? 1 : 0);
+}
+
+// Sets the receiver up for the beacon: only the NMEA sentences NeoGPS needs for position and time, or only NAV-PVT with GPS_UBX_Nav.
+// Satellite data only when it is sent on to a PC, and power save mode with a fix every second. Returns false if a setting was not accepted
+boolean UBXSetupReceiver(boolean SatelliteData)
+{
+    const uint8_t NMEAOff[] = {UBX_NMEA_GLL, UBX_NMEA_GSA, UBX_NMEA_VTG, UBX_NMEA_GSV, UBX_NMEA_GGA, UBX_NMEA_RMC}; // The last two only with GPS_UBX_Nav
+    boolean Accepted = true;
+
+    for (uint8_t i = 0; i < sizeof(NMEAOff) - (GPS_UBX_Nav ? 0 : 2); i++)
+    {
+        Accepted &= UBXSetMessageRate(UBX_CLASS_NMEA, NMEAOff[i], 0);
+    }
+    if (GPS_UBX_Nav)
+    {
+        Accepted &= UBXSetMessageRate(UBX_CLASS_NAV, UBX_NAV_PVT, 1);
+    }
+    if (SatelliteData)
+    {
+        Accepted &= UBXSetSatelliteData(true);
+    }
+    Accepted &= UBXSetCyclicTracking(1000, 10000);
+    Accepted &= UBXSetPowerSave(true);
+    return Accepted;
+}
+
+// RXM-PMREQ, backup mode. Only the RTC and the backup RAM with ephemeris and settings stay powered so the next fix is a hot start.
+// Duration is in milliseconds, 0 sleeps until woken with UBXWakeUp
+void UBXBackup(uint32_t Duration)
+{
+    uint8_t Payload[8];
+
+    UBXPut32(&Payload[0], Duration);
+    UBXPut32(&Payload[4], 2); // Flags, go to backup mode
+    UBXSend(UBX_CLASS_RXM, UBX_RXM_PMREQ, Payload, sizeof(Payload));
+    GPSSerial.flush();
+}
+
+// Any activity on the RX line of the receiver wakes it from backup mode, what is sent is lost
+void UBXWakeUp()
+{
+    GPSSerial.write(0xFF);
+    GPSSerial.flush();
+    delay(UBX_WAKE_TIME);
+}
+
+// CFG-RST, hot start of the GNSS part only, all settings and satellite data are kept
+void UBXReset()
+{
+    uint8_t Payload[4] = {0, 0, 2, 0}; // No backup RAM cleared, controlled software reset of the GNSS, reserved
+
+    UBXSend(UBX_CLASS_CFG, UBX_CFG_RST, Payload, sizeof(Payload));
+}
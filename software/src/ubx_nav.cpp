@@ -0,0 +1,327 @@
+#include "ubx_nav.hpp"
+#include "ubx.hpp"
+#include "defines.hpp"
+#include "gps_transport.hpp"
+
+#if GPS_UBX_Nav && !GPS_UBlox
+#error "GPS_UBX_Nav needs a u-blox receiver, set GPS_UBlox as well"
+#endif
+
+extern NMEAGPS gps; // Holds the satellite list that is sent to the PC
+
+uint32_t UBXNavHorizontalAccuracy;
+uint32_t UBXNavVerticalAccuracy;
+unsigned long UBXNavFixMillis;
+
+static gps_fix NavFix;       // Decoded in place, only valid when UBXNavAvailable has returned true
+static uint32_t Accuracy[2]; // hAcc and vAcc of the NAV-PVT being received
+static uint16_t Position;    // Bytes of the frame received so far
+static uint16_t Length;      // Payload length of the frame
+static uint8_t Class;        // Class and ID of the frame
+static uint8_t ID;
+static uint8_t Checksum[2]; // Running checksum of the frame
+static uint32_t Value;      // The last four payload bytes, the newest in the top byte. Multi byte fields are read from here
+static uint8_t FixType;     // GNSS fix type of the NAV-PVT being received
+static uint8_t SatsInFrame; // Number of satellites in the NAV-SAT or NAV-SVINFO being received
+
+// One byte of a NAV-PVT payload, the fields are picked up at their last byte
+static void DecodePVT(uint16_t Index, uint8_t Data)
+{
+    switch (Index)
+    {
+    case 0:
+        NavFix.init();
+        break;
+
+    case 5:
+        NavFix.dateTime.year = (Value >> 16) % 100; // NeoGPS keeps two digits
+        break;
+
+    case 6:
+        NavFix.dateTime.month = Data;
+        break;
+
+    case 7:
+        NavFix.dateTime.date = Data;
+        break;
+
+    case 8:
+        NavFix.dateTime.hours = Data;
+        break;
+
+    case 9:
+        NavFix.dateTime.minutes = Data;
+        break;
+
+    case 10:
+        NavFix.dateTime.seconds = Data;
+        break;
+
+    case 11:
+        NavFix.valid.date = Data & 0x01;
+        NavFix.valid.time = (Data & 0x06) == 0x06; // Valid and fully resolved, so the GPS to UTC leap seconds are known
+        break;
+
+    case 19:
+        NavFix.dateTime_cs = ((int32_t)Value > 0) ? Value / 10000000 : 0; // Nanoseconds to the second, can be negative
+        break;
+
+    case 20:
+        FixType = Data;
+        break;
+
+    case 21:
+        if (!(Data & 0x01)) // No fix within the accuracy limits
+        {
+            FixType = 0;
+        }
+        NavFix.status = (FixType == 0) ? gps_fix::STATUS_NONE : (FixType == 1) ? gps_fix::STATUS_EST : (FixType == 5) ? gps_fix::STATUS_TIME_ONLY : gps_fix::STATUS_STD;
+        NavFix.valid.status = true;
+        break;
+
+#ifdef GPS_FIX_SATELLITES
+    case 23:
+        NavFix.satellites = Data;
+        NavFix.valid.satellites = true;
+        break;
+#endif
+
+    case 27:
+        NavFix.location.lon(Value); // Both in 1e-7 degrees as NeoGPS
+        break;
+
+    case 31:
+        NavFix.location.lat(Value);
+        NavFix.valid.location = (FixType >= 2) && (FixType <= 4);
+        break;
+
+    case 39:
+        NavFix.alt.whole = (int32_t)Value / 1000; // Height above mean sea level in mm
+        NavFix.alt.frac = ((int32_t)Value % 1000) / 10;
+        NavFix.valid.altitude = (FixType == 3) || (FixType == 4);
+        break;
+
+    case 43:
+        Accuracy[0] = Value;
+        break;
+
+    case 47:
+        Accuracy[1] = Value;
+        break;
+
+#ifdef GPS_FIX_SPEED
+    case 63:
+        Value = ((int32_t)Value > 0) ? Value * 36 / 1852 * 100 + (Value * 36 % 1852) * 100 / 1852 : 0; // mm/s to thousandths of a knot
+        NavFix.spd.whole = Value / 1000;
+        NavFix.spd.frac = Value % 1000;
+        NavFix.valid.speed = NavFix.valid.location;
+        break;
+#endif
+
+#ifdef GPS_FIX_HEADING
+    case 67:
+        NavFix.hdg = Value / 1000; // 1e-5 to 1e-2 degrees
+        NavFix.valid.heading = NavFix.valid.location;
+        break;
+#endif
+    }
+}
+
+// One byte of a NAV-SAT payload. An eight byte header and then twelve bytes for each satellite.
+// The satellites go straight in to the NeoGPS list, the count is only updated when the checksum is right
+static void DecodeSAT(uint16_t Index, uint8_t Data)
+{
+    uint8_t Sat;
+
+    if (Index < 8)
+    {
+        SatsInFrame = 0;
+        return;
+    }
+    Sat = (Index - 8) / 12;
+    if (Sat >= sizeof(gps.satellites) / sizeof(gps.satellites[0]))
+    {
+        return;
+    }
+    switch ((Index - 8) % 12)
+    {
+    case 1: // GNSS and satellite ID, numbered as in NMEA where GLONASS is 65 and up
+        gps.satellites[Sat].id = (Value >> 24) + ((((Value >> 16) & 0xFF) == 6) ? 64 : 0);
+        SatsInFrame = Sat + 1;
+        break;
+
+    case 2:
+        gps.satellites[Sat].snr = (Data > 99) ? 99 : Data;
+        break;
+
+    case 3:
+        gps.satellites[Sat].elevation = ((int8_t)Data < 0) ? 0 : Data;
+        break;
+
+    case 5:
+        gps.satellites[Sat].azimuth = Value >> 16;
+        break;
+
+    case 8:
+        gps.satellites[Sat].tracked = (Data & 0x07) >= 4; // Code locked
+        break;
+    }
+}
+
+// One byte of a NAV-SVINFO payload, the u-blox 7 counterpart of NAV-SAT. An eight byte header and then twelve bytes
+// for each channel, the satellite IDs are already numbered as in NMEA
+static void DecodeSVINFO(uint16_t Index, uint8_t Data)
+{
+    uint8_t Sat;
+
+    if (Index < 8)
+    {
+        SatsInFrame = 0;
+        return;
+    }
+    Sat = (Index - 8) / 12;
+    if (Sat >= sizeof(gps.satellites) / sizeof(gps.satellites[0]))
+    {
+        return;
+    }
+    switch ((Index - 8) % 12)
+    {
+    case 1:
+        gps.satellites[Sat].id = Data;
+        SatsInFrame = Sat + 1;
+        break;
+
+    case 3:
+        gps.satellites[Sat].tracked = (Data & 0x0F) >= 4; // Code locked
+        break;
+
+    case 4:
+        gps.satellites[Sat].snr = (Data > 99) ? 99 : Data;
+        break;
+
+    case 5:
+        gps.satellites[Sat].elevation = ((int8_t)Data < 0) ? 0 : Data;
+        break;
+
+    case 7:
+        gps.satellites[Sat].azimuth = Value >> 16;
+        break;
+    }
+}
+
+// Feeds one received byte to the decoder. Returns true when a NAV-PVT with the right checksum is complete
+static boolean UBXNavByte(uint8_t Data)
+{
+    uint16_t Index = Position - 6; // Payload byte
+
+    switch (Position)
+    {
+    case 0:
+        Position = (Data == UBX_SYNC_1);
+        return false;
+
+    case 1:
+        Position = (Data == UBX_SYNC_2) ? 2 : (Data == UBX_SYNC_1);
+        Checksum[0] = Checksum[1] = 0;
+        return false;
+    }
+    if ((Position < 6) || (Index < Length)) // Header and payload are in the checksum
+    {
+        Checksum[0] += Data;
+        Checksum[1] += Checksum[0];
+    }
+    switch (Position)
+    {
+    case 2:
+        Class = Data;
+        Length = 0;
+        break;
+
+    case 3:
+        ID = Data;
+        break;
+
+    case 4:
+        Length = Data;
+        break;
+
+    case 5:
+        Length |= Data << 8;
+        if (Length > 1024) // Not a frame we know, look for the next one
+        {
+            Position = 0;
+            return false;
+        }
+        break;
+
+    default:
+        if (Index < Length)
+        {
+            Value = (Value >> 8) | ((uint32_t)Data << 24);
+            if ((Class == UBX_CLASS_NAV) && (ID == UBX_NAV_PVT) && (Index < UBX_NAV_PVT_LENGTH))
+            {
+                DecodePVT(Index, Data);
+            }
+            if ((Class == UBX_CLASS_NAV) && (ID == UBX_NAV_SAT))
+            {
+                DecodeSAT(Index, Data);
+            }
+            if ((Class == UBX_CLASS_NAV) && (ID == UBX_NAV_SVINFO))
+            {
+                DecodeSVINFO(Index, Data);
+            }
+        }
+        else if (Index == Length) // First checksum byte
+        {
+            if (Data != Checksum[0])
+            {
+                Position = (Data == UBX_SYNC_1);
+                return false;
+            }
+        }
+        else // Second checksum byte, the frame is complete
+        {
+            Position = 0;
+            if ((Data != Checksum[1]) || (Class != UBX_CLASS_NAV))
+            {
+                return false;
+            }
+            if ((ID == UBX_NAV_SAT) || (ID == UBX_NAV_SVINFO))
+            {
+                gps.sat_count = SatsInFrame;
+            }
+            if ((ID == UBX_NAV_PVT) && (Length >= UBX_NAV_PVT_LENGTH))
+            {
+                UBXNavHorizontalAccuracy = Accuracy[0];
+                UBXNavVerticalAccuracy = Accuracy[1];
+                if (NavFix.valid.location)
+                {
+                    UBXNavFixMillis = millis();
+                }
+                return true;
+            }
+            return false;
+        }
+    }
+    Position++;
+    return false;
+}
+
+// Decodes what the GPS has sent, returns true as soon as a new fix is ready for UBXNavRead. Works like gps.available() of NeoGPS
+boolean UBXNavAvailable()
+{
+    while (GPSSerial.available())
+    {
+        if (UBXNavByte(GPSSerial.read()))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The fix of the NAV-PVT that UBXNavAvailable has just found
+gps_fix UBXNavRead()
+{
+    return NavFix;
+}
@@ -1,7 +1,6 @@
 #include "wspr_packet_formatting.hpp"
 #include "datatypes.hpp"
-
-#define WSPR_SYMBOL_COUNT 162
+#include <avr/pgmspace.h>
 
 // macro functions
 #define rot(x, k) ((x << k) | (x >> (32 - k)))
@@ -11,8 +10,7 @@ char callsign[7];
 char locator[5];
 uint8_t power;
 
-uint8_t symbolSequence[WSPR_SYMBOL_COUNT];
-uint8_t tx_buffer[WSPR_SYMBOL_COUNT];
+uint8_t tx_buffer[WSPR_PACKED_SIZE]; // Channel symbols, 2 bits each and four to a byte. Symbol 0 in the low bits of byte 0
 
 uint8_t *get_tx_buffer_ptr()
 {
@@ -23,6 +21,13 @@ uint8_t get_tx_buffer_size()
 {
     return sizeof(tx_buffer);
 }
+
+// Returns channel symbol i (0-3) from the packed symbol buffer
+uint8_t get_tx_symbol(uint8_t i)
+{
+    return (tx_buffer[i >> 2] >> ((i & 0x03) << 1)) & 0x03;
+}
+
 // Converts a letter (A-Z) or digit (0-9)to a special format used in the encoding of WSPR messages
 uint8_t EncodeChar(char Character)
 {
@@ -45,7 +50,7 @@ uint8_t EncodeChar(char Character)
     return ConvertedNumber;
 }
 
-void wspr_encode(const char *call, const char *loc, const uint8_t dbm, uint8_t *symbols, uint8_t WSPRMessageType, S_GadgetData GadgetData)
+void wspr_encode(const char *call, const char *loc, const uint8_t dbm, uint8_t *symbols, uint8_t WSPRMessageType, const S_GadgetData &GadgetData)
 {
     char call_[7];
     char loc_[5];
@@ -148,18 +153,10 @@ void wspr_encode(const char *call, const char *loc, const uint8_t dbm, uint8_t *
     c[9] = 0;
     c[10] = 0;
 
-    // Convolutional Encoding
-    // ---------------------
-    uint8_t s[WSPR_SYMBOL_COUNT];
-    convolve(c, s, 11, WSPR_SYMBOL_COUNT);
-
-    // Interleaving
-    // ------------
-    wspr_interleave(s);
-
-    // Merge with sync vector
-    // ----------------------
-    wspr_merge_sync_vector(s, symbols);
+    // Convolutional Encoding, Interleaving and Merge with sync vector
+    // ---------------------------------------------------------------
+    memset(symbols, 0, WSPR_PACKED_SIZE);
+    convolve(c, symbols, 11, WSPR_SYMBOL_COUNT);
 }
 
 void wspr_message_prep(char *call, char *loc, uint8_t dbm)
@@ -232,110 +229,85 @@ uint8_t ValiddBmValue(uint8_t dBmIn)
     return validateddBmValue;
 }
 
-void convolve(uint8_t *c, uint8_t *s, uint8_t message_size, uint8_t bit_size)
+// Reverses the bit order of a byte
+constexpr uint8_t bit_reverse(uint8_t j)
 {
-    uint32_t reg_0 = 0;
-    uint32_t reg_1 = 0;
-    uint32_t reg_temp = 0;
-    uint8_t input_bit, parity_bit;
-    uint8_t bit_count = 0;
-    uint8_t i, j, k;
-
-    for (i = 0; i < message_size; i++)
-    {
-        for (j = 0; j < 8; j++)
-        {
-            // Set input bit according the MSB of current element
-            input_bit = (((c[i] << j) & 0x80) == 0x80) ? 1 : 0;
-
-            // Shift both registers and put in the new input bit
-            reg_0 = reg_0 << 1;
-            reg_1 = reg_1 << 1;
-            reg_0 |= (uint32_t)input_bit;
-            reg_1 |= (uint32_t)input_bit;
-
-            // AND Register 0 with feedback taps, calculate parity
-            reg_temp = reg_0 & 0xf2d05351;
-            parity_bit = 0;
-            for (k = 0; k < 32; k++)
-            {
-                parity_bit = parity_bit ^ (reg_temp & 0x01);
-                reg_temp = reg_temp >> 1;
-            }
-            s[bit_count] = parity_bit;
-            bit_count++;
-
-            // AND Register 1 with feedback taps, calculate parity
-            reg_temp = reg_1 & 0xe4613c47;
-            parity_bit = 0;
-            for (k = 0; k < 32; k++)
-            {
-                parity_bit = parity_bit ^ (reg_temp & 0x01);
-                reg_temp = reg_temp >> 1;
-            }
-            s[bit_count] = parity_bit;
-            bit_count++;
-            if (bit_count >= bit_size)
-            {
-                break;
-            }
-        }
-    }
+    return ((j & 0x01) << 7) | ((j & 0x02) << 5) | ((j & 0x04) << 3) | ((j & 0x08) << 1) |
+           ((j & 0x10) >> 1) | ((j & 0x20) >> 3) | ((j & 0x40) >> 5) | ((j & 0x80) >> 7);
 }
 
-void wspr_interleave(uint8_t *s)
+// Interleaved position of encoded bit n. The WSPR interleaver places the bits in bit reversed
+// index order, skipping reversed indexes that fall outside the 162 symbols. Search starts at index j
+constexpr uint8_t interleave_pos(uint8_t n, uint8_t j = 0)
 {
-    uint8_t d[WSPR_SYMBOL_COUNT];
-    uint8_t rev, index_temp, i, j, k;
+    return (bit_reverse(j) < WSPR_SYMBOL_COUNT) ? ((n == 0) ? bit_reverse(j) : interleave_pos(n - 1, j + 1)) : interleave_pos(n, j + 1);
+}
 
-    i = 0;
+// The interleave permutation is generated by the compiler and only the result ends up in flash
+#define IP1(n) interleave_pos(n)
+#define IP2(n) IP1(n), IP1(n + 1)
+#define IP4(n) IP2(n), IP2(n + 2)
+#define IP8(n) IP4(n), IP4(n + 4)
+#define IP16(n) IP8(n), IP8(n + 8)
+#define IP32(n) IP16(n), IP16(n + 16)
+#define IP64(n) IP32(n), IP32(n + 32)
+#define IP128(n) IP64(n), IP64(n + 64)
 
-    for (j = 0; j < 255; j++)
-    {
-        // Bit reverse the index
-        index_temp = j;
-        rev = 0;
+const uint8_t InterleavePos[WSPR_SYMBOL_COUNT] PROGMEM = {IP128(0), IP32(128), IP2(160)};
 
-        for (k = 0; k < 8; k++)
-        {
-            if (index_temp & 0x01)
-            {
-                rev = rev | (1 << (7 - k));
-            }
-            index_temp = index_temp >> 1;
-        }
+// WSPR sync vector, one bit per symbol, MSB first
+const uint8_t SyncVector[(WSPR_SYMBOL_COUNT + 7) / 8] PROGMEM =
+    {0xc0, 0x8e, 0x25, 0xe0, 0x25, 0x02, 0xcd, 0x1a, 0x1a, 0xa9, 0x2c,
+     0x6a, 0x20, 0x93, 0xb3, 0x47, 0x05, 0x30, 0x1a, 0xc6, 0x00};
 
-        if (rev < WSPR_SYMBOL_COUNT)
-        {
-            d[rev] = s[i];
-            i++;
-        }
+static inline uint8_t sync_bit(uint8_t i)
+{
+    return (pgm_read_byte(&SyncVector[i >> 3]) >> (7 - (i & 0x07))) & 0x01;
+}
 
-        if (i >= WSPR_SYMBOL_COUNT)
-        {
-            break;
-        }
-    }
+static inline void set_symbol(uint8_t *symbols, uint8_t i, uint8_t symbol)
+{
+    symbols[i >> 2] |= symbol << ((i & 0x03) << 1);
+}
 
-    memcpy(s, d, WSPR_SYMBOL_COUNT);
+// Parity of a 32 bit word. The four bytes are XOR folded to one, then to a nibble,
+// and the parity of the nibble is looked up in the 16 bit constant 0x6996 (bit n is the parity of n)
+static inline uint8_t parity32(uint32_t x)
+{
+    uint8_t p = (uint8_t)x ^ (uint8_t)(x >> 8) ^ (uint8_t)(x >> 16) ^ (uint8_t)(x >> 24);
+    p ^= p >> 4;
+    return (0x6996 >> (p & 0x0f)) & 0x01;
 }
 
-void wspr_merge_sync_vector(uint8_t *g, uint8_t *symbols)
+// Rate 1/2, constraint length 32 convolutional encoder
+// Both polynomials see the same input bits so one shift register is enough.
+// Each encoded bit is written straight to its interleaved position and merged with the sync vector there,
+// so the channel symbols are built in a single pass without any temporary buffers.
+// symbols is the packed 2 bit symbol buffer and must be cleared before the call
+void convolve(uint8_t *c, uint8_t *symbols, uint8_t message_size, uint8_t bit_size)
 {
-    uint8_t i;
-    const uint8_t sync_vector[WSPR_SYMBOL_COUNT] =
-        {1, 1, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 1, 1, 1, 0, 0, 0, 1, 0, 0,
-         1, 0, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 1, 0, 1, 0, 0,
-         0, 0, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 0, 1, 1, 0, 1,
-         0, 0, 0, 0, 1, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 0,
-         1, 1, 0, 0, 0, 1, 1, 0, 1, 0, 1, 0, 0, 0, 1, 0, 0, 0, 0, 0, 1,
-         0, 0, 1, 0, 0, 1, 1, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 0, 1,
-         1, 1, 0, 0, 0, 0, 0, 1, 0, 1, 0, 0, 1, 1, 0, 0, 0, 0, 0, 0, 0,
-         1, 1, 0, 1, 0, 1, 1, 0, 0, 0, 1, 1, 0, 0, 0};
-
-    for (i = 0; i < WSPR_SYMBOL_COUNT; i++)
+    uint32_t reg = 0;
+    uint8_t bit_count = 0;
+    uint8_t i, j, in_byte, pos;
+
+    for (i = 0; i < message_size; i++)
     {
-        symbols[i] = sync_vector[i] + (2 * g[i]);
+        in_byte = c[i];
+        for (j = 0; j < 8; j++)
+        {
+            // Shift in the MSB of the current element
+            reg = (reg << 1) | (in_byte >> 7);
+            in_byte <<= 1;
+
+            pos = pgm_read_byte(&InterleavePos[bit_count++]);
+            set_symbol(symbols, pos, sync_bit(pos) | (parity32(reg & 0xf2d05351) << 1));
+            pos = pgm_read_byte(&InterleavePos[bit_count++]);
+            set_symbol(symbols, pos, sync_bit(pos) | (parity32(reg & 0xe4613c47) << 1));
+            if (bit_count >= bit_size)
+            {
+                return;
+            }
+        }
     }
 }
 
@@ -363,11 +335,11 @@ uint8_t wspr_code(char c)
 }
 
 // Type 3 call sign hash by RFZero www.rfzero.net modified by SM7PNV
-uint32_t WSPRCallHash(const char *call, S_GadgetData GadgetData)
+uint32_t WSPRCallHash(const char *call, const S_GadgetData &GadgetData)
 {
 
     uint32_t a, b, c;
-    char CallWithSuPrefix[11];
+    char CallWithSuPrefix[12]; // Up to 10 characters, the hash reads whole 32 bit words
     uint8_t Length = strlen(call);
     uint8_t CharLoop;
     Serial.print("Length ");
@@ -388,32 +360,27 @@ uint32_t WSPRCallHash(const char *call, S_GadgetData GadgetData)
                 CallWithSuPrefix[Length + 1] = 'A' + (GadgetData.WSPRData.Sufix - 10); // Add a single letter
             }
         }
-        else // Suffix is double digits
+        else // Suffix is double digits, 10-99 is coded as 36-125
         {
-            /* Seems the Type 3 decodes are not correct in case of two suffix numbers so this code is commented out for now as it will not be used by the Configurtion software
-              Number=GadgetData.WSPRData.Sufix-36;
-              while (Number>9)
-              {
-              ++TenDigit;
-              Number -= 10;
-              }
-              CallWithSuPrefix[Length+1]='0'+TenDigit; //Add the Ten Digit
-              CallWithSuPrefix[Length+2]='0'+Number; //Add the One Digit
-              CallWithSuPrefix[Length+3]=0; //Zero terminate
-            */
+            CallWithSuPrefix[Length + 1] = '0' + (GadgetData.WSPRData.Sufix - 26) / 10; // Add the ten digit
+            CallWithSuPrefix[Length + 2] = '0' + (GadgetData.WSPRData.Sufix - 26) % 10; // Add the one digit
+            CallWithSuPrefix[Length + 3] = 0;                                          // Zero terminate
         }
     } // if Sufix
     else if (GadgetData.WSPRData.SuPreFixOption == Prefix)
     {
-        CallWithSuPrefix[0] = GadgetData.WSPRData.Prefix[0];
-        CallWithSuPrefix[1] = GadgetData.WSPRData.Prefix[1];
-        CallWithSuPrefix[2] = GadgetData.WSPRData.Prefix[2];
-        CallWithSuPrefix[3] = '/';
-
-        for (CharLoop = 0; CharLoop < Length; CharLoop++)
+        CharLoop = 0;
+        while ((CharLoop < 2) && (GadgetData.WSPRData.Prefix[CharLoop] == ' ')) // The prefix is right aligned, a short one is hashed without the padding
+        {
+            CharLoop++;
+        }
+        Length = 0;
+        while (CharLoop < 3)
         {
-            CallWithSuPrefix[CharLoop + 4] = call[CharLoop];
+            CallWithSuPrefix[Length++] = GadgetData.WSPRData.Prefix[CharLoop++];
         }
+        CallWithSuPrefix[Length++] = '/';
+        strcpy(&CallWithSuPrefix[Length], call);
     } // else if Prefix
 
     Length = strlen(CallWithSuPrefix);
@@ -482,38 +449,44 @@ uint32_t WSPRCallHash(const char *call, S_GadgetData GadgetData)
     return c;
 }
 
-// Maidenhead code from Ossi Väänänen https://ham.stackexchange.com/questions/221/how-can-one-convert-from-lat-long-to-grid-square
-void calcLocator(double lat, double lon, S_WSPRData *WSPRData)
+// Maidenhead locator from NeoGPS integer coordinates, lat and lon are in 1e-7 degrees (fix.latitudeL() and fix.longitudeL())
+// Fills in both the four and six character locators
+void calcLocator(int32_t lat, int32_t lon, S_WSPRData *WSPRData)
 {
-    int o1, o2, o3;
-    int a1, a2, a3;
-    double remainder;
-    // longitude
-    remainder = lon + 180.0;
-    o1 = (int)(remainder / 20.0);
-    remainder = remainder - (double)o1 * 20.0;
-    o2 = (int)(remainder / 2.0);
-    remainder = remainder - 2.0 * (double)o2;
-    o3 = (int)(12.0 * remainder);
-
-    // latitude
-    remainder = lat + 90.0;
-    a1 = (int)(remainder / 10.0);
-    remainder = remainder - (double)a1 * 10.0;
-    a2 = (int)(remainder);
-    remainder = remainder - (double)a2;
-    a3 = (int)(24.0 * remainder);
-
-    WSPRData->MaidenHead4[0] = (char)o1 + 'A';
-    WSPRData->MaidenHead4[1] = (char)a1 + 'A';
-    WSPRData->MaidenHead4[2] = (char)o2 + '0';
-    WSPRData->MaidenHead4[3] = (char)a2 + '0';
+    calcLocatorPrecise(lat, lon, WSPRData->MaidenHead6, 6);
+    memcpy(WSPRData->MaidenHead4, WSPRData->MaidenHead6, 4);
     WSPRData->MaidenHead4[4] = 0;
-    WSPRData->MaidenHead6[0] = (char)o1 + 'A';
-    WSPRData->MaidenHead6[1] = (char)a1 + 'A';
-    WSPRData->MaidenHead6[2] = (char)o2 + '0';
-    WSPRData->MaidenHead6[3] = (char)a2 + '0';
-    WSPRData->MaidenHead6[4] = (char)o3 + 'A';
-    WSPRData->MaidenHead6[5] = (char)a3 + 'A';
-    WSPRData->MaidenHead6[6] = 0;
-}
\ No newline at end of file
+}
+
+// Maidenhead locator with 4, 6, 8 or 10 characters, Locator must have room for Length characters and a zero termination
+// All in integer math, the remainders are kept in 1e-7 degrees until the square and after that scaled so 10000000 is one sub division
+void calcLocatorPrecise(int32_t lat, int32_t lon, char *Locator, uint8_t Length)
+{
+    uint32_t LonRem = lon + 1800000000L; // 1e-7 degrees east of 180W
+    uint32_t LatRem = lat + 900000000L;  // 1e-7 degrees north of 90S
+    uint8_t i;
+    char Base;
+
+    // Field, 20 by 10 degrees
+    Locator[0] = 'A' + LonRem / 200000000UL;
+    Locator[1] = 'A' + LatRem / 100000000UL;
+    LonRem %= 200000000UL;
+    LatRem %= 100000000UL;
+
+    // Square, 2 by 1 degrees
+    Locator[2] = '0' + LonRem / 20000000UL;
+    Locator[3] = '0' + LatRem / 10000000UL;
+    LonRem = (LonRem % 20000000UL) * 12; // Subsquares are 1/12 degree of longitude
+    LatRem = (LatRem % 10000000UL) * 24; // and 1/24 degree of latitude
+
+    // Subsquare (letters), extended square (digits) and extended subsquare (letters)
+    for (i = 4; i < Length; i += 2)
+    {
+        Base = (i & 0x02) ? '0' : 'A';
+        Locator[i] = Base + LonRem / 10000000UL;
+        Locator[i + 1] = Base + LatRem / 10000000UL;
+        LonRem = (LonRem % 10000000UL) * ((i & 0x02) ? 24 : 10);
+        LatRem = (LatRem % 10000000UL) * ((i & 0x02) ? 24 : 10);
+    }
+    Locator[Length] = 0;
+}
@@ -0,0 +1,259 @@
+// Binary framed protocol (binary_protocol.cpp), pio test -e native
+// Packets from BinSend are checked with a separate COBS decoder and fed back through BinReceiveByte. A packet with an ID
+// the device does not take from the host is answered with BIN_MSG_ERROR, so that reply shows the frame decoded and passed the CRC.
+
+#include <unity.h>
+#include "Arduino.h"
+#include "binary_protocol.hpp"
+
+#define TEST_ID 0x55 // Not a host to device message
+
+static uint8_t Out[1024];
+static uint16_t OutLength;
+
+static void Catch(uint8_t Data)
+{
+    if (OutLength < sizeof(Out))
+        Out[OutLength++] = Data;
+}
+
+// COBS decodes the frame between the first two zero delimiters of the output, returns the packet length or -1
+static int Decode(uint8_t *Packet)
+{
+    uint16_t Pos = 1;
+    int Length = 0;
+    uint8_t Code;
+
+    if ((OutLength < 2) || (Out[0] != 0))
+        return -1;
+    while (Out[Pos] != 0)
+    {
+        Code = Out[Pos++];
+        for (uint8_t i = 1; i < Code; i++)
+        {
+            if ((Pos >= OutLength) || (Out[Pos] == 0))
+                return -1;
+            Packet[Length++] = Out[Pos++];
+        }
+        if ((Code < 0xFF) && (Out[Pos] != 0))
+            Packet[Length++] = 0;
+    }
+    return Length;
+}
+
+// CRC-16/CCITT-FALSE bit by bit as in the spec, not through BinCRC16
+static uint16_t ReferenceCRC(const uint8_t *Data, uint8_t Length)
+{
+    uint16_t CRC = 0xFFFF;
+
+    for (uint8_t i = 0; i < Length; i++)
+    {
+        for (uint8_t Bit = 0; Bit < 8; Bit++)
+        {
+            boolean In = (Data[i] >> (7 - Bit)) & 1;
+            boolean Top = CRC >> 15;
+            CRC <<= 1;
+            if (In != Top)
+                CRC ^= 0x1021;
+        }
+    }
+    return CRC;
+}
+
+// Sends a packet with BinSend and checks it decodes to ID, payload and CRC, the frame is left in Frame
+static uint16_t SendAndCheck(const uint8_t *Payload, uint8_t Length, uint8_t *Frame)
+{
+    uint8_t Packet[BIN_MAX_PAYLOAD + 3];
+    uint16_t CRC;
+
+    OutLength = 0;
+    BinSend(TEST_ID, Payload, Length);
+    TEST_ASSERT_EQUAL(0, Out[OutLength - 1]);
+    for (uint16_t i = 1; i < OutLength - 1; i++)
+        TEST_ASSERT_TRUE(Out[i] != 0);
+    TEST_ASSERT_EQUAL(Length + 3, Decode(Packet));
+    TEST_ASSERT_EQUAL(TEST_ID, Packet[0]);
+    TEST_ASSERT_EQUAL_MEMORY(Payload, &Packet[1], Length);
+    CRC = ReferenceCRC(Packet, Length + 1);
+    TEST_ASSERT_EQUAL(CRC & 0xFF, Packet[Length + 1]);
+    TEST_ASSERT_EQUAL(CRC >> 8, Packet[Length + 2]);
+    memcpy(Frame, Out, OutLength);
+    return OutLength;
+}
+
+// Feeds a frame to the receiver, returns true if it was answered with BIN_MSG_ERROR for TEST_ID
+static boolean Receive(const uint8_t *Frame, uint16_t Length)
+{
+    uint8_t Packet[BIN_MAX_PAYLOAD + 3];
+
+    OutLength = 0;
+    for (uint16_t i = 0; i < Length; i++)
+        BinReceiveByte(Frame[i]);
+    if (OutLength == 0)
+        return false;
+    TEST_ASSERT_EQUAL(4, Decode(Packet));
+    TEST_ASSERT_EQUAL(BIN_MSG_ERROR, Packet[0]);
+    TEST_ASSERT_EQUAL(TEST_ID, Packet[1]);
+    return true;
+}
+
+static void RoundTrip(const uint8_t *Payload, uint8_t Length)
+{
+    uint8_t Frame[sizeof(Out)];
+    uint16_t FrameLength = SendAndCheck(Payload, Length, Frame);
+
+    TEST_ASSERT_TRUE(Receive(Frame, FrameLength));
+}
+
+void setUp()
+{
+    ShimSerialOutput = Catch;
+    OutLength = 0;
+    BinaryMode = true;
+    BinReceiveByte(0); // Ends any frame a test left behind
+}
+
+void tearDown()
+{
+    ShimSerialOutput = NULL;
+}
+
+void test_crc()
+{
+    uint16_t CRC = 0xFFFF;
+
+    for (const char *Data = "123456789"; *Data; Data++)
+        CRC = BinCRC16(CRC, *Data);
+    TEST_ASSERT_EQUAL(0x29B1, CRC); // Check value of CRC-16/CCITT-FALSE
+}
+
+void test_round_trip()
+{
+    uint8_t Payload[BIN_MAX_PAYLOAD];
+
+    memset(Payload, 0, sizeof(Payload));
+    RoundTrip(Payload, 0);
+    RoundTrip(Payload, 1);
+    RoundTrip(Payload, sizeof(Payload));
+    for (uint8_t i = 0; i < sizeof(Payload); i++)
+        Payload[i] = i + 1;
+    RoundTrip(Payload, sizeof(Payload)); // No zeros, ID and payload are one COBS block
+    for (uint8_t i = 0; i < sizeof(Payload); i++)
+        Payload[i] = (i % 3) ? 0 : 0xA5;
+    RoundTrip(Payload, sizeof(Payload));
+    Payload[0] = 0;
+    Payload[1] = 0xFF;
+    RoundTrip(Payload, 2);
+}
+
+// Every payload length and a zero at every position of the largest packet
+void test_zero_positions()
+{
+    uint8_t Payload[BIN_MAX_PAYLOAD];
+
+    for (uint8_t i = 0; i < sizeof(Payload); i++)
+        Payload[i] = 0x80 | i;
+    for (uint8_t Length = 0; Length <= sizeof(Payload); Length++)
+        RoundTrip(Payload, Length);
+    for (uint8_t Zero = 0; Zero < sizeof(Payload); Zero++)
+    {
+        Payload[Zero] = 0;
+        RoundTrip(Payload, sizeof(Payload));
+        Payload[Zero] = 0x80 | Zero;
+    }
+}
+
+// A payload longer than BIN_MAX_PAYLOAD is not sent
+void test_too_long_payload()
+{
+    uint8_t Payload[BIN_MAX_PAYLOAD + 1] = {0};
+
+    BinSend(TEST_ID, Payload, sizeof(Payload));
+    TEST_ASSERT_EQUAL(0, OutLength);
+}
+
+// A damaged frame is dropped without a reply, the next good one is taken
+void test_bad_crc()
+{
+    uint8_t Payload[] = {1, 0, 2, 3};
+    uint8_t Frame[sizeof(Out)];
+    uint16_t Length = SendAndCheck(Payload, sizeof(Payload), Frame);
+
+    Frame[Length - 2] ^= 0x01; // The CRC high byte, never zero in this packet
+    TEST_ASSERT_TRUE(Frame[Length - 2] != 0);
+    TEST_ASSERT_FALSE(Receive(Frame, Length));
+    Frame[Length - 2] ^= 0x01;
+    Frame[3] ^= 0x40; // A payload byte
+    TEST_ASSERT_FALSE(Receive(Frame, Length));
+    Frame[3] ^= 0x40;
+    TEST_ASSERT_TRUE(Receive(Frame, Length));
+}
+
+// A frame longer than the receive buffer is dropped at the delimiter, however long it is. 256 bytes of noise before a
+// good frame would bring an 8 bit position counter back to the start of the buffer and let the tail of the noise through
+void test_over_long_frame()
+{
+    uint8_t Payload[] = {7, 8, 9};
+    uint8_t Frame[sizeof(Out)];
+    uint16_t Length = SendAndCheck(Payload, sizeof(Payload), Frame);
+
+    for (uint16_t i = 0; i < 256; i++)
+        BinReceiveByte(0x11);
+    TEST_ASSERT_FALSE(Receive(&Frame[1], Length - 1)); // The good frame without its leading delimiter
+    for (uint16_t i = 0; i < 1000; i++)
+        BinReceiveByte(0x22);
+    BinReceiveByte(0);
+    TEST_ASSERT_EQUAL(0, OutLength);
+    TEST_ASSERT_TRUE(Receive(Frame, Length));
+}
+
+// Packets are at most 64 bytes, so a frame never holds a full 254 byte COBS block (code 0xFF). One that does is too
+// long and is dropped. The largest packet without zeros is the longest block that can occur, one of 64 bytes
+void test_cobs_block_edges()
+{
+    uint8_t Frame[300];
+    uint8_t Payload[BIN_MAX_PAYLOAD];
+    uint16_t Length;
+
+    Frame[0] = 0;
+    Frame[1] = 0xFF;
+    memset(&Frame[2], 0x33, 254);
+    Frame[256] = 0;
+    TEST_ASSERT_FALSE(Receive(Frame, 257));
+
+    for (uint8_t i = 0; i < sizeof(Payload); i++)
+        Payload[i] = i + 1;
+    Length = SendAndCheck(Payload, sizeof(Payload), Frame);
+    TEST_ASSERT_EQUAL(BIN_MAX_PAYLOAD + 3 + 1 + 2, Length); // One block for the whole packet plus the two delimiters
+    TEST_ASSERT_EQUAL(BIN_MAX_PAYLOAD + 3 + 1, Frame[1]);
+    TEST_ASSERT_TRUE(Receive(Frame, Length));
+}
+
+// BIN_MSG_TEXT_MODE goes back to the text API
+void test_text_mode()
+{
+    uint8_t Packet[3] = {BIN_MSG_TEXT_MODE};
+    uint16_t CRC = ReferenceCRC(Packet, 1);
+    uint8_t Frame[] = {0, 4, BIN_MSG_TEXT_MODE, (uint8_t)(CRC & 0xFF), (uint8_t)(CRC >> 8), 0};
+
+    TEST_ASSERT_TRUE((Frame[3] != 0) && (Frame[4] != 0));
+    for (uint8_t i = 0; i < sizeof(Frame); i++)
+        BinReceiveByte(Frame[i]);
+    TEST_ASSERT_FALSE(BinaryMode);
+    Out[OutLength] = 0;
+    TEST_ASSERT_EQUAL_STRING("{CBM} F\r\n", (const char *)Out);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_crc);
+    RUN_TEST(test_round_trip);
+    RUN_TEST(test_zero_positions);
+    RUN_TEST(test_too_long_payload);
+    RUN_TEST(test_bad_crc);
+    RUN_TEST(test_over_long_frame);
+    RUN_TEST(test_cobs_block_edges);
+    RUN_TEST(test_text_mode);
+    return UNITY_END();
+}
@@ -0,0 +1,73 @@
+// Energy ledger (energy.cpp), pio test -e native
+// The clock is stopped so the time in each state is exact. A power down is booked by MCUGoToSleep (sleep.cpp) as on the
+// hardware, with the uncalibrated watchdog period.
+
+#include <unity.h>
+#include "Arduino.h"
+#include <EEPROM.h>
+#include "defines.hpp"
+#include "energy.hpp"
+#include "sleep.hpp"
+
+void setUp()
+{
+    ShimStopClock(true);
+    for (uint16_t i = 0; i < 2; i++)
+        EEPROM.write(ENERGY_EEPROM + i, 0xFF); // No saved ledger
+    EnergyInit();
+    EnergyState(ENERGY_GPS, 0);
+}
+
+void tearDown()
+{
+    ShimStopClock(false);
+}
+
+// Each energized relay counts
+void test_relays_awake()
+{
+    EnergyState(ENERGY_RELAY, 2);
+    delay(1500);
+    EnergyState(ENERGY_RELAY, 1);
+    delay(1000);
+    TEST_ASSERT_EQUAL(4, EnergySeconds(ENERGY_RELAY));
+    TEST_ASSERT_EQUAL(2, EnergySeconds(ENERGY_MCU));
+}
+
+// The relay pins are low while the MCU sleeps, the Si5351 has no power switch and goes on drawing current
+void test_relays_released_in_sleep()
+{
+    EnergyState(ENERGY_RELAY, 2);
+    EnergySlept(10000);
+    TEST_ASSERT_EQUAL(10, EnergySeconds(ENERGY_SLEEP));
+    TEST_ASSERT_EQUAL(10, EnergySeconds(ENERGY_SI5351));
+    TEST_ASSERT_EQUAL(0, EnergySeconds(ENERGY_RELAY));
+    TEST_ASSERT_EQUAL(0, EnergySeconds(ENERGY_GPS));
+    TEST_ASSERT_EQUAL(0, EnergySeconds(ENERGY_MCU));
+
+    delay(1000); // Awake again with the relays energized
+    TEST_ASSERT_EQUAL(2, EnergySeconds(ENERGY_RELAY));
+}
+
+// 3 x 8800 + 2200 + 1100 + 275ms of watchdog periods fit 30 seconds, the relays are left out
+void test_mcu_sleep()
+{
+    uint32_t Awake = EnergySeconds(ENERGY_MCU);
+
+    EnergyState(ENERGY_RELAY, 1);
+    EnergyState(ENERGY_SI5351, 0);
+    MCUGoToSleep(30);
+    TEST_ASSERT_EQUAL(29, EnergySeconds(ENERGY_SLEEP));
+    TEST_ASSERT_EQUAL(0, EnergySeconds(ENERGY_RELAY));
+    TEST_ASSERT_EQUAL(0, EnergySeconds(ENERGY_SI5351));
+    TEST_ASSERT_TRUE(EnergySeconds(ENERGY_MCU) - Awake <= 1); // Only the voltage and temperature readings
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_relays_awake);
+    RUN_TEST(test_relays_released_in_sleep);
+    RUN_TEST(test_mcu_sleep);
+    return UNITY_END();
+}
@@ -0,0 +1,149 @@
+// Geofence (geofence.cpp), pio test -e native
+// The sorted grid table and its binary search are compared with the original string scan over every four character
+// Maidenhead square, and the polygon crossing test is checked on a convex and a concave fence.
+
+#include <unity.h>
+#include "Arduino.h"
+#include "geofence.hpp"
+#include "wspr_packet_formatting.hpp"
+
+#define DEG(d) ((int32_t)((d) * 10000000L)) // Degrees to NeoGPS 1e-7 degrees
+
+// The original geofence, a string scan of the grid list
+static const char OriginalGrids[] = {"IO78 IO88 IO77 IO87 IO76 IO86 IO75 IO85 IO84 IO94 IO83 IO93 IO82 IO92 JO02 IO81 IO91 JO01 IO70 IO80 IO90 IO64 PN31 PN41 PN20 PN30 PN40 PM29 PM39 PM28 PM38 LK16 LK15 LK14 LK13 LK23 LK24 LK25 LK26 LK36 LK35 LK34 LK33 LK44 LK45 LK46 LK47 LK48 LK58 LK57 LK56 LK55"};
+
+static boolean OriginalOutsideGeoFence(const char *MaidenHead4)
+{
+    for (uint16_t i = 0; i < strlen(OriginalGrids); i += 5)
+    {
+        if (strncmp(&OriginalGrids[i], MaidenHead4, 4) == 0)
+            return false;
+    }
+    return true;
+}
+
+// Triangle 50-52N 1W-1E, apex in the south
+static const S_GeoPoint Triangle[] PROGMEM = {{DEG(52), DEG(-1)}, {DEG(52), DEG(1)}, {DEG(50), 0}};
+
+// U shape 10-20N 10-20E open to the north, the notch is 13-17E down to 12N
+static const S_GeoPoint UShape[] PROGMEM = {{DEG(10), DEG(10)}, {DEG(10), DEG(20)}, {DEG(20), DEG(20)}, {DEG(20), DEG(17)}, {DEG(12), DEG(17)}, {DEG(12), DEG(13)}, {DEG(20), DEG(13)}, {DEG(20), DEG(10)}};
+
+static void SetGrid(S_WSPRData *WSPRData, uint16_t Code)
+{
+    WSPRData->MaidenHead4[0] = 'A' + Code / 1800;
+    WSPRData->MaidenHead4[1] = 'A' + (Code / 100) % 18;
+    WSPRData->MaidenHead4[2] = '0' + (Code / 10) % 10;
+    WSPRData->MaidenHead4[3] = '0' + Code % 10;
+    WSPRData->MaidenHead4[4] = 0;
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// Grid codes run 0-32399 in the order the grid names sort
+void test_grid_code()
+{
+    S_WSPRData WSPRData;
+
+    TEST_ASSERT_EQUAL(0, GridCode("AA00"));
+    TEST_ASSERT_EQUAL(32399, GridCode("RR99"));
+    for (uint16_t Code = 0; Code < 32400; Code++)
+    {
+        SetGrid(&WSPRData, Code);
+        TEST_ASSERT_EQUAL(Code, GridCode(WSPRData.MaidenHead4));
+    }
+}
+
+// Every square gives the same result as the string scan, in order and again in an order that changes the cached grid every call
+void test_all_squares()
+{
+    S_WSPRData WSPRData;
+    uint16_t Fenced = 0;
+
+    for (uint16_t Code = 0; Code < 32400; Code++)
+    {
+        SetGrid(&WSPRData, Code);
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(OriginalOutsideGeoFence(WSPRData.MaidenHead4) ? "outside" : "inside",
+                                         OutsideGeoFence(WSPRData, 0, 0) ? "outside" : "inside", WSPRData.MaidenHead4);
+        Fenced += !OutsideGeoFence(WSPRData, 0, 0); // Second call on the same square, answered from the cache
+    }
+    TEST_ASSERT_EQUAL(52, Fenced);
+    for (uint32_t i = 0; i < 32400; i++)
+    {
+        SetGrid(&WSPRData, (i * 7919) % 32400);
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(OriginalOutsideGeoFence(WSPRData.MaidenHead4) ? "outside" : "inside",
+                                         OutsideGeoFence(WSPRData, 0, 0) ? "outside" : "inside", WSPRData.MaidenHead4);
+    }
+}
+
+// Positions from the locator calculation, London and Pyongyang are fenced, Paris and Seoul are not
+void test_positions()
+{
+    S_WSPRData WSPRData;
+
+    calcLocator(DEG(51.5), DEG(-0.12), &WSPRData);
+    TEST_ASSERT_FALSE(OutsideGeoFence(WSPRData, DEG(51.5), DEG(-0.12)));
+    calcLocator(DEG(48.86), DEG(2.35), &WSPRData);
+    TEST_ASSERT_TRUE(OutsideGeoFence(WSPRData, DEG(48.86), DEG(2.35)));
+    calcLocator(DEG(39.02), DEG(125.75), &WSPRData);
+    TEST_ASSERT_FALSE(OutsideGeoFence(WSPRData, DEG(39.02), DEG(125.75)));
+    calcLocator(DEG(37.57), DEG(126.98), &WSPRData);
+    TEST_ASSERT_TRUE(OutsideGeoFence(WSPRData, DEG(37.57), DEG(126.98)));
+}
+
+void test_polygon_convex()
+{
+    S_GeoPolygon Polygon = {Triangle, 3};
+
+    TEST_ASSERT_TRUE(InsidePolygon(Polygon, DEG(51), 0));
+    TEST_ASSERT_TRUE(InsidePolygon(Polygon, DEG(51.9), DEG(0.9)));
+    TEST_ASSERT_FALSE(InsidePolygon(Polygon, DEG(51), DEG(0.6))); // East of the sloping edge, inside the bounding box
+    TEST_ASSERT_FALSE(InsidePolygon(Polygon, DEG(51), DEG(-0.6)));
+    TEST_ASSERT_FALSE(InsidePolygon(Polygon, DEG(49.9), 0));
+    TEST_ASSERT_FALSE(InsidePolygon(Polygon, DEG(52.1), 0));
+    TEST_ASSERT_TRUE(InsidePolygon(Polygon, DEG(50) + 10, 0)); // 1e-6 degrees above the apex
+    TEST_ASSERT_FALSE(InsidePolygon(Polygon, DEG(51), DEG(0.5) + 10));
+}
+
+// The ray from a point in the west arm crosses the notch and the east arm, four edges in all
+void test_polygon_concave()
+{
+    S_GeoPolygon Polygon = {UShape, 8};
+
+    TEST_ASSERT_TRUE(InsidePolygon(Polygon, DEG(15), DEG(11)));
+    TEST_ASSERT_TRUE(InsidePolygon(Polygon, DEG(15), DEG(19)));
+    TEST_ASSERT_TRUE(InsidePolygon(Polygon, DEG(11), DEG(15)));
+    TEST_ASSERT_FALSE(InsidePolygon(Polygon, DEG(15), DEG(15))); // In the notch
+    TEST_ASSERT_FALSE(InsidePolygon(Polygon, DEG(15), DEG(9)));
+    TEST_ASSERT_FALSE(InsidePolygon(Polygon, DEG(15), DEG(21)));
+    TEST_ASSERT_FALSE(InsidePolygon(Polygon, DEG(9), DEG(15)));
+}
+
+// Corners far apart at the ends of the coordinate range, the products need the 64 bit math
+void test_polygon_large()
+{
+    static const S_GeoPoint Band[] PROGMEM = {{DEG(-89), DEG(-179)}, {DEG(-89), DEG(179)}, {DEG(89), DEG(179)}, {DEG(89), DEG(-179)}};
+    S_GeoPolygon Polygon = {Band, 4};
+
+    TEST_ASSERT_TRUE(InsidePolygon(Polygon, 0, 0));
+    TEST_ASSERT_TRUE(InsidePolygon(Polygon, DEG(88.9), DEG(178.9)));
+    TEST_ASSERT_FALSE(InsidePolygon(Polygon, DEG(89.5), 0));
+    TEST_ASSERT_FALSE(InsidePolygon(Polygon, 0, DEG(179.5)));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_grid_code);
+    RUN_TEST(test_all_squares);
+    RUN_TEST(test_positions);
+    RUN_TEST(test_polygon_convex);
+    RUN_TEST(test_polygon_concave);
+    RUN_TEST(test_polygon_large);
+    return UNITY_END();
+}
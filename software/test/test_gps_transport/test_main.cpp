@@ -0,0 +1,130 @@
+// GPS transport, replay backend (gps_transport.cpp), pio test -e native
+// A GPS log larger than the receive buffer is fed in both ways the host has, pushed with GPSTransportFeed and pulled by a
+// replay source. Every byte must come out in order: a full buffer holds the feeder back instead of dropping data.
+
+#include <unity.h>
+#include "Arduino.h"
+#include "defines.hpp"
+#include "gps_transport.hpp"
+
+// Two seconds of NMEA from a receiver with a fix, as in host/gps_sample.nmea
+static const char Log[] =
+    "$GPRMC,095958.00,A,5540.12345,N,01255.54321,E,0.012,,160426,,,A*7B\r\n"
+    "$GPGGA,095958.00,5540.12345,N,01255.54321,E,1,08,1.01,35.2,M,40.1,M,,*6A\r\n"
+    "$GPGSA,A,3,02,05,12,13,15,18,25,29,,,,,1.83,1.01,1.52*09\r\n"
+    "$GPGSV,3,1,11,02,35,289,32,05,62,232,40,12,28,069,29,13,46,178,38*73\r\n"
+    "$GPGSV,3,2,11,15,22,138,31,18,09,036,,20,06,270,,25,19,099,27*7A\r\n"
+    "$GPGSV,3,3,11,29,59,103,41,31,03,327,,49,25,188,*45\r\n"
+    "$GPGLL,5540.12345,N,01255.54321,E,095958.00,A,A*66\r\n"
+    "$GPRMC,095959.00,A,5540.12350,N,01255.54330,E,0.020,,160426,,,A*7F\r\n"
+    "$GPGGA,095959.00,5540.12350,N,01255.54330,E,1,08,1.01,35.4,M,40.1,M,,*69\r\n";
+
+#define LOG_LENGTH (sizeof(Log) - 1)
+
+static uint16_t Sent;       // Bytes of the log handed out by the source
+static uint16_t MaxRoom;    // Largest room the source was offered
+static uint8_t Written[16]; // Commands to the GPS seen by the sink
+static uint8_t WrittenCount;
+
+static uint16_t Source(uint8_t *Data, uint16_t Room)
+{
+    uint16_t Length = (LOG_LENGTH - Sent < Room) ? LOG_LENGTH - Sent : Room;
+
+    MaxRoom = (Room > MaxRoom) ? Room : MaxRoom;
+    memcpy(Data, &Log[Sent], Length);
+    Sent += Length;
+    return Length;
+}
+
+static void Sink(uint8_t Data)
+{
+    if (WrittenCount < sizeof(Written))
+    {
+        Written[WrittenCount++] = Data;
+    }
+}
+
+void setUp()
+{
+    Sent = 0;
+    MaxRoom = 0;
+    WrittenCount = 0;
+    GPSTransportReplay(NULL, NULL);
+    GPSSerial.begin(9600);
+}
+
+void tearDown()
+{
+    GPSTransportReplay(NULL, NULL);
+}
+
+// Pushed in chunks larger than the buffer, the parser reading a few bytes in between
+void test_feed_back_pressure()
+{
+    char Received[LOG_LENGTH];
+    uint16_t Fed = 0, Count = 0, Taken;
+    uint8_t Chunk = 1;
+
+    while (Count < LOG_LENGTH)
+    {
+        Taken = GPSTransportFeed((const uint8_t *)&Log[Fed], (LOG_LENGTH - Fed < 100) ? LOG_LENGTH - Fed : 100);
+        Fed += Taken;
+        TEST_ASSERT_TRUE(GPSSerial.available() <= GPS_RX_BUFFER_SIZE - 1);
+        if (Fed < LOG_LENGTH) // Anything not taken was stopped by a full buffer
+        {
+            TEST_ASSERT_EQUAL(GPS_RX_BUFFER_SIZE - 1, GPSSerial.available());
+            TEST_ASSERT_EQUAL(0, GPSTransportFeed((const uint8_t *)&Log[Fed], 1));
+        }
+        for (uint8_t i = 0; (i < Chunk) && (GPSSerial.available() > 0); i++)
+        {
+            TEST_ASSERT_EQUAL(Log[Count], GPSSerial.peek());
+            Received[Count++] = GPSSerial.read();
+        }
+        Chunk = (Chunk % 37) + 5;
+    }
+    TEST_ASSERT_EQUAL(LOG_LENGTH, Fed);
+    TEST_ASSERT_EQUAL_MEMORY(Log, Received, LOG_LENGTH);
+    TEST_ASSERT_EQUAL(-1, GPSSerial.read());
+    TEST_ASSERT_EQUAL(0, GPSTransportOverruns());
+}
+
+// Pulled by the transport, the source is only asked for what fits and the log comes out whole
+void test_replay_source()
+{
+    char Received[LOG_LENGTH];
+    uint16_t Count = 0;
+
+    GPSTransportReplay(Source, Sink);
+    TEST_ASSERT_EQUAL(GPS_RX_BUFFER_SIZE - 1, GPSSerial.available());
+    while (GPSSerial.available() > 0)
+    {
+        TEST_ASSERT_TRUE(Count < LOG_LENGTH);
+        Received[Count++] = GPSSerial.read();
+    }
+    TEST_ASSERT_EQUAL(LOG_LENGTH, Count);
+    TEST_ASSERT_EQUAL(LOG_LENGTH, Sent);
+    TEST_ASSERT_EQUAL_MEMORY(Log, Received, LOG_LENGTH);
+    TEST_ASSERT_TRUE(MaxRoom <= GPS_RX_BUFFER_SIZE - 1);
+    TEST_ASSERT_EQUAL(0, GPSTransportOverruns());
+}
+
+// Commands to the GPS go to the sink, without one they are dropped
+void test_replay_sink()
+{
+    GPSSerial.write((const uint8_t *)"$PMTK", 5);
+    TEST_ASSERT_EQUAL(0, WrittenCount);
+    GPSTransportReplay(NULL, Sink);
+    TEST_ASSERT_EQUAL(3, GPSSerial.write((const uint8_t *)"*28", 3));
+    TEST_ASSERT_EQUAL(3, WrittenCount);
+    TEST_ASSERT_EQUAL_MEMORY("*28", Written, 3);
+    TEST_ASSERT_EQUAL(0, GPSSerial.available());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_feed_back_pressure);
+    RUN_TEST(test_replay_source);
+    RUN_TEST(test_replay_sink);
+    return UNITY_END();
+}
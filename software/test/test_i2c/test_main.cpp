@@ -0,0 +1,198 @@
+// TWI driver (i2c.cpp) against the TWI model, pio test -e native
+
+#include <unity.h>
+#include "Arduino.h"
+#include "i2c.hpp"
+#include "twi_model.hpp"
+
+#define SLAVE 0x60
+
+static uint8_t Regs[256];
+static uint16_t Writes;
+static uint8_t Results[2 * I2C_QUEUE_SIZE]; // Results handed to Callback in the order the transactions completed
+static uint8_t ResultCount;
+
+static void Callback(uint8_t Result)
+{
+    Results[ResultCount++] = Result;
+}
+
+void setUp()
+{
+    memset(Regs, 0, sizeof(Regs));
+    memset(ShimPinOutputs, 0, sizeof(ShimPinOutputs));
+    Writes = 0;
+    ResultCount = 0;
+    TWIModelReset();
+    TWIModelAttach(SLAVE, Regs, &Writes);
+    i2cInit();
+}
+
+void tearDown()
+{
+}
+
+// START, SLA+W, register address, data bytes and STOP, each byte ACKed by the slave
+void test_write()
+{
+    const uint8_t Data[] = {0x11, 0x22, 0x33};
+
+    TEST_ASSERT_EQUAL(I2C_RESULT_OK, i2cSendRegisters(5, Data, sizeof(Data), SLAVE));
+    TEST_ASSERT_EQUAL_STRING("S A60w 05 11 22 33 P ", TWIModelTrace);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(Data, &Regs[5], sizeof(Data));
+    TEST_ASSERT_EQUAL(3, Writes);
+    TEST_ASSERT_FALSE(i2cBusy());
+}
+
+// Register address written, repeated START, SLA+R and the one byte read NACKed as the last one
+void test_read()
+{
+    uint8_t Data = 0;
+
+    Regs[0x21] = 0x5A;
+    TEST_ASSERT_EQUAL(I2C_RESULT_OK, i2cReadRegister(0x21, &Data, SLAVE));
+    TEST_ASSERT_EQUAL_STRING("S A60w 21 Sr A60r <5A- P ", TWIModelTrace);
+    TEST_ASSERT_EQUAL_HEX8(0x5A, Data);
+}
+
+// A probe is START, SLA+W and STOP, nothing is written to the slave
+void test_probe()
+{
+    TEST_ASSERT_EQUAL(I2C_RESULT_OK, i2cProbe(SLAVE));
+    TEST_ASSERT_EQUAL_STRING("S A60w P ", TWIModelTrace);
+    TEST_ASSERT_EQUAL(0, Writes);
+    TEST_ASSERT_EQUAL(I2C_RESULT_ADDRESS_NACK, i2cProbe(SLAVE + 2));
+    TEST_ASSERT_EQUAL_STRING("S A60w P S A62w- P ", TWIModelTrace);
+}
+
+// A NACK of the address, the register address or a data byte fails the transaction with a STOP
+void test_nack()
+{
+    TEST_ASSERT_EQUAL(I2C_RESULT_ADDRESS_NACK, i2cSendRegister(1, 0xAA, SLAVE + 1));
+    TEST_ASSERT_EQUAL_STRING("S A61w- P ", TWIModelTrace);
+
+    TWIModelTrace[0] = 0;
+    TWIModelNackByte = 0;
+    TEST_ASSERT_EQUAL(I2C_RESULT_REG_NACK, i2cSendRegister(1, 0xAA, SLAVE));
+    TEST_ASSERT_EQUAL_STRING("S A60w 01- P ", TWIModelTrace);
+
+    TWIModelTrace[0] = 0;
+    TWIModelNackByte = 2;
+    TEST_ASSERT_EQUAL(I2C_RESULT_DATA_NACK, i2cSendRegisters(1, (const uint8_t *)"\x01\x02\x03", 3, SLAVE));
+    TEST_ASSERT_EQUAL_STRING("S A60w 01 01 02- P ", TWIModelTrace);
+    TEST_ASSERT_EQUAL(1, Writes);
+    TEST_ASSERT_EQUAL(3, TWIModelStops);
+}
+
+// Losing the bus to another master fails the transaction without a STOP, the next one gets the bus again
+void test_arbitration_lost()
+{
+    TWIModelArbLostByte = 1;
+    TEST_ASSERT_EQUAL(I2C_RESULT_BUS_ERROR, i2cSendRegisters(1, (const uint8_t *)"\x01\x02", 2, SLAVE));
+    TEST_ASSERT_EQUAL_STRING("S A60w 01 01! ", TWIModelTrace);
+    TEST_ASSERT_EQUAL(0, TWIModelStops);
+
+    TWIModelArbLostByte = TWI_MODEL_NEVER;
+    TEST_ASSERT_EQUAL(I2C_RESULT_OK, i2cSendRegister(7, 0x77, SLAVE));
+    TEST_ASSERT_EQUAL_HEX8(0x77, Regs[7]);
+}
+
+// A START that never completes times out after I2C_TIMEOUT, the bus is then freed with nine SCL clocks and a STOP
+void test_timeout_and_recovery()
+{
+    unsigned long Start = millis();
+
+    TWIModelStuck = true;
+    TEST_ASSERT_EQUAL(I2C_RESULT_TIMEOUT, i2cSendRegister(1, 0x10, SLAVE));
+    TEST_ASSERT_TRUE(millis() - Start > I2C_TIMEOUT);
+    TEST_ASSERT_EQUAL(9, ShimPinOutputs[SCL]);
+    TEST_ASSERT_EQUAL(1, ShimPinOutputs[SDA]);
+    TEST_ASSERT_EQUAL(_BV(TWEN), (uint8_t)TWCR);
+    TEST_ASSERT_FALSE(i2cBusy());
+
+    TWIModelStuck = false;
+    TEST_ASSERT_EQUAL(I2C_RESULT_OK, i2cSendRegister(1, 0x10, SLAVE));
+    TEST_ASSERT_EQUAL_HEX8(0x10, Regs[1]);
+}
+
+// Once the last transaction has completed a stale start time is no timeout, the queue and the bus are left alone
+void test_service_idle()
+{
+    TEST_ASSERT_EQUAL(I2C_RESULT_OK, i2cSendRegister(1, 0x10, SLAVE));
+    delay(I2C_TIMEOUT + 5);
+    i2cService();
+    TEST_ASSERT_FALSE(i2cBusy());
+    TEST_ASSERT_EQUAL(1, TWIModelStops);
+    TEST_ASSERT_EQUAL(0, ShimPinOutputs[SCL]);
+}
+
+// Transactions queued while the bus is busy go out one after the other, a STOP and a START between them
+void test_queue()
+{
+    static uint8_t Data[3] = {1, 2, 3};
+
+    cli(); // Hold the TWI interrupt so the transactions pile up
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        TEST_ASSERT_EQUAL(I2C_RESULT_OK, i2cQueueTransaction(SLAVE, 0x10 + i, &Data[i], 1, false, Callback));
+    }
+    TEST_ASSERT_TRUE(i2cBusy());
+    TEST_ASSERT_EQUAL(0, ResultCount);
+    sei();
+    TEST_ASSERT_EQUAL(I2C_RESULT_OK, i2cWait());
+    TEST_ASSERT_EQUAL_STRING("S A60w 10 01 P S A60w 11 02 P S A60w 12 03 P ", TWIModelTrace);
+    TEST_ASSERT_EQUAL(3, ResultCount);
+    TEST_ASSERT_EQUAL(I2C_RESULT_OK, Results[2]);
+}
+
+// The transfer on the bus completes while the next transaction is being queued behind the one waiting: the TWI interrupt
+// is pending when i2cQueue reads the head and the count and is taken as soon as it can. Nothing queued may be overwritten
+void test_queue_while_completing()
+{
+    static uint8_t Data[3][2] = {{1, 2}, {3, 4}, {5, 6}};
+
+    TWIModelHold = true;
+    TEST_ASSERT_EQUAL(I2C_RESULT_OK, i2cQueueTransaction(SLAVE, 0x10, Data[0], 2, false, Callback)); // START is on the bus
+    TEST_ASSERT_EQUAL(I2C_RESULT_OK, i2cQueueTransaction(SLAVE, 0x20, Data[1], 2, false, Callback));
+    TWIModelRelease();
+    TEST_ASSERT_EQUAL(I2C_RESULT_OK, i2cQueueTransaction(SLAVE, 0x30, Data[2], 2, false, Callback));
+    TEST_ASSERT_EQUAL(I2C_RESULT_OK, i2cWait());
+    TEST_ASSERT_EQUAL_STRING("S A60w 10 01 02 P S A60w 20 03 04 P S A60w 30 05 06 P ", TWIModelTrace);
+    TEST_ASSERT_EQUAL(3, ResultCount);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(Data[0], &Regs[0x10], 2);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(Data[1], &Regs[0x20], 2);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(Data[2], &Regs[0x30], 2);
+}
+
+// A full queue is waited on, the transaction gets the slot the completed one has freed
+void test_queue_full()
+{
+    static uint8_t Data[I2C_QUEUE_SIZE + 1] = {1, 2, 3, 4, 5};
+
+    TWIModelHold = true;
+    for (uint8_t i = 0; i < I2C_QUEUE_SIZE; i++)
+    {
+        TEST_ASSERT_EQUAL(I2C_RESULT_OK, i2cQueueTransaction(SLAVE, 0x10 + i, &Data[i], 1, false, Callback));
+    }
+    TWIModelRelease();
+    TEST_ASSERT_EQUAL(I2C_RESULT_OK, i2cQueueTransaction(SLAVE, 0x10 + I2C_QUEUE_SIZE, &Data[I2C_QUEUE_SIZE], 1, false, Callback));
+    TEST_ASSERT_EQUAL(I2C_RESULT_OK, i2cWait());
+    TEST_ASSERT_EQUAL(I2C_QUEUE_SIZE + 1, ResultCount);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(Data, &Regs[0x10], sizeof(Data));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_write);
+    RUN_TEST(test_read);
+    RUN_TEST(test_probe);
+    RUN_TEST(test_nack);
+    RUN_TEST(test_arbitration_lost);
+    RUN_TEST(test_timeout_and_recovery);
+    RUN_TEST(test_service_idle);
+    RUN_TEST(test_queue);
+    RUN_TEST(test_queue_while_completing);
+    RUN_TEST(test_queue_full);
+    return UNITY_END();
+}
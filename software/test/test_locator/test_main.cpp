@@ -0,0 +1,159 @@
+// Maidenhead locators (calcLocatorPrecise in wspr_packet_formatting.cpp), pio test -e native
+// The integer calculation is compared with the original double based one for four and six character locators, on a dense
+// sweep across every field, square and subsquare boundary and on random positions all over the globe.
+
+#include <unity.h>
+#include <math.h>
+#include "Arduino.h"
+#include "wspr_packet_formatting.hpp"
+
+#define EDGE_OFFSET 3     // Positions checked on each side of a boundary, in 1e-7 degrees
+#define RANDOM_POSITIONS 2000000UL
+
+static uint32_t Seed;
+static uint32_t Checked;
+
+void setUp()
+{
+    Seed = 12345;
+    Checked = 0;
+}
+
+void tearDown()
+{
+}
+
+static uint32_t Random()
+{
+    Seed = Seed * 1103515245UL + 12345UL;
+    return (Seed >> 16) | ((Seed & 0xffff0000UL) ^ (Seed << 16));
+}
+
+// The original calcLocator in double math, the code of Ossi Väänänen
+static void RefLocator(double lat, double lon, char *Locator)
+{
+    int o1, o2, o3;
+    int a1, a2, a3;
+    double remainder;
+
+    remainder = lon + 180.0;
+    o1 = (int)(remainder / 20.0);
+    remainder = remainder - (double)o1 * 20.0;
+    o2 = (int)(remainder / 2.0);
+    remainder = remainder - 2.0 * (double)o2;
+    o3 = (int)(12.0 * remainder);
+
+    remainder = lat + 90.0;
+    a1 = (int)(remainder / 10.0);
+    remainder = remainder - (double)a1 * 10.0;
+    a2 = (int)(remainder);
+    remainder = remainder - (double)a2;
+    a3 = (int)(24.0 * remainder);
+
+    Locator[0] = (char)o1 + 'A';
+    Locator[1] = (char)a1 + 'A';
+    Locator[2] = (char)o2 + '0';
+    Locator[3] = (char)a2 + '0';
+    Locator[4] = (char)o3 + 'A';
+    Locator[5] = (char)a3 + 'A';
+    Locator[6] = 0;
+}
+
+// Both lengths of the integer calculation and calcLocator against the reference
+static void CheckPosition(int32_t lat, int32_t lon)
+{
+    char Expected[7], Locator[7];
+    S_WSPRData WSPRData;
+    char Message[48];
+
+    RefLocator(lat / 1e7, lon / 1e7, Expected);
+    snprintf(Message, sizeof(Message), "lat %ld lon %ld", (long)lat, (long)lon);
+    calcLocatorPrecise(lat, lon, Locator, 6);
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(Expected, Locator, Message);
+    calcLocatorPrecise(lat, lon, Locator, 4);
+    Expected[4] = 0;
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(Expected, Locator, Message);
+    calcLocator(lat, lon, &WSPRData);
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(Expected, WSPRData.MaidenHead4, Message);
+    Checked++;
+}
+
+// Around each subsquare edge of longitude, 1/12 degree apart, which includes the square and field edges
+void test_longitude_edges()
+{
+    int32_t Edge, lat;
+
+    for (int32_t k = 0; k < 360 * 12; k++)
+    {
+        Edge = -1800000000L + (int32_t)llround(k * 1e7 / 12);
+        lat = (int32_t)(Random() % 1800000000UL) - 900000000L;
+        for (int32_t d = -EDGE_OFFSET; d <= EDGE_OFFSET; d++)
+        {
+            if ((Edge + d >= -1800000000L) && (Edge + d < 1800000000L))
+            {
+                CheckPosition(lat, Edge + d);
+            }
+        }
+    }
+    TEST_ASSERT_TRUE(Checked > 360 * 12 * 6);
+}
+
+// Around each subsquare edge of latitude, 1/24 degree apart
+void test_latitude_edges()
+{
+    int32_t Edge, lon;
+
+    for (int32_t k = 0; k < 180 * 24; k++)
+    {
+        Edge = -900000000L + (int32_t)llround(k * 1e7 / 24);
+        lon = (int32_t)(Random() % 3600000000UL) - 1800000000L;
+        for (int32_t d = -EDGE_OFFSET; d <= EDGE_OFFSET; d++)
+        {
+            if ((Edge + d >= -900000000L) && (Edge + d < 900000000L))
+            {
+                CheckPosition(Edge + d, lon);
+            }
+        }
+    }
+    TEST_ASSERT_TRUE(Checked > 180 * 24 * 6);
+}
+
+// Corners where a field, square and subsquare edge of both coordinates meet, and the limits of the coordinates
+void test_corners()
+{
+    for (int32_t lon = -1800000000L; lon < 1800000000L; lon += 20000000L)
+    {
+        for (int32_t lat = -900000000L; lat < 900000000L; lat += 10000000L)
+        {
+            for (int32_t dLat = (lat > -900000000L) ? -1 : 0; dLat <= 1; dLat++)
+            {
+                for (int32_t dLon = (lon > -1800000000L) ? -1 : 0; dLon <= 1; dLon++)
+                {
+                    CheckPosition(lat + dLat, lon + dLon);
+                }
+            }
+        }
+    }
+    CheckPosition(-900000000L, -1800000000L);
+    CheckPosition(899999999L, 1799999999L);
+    CheckPosition(0, 0);
+    CheckPosition(-1, -1);
+}
+
+void test_random_positions()
+{
+    for (uint32_t n = 0; n < RANDOM_POSITIONS; n++)
+    {
+        CheckPosition((int32_t)(Random() % 1800000000UL) - 900000000L, (int32_t)(Random() % 3600000000UL) - 1800000000L);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_longitude_edges);
+    RUN_TEST(test_latitude_edges);
+    RUN_TEST(test_corners);
+    RUN_TEST(test_random_positions);
+    return UNITY_END();
+}
@@ -0,0 +1,120 @@
+// Battery aware transmission policy (policy.cpp), pio test -e native
+// The supply voltage is set through the ADC reading of the bandgap that GetVCC converts, with the uncalibrated 1.1V
+// reference a reading is about 10mV apart from the next. The policy keeps its level between tests, so every test but
+// the first starts from a steady supply.
+
+#include <unity.h>
+#include "Arduino.h"
+#include "defines.hpp"
+#include "adc.hpp"
+#include "policy.hpp"
+
+// Sets the ADC to the reading of the lowest supply voltage at or above mV
+static void SupplyAtLeast(uint16_t mV)
+{
+    ADC = 1023;
+    while (GetVCC(false) < mV)
+        ADC = ADC - 1;
+}
+
+// Sets the ADC to the reading of the highest supply voltage below mV
+static void SupplyBelow(uint16_t mV)
+{
+    SupplyAtLeast(mV);
+    ADC = ADC + 1;
+}
+
+// Updates at a steady supply until the trend has died away, returns the level
+static uint8_t Hold(uint16_t mV)
+{
+    uint8_t Level;
+
+    SupplyAtLeast(mV);
+    do
+    {
+        Level = PolicyUpdate(false);
+    } while (PolicyTrend() != 0);
+    return Level;
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// The first update picks the highest level the voltage is good for, without hysteresis
+void test_first_level()
+{
+    SupplyAtLeast(3650);
+    TEST_ASSERT_EQUAL(2, PolicyUpdate(false));
+    TEST_ASSERT_EQUAL(0, PolicyTrend());
+}
+
+// A level holds down to its MinVCC and is left as soon as the voltage is below it
+void test_drop_at_min_vcc()
+{
+    TEST_ASSERT_EQUAL(1, Hold(3500));
+    SupplyAtLeast(3450);
+    TEST_ASSERT_EQUAL(1, PolicyUpdate(false));
+    TEST_ASSERT_TRUE(PolicyVCC() >= 3450);
+    SupplyBelow(3450);
+    TEST_ASSERT_EQUAL(POLICY_LOCKOUT, PolicyUpdate(false));
+    TEST_ASSERT_TRUE(PolicyVCC() < 3450);
+}
+
+// A higher level is only used from its MinVCC + POLICY_HYSTERESIS
+void test_rise_with_hysteresis()
+{
+    TEST_ASSERT_EQUAL(POLICY_LOCKOUT, Hold(3400));
+    SupplyBelow(3450 + POLICY_HYSTERESIS);
+    TEST_ASSERT_EQUAL(POLICY_LOCKOUT, PolicyUpdate(false));
+    SupplyAtLeast(3450 + POLICY_HYSTERESIS);
+    TEST_ASSERT_EQUAL(1, PolicyUpdate(false));
+    SupplyBelow(3650 + POLICY_HYSTERESIS);
+    TEST_ASSERT_EQUAL(1, PolicyUpdate(false));
+    SupplyAtLeast(3650 + POLICY_HYSTERESIS);
+    TEST_ASSERT_EQUAL(2, PolicyUpdate(false));
+}
+
+// After a steep drop the voltage recovers when the load is gone, the lockout holds until the trend is no longer falling
+void test_lockout_while_discharging()
+{
+    uint8_t Level;
+
+    TEST_ASSERT_EQUAL(3, Hold(4000));
+    SupplyAtLeast(3300);
+    TEST_ASSERT_EQUAL(POLICY_LOCKOUT, PolicyUpdate(false));
+    SupplyAtLeast(3450 + POLICY_HYSTERESIS + 10);
+    Level = PolicyUpdate(false);
+    TEST_ASSERT_TRUE(PolicyTrend() < 0);
+    while (PolicyTrend() < 0)
+    {
+        TEST_ASSERT_EQUAL(POLICY_LOCKOUT, Level);
+        Level = PolicyUpdate(false);
+    }
+    TEST_ASSERT_EQUAL(1, Level); // Out of the lockout with the first update that is not falling
+}
+
+// The pause of the level is the shortest one, a longer TXPause set by the user is kept
+void test_pause()
+{
+    TEST_ASSERT_EQUAL(1, Hold(3500));
+    TEST_ASSERT_EQUAL(1800, PolicyPause(60));
+    TEST_ASSERT_EQUAL(3600, PolicyPause(3600));
+    TEST_ASSERT_EQUAL(3, Hold(4000));
+    TEST_ASSERT_EQUAL(60, PolicyPause(60));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_first_level);
+    RUN_TEST(test_drop_at_min_vcc);
+    RUN_TEST(test_rise_with_hysteresis);
+    RUN_TEST(test_lockout_while_discharging);
+    RUN_TEST(test_pause);
+    return UNITY_END();
+}
@@ -0,0 +1,203 @@
+// Watchdog calibration and sleep planning (sleep.cpp), pio test -e native
+// The shim reports the prescaler of every watchdog period MCUGoToSleep starts. The GPS time of each sleep is made up
+// as a whole number of 250ms units, so the measured 8 second period comes out exact.
+
+#include <unity.h>
+#include "Arduino.h"
+#include <EEPROM.h>
+#include "defines.hpp"
+#include "sleep.hpp"
+#include "adc.hpp"
+
+// As in sleep.cpp
+struct S_WDTCalibration
+{
+    uint16_t Period;
+    uint8_t VCC;
+    int8_t Temperature;
+};
+
+#define WDT_8S ((1 << WDP3) | (1 << WDP0))
+#define WDT_4S (1 << WDP3)
+#define WDT_2S ((1 << WDP2) | (1 << WDP1) | (1 << WDP0))
+#define WDT_1S ((1 << WDP2) | (1 << WDP1))
+#define WDT_500MS ((1 << WDP2) | (1 << WDP0))
+#define WDT_250MS (1 << WDP2)
+
+static uint8_t Chunks[250];
+static uint8_t ChunkCount;
+
+static void Record(uint8_t Prescaler)
+{
+    if (ChunkCount < sizeof(Chunks))
+        Chunks[ChunkCount++] = Prescaler;
+}
+
+// Nominal length in milliseconds of the recorded periods, 250ms for WDP 4 and twice that for each step up
+static uint32_t Nominal()
+{
+    uint32_t Sum = 0;
+
+    for (uint8_t i = 0; i < ChunkCount; i++)
+        Sum += 250UL << ((((Chunks[i] & (1 << WDP3)) >> 2) | (Chunks[i] & 7)) - 4);
+    return Sum;
+}
+
+// GPS time of the last sleep for a watchdog whose 8 second period lasts Period milliseconds, a multiple of 32
+static uint32_t GPSTime(uint16_t Period)
+{
+    return Nominal() / 250 * (Period / 32);
+}
+
+static S_WDTCalibration Stored(uint8_t Index)
+{
+    S_WDTCalibration Entry;
+
+    return EEPROM.get(WDT_CAL_EEPROM + Index * sizeof(Entry), Entry);
+}
+
+static void Store(uint8_t Index, uint16_t Period, uint8_t VCC, int8_t Temperature)
+{
+    S_WDTCalibration Entry = {Period, VCC, Temperature};
+
+    EEPROM.put(WDT_CAL_EEPROM + Index * sizeof(Entry), Entry);
+}
+
+// The conditions MCUGoToSleep measures
+static S_WDTCalibration Now()
+{
+    S_WDTCalibration Conditions;
+
+    Conditions.Period = 0;
+    Conditions.VCC = GetVCC(true) / 100;
+    Conditions.Temperature = (GetTemperature(true) + 200) / 5 - 40;
+    return Conditions;
+}
+
+static void Sleep(uint32_t Seconds)
+{
+    ChunkCount = 0;
+    MCUGoToSleep(Seconds);
+}
+
+void setUp()
+{
+    for (uint16_t i = 0; i < WDT_CAL_ENTRIES * sizeof(S_WDTCalibration); i++)
+        EEPROM.write(WDT_CAL_EEPROM + i, 0xFF);
+    ADC = 341; // About 3.3V and 13 degrees
+    ShimWatchdogStart = Record;
+    ChunkCount = 0;
+}
+
+void tearDown()
+{
+    ShimWatchdogStart = NULL;
+}
+
+// Uncalibrated the 8 second period is taken to be WDT_PERIOD_DEFAULT, 8800ms: 3 x 8800 + 2200 + 1100 + 275 fit 30 seconds
+void test_default_chunks()
+{
+    const uint8_t Expected[] = {WDT_8S, WDT_8S, WDT_8S, WDT_2S, WDT_1S, WDT_250MS};
+
+    Sleep(30);
+    TEST_ASSERT_EQUAL(sizeof(Expected), ChunkCount);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(Expected, Chunks, sizeof(Expected));
+    TEST_ASSERT_EQUAL(0, WDTCSR); // Watchdog off again
+}
+
+void test_stored_period()
+{
+    S_WDTCalibration Conditions = Now();
+
+    Sleep(600);
+    TEST_ASSERT_EQUAL(545250, Nominal()); // 68 x 8s, 1s and 250ms. Shorter than WDT_CAL_MIN_TIME, but it lasted 615 seconds
+    WDTCalibrate(GPSTime(9024));
+    TEST_ASSERT_EQUAL(9024, Stored(0).Period);
+    TEST_ASSERT_EQUAL(Conditions.VCC, Stored(0).VCC);
+    TEST_ASSERT_EQUAL(Conditions.Temperature, Stored(0).Temperature);
+    TEST_ASSERT_EQUAL(0xFFFF, Stored(1).Period);
+
+    // Periods of 9024, 4512, 2256, 1128, 564 and 282ms now: 3 x 9024 + 2256 + 564 fit 30 seconds
+    const uint8_t Expected[] = {WDT_8S, WDT_8S, WDT_8S, WDT_2S, WDT_500MS};
+    Sleep(30);
+    TEST_ASSERT_EQUAL(sizeof(Expected), ChunkCount);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(Expected, Chunks, sizeof(Expected));
+}
+
+// A measurement in the same conditions is averaged in with weight 1/4
+void test_averaged()
+{
+    Sleep(600);
+    WDTCalibrate(GPSTime(9024));
+    Sleep(600);
+    TEST_ASSERT_EQUAL(531750, Nominal()); // Planned with 9024ms, 66 x 8s, 2s, 1s, 500ms and 250ms
+    WDTCalibrate(GPSTime(10240));
+    TEST_ASSERT_EQUAL((9024 * 3 + 10240 + 2) / 4, Stored(0).Period);
+    TEST_ASSERT_EQUAL(0xFFFF, Stored(1).Period);
+}
+
+void test_rejected()
+{
+    Sleep(500); // Lasted some 513 seconds, too short for the GPS time to be good enough
+    WDTCalibrate(GPSTime(9024));
+    TEST_ASSERT_EQUAL(0xFFFF, Stored(0).Period);
+
+    Sleep(1200);
+    WDTCalibrate(GPSTime(WDT_PERIOD_MIN - 32)); // Out of range, e.g. no GPS time yet
+    TEST_ASSERT_EQUAL(0xFFFF, Stored(0).Period);
+    WDTCalibrate(GPSTime(9024)); // Each sleep is only measured once
+    TEST_ASSERT_EQUAL(0xFFFF, Stored(0).Period);
+
+    Sleep(600);
+    WDTCalibrate(GPSTime(WDT_PERIOD_MAX + 32));
+    TEST_ASSERT_EQUAL(0xFFFF, Stored(0).Period);
+}
+
+// New conditions take a free entry, once all are used the closest one is replaced
+void test_new_conditions()
+{
+    S_WDTCalibration Conditions = Now();
+
+    Store(0, 9600, Conditions.VCC + 5, Conditions.Temperature);
+    Sleep(900); // Planned with the longer periods of the closest entry
+    WDTCalibrate(GPSTime(9024));
+    TEST_ASSERT_EQUAL(9600, Stored(0).Period);
+    TEST_ASSERT_EQUAL(9024, Stored(1).Period);
+    TEST_ASSERT_EQUAL(Conditions.VCC, Stored(1).VCC);
+
+    for (uint8_t i = 0; i < WDT_CAL_ENTRIES; i++)
+        Store(i, 11520, Conditions.VCC + 10 + i, Conditions.Temperature - 3);
+    Store(5, 11520, Conditions.VCC + 1, Conditions.Temperature);
+    Sleep(900);
+    WDTCalibrate(GPSTime(9024));
+    TEST_ASSERT_EQUAL(9024, Stored(5).Period);
+    TEST_ASSERT_EQUAL(Conditions.VCC, Stored(5).VCC);
+    TEST_ASSERT_EQUAL(11520, Stored(4).Period);
+    TEST_ASSERT_EQUAL(11520, Stored(6).Period);
+}
+
+// The sleep is planned with the measurement made in the closest conditions
+void test_closest_conditions()
+{
+    S_WDTCalibration Conditions = Now();
+    const uint8_t Expected[] = {WDT_8S, WDT_8S, WDT_8S, WDT_2S, WDT_500MS}; // As with 9024ms above
+
+    Store(0, 11520, Conditions.VCC + 4, Conditions.Temperature);
+    Store(1, 9024, Conditions.VCC, Conditions.Temperature - 2);
+    Store(2, 7040, Conditions.VCC - 3, Conditions.Temperature + 1);
+    Sleep(30);
+    TEST_ASSERT_EQUAL(sizeof(Expected), ChunkCount);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(Expected, Chunks, sizeof(Expected));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_default_chunks);
+    RUN_TEST(test_stored_period);
+    RUN_TEST(test_averaged);
+    RUN_TEST(test_rejected);
+    RUN_TEST(test_new_conditions);
+    RUN_TEST(test_closest_conditions);
+    return UNITY_END();
+}
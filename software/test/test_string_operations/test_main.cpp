@@ -0,0 +1,121 @@
+// Number formatting (string_operations.cpp), pio test -e native
+// uint64ToStr is compared with printf on the 10000 limb edges, the 16 bit limb edges, UINT64_MAX, random values of every
+// length and every padding width.
+
+#include <unity.h>
+#include <inttypes.h>
+#include "Arduino.h"
+#include "string_operations.hpp"
+
+#define RANDOM_VALUES 1000000UL
+
+static uint64_t Seed;
+
+void setUp()
+{
+    Seed = 0x9E3779B97F4A7C15ULL;
+}
+
+void tearDown()
+{
+}
+
+static uint64_t Random()
+{
+    Seed ^= Seed << 13;
+    Seed ^= Seed >> 7;
+    Seed ^= Seed << 17;
+    return Seed;
+}
+
+// Formats Value with uint64ToStr and printf and compares, the buffer is filled first so a missing terminator shows
+static void Check(uint64_t Value, uint8_t Width)
+{
+    char Expected[UINT64_DIGITS + 32];
+    char Buffer[UINT64_DIGITS + 32];
+    uint8_t Length;
+
+    snprintf(Expected, sizeof(Expected), "%0*" PRIu64, Width, Value);
+    memset(Buffer, 'x', sizeof(Buffer));
+    Length = uint64ToStr(Value, Buffer, Width);
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(Expected, Buffer, Expected);
+    TEST_ASSERT_EQUAL_MESSAGE(strlen(Expected), Length, Expected);
+    TEST_ASSERT_EQUAL_MESSAGE(Value, StrTouint64_t(Buffer), Expected);
+}
+
+// Powers of ten and 10000^n on both sides, they change the number of limbs and of digits in the top chunk
+void test_decimal_edges()
+{
+    uint64_t Power = 1;
+
+    Check(0, 0);
+    for (uint8_t i = 0; i < 20; i++)
+    {
+        Check(Power - 1, 0);
+        Check(Power, 0);
+        Check(Power + 1, 0);
+        if (Power > UINT64_MAX / 10)
+            break;
+        Power *= 10;
+    }
+    Check(9999, 0);
+    Check(10000, 0);
+    Check(99999999, 0);
+    Check(100000000, 0);
+    Check(999999999999ULL, 0);
+    Check(1000000000000ULL, 0);
+    Check(9999999999999999ULL, 0);
+    Check(10000000000000000ULL, 0);
+    Check(10000000000000000000ULL, 0);
+    Check(UINT64_MAX, 0);
+    Check(UINT64_MAX - 1, 0);
+}
+
+// Values around 2^16n, where a limb becomes zero and is skipped
+void test_limb_edges()
+{
+    for (uint8_t Shift = 16; Shift < 64; Shift += 16)
+    {
+        uint64_t Edge = 1ULL << Shift;
+
+        Check(Edge - 1, 0);
+        Check(Edge, 0);
+        Check(Edge + 1, 0);
+        Check(Edge * 9999, 0);
+        Check(Edge * 10000 - 1, 0);
+    }
+    for (uint32_t Value = 0; Value < 200000; Value++)
+        Check(Value, 0);
+}
+
+// Zero padding from no padding to wider than the number, a width below the length does not cut the number
+void test_width()
+{
+    for (uint8_t Width = 0; Width <= UINT64_DIGITS + 4; Width++)
+    {
+        Check(0, Width);
+        Check(7, Width);
+        Check(1409710000ULL, Width);
+        Check(UINT64_MAX, Width);
+    }
+}
+
+// Random values with a random number of significant bits, so every length from 1 to 20 digits is covered
+void test_random()
+{
+    for (uint32_t i = 0; i < RANDOM_VALUES; i++)
+    {
+        uint64_t Value = Random() >> (Random() % 64);
+        Check(Value, Random() % 24);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_decimal_edges);
+    RUN_TEST(test_limb_edges);
+    RUN_TEST(test_width);
+    RUN_TEST(test_random);
+    return UNITY_END();
+}
@@ -0,0 +1,75 @@
+// WSPR symbol clock (symbol_clock.cpp), pio test -e native
+// The Timer1 compare interrupt is run by hand as the timer would reach OCR1A, the compare times it sets up are then
+// checked against the exact symbol edges k * 8192/12000 s over many transmissions worth of symbols.
+
+#include <unity.h>
+#include "Arduino.h"
+#include "symbol_clock.hpp"
+
+#define TICKS_PER_SECOND (F_CPU / 256) // Timer1 runs at F_CPU/256
+#define SYMBOLS 162000UL              // A thousand transmissions
+
+void TIMER1_COMPA_vect(); // ISR in symbol_clock.cpp
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// Runs the clock for SYMBOLS edges from Start and returns the largest error of an edge in Timer1 ticks times 12000
+static uint32_t RunClock(uint16_t Start)
+{
+    uint64_t Edge = Start; // Timer1 time of the next edge, not wrapped at 16 bits
+    uint64_t Exact;        // Exact edge time in Timer1 ticks times 12000
+    uint32_t Error, MaxError = 0;
+    uint16_t Compare;
+
+    for (uint32_t k = 1; k <= SYMBOLS; k++)
+    {
+        Edge += (uint16_t)(OCR1A - (uint16_t)Edge); // Timer1 counts up to the compare value, wrapping around
+        Exact = (uint64_t)Start * 12000 + k * TICKS_PER_SECOND * 8192;
+        TEST_ASSERT_TRUE(Edge * 12000 <= Exact); // An edge is never early
+        Error = Exact - Edge * 12000;
+        if (Error > MaxError)
+        {
+            MaxError = Error;
+        }
+        Compare = OCR1A;
+        TIMER1_COMPA_vect();
+        TEST_ASSERT_EQUAL((uint8_t)k, SymbolClockCount());
+        TEST_ASSERT_TRUE((uint16_t)(OCR1A - Compare) > 0);
+    }
+    return MaxError;
+}
+
+// Edges from SymbolClockStart are always within one Timer1 tick of the exact time, the error does not grow
+void test_no_drift()
+{
+    uint32_t MaxError;
+
+    SymbolClockStart();
+    TEST_ASSERT_EQUAL(_BV(OCIE1A), TIMSK1 & _BV(OCIE1A));
+    MaxError = RunClock(0);
+    TEST_ASSERT_TRUE(MaxError < 12000);
+    SymbolClockStop();
+    TEST_ASSERT_EQUAL(0, TIMSK1 & _BV(OCIE1A));
+}
+
+// Started from a PPS capture close to the 16 bit wrap around of Timer1
+void test_start_at()
+{
+    SymbolClockStart();
+    SymbolClockStartAt(65000);
+    TEST_ASSERT_TRUE(RunClock(65000) < 12000);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_no_drift);
+    RUN_TEST(test_start_at);
+    return UNITY_END();
+}
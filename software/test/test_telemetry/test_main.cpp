@@ -0,0 +1,246 @@
+// Telemetry scheduler (telemetry.cpp), pio test -e native
+// Serial output is caught by the shim and the clock is stopped, so the byte budget can be followed to the byte.
+
+#include <unity.h>
+#include "Arduino.h"
+#include <NMEAGPS.h>
+#include "defines.hpp"
+#include "telemetry.hpp"
+#include "binary_protocol.hpp"
+
+extern NMEAGPS gps;
+extern uint8_t CurrentBand;
+
+#define SAT_LINE 26 // Budget a {GSI} line takes, as in TelemetryMessages
+
+static char Out[4096];
+static uint16_t OutLength;
+
+static void Catch(uint8_t Data)
+{
+    if (OutLength < sizeof(Out) - 1)
+    {
+        Out[OutLength++] = Data;
+        Out[OutLength] = 0;
+    }
+}
+
+static void ClearOut()
+{
+    OutLength = 0;
+    Out[0] = 0;
+}
+
+static uint16_t Count(const char *Text)
+{
+    uint16_t Found = 0;
+
+    for (const char *Pos = strstr(Out, Text); Pos != NULL; Pos = strstr(Pos + 1, Text))
+        Found++;
+    return Found;
+}
+
+// Zero bytes in the output
+static uint16_t Zeros()
+{
+    uint16_t Found = 0;
+
+    for (uint16_t i = 0; i < OutLength; i++)
+        Found += (Out[i] == 0);
+    return Found;
+}
+
+// Position of Text in the output, -1 if it is not there
+static int Where(const char *Text)
+{
+    const char *Pos = strstr(Out, Text);
+
+    return (Pos == NULL) ? -1 : Pos - Out;
+}
+
+// Starts every test with nothing pending and a full budget
+void setUp()
+{
+    ShimStopClock(true);
+    ShimSerialOutput = Catch;
+    ShimSerialRoom = 63;
+    BinaryMode = false;
+    gps.sat_count = 0;
+    CurrentBand = 5;
+    TelemetryHold(false);
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        delay(1000);
+        TelemetryDrain();
+    }
+    delay(1000);
+    TelemetryDrain();
+    ClearOut();
+}
+
+void tearDown()
+{
+    ShimSerialOutput = NULL;
+}
+
+// Posted messages go out highest priority first, not in the order they were posted
+void test_priority()
+{
+    TelemetryPost(UMesVCC);
+    TelemetryPost(UMesBand);
+    TelemetryPost(UMesTXOn);
+    TelemetryDrain();
+    TEST_ASSERT_EQUAL(0, Where("{TON} T"));
+    TEST_ASSERT_TRUE(Where("{TBN} 05") > Where("{TON} T"));
+    TEST_ASSERT_TRUE(Where("{MVC} ") > Where("{TBN} 05"));
+}
+
+// A message posted again before it went out is sent once, with the last value
+void test_coalescing()
+{
+    TelemetryPostValue(UMesPause, 30);
+    TelemetryPostValue(UMesPause, 29);
+    TelemetryPost(UMesBand);
+    TelemetryPost(UMesBand);
+    TelemetryDrain();
+    TEST_ASSERT_EQUAL_STRING("{MPS} 29\r\n{TBN} 05\r\n", Out);
+}
+
+// The two messages of a state cancel each other, the PC only sees the last one
+void test_state_cancellation()
+{
+    TelemetryPost(UMesTXOn);
+    TelemetryPost(UMesTXOff);
+    TelemetryPost(UMesGPSLock);
+    TelemetryPost(UMesNoGPSLock);
+    TelemetryDrain();
+    TEST_ASSERT_EQUAL_STRING("{TON} F\r\n{GLC} F\r\n", Out);
+
+    ClearOut();
+    TelemetryPost(UMesTXOff);
+    TelemetryPost(UMesTXOn);
+    TelemetryPost(UMesNoGPSLock);
+    TelemetryPost(UMesGPSLock);
+    TelemetryDrain();
+    TEST_ASSERT_EQUAL_STRING("{TON} T\r\n{GLC} T\r\n", Out);
+}
+
+// While held, messages are only collected
+void test_hold()
+{
+    TelemetryHold(true);
+    TelemetryPost(UMesTXOn);
+    delay(1000);
+    TelemetryDrain();
+    TEST_ASSERT_EQUAL(0, OutLength);
+    TelemetryHold(false);
+    TelemetryDrain();
+    TEST_ASSERT_EQUAL_STRING("{TON} T\r\n", Out);
+}
+
+// A message waits for room in the Serial TX buffer, and a less important one that would fit does not overtake it
+void test_tx_buffer_room()
+{
+    ShimSerialRoom = 8;
+    TelemetryPost(UMesTXOn); // Up to 9 bytes
+    TelemetryDrain();
+    TEST_ASSERT_EQUAL(0, OutLength);
+
+    ShimSerialRoom = 20;
+    TelemetryPost(UMesLocator); // Up to 26 bytes
+    TelemetryPost(UMesVCC);     // Up to 12 bytes
+    TelemetryDrain();
+    TEST_ASSERT_EQUAL_STRING("{TON} T\r\n", Out);
+
+    ShimSerialRoom = 63;
+    TelemetryDrain();
+    TEST_ASSERT_TRUE(Where("{GL4}") > 0);
+    TEST_ASSERT_TRUE(Where("{MVC}") > Where("{GL6}"));
+}
+
+// The satellite list goes out a line at a time while the budget lasts, the budget refills at
+// TELEMETRY_BYTES_PER_SECOND with the fraction of a byte carried over, and is full again after a second
+void test_budget()
+{
+    uint16_t Lines = TELEMETRY_BYTES_PER_SECOND / SAT_LINE;
+
+    gps.sat_count = Lines + 2;
+    for (uint8_t i = 0; i < gps.sat_count; i++)
+    {
+        gps.satellites[i].id = i + 1;
+        gps.satellites[i].tracked = true;
+    }
+    TelemetryPost(UMesSatData);
+    TelemetryDrain();
+    TEST_ASSERT_EQUAL(Lines, Count("{GSI}"));
+
+    // Budget left is 480 - 18 * 26 = 12, 100 ms adds 48 for two more lines and 8 left, short of the end of the list
+    delay(100);
+    TelemetryDrain();
+    TEST_ASSERT_EQUAL(Lines + 2, Count("{GSI}"));
+    TEST_ASSERT_EQUAL(0, Count("\r\n\r\n"));
+
+    // 30 ms is 14.4 bytes, 14 are added for 29 ms and 1 ms is carried. 8 + 14 is still short
+    delay(30);
+    TelemetryDrain();
+    TEST_ASSERT_EQUAL(0, Count("\r\n\r\n"));
+
+    // 8 ms alone is only 3 bytes, with the carried 1 ms it is 4 and 26 in all, the end of the list goes out
+    delay(8);
+    TelemetryDrain();
+    TEST_ASSERT_EQUAL(1, Count("\r\n\r\n"));
+
+    // The budget is empty, a second later it is full again for a whole new list
+    gps.sat_count = Lines;
+    TelemetryPost(UMesSatData);
+    TelemetryDrain();
+    TEST_ASSERT_EQUAL(Lines + 2, Count("{GSI}"));
+    delay(1000);
+    TelemetryDrain();
+    TEST_ASSERT_EQUAL(2 * Lines + 2, Count("{GSI}"));
+}
+
+// A satellite list posted again while it is going out carries on where it is instead of starting over
+void test_satellite_repost()
+{
+    uint16_t Lines = TELEMETRY_BYTES_PER_SECOND / SAT_LINE;
+
+    gps.sat_count = Lines + 2;
+    for (uint8_t i = 0; i < gps.sat_count; i++)
+    {
+        gps.satellites[i].id = 10 + i;
+    }
+    TelemetryPost(UMesSatData);
+    TelemetryDrain();
+    TEST_ASSERT_EQUAL(Lines, Count("{GSI}"));
+    TelemetryPost(UMesSatData);
+    delay(1000);
+    TelemetryDrain();
+    TEST_ASSERT_EQUAL(Lines + 2, Count("{GSI}"));
+    TEST_ASSERT_EQUAL(1, Count("{GSI} 10"));
+    TEST_ASSERT_EQUAL(1, Count("\r\n\r\n"));
+}
+
+// In binary mode the satellites go out TELEMETRY_SAT_BATCH to a packet, an empty packet ends the list
+void test_binary_satellites()
+{
+    BinaryMode = true;
+    gps.sat_count = TELEMETRY_SAT_BATCH + 2;
+    TelemetryPost(UMesSatData);
+    TelemetryDrain();
+    TEST_ASSERT_EQUAL(3 * 2, Zeros()); // Every packet has a zero delimiter before and after it
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_priority);
+    RUN_TEST(test_coalescing);
+    RUN_TEST(test_state_cancellation);
+    RUN_TEST(test_hold);
+    RUN_TEST(test_tx_buffer_room);
+    RUN_TEST(test_budget);
+    RUN_TEST(test_satellite_repost);
+    RUN_TEST(test_binary_satellites);
+    return UNITY_END();
+}
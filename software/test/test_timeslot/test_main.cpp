@@ -0,0 +1,160 @@
+// Transmission schedules (timeslot.cpp), pio test -e native
+// TimeslotMinute is compared with the original CorrectTimeslot on every schedule, band and minute. SecondsToNextSlot is
+// checked at the start of a slot, the second before it, the second after it and across the end of the hour.
+
+#include <unity.h>
+#include "Arduino.h"
+#include "timeslot.hpp"
+
+// The schedule part of CorrectTimeslot as it was in main.cpp, tracker mode without the position check
+static boolean OriginalCorrectTimeslot(uint8_t TimeSlotCode, uint8_t CurrentBand, uint8_t TestMinute)
+{
+    boolean CorrectSlot = false;
+    uint8_t ScheduleLenght;
+    uint8_t SlotCode;
+    if ((TestMinute % 2) == 0)
+    {
+        if ((TimeSlotCode == 17) || (TimeSlotCode == 16))
+        {
+            CorrectSlot = true;
+        }
+        else if (TimeSlotCode == 15)
+        {
+            switch (CurrentBand)
+            {
+            case 2:
+                CorrectSlot = (TestMinute == 0 || TestMinute == 20 || TestMinute == 40);
+                break;
+            case 3:
+                CorrectSlot = (TestMinute == 2 || TestMinute == 22 || TestMinute == 42);
+                break;
+            case 4:
+                CorrectSlot = (TestMinute == 6 || TestMinute == 26 || TestMinute == 46);
+                break;
+            case 5:
+                CorrectSlot = (TestMinute == 8 || TestMinute == 28 || TestMinute == 48);
+                break;
+            case 6:
+                CorrectSlot = (TestMinute == 10 || TestMinute == 30 || TestMinute == 50);
+                break;
+            case 7:
+                CorrectSlot = (TestMinute == 12 || TestMinute == 32 || TestMinute == 52);
+                break;
+            case 8:
+                CorrectSlot = (TestMinute == 14 || TestMinute == 34 || TestMinute == 54);
+                break;
+            case 9:
+                CorrectSlot = (TestMinute == 16 || TestMinute == 36 || TestMinute == 56);
+                break;
+            case 10:
+                CorrectSlot = (TestMinute == 18 || TestMinute == 38 || TestMinute == 58);
+                break;
+            default:
+                CorrectSlot = true;
+                break;
+            }
+        }
+        else if (TimeSlotCode < 15)
+        {
+            if (TimeSlotCode < 5)
+            {
+                ScheduleLenght = 10;
+                SlotCode = TimeSlotCode;
+            }
+            else
+            {
+                ScheduleLenght = 20;
+                SlotCode = TimeSlotCode - 5;
+            }
+            do
+            {
+                if (TestMinute > ScheduleLenght - 1)
+                    TestMinute = TestMinute - ScheduleLenght;
+            } while (TestMinute > ScheduleLenght - 1);
+            CorrectSlot = (TestMinute == (SlotCode * 2));
+        }
+    }
+    return CorrectSlot;
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_same_as_original()
+{
+    char Message[32];
+
+    for (uint8_t Code = 0; Code <= 20; Code++)
+    {
+        for (uint8_t Band = 0; Band <= 12; Band++)
+        {
+            for (uint8_t Minute = 0; Minute < 60; Minute++)
+            {
+                snprintf(Message, sizeof(Message), "code %u band %u minute %u", Code, Band, Minute);
+                TEST_ASSERT_EQUAL_MESSAGE(OriginalCorrectTimeslot(Code, Band, Minute), TimeslotMinute(Code, Band, Minute), Message);
+            }
+        }
+    }
+}
+
+void test_schedules()
+{
+    TEST_ASSERT_TRUE(TimeslotMinute(3, 0, 56));             // Every ten minutes on minute 6
+    TEST_ASSERT_FALSE(TimeslotMinute(3, 0, 48));
+    TEST_ASSERT_TRUE(TimeslotMinute(14, 0, 38));            // Every twenty minutes on minute 18
+    TEST_ASSERT_FALSE(TimeslotMinute(14, 0, 28));
+    TEST_ASSERT_TRUE(TimeslotMinute(TIMESLOT_BAND_COORDINATED, 6, 30)); // 20m on minute 10, 30 and 50
+    TEST_ASSERT_FALSE(TimeslotMinute(TIMESLOT_BAND_COORDINATED, 6, 32));
+    TEST_ASSERT_TRUE(TimeslotMinute(TIMESLOT_ANY, 0, 58));
+    TEST_ASSERT_FALSE(TimeslotMinute(TIMESLOT_ANY, 0, 59));
+    TEST_ASSERT_TRUE(TimeslotMinute(TIMESLOT_TRACKER, 0, 2));
+}
+
+// Every ten minutes on minute 0 (TimeSlotCode 0): slots start at second 0, 600, 1200 ... of the hour
+void test_slot_boundaries()
+{
+    TEST_ASSERT_EQUAL(0, SecondsToNextSlot(0, 0, 600, 0));     // Second 0 of a slot
+    TEST_ASSERT_EQUAL(1, SecondsToNextSlot(0, 0, 599, 0));     // The last second before a slot
+    TEST_ASSERT_EQUAL(599, SecondsToNextSlot(0, 0, 601, 0));   // Just missed, the next one
+    TEST_ASSERT_EQUAL(600, SecondsToNextSlot(0, 0, 0, 600));   // A slot exactly MinSeconds away counts
+    TEST_ASSERT_EQUAL(1200, SecondsToNextSlot(0, 0, 0, 601));  // One second more and it is the slot after
+    TEST_ASSERT_EQUAL(599, SecondsToNextSlot(0, 0, 1, 599));   // The pause ends on the start of a slot, counted from now
+    TEST_ASSERT_EQUAL(1199, SecondsToNextSlot(0, 0, 1, 600));
+}
+
+// Slots past the end of the hour are counted on from this hour
+void test_hour_rollover()
+{
+    TEST_ASSERT_EQUAL(1, SecondsToNextSlot(0, 0, 3599, 0));      // 59:59, the slot at 00:00
+    TEST_ASSERT_EQUAL(599, SecondsToNextSlot(0, 0, 3001, 0));    // 50:01, the slot at 00:00
+    TEST_ASSERT_EQUAL(599, SecondsToNextSlot(4, 0, 3481, 0));    // 58:01, the next slot on minute 8 is 08:00
+    TEST_ASSERT_EQUAL(0, SecondsToNextSlot(4, 0, 3480, 0));      // 58:00 itself
+    TEST_ASSERT_EQUAL(1199, SecondsToNextSlot(TIMESLOT_BAND_COORDINATED, 2, 2401, 0)); // 160m at 40:01, the next is 00:00
+    TEST_ASSERT_EQUAL(5400, SecondsToNextSlot(0, 0, 0, 5000));   // A pause longer than the hour, minute 84 is not a slot, minute 90 is
+    TEST_ASSERT_EQUAL(3600 + 360 - 3599, SecondsToNextSlot(3, 0, 3599, 120)); // Minute 6 of the next hour
+}
+
+// Tracker mode and no scheduling wake for every even minute, a schedule with no slot gives MinSeconds back
+void test_even_minutes_and_no_slot()
+{
+    TEST_ASSERT_EQUAL(59, SecondsToNextSlot(TIMESLOT_TRACKER, 0, 61, 0));
+    TEST_ASSERT_EQUAL(0, SecondsToNextSlot(TIMESLOT_ANY, 0, 120, 0));
+    TEST_ASSERT_EQUAL(1, SecondsToNextSlot(TIMESLOT_ANY, 0, 3599, 0));
+    TEST_ASSERT_EQUAL(300, SecondsToNextSlot(18, 0, 100, 300));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_same_as_original);
+    RUN_TEST(test_schedules);
+    RUN_TEST(test_slot_boundaries);
+    RUN_TEST(test_hour_rollover);
+    RUN_TEST(test_even_minutes_and_no_slot);
+    return UNITY_END();
+}
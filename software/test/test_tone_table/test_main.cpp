@@ -0,0 +1,104 @@
+// Si5351 tone table mode against the per-symbol frequency setup, pio test -e native
+// For every tone of a transmission the registers the tone table leaves in the Si5351 model must be exactly the ones
+// calculated for that tone on its own, as long as that picks the same MultiSynth divider as tone 0.
+
+#include <unity.h>
+#include "Arduino.h"
+#include "defines.hpp"
+#include "Si5351.hpp"
+#include "si5351_model.hpp"
+
+// WSPR dial frequencies in Hz, the transmit frequency is 1400 to 1600 Hz above
+static const uint32_t Dials[] = {137400, 474200, 1836600, 3568600, 5287200, 7038600, 10138700, 14095600, 18104600,
+                                 21094600, 24924600, 28124600, 50293000, 70091000, 144489000};
+
+// Reference oscillators, nominal and as calibrated
+static const uint32_t RefFreqs[] = {25000000, 26000000, 25999870, 27000143};
+
+// The registers that set the CLK0 frequency: PLL A, MultiSynth 0 and the CLK0 control, and the frequency error
+struct S_Setup
+{
+    uint8_t PLL[8];
+    uint8_t MS[8];
+    uint8_t Control;
+    int32_t Error;
+};
+
+// The per-symbol computation of a tone: PLL A and MultiSynth 0 calculated for the tone frequency on its own
+static void PerSymbolSetup(uint64_t FreqmHz, uint32_t RefFreq, S_Setup *Setup)
+{
+    uint32_t Divider;
+    uint8_t rDiv;
+
+    Si5351ModelReset();
+    Setup->Error = si5351aCalcFrequency(FreqmHz, RefFreq, Setup->PLL, &Divider, &rDiv);
+    setupMultisynth(SI_SYNTH_MS_0, Divider, rDiv);
+    memcpy(Setup->MS, &Si5351Regs[SI_SYNTH_MS_0], 8);
+    Setup->Control = 0x4F | SI_CLK_SRC_PLL_A;
+}
+
+// What the tone table has left in the Si5351 model
+static void Snapshot(S_Setup *Setup)
+{
+    memcpy(Setup->PLL, &Si5351Regs[SI_SYNTH_PLL_A], 8);
+    memcpy(Setup->MS, &Si5351Regs[SI_SYNTH_MS_0], 8);
+    Setup->Control = Si5351Regs[SI_CLK0_CONTROL];
+    Setup->Error = si5351aFrequencyError();
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_tones_match_per_symbol_setup()
+{
+    static const uint8_t Symbols[] = {3, 1, 0, 2, 2, 0, 1, 3, 3, 0, 1, 1, 2, 3, 0}; // Every change between two tones
+    S_Setup PerSymbol[4], Table;
+    uint16_t Compared = 0, DividerChanges = 0;
+    uint64_t Freq;
+
+    for (uint8_t r = 0; r < sizeof(RefFreqs) / sizeof(RefFreqs[0]); r++)
+    {
+        for (uint8_t d = 0; d < sizeof(Dials) / sizeof(Dials[0]); d++)
+        {
+            for (uint32_t Audio = 140000; Audio <= 160000; Audio += 1337) // centiHz above the dial
+            {
+                Freq = Dials[d] * 100ULL + Audio;
+                for (uint8_t Tone = 0; Tone < 4; Tone++)
+                {
+                    PerSymbolSetup(Freq * 10 + WSPR_TONE_OFFSET(Tone), RefFreqs[r], &PerSymbol[Tone]);
+                }
+
+                Si5351ModelReset();
+                si5351aStartToneTable(Freq, RefFreqs[r], Symbols[0]);
+                for (uint8_t i = 0; i < sizeof(Symbols); i++)
+                {
+                    si5351aSetTone(Symbols[i]);
+                    Snapshot(&Table);
+                    TEST_ASSERT_EQUAL_HEX8(PerSymbol[0].Control, Table.Control);
+                    TEST_ASSERT_EQUAL_UINT8_ARRAY(PerSymbol[0].MS, Table.MS, 8); // All tones keep the divider of tone 0
+                    if (memcmp(Table.MS, PerSymbol[Symbols[i]].MS, 8) != 0)
+                    {
+                        DividerChanges++; // The per-symbol computation picked another divider for this tone, nothing to compare
+                        continue;
+                    }
+                    TEST_ASSERT_EQUAL_UINT8_ARRAY(PerSymbol[Symbols[i]].PLL, Table.PLL, 8);
+                    TEST_ASSERT_EQUAL(PerSymbol[Symbols[i]].Error, Table.Error);
+                    Compared++;
+                }
+            }
+        }
+    }
+    printf("%u tones compared, %u with another divider\n", Compared, DividerChanges);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_tones_match_per_symbol_setup);
+    return UNITY_END();
+}
@@ -0,0 +1,164 @@
+// UBX command layer (ubx.cpp), pio test -e native
+// The firmware talks to a u-blox receiver model (ubx_model.cpp) through the replay backend of the GPS transport. The model
+// checks every frame against the UBX specification and answers CFG messages with NMEA and an ACK-ACK or ACK-NAK. The frames
+// the firmware sends must be exactly the byte sequences in the u-blox documentation.
+
+#include <unity.h>
+#include "Arduino.h"
+#include "defines.hpp"
+#include "gps_transport.hpp"
+#include "ubx.hpp"
+#include "ubx_model.hpp"
+
+// Frames as given in the u-blox documentation
+static const uint8_t PowerSave[] = {0xB5, 0x62, 0x06, 0x11, 0x02, 0x00, 0x08, 0x01, 0x22, 0x92};
+static const uint8_t Backup[] = {0xB5, 0x62, 0x02, 0x41, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x4D, 0x3B};
+static const uint8_t GSVOff[] = {0xB5, 0x62, 0x06, 0x01, 0x03, 0x00, 0xF0, 0x03, 0x00, 0xFD, 0x15};
+static const uint8_t PVTOn[] = {0xB5, 0x62, 0x06, 0x01, 0x03, 0x00, 0x01, 0x07, 0x01, 0x13, 0x51};
+static const uint8_t HotStart[] = {0xB5, 0x62, 0x06, 0x04, 0x04, 0x00, 0x00, 0x00, 0x02, 0x00, 0x10, 0x68};
+static const uint8_t CyclicTracking[] = {0xB5, 0x62, 0x06, 0x3B, 0x2C, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x15, 0x02, 0x00, 0xE8, 0x03,
+                                         0x00, 0x00, 0x10, 0x27, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                         0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                         0x00, 0x00, 0xA7, 0x4A};
+
+// Answer for CFG-RXM
+static const uint8_t NakPowerSave[] = {0xB5, 0x62, 0x05, 0x00, 0x02, 0x00, 0x06, 0x11, 0x1E, 0x43};
+
+static void AssertLast(const uint8_t *Expected, uint16_t Length)
+{
+    TEST_ASSERT_EQUAL(Length, UBXModelLastLength);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(Expected, UBXModelLast, Length);
+}
+
+void setUp()
+{
+    UBXModelReset();
+}
+
+void tearDown()
+{
+    GPSTransportReplay(NULL, NULL);
+}
+
+void test_documented_frames()
+{
+    TEST_ASSERT_TRUE(UBXSetPowerSave(true));
+    AssertLast(PowerSave, sizeof(PowerSave));
+    TEST_ASSERT_TRUE(UBXSetMessageRate(UBX_CLASS_NMEA, UBX_NMEA_GSV, 0));
+    AssertLast(GSVOff, sizeof(GSVOff));
+    TEST_ASSERT_TRUE(UBXSetMessageRate(UBX_CLASS_NAV, UBX_NAV_PVT, 1));
+    AssertLast(PVTOn, sizeof(PVTOn));
+    TEST_ASSERT_TRUE(UBXSetCyclicTracking(1000, 10000));
+    AssertLast(CyclicTracking, sizeof(CyclicTracking));
+    UBXBackup(0);
+    AssertLast(Backup, sizeof(Backup));
+    UBXReset();
+    AssertLast(HotStart, sizeof(HotStart));
+    TEST_ASSERT_EQUAL(6, UBXModelFrames);
+    TEST_ASSERT_EQUAL(0, UBXModelErrors);
+}
+
+// GLL, GSA, VTG and GSV off, GSV on for the PC, CFG-PM2 and CFG-RXM, each acknowledged at the first try
+void test_setup_receiver()
+{
+    TEST_ASSERT_TRUE(UBXSetupReceiver(true));
+    TEST_ASSERT_EQUAL(GPS_UBX_Nav ? 10 : 7, UBXModelFrames);
+    TEST_ASSERT_EQUAL(0, UBXModelErrors);
+    AssertLast(PowerSave, sizeof(PowerSave));
+}
+
+// The wake up byte is not a frame, the receiver ignores it
+void test_wake_up()
+{
+    UBXWakeUp();
+    TEST_ASSERT_EQUAL(0, UBXModelFrames);
+    UBXReset();
+    TEST_ASSERT_EQUAL(1, UBXModelFrames);
+    TEST_ASSERT_EQUAL(0, UBXModelErrors);
+}
+
+// Frames the receiver would not take are caught by the model, so the tests above do check something
+void test_model_checks()
+{
+    const uint8_t BadChecksum[] = {0xB5, 0x62, 0x06, 0x04, 0x04, 0x00, 0x00, 0x00, 0x02, 0x00, 0x10, 0x69};
+    const uint8_t BadMode[] = {8, 2};
+    const uint8_t BadVersion[44] = {2};
+    const uint8_t NoBackupFlag[8] = {0};
+    const uint8_t BadResetMode[4] = {0, 0, 3, 0};
+    const uint8_t Short[1] = {0};
+
+    GPSSerial.write(BadChecksum, sizeof(BadChecksum));
+    TEST_ASSERT_EQUAL_STRING("bad checksum", UBXModelError);
+    UBXSend(UBX_CLASS_CFG, 0x99, Short, 0);
+    TEST_ASSERT_EQUAL_STRING("unknown message", UBXModelError);
+    UBXSend(UBX_CLASS_CFG, UBX_CFG_RXM, Short, sizeof(Short));
+    TEST_ASSERT_EQUAL_STRING("wrong payload length", UBXModelError);
+    UBXSend(UBX_CLASS_CFG, UBX_CFG_RXM, BadMode, sizeof(BadMode));
+    TEST_ASSERT_EQUAL_STRING("lpMode must be 0, 1 or 4", UBXModelError);
+    UBXSend(UBX_CLASS_CFG, UBX_CFG_PM2, BadVersion, sizeof(BadVersion));
+    TEST_ASSERT_EQUAL_STRING("version must be 1", UBXModelError);
+    UBXSend(UBX_CLASS_RXM, UBX_RXM_PMREQ, NoBackupFlag, sizeof(NoBackupFlag));
+    TEST_ASSERT_EQUAL_STRING("backup flag not set, the receiver would ignore it", UBXModelError);
+    UBXSend(UBX_CLASS_CFG, UBX_CFG_RST, BadResetMode, sizeof(BadResetMode));
+    TEST_ASSERT_EQUAL_STRING("reserved resetMode", UBXModelError);
+    TEST_ASSERT_EQUAL(7, UBXModelErrors);
+}
+
+// A rejected CFG message is NAKed each time, it is sent UBX_RETRIES times
+void test_nak()
+{
+    const uint8_t BadMode[] = {8, 2};
+
+    TEST_ASSERT_FALSE(UBXCommand(UBX_CLASS_CFG, UBX_CFG_RXM, BadMode, sizeof(BadMode)));
+    TEST_ASSERT_EQUAL(UBX_RETRIES, UBXModelFrames);
+    TEST_ASSERT_EQUAL(UBX_RETRIES, UBXModelErrors);
+}
+
+// A NAK ends the wait, the next try finds the ACK the receiver sent for the first one
+void test_nak_then_ack()
+{
+    UBXModelReply(NakPowerSave, sizeof(NakPowerSave));
+    TEST_ASSERT_TRUE(UBXSetPowerSave(true));
+    TEST_ASSERT_EQUAL(2, UBXModelFrames);
+}
+
+// Acknowledges of other messages, a broken checksum and a cut off frame in front of the right answer are passed over
+void test_ack_search()
+{
+    const uint8_t AckOther[] = {0xB5, 0x62, 0x05, 0x01, 0x02, 0x00, 0x06, 0x01, 0x0F, 0x38};
+    const uint8_t NakBadChecksum[] = {0xB5, 0x62, 0x05, 0x00, 0x02, 0x00, 0x06, 0x11, 0x1E, 0x44};
+    const uint8_t CutOff[] = {0xB5, 0x62, 0x05, 0x01, 0x02, 0x00};
+    const uint8_t Sync[] = {0xB5, 0xB5};
+
+    UBXModelReply(AckOther, sizeof(AckOther));
+    UBXModelReply(NakBadChecksum, sizeof(NakBadChecksum));
+    UBXModelReply(CutOff, sizeof(CutOff));
+    UBXModelReply(Sync, sizeof(Sync));
+    TEST_ASSERT_TRUE(UBXSetPowerSave(true));
+    TEST_ASSERT_EQUAL(1, UBXModelFrames);
+}
+
+// Without an answer a CFG message is tried UBX_RETRIES times, UBX_ACK_TIMEOUT each
+void test_no_answer()
+{
+    const uint8_t Payload[4] = {0, 0, 2, 0};
+    unsigned long Start = millis();
+
+    TEST_ASSERT_FALSE(UBXCommand(UBX_CLASS_CFG, UBX_CFG_RST, Payload, sizeof(Payload))); // CFG-RST is never acknowledged
+    TEST_ASSERT_EQUAL(UBX_RETRIES, UBXModelFrames);
+    TEST_ASSERT_TRUE(millis() - Start >= UBX_RETRIES * UBX_ACK_TIMEOUT);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_documented_frames);
+    RUN_TEST(test_setup_receiver);
+    RUN_TEST(test_wake_up);
+    RUN_TEST(test_model_checks);
+    RUN_TEST(test_nak);
+    RUN_TEST(test_nak_then_ack);
+    RUN_TEST(test_ack_search);
+    RUN_TEST(test_no_answer);
+    return UNITY_END();
+}
@@ -0,0 +1,176 @@
+#include "ubx_model.hpp"
+#include "gps_transport.hpp"
+#include "ubx.hpp"
+#include <deque>
+#include <vector>
+
+uint16_t UBXModelFrames;
+uint16_t UBXModelErrors;
+const char *UBXModelError;
+uint8_t UBXModelLast[64];
+uint16_t UBXModelLastLength;
+
+struct S_UBXSpec
+{
+    uint8_t Class;
+    uint8_t ID;
+    uint16_t Length; // Payload length the receiver accepts
+    bool Acked;      // Answered with ACK-ACK or ACK-NAK
+    const char *Name;
+};
+
+// The messages the firmware sends, as described in the u-blox receiver description (protocol version 14 and later)
+static const S_UBXSpec Spec[] = {
+    {UBX_CLASS_CFG, UBX_CFG_MSG, 3, true, "CFG-MSG"},
+    {UBX_CLASS_CFG, UBX_CFG_RST, 4, false, "CFG-RST"},
+    {UBX_CLASS_CFG, UBX_CFG_RXM, 2, true, "CFG-RXM"},
+    {UBX_CLASS_CFG, UBX_CFG_PM2, 44, true, "CFG-PM2"},
+    {UBX_CLASS_RXM, UBX_RXM_PMREQ, 8, false, "RXM-PMREQ"}};
+
+static std::vector<uint8_t> Frame; // Frame being received from the firmware
+static std::deque<uint8_t> Reply;  // What the receiver sends back
+
+static uint16_t Source(uint8_t *Data, uint16_t Room);
+static void Sink(uint8_t Data);
+
+// Connects the model to the replay backend of the GPS transport, the firmware writes its UBX frames to it
+void UBXModelReset()
+{
+    Frame.clear();
+    Reply.clear();
+    UBXModelFrames = 0;
+    UBXModelErrors = 0;
+    UBXModelError = NULL;
+    UBXModelLastLength = 0;
+    GPSTransportReplay(Source, Sink);
+    GPSSerial.begin(9600);
+}
+
+static uint32_t Get32(const uint8_t *Data)
+{
+    return Data[0] | (Data[1] << 8) | (Data[2] << 16) | ((uint32_t)Data[3] << 24);
+}
+
+// Checks the fields of a payload, NULL if they are all valid
+static const char *CheckPayload(uint8_t Class, uint8_t ID, const uint8_t *Payload)
+{
+    uint32_t Flags;
+
+    if ((Class == UBX_CLASS_CFG) && (ID == UBX_CFG_RXM))
+    {
+        if (Payload[0] != 8)
+            return "reserved byte must be 8";
+        if ((Payload[1] != 0) && (Payload[1] != 1) && (Payload[1] != 4))
+            return "lpMode must be 0, 1 or 4";
+    }
+    if ((Class == UBX_CLASS_CFG) && (ID == UBX_CFG_PM2))
+    {
+        Flags = Get32(&Payload[4]);
+        if (Payload[0] != 1)
+            return "version must be 1";
+        if (((Flags >> 17) & 3) > 1)
+            return "reserved mode";
+        if (((Flags >> 8) & 3) > 1)
+            return "reserved limitPeakCurr";
+        if ((Get32(&Payload[8]) != 0) && (Get32(&Payload[8]) < 1000))
+            return "updatePeriod below one second";
+    }
+    if ((Class == UBX_CLASS_RXM) && (ID == UBX_RXM_PMREQ))
+    {
+        if (!(Get32(&Payload[4]) & 2))
+            return "backup flag not set, the receiver would ignore it";
+    }
+    if ((Class == UBX_CLASS_CFG) && (ID == UBX_CFG_RST))
+    {
+        if ((Payload[2] != 0) && (Payload[2] != 1) && (Payload[2] != 2) && (Payload[2] != 4) && (Payload[2] != 8) && (Payload[2] != 9))
+            return "reserved resetMode";
+    }
+    return NULL;
+}
+
+// Queues an ACK-ACK or ACK-NAK behind a line of NMEA, so the firmware has to find the acknowledge in between other data
+static void SendAck(bool Ack, uint8_t Class, uint8_t ID)
+{
+    const char *NMEA = "$GPRMC,120000.00,A,5540.00000,N,01255.00000,E,0.0,,010126,,,A*55\r\n";
+    uint8_t Ck[2] = {0, 0};
+    uint8_t Msg[8] = {UBX_SYNC_1, UBX_SYNC_2, UBX_CLASS_ACK, (uint8_t)(Ack ? UBX_ACK_ACK : UBX_ACK_NAK), 2, 0, Class, ID};
+
+    Reply.insert(Reply.end(), NMEA, NMEA + strlen(NMEA));
+    for (int i = 2; i < 8; i++)
+    {
+        Ck[0] += Msg[i];
+        Ck[1] += Ck[0];
+    }
+    Reply.insert(Reply.end(), Msg, Msg + 8);
+    Reply.insert(Reply.end(), Ck, Ck + 2);
+}
+
+// A complete frame from the firmware
+static void Received()
+{
+    uint16_t Length = Frame[4] | (Frame[5] << 8);
+    const S_UBXSpec *Msg = NULL;
+    const char *Error = NULL;
+    uint8_t Ck[2] = {0, 0};
+
+    UBXModelFrames++;
+    UBXModelLastLength = (Frame.size() < sizeof(UBXModelLast)) ? Frame.size() : sizeof(UBXModelLast);
+    memcpy(UBXModelLast, Frame.data(), UBXModelLastLength);
+    for (size_t i = 2; i < Frame.size() - 2; i++)
+    {
+        Ck[0] += Frame[i];
+        Ck[1] += Ck[0];
+    }
+    for (size_t i = 0; i < sizeof(Spec) / sizeof(Spec[0]); i++)
+    {
+        if ((Spec[i].Class == Frame[2]) && (Spec[i].ID == Frame[3]))
+            Msg = &Spec[i];
+    }
+    if ((Ck[0] != Frame[Frame.size() - 2]) || (Ck[1] != Frame[Frame.size() - 1]))
+        Error = "bad checksum";
+    else if (Msg == NULL)
+        Error = "unknown message";
+    else if (Length != Msg->Length)
+        Error = "wrong payload length";
+    else
+        Error = CheckPayload(Frame[2], Frame[3], &Frame[6]);
+
+    UBXModelError = Error;
+    if (Error)
+        UBXModelErrors++;
+    if ((Msg != NULL) && Msg->Acked)
+        SendAck(Error == NULL, Frame[2], Frame[3]);
+}
+
+void UBXModelReply(const uint8_t *Data, uint16_t Length)
+{
+    Reply.insert(Reply.end(), Data, Data + Length);
+}
+
+// Hands the reply to the transport as fast as the firmware reads it
+static uint16_t Source(uint8_t *Data, uint16_t Room)
+{
+    uint16_t Length = 0;
+
+    while ((Length < Room) && !Reply.empty())
+    {
+        Data[Length++] = Reply.front();
+        Reply.pop_front();
+    }
+    return Length;
+}
+
+// Bytes outside a frame, like the wake up byte, are ignored as the receiver does
+static void Sink(uint8_t Data)
+{
+    if ((Frame.size() == 0) && (Data != UBX_SYNC_1))
+        return;
+    Frame.push_back(Data);
+    if ((Frame.size() == 2) && (Data != UBX_SYNC_2))
+        Frame.clear();
+    if ((Frame.size() >= 6) && (Frame.size() == 8u + (Frame[4] | (Frame[5] << 8))))
+    {
+        Received();
+        Frame.clear();
+    }
+}
@@ -0,0 +1,13 @@
+// Model of a u-blox receiver on the GPS port for the UBX tests. It is connected to the replay backend of the GPS transport
+// so the firmware UBX code runs unchanged. Every frame written is checked against the UBX protocol specification and CFG messages
+// are answered with ACK-ACK or ACK-NAK, with NMEA data in front as a real receiver would send it
+#include "Arduino.h"
+
+extern uint16_t UBXModelFrames;     // Complete frames received since the last UBXModelReset
+extern uint16_t UBXModelErrors;     // Frames that broke the specification
+extern const char *UBXModelError;   // What was wrong with the last frame, NULL if it was valid
+extern uint8_t UBXModelLast[64];    // Last complete frame
+extern uint16_t UBXModelLastLength;
+
+void UBXModelReset();
+void UBXModelReply(const uint8_t *Data, uint16_t Length); // Queues data for the firmware ahead of the next answer
@@ -0,0 +1,328 @@
+// UBX navigation decoder (ubx_nav.cpp), pio test -e native
+// Hand-built NAV-PVT, NAV-SAT and NAV-SVINFO frames are fed through the GPS transport as the receiver would send them.
+// The fields are placed at their offsets in the u-blox receiver description, the checksum is worked out here.
+
+#include <unity.h>
+#include "Arduino.h"
+#include <NMEAGPS.h>
+#include "defines.hpp"
+#include "gps_transport.hpp"
+#include "ubx.hpp"
+#include "ubx_nav.hpp"
+
+extern NMEAGPS gps;
+
+#define NOT_SET 0xFFFFFFFF
+
+static const char NMEA[] = "$GPRMC,095958.00,A,5540.12345,N,01255.54321,E,0.012,,160426,,,A*7B\r\n";
+
+static uint8_t Frame[8 + 12 * 24];
+static uint16_t FrameLength;
+
+static void Put(uint16_t Offset, uint32_t Value, uint8_t Size)
+{
+    for (uint8_t i = 0; i < Size; i++)
+        Frame[6 + Offset + i] = Value >> (8 * i);
+}
+
+// Starts a frame with an empty payload of Length bytes
+static void Start(uint8_t Class, uint8_t ID, uint16_t Length)
+{
+    memset(Frame, 0, sizeof(Frame));
+    Frame[0] = UBX_SYNC_1;
+    Frame[1] = UBX_SYNC_2;
+    Frame[2] = Class;
+    Frame[3] = ID;
+    Frame[4] = Length & 0xFF;
+    Frame[5] = Length >> 8;
+    FrameLength = Length + 8;
+}
+
+// Fletcher checksum over class, ID, length and payload
+static void Finish()
+{
+    uint8_t A = 0, B = 0;
+
+    for (uint16_t i = 2; i < FrameLength - 2; i++)
+    {
+        A += Frame[i];
+        B += A;
+    }
+    Frame[FrameLength - 2] = A;
+    Frame[FrameLength - 1] = B;
+}
+
+// 2026-04-16 09:59:58.25 UTC, 3D fix with 8 satellites at 55.6687242N 12.5925535E, 35.2m above sea level
+static void BuildPVT(uint16_t Length)
+{
+    Start(UBX_CLASS_NAV, UBX_NAV_PVT, Length);
+    Put(0, 381616250, 4); // iTOW
+    Put(4, 2026, 2);
+    Put(6, 4, 1);
+    Put(7, 16, 1);
+    Put(8, 9, 1);
+    Put(9, 59, 1);
+    Put(10, 58, 1);
+    Put(11, 0x07, 1); // validDate, validTime, fullyResolved
+    Put(16, 250000000, 4); // nano
+    Put(20, 3, 1);         // fixType 3D
+    Put(21, 0x01, 1);      // gnssFixOK
+    Put(23, 8, 1);         // numSV
+    Put(24, 125925535, 4); // lon
+    Put(28, 556687242, 4); // lat
+    Put(32, 77300, 4);     // height above the ellipsoid
+    Put(36, 35200, 4);     // hMSL
+    Put(40, 2500, 4);      // hAcc
+    Put(44, 4000, 4);      // vAcc
+    Finish();
+}
+
+// Pushes data in to the transport, decoding whenever the receive buffer is full. Returns the number of fixes
+static uint8_t Feed(const uint8_t *Data, uint16_t Length)
+{
+    uint16_t Fed = 0;
+    uint8_t Fixes = 0;
+
+    while (Fed < Length)
+    {
+        Fed += GPSTransportFeed(&Data[Fed], Length - Fed);
+        while (UBXNavAvailable())
+            Fixes++;
+    }
+    return Fixes;
+}
+
+static uint8_t FeedFrame()
+{
+    return Feed(Frame, FrameLength);
+}
+
+static uint8_t FeedNMEA()
+{
+    return Feed((const uint8_t *)NMEA, sizeof(NMEA) - 1);
+}
+
+void setUp()
+{
+    GPSTransportReplay(NULL, NULL);
+    GPSSerial.begin(9600);
+    while (UBXNavAvailable()) // A frame cut off by the last test is ended by the sentence
+        ;
+    FeedNMEA();
+    gps.sat_count = 0;
+    UBXNavHorizontalAccuracy = 0;
+    UBXNavFixMillis = NOT_SET;
+}
+
+void tearDown()
+{
+}
+
+static void AssertFix()
+{
+    gps_fix Fix = UBXNavRead();
+
+    TEST_ASSERT_TRUE(Fix.valid.status);
+    TEST_ASSERT_EQUAL(gps_fix::STATUS_STD, Fix.status);
+    TEST_ASSERT_TRUE(Fix.valid.date);
+    TEST_ASSERT_TRUE(Fix.valid.time);
+    TEST_ASSERT_EQUAL(26, Fix.dateTime.year);
+    TEST_ASSERT_EQUAL(4, Fix.dateTime.month);
+    TEST_ASSERT_EQUAL(16, Fix.dateTime.date);
+    TEST_ASSERT_EQUAL(9, Fix.dateTime.hours);
+    TEST_ASSERT_EQUAL(59, Fix.dateTime.minutes);
+    TEST_ASSERT_EQUAL(58, Fix.dateTime.seconds);
+    TEST_ASSERT_EQUAL(25, Fix.dateTime_cs);
+    TEST_ASSERT_TRUE(Fix.valid.location);
+    TEST_ASSERT_EQUAL(556687242, Fix.latitudeL());
+    TEST_ASSERT_EQUAL(125925535, Fix.longitudeL());
+    TEST_ASSERT_TRUE(Fix.valid.altitude);
+    TEST_ASSERT_EQUAL(35, Fix.alt.whole);
+    TEST_ASSERT_EQUAL(20, Fix.alt.frac);
+    TEST_ASSERT_TRUE(Fix.valid.satellites);
+    TEST_ASSERT_EQUAL(8, Fix.satellites);
+    TEST_ASSERT_EQUAL(2500, UBXNavHorizontalAccuracy);
+    TEST_ASSERT_EQUAL(4000, UBXNavVerticalAccuracy);
+}
+
+// 92 bytes from u-blox 8, 84 on u-blox 7
+void test_pvt()
+{
+    BuildPVT(92);
+    TEST_ASSERT_EQUAL(1, FeedFrame());
+    AssertFix();
+    TEST_ASSERT_TRUE(millis() - UBXNavFixMillis < 100);
+
+    BuildPVT(UBX_NAV_PVT_LENGTH);
+    TEST_ASSERT_EQUAL(1, FeedFrame());
+    AssertFix();
+}
+
+// Time that is not fully resolved yet may be off by the leap seconds, no fix within the accuracy limits is no position
+void test_pvt_no_fix()
+{
+    BuildPVT(92);
+    Put(11, 0x03, 1);
+    Put(21, 0x00, 1);
+    Finish();
+    TEST_ASSERT_EQUAL(1, FeedFrame());
+    TEST_ASSERT_EQUAL(gps_fix::STATUS_NONE, UBXNavRead().status);
+    TEST_ASSERT_TRUE(UBXNavRead().valid.date);
+    TEST_ASSERT_FALSE(UBXNavRead().valid.time);
+    TEST_ASSERT_FALSE(UBXNavRead().valid.location);
+    TEST_ASSERT_FALSE(UBXNavRead().valid.altitude);
+    TEST_ASSERT_EQUAL(NOT_SET, UBXNavFixMillis);
+}
+
+// A broken frame gives no fix, the decoder picks up the next one
+void test_bad_checksum()
+{
+    BuildPVT(92);
+    Frame[FrameLength - 1] ^= 0x01;
+    TEST_ASSERT_EQUAL(0, FeedFrame());
+    Frame[FrameLength - 1] ^= 0x01;
+    Frame[FrameLength - 2] ^= 0x80;
+    TEST_ASSERT_EQUAL(0, FeedFrame());
+    Frame[FrameLength - 2] ^= 0x80;
+    Frame[30] ^= 0x10; // A bit of the latitude
+    TEST_ASSERT_EQUAL(0, FeedFrame());
+    Frame[30] ^= 0x10;
+    TEST_ASSERT_EQUAL(1, FeedFrame());
+    AssertFix();
+}
+
+// NMEA between frames is passed over. A sentence in the middle of a frame breaks it, the frame after it is decoded
+void test_nmea_interleaved()
+{
+    BuildPVT(92);
+    TEST_ASSERT_EQUAL(0, FeedNMEA());
+    TEST_ASSERT_EQUAL(1, FeedFrame());
+    TEST_ASSERT_EQUAL(0, FeedNMEA());
+
+    TEST_ASSERT_EQUAL(0, Feed(Frame, 40));
+    TEST_ASSERT_EQUAL(0, FeedNMEA());
+    TEST_ASSERT_EQUAL(0, Feed(&Frame[40], FrameLength - 40));
+    TEST_ASSERT_EQUAL(1, FeedFrame());
+    AssertFix();
+}
+
+// GPS 5, SBAS 123 and GLONASS slot 7, which is 71 in NMEA. Elevation below the horizon and SNR over 99 are limited
+void test_nav_sat()
+{
+    Start(UBX_CLASS_NAV, UBX_NAV_SAT, 8 + 3 * 12);
+    Put(0, 381616250, 4);
+    Put(4, 1, 1); // version
+    Put(5, 3, 1); // numSvs
+    Put(8 + 0, 0, 1);
+    Put(8 + 1, 5, 1);
+    Put(8 + 2, 42, 1);
+    Put(8 + 3, 61, 1);
+    Put(8 + 4, 232, 2);
+    Put(8 + 8, 0x0F, 4); // qualityInd 7, svUsed
+    Put(20 + 0, 1, 1);
+    Put(20 + 1, 123, 1);
+    Put(20 + 2, 120, 1);
+    Put(20 + 3, 28, 1);
+    Put(20 + 4, 197, 2);
+    Put(20 + 8, 0x04, 4); // Code locked
+    Put(32 + 0, 6, 1);
+    Put(32 + 1, 7, 1);
+    Put(32 + 2, 0, 1);
+    Put(32 + 3, (uint8_t)-3, 1);
+    Put(32 + 4, 315, 2);
+    Put(32 + 8, 0x01, 4); // Searching
+    Finish();
+    TEST_ASSERT_EQUAL(0, FeedFrame()); // Not a fix
+    TEST_ASSERT_EQUAL(3, gps.sat_count);
+    TEST_ASSERT_EQUAL(5, gps.satellites[0].id);
+    TEST_ASSERT_EQUAL(42, gps.satellites[0].snr);
+    TEST_ASSERT_EQUAL(61, gps.satellites[0].elevation);
+    TEST_ASSERT_EQUAL(232, gps.satellites[0].azimuth);
+    TEST_ASSERT_TRUE(gps.satellites[0].tracked);
+    TEST_ASSERT_EQUAL(123, gps.satellites[1].id);
+    TEST_ASSERT_EQUAL(99, gps.satellites[1].snr);
+    TEST_ASSERT_EQUAL(197, gps.satellites[1].azimuth);
+    TEST_ASSERT_TRUE(gps.satellites[1].tracked);
+    TEST_ASSERT_EQUAL(71, gps.satellites[2].id);
+    TEST_ASSERT_EQUAL(0, gps.satellites[2].elevation);
+    TEST_ASSERT_EQUAL(315, gps.satellites[2].azimuth);
+    TEST_ASSERT_FALSE(gps.satellites[2].tracked);
+
+    // With a bad checksum the count stays as it was
+    Start(UBX_CLASS_NAV, UBX_NAV_SAT, 8 + 12);
+    Put(5, 1, 1);
+    Put(8 + 1, 9, 1);
+    Finish();
+    Frame[FrameLength - 1]++;
+    FeedFrame();
+    TEST_ASSERT_EQUAL(3, gps.sat_count);
+}
+
+// The same satellites as NAV-SVINFO from a u-blox 7, which numbers them as NMEA does
+void test_nav_svinfo()
+{
+    Start(UBX_CLASS_NAV, UBX_NAV_SVINFO, 8 + 3 * 12);
+    Put(0, 381616250, 4);
+    Put(4, 3, 1); // numCh
+    Put(5, 3, 1); // globalFlags, u-blox 7
+    Put(8 + 0, 0, 1);
+    Put(8 + 1, 5, 1);
+    Put(8 + 2, 0x01, 1); // svUsed
+    Put(8 + 3, 7, 1);    // quality
+    Put(8 + 4, 42, 1);
+    Put(8 + 5, 61, 1);
+    Put(8 + 6, 232, 2);
+    Put(20 + 0, 1, 1);
+    Put(20 + 1, 123, 1);
+    Put(20 + 3, 4, 1);
+    Put(20 + 4, 120, 1);
+    Put(20 + 5, 28, 1);
+    Put(20 + 6, 197, 2);
+    Put(32 + 0, 2, 1);
+    Put(32 + 1, 71, 1);
+    Put(32 + 3, 1, 1);
+    Put(32 + 5, (uint8_t)-3, 1);
+    Put(32 + 6, 315, 2);
+    Finish();
+    TEST_ASSERT_EQUAL(0, FeedFrame());
+    TEST_ASSERT_EQUAL(3, gps.sat_count);
+    TEST_ASSERT_EQUAL(5, gps.satellites[0].id);
+    TEST_ASSERT_EQUAL(42, gps.satellites[0].snr);
+    TEST_ASSERT_EQUAL(61, gps.satellites[0].elevation);
+    TEST_ASSERT_EQUAL(232, gps.satellites[0].azimuth);
+    TEST_ASSERT_TRUE(gps.satellites[0].tracked);
+    TEST_ASSERT_EQUAL(123, gps.satellites[1].id);
+    TEST_ASSERT_EQUAL(99, gps.satellites[1].snr);
+    TEST_ASSERT_EQUAL(197, gps.satellites[1].azimuth);
+    TEST_ASSERT_TRUE(gps.satellites[1].tracked);
+    TEST_ASSERT_EQUAL(71, gps.satellites[2].id);
+    TEST_ASSERT_EQUAL(0, gps.satellites[2].elevation);
+    TEST_ASSERT_EQUAL(315, gps.satellites[2].azimuth);
+    TEST_ASSERT_FALSE(gps.satellites[2].tracked);
+}
+
+// More satellites than the NeoGPS list holds are left out
+void test_nav_sat_overflow()
+{
+    Start(UBX_CLASS_NAV, UBX_NAV_SAT, 8 + 24 * 12);
+    Put(5, 24, 1);
+    for (uint8_t i = 0; i < 24; i++)
+        Put(8 + i * 12 + 1, i + 1, 1);
+    Finish();
+    FeedFrame();
+    TEST_ASSERT_EQUAL(NMEAGPS_MAX_SATELLITES, gps.sat_count);
+    TEST_ASSERT_EQUAL(NMEAGPS_MAX_SATELLITES, gps.satellites[NMEAGPS_MAX_SATELLITES - 1].id);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_pvt);
+    RUN_TEST(test_pvt_no_fix);
+    RUN_TEST(test_bad_checksum);
+    RUN_TEST(test_nmea_interleaved);
+    RUN_TEST(test_nav_sat);
+    RUN_TEST(test_nav_svinfo);
+    RUN_TEST(test_nav_sat_overflow);
+    return UNITY_END();
+}
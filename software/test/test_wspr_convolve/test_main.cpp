@@ -0,0 +1,201 @@
+// WSPR convolutional encoder (convolve in wspr_packet_formatting.cpp), pio test -e native
+// The single pass encoder is checked against the original bit-serial pipeline: two shift registers with a 32 step parity
+// loop each, then the interleaver with a runtime bit reversal, then the merge with the 162 entry sync vector.
+// The compile time InterleavePos table and the packed SyncVector are also checked entry by entry against that pipeline.
+
+#include <unity.h>
+#include "Arduino.h"
+#include "wspr_packet_formatting.hpp"
+
+#define MESSAGES 20000 // Random message buffers per test
+
+static const uint8_t RefSync[WSPR_SYMBOL_COUNT] =
+    {1, 1, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 1, 1, 1, 0, 0, 0, 1, 0, 0,
+     1, 0, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 1, 0, 1, 0, 0,
+     0, 0, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 0, 1, 1, 0, 1,
+     0, 0, 0, 0, 1, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 0,
+     1, 1, 0, 0, 0, 1, 1, 0, 1, 0, 1, 0, 0, 0, 1, 0, 0, 0, 0, 0, 1,
+     0, 0, 1, 0, 0, 1, 1, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 0, 1,
+     1, 1, 0, 0, 0, 0, 0, 1, 0, 1, 0, 0, 1, 1, 0, 0, 0, 0, 0, 0, 0,
+     1, 1, 0, 1, 0, 1, 1, 0, 0, 0, 1, 1, 0, 0, 0};
+
+static uint32_t Seed;
+
+void setUp()
+{
+    Seed = 12345;
+}
+
+void tearDown()
+{
+}
+
+static uint8_t RandomByte()
+{
+    Seed = Seed * 1103515245UL + 12345UL;
+    return Seed >> 16;
+}
+
+// Parity of the register and the taps, one bit at a time
+static uint8_t RefParity(uint32_t Reg)
+{
+    uint8_t Parity = 0;
+
+    for (uint8_t k = 0; k < 32; k++)
+    {
+        Parity ^= Reg & 0x01;
+        Reg >>= 1;
+    }
+    return Parity;
+}
+
+// The original encoder, interleaver and sync merge, one symbol per byte
+static void RefEncode(const uint8_t *c, uint8_t *Symbols)
+{
+    uint8_t s[WSPR_SYMBOL_COUNT];
+    uint8_t d[WSPR_SYMBOL_COUNT];
+    uint32_t Reg0 = 0, Reg1 = 0;
+    uint8_t Count = 0, Rev, i;
+
+    for (i = 0; (i < 11) && (Count < WSPR_SYMBOL_COUNT); i++)
+    {
+        for (uint8_t j = 0; (j < 8) && (Count < WSPR_SYMBOL_COUNT); j++)
+        {
+            Reg0 = (Reg0 << 1) | ((c[i] >> (7 - j)) & 0x01);
+            Reg1 = (Reg1 << 1) | ((c[i] >> (7 - j)) & 0x01);
+            s[Count++] = RefParity(Reg0 & 0xf2d05351);
+            s[Count++] = RefParity(Reg1 & 0xe4613c47);
+        }
+    }
+    i = 0;
+    for (uint16_t j = 0; (j < 256) && (i < WSPR_SYMBOL_COUNT); j++)
+    {
+        Rev = 0;
+        for (uint8_t k = 0; k < 8; k++)
+        {
+            if (j & (1 << k))
+            {
+                Rev |= 1 << (7 - k);
+            }
+        }
+        if (Rev < WSPR_SYMBOL_COUNT)
+        {
+            d[Rev] = s[i++];
+        }
+    }
+    for (i = 0; i < WSPR_SYMBOL_COUNT; i++)
+    {
+        Symbols[i] = RefSync[i] + 2 * d[i];
+    }
+}
+
+// Encodes Message both ways and compares every channel symbol
+static void CheckMessage(uint8_t *Message)
+{
+    uint8_t Packed[WSPR_PACKED_SIZE] = {0};
+    uint8_t Expected[WSPR_SYMBOL_COUNT];
+
+    RefEncode(Message, Expected);
+    convolve(Message, Packed, 11, WSPR_SYMBOL_COUNT);
+    for (uint8_t i = 0; i < WSPR_SYMBOL_COUNT; i++)
+    {
+        TEST_ASSERT_EQUAL_MESSAGE(Expected[i], (Packed[i >> 2] >> ((i & 0x03) << 1)) & 0x03, "symbol differs from the bit-serial encoder");
+    }
+}
+
+// Messages as wspr_encode builds them, 50 random bits followed by the 31 zero bits that flush the encoder
+void test_random_messages()
+{
+    uint8_t Message[11];
+
+    for (uint16_t n = 0; n < MESSAGES; n++)
+    {
+        for (uint8_t i = 0; i < 11; i++)
+        {
+            Message[i] = (i < 7) ? RandomByte() : 0;
+        }
+        Message[6] &= 0xc0;
+        CheckMessage(Message);
+    }
+}
+
+// Random bits all the way, the register is never flushed
+void test_random_bits()
+{
+    uint8_t Message[11];
+
+    for (uint16_t n = 0; n < MESSAGES; n++)
+    {
+        for (uint8_t i = 0; i < 11; i++)
+        {
+            Message[i] = RandomByte();
+        }
+        CheckMessage(Message);
+    }
+}
+
+// A single bit set, each position of the register in turn
+void test_single_bits()
+{
+    uint8_t Message[11];
+
+    for (uint8_t Bit = 0; Bit < 81; Bit++)
+    {
+        memset(Message, 0, sizeof(Message));
+        Message[Bit >> 3] = 0x80 >> (Bit & 0x07);
+        CheckMessage(Message);
+    }
+}
+
+// Each InterleavePos entry is the next bit reversed index below 162, as the original interleaver found them at runtime
+void test_interleave_table()
+{
+    uint8_t n = 0, Rev;
+
+    for (uint16_t j = 0; j < 256; j++)
+    {
+        Rev = 0;
+        for (uint8_t k = 0; k < 8; k++)
+        {
+            if (j & (1 << k))
+            {
+                Rev |= 1 << (7 - k);
+            }
+        }
+        if (Rev < WSPR_SYMBOL_COUNT)
+        {
+            TEST_ASSERT_EQUAL(Rev, pgm_read_byte(&InterleavePos[n]));
+            n++;
+        }
+    }
+    TEST_ASSERT_EQUAL(WSPR_SYMBOL_COUNT, n);
+}
+
+// The packed sync vector holds the 162 entry array of the original merge, the unused bits of the last byte are clear
+void test_sync_vector()
+{
+    uint8_t Message[11] = {0};
+    uint8_t Packed[WSPR_PACKED_SIZE] = {0};
+
+    for (uint8_t i = 0; i < WSPR_SYMBOL_COUNT; i++)
+    {
+        TEST_ASSERT_EQUAL(RefSync[i], (pgm_read_byte(&SyncVector[i >> 3]) >> (7 - (i & 0x07))) & 0x01);
+    }
+    TEST_ASSERT_EQUAL(0, pgm_read_byte(&SyncVector[sizeof(SyncVector) - 1]) & (0xff >> (WSPR_SYMBOL_COUNT & 0x07)));
+    convolve(Message, Packed, 11, WSPR_SYMBOL_COUNT); // All zero message, the symbols are the sync vector alone
+    for (uint8_t i = 0; i < WSPR_SYMBOL_COUNT; i++)
+    {
+        TEST_ASSERT_EQUAL(RefSync[i], (Packed[i >> 2] >> ((i & 0x03) << 1)) & 0x03);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_interleave_table);
+    RUN_TEST(test_sync_vector);
+    RUN_TEST(test_random_messages);
+    RUN_TEST(test_random_bits);
+    RUN_TEST(test_single_bits);
+    return UNITY_END();
+}
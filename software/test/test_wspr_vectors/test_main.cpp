@@ -0,0 +1,133 @@
+// Golden vectors for the WSPR encoder, pio test -e native
+// The channel symbols come from host/wspr_reference.py, an encoder written from the WSJT-X wsprcode packing rules that
+// shares no code with the firmware. K1ABC FN42 37 is also the example message of the WSJT-X documentation.
+// Regenerate the table with: python3 host/wspr_reference.py --test-vectors
+
+#include <unity.h>
+#include "Arduino.h"
+#include "datatypes.hpp"
+#include "wspr_packet_formatting.hpp"
+
+struct S_Vector
+{
+    const char *Message;  // As WSJT-X takes it
+    const char *CallSign; // Firmware settings for the message
+    const char *Locator;  // Four characters for Type 1, six for Type 3
+    uint8_t TXPowerdBm;
+    uint8_t Type;
+    E_SufixPreFixOption SuPreFixOption;
+    const char *Prefix;
+    uint8_t Sufix;
+    const char *Symbols; // The 162 channel symbols
+};
+
+static const S_Vector Vectors[] = {
+    {"K1ABC FN42 37", "K1ABC", "FN42", 37, 1, None, "", 0,
+     "330020001020131222100323133220200032012322002232110233210221321222033030301210212032132003323032203020201023021112330231212221332000010320132222202332323320031222"},
+    {"G4JNT IO90 30", "G4JNT", "IO90", 30, 1, None, "", 0,
+     "332200001222333022100121133220200030012100002012112033030201121020213010301012032010110221123012223200023201001112112031230003312222012120310022222130121320031222"},
+    {"SM7PNV JO65 10", "SM7PNV", "JO65", 10, 1, None, "", 0,
+     "330220021002111000120121313000220212010302222030112031230221303020033230323012012232110021103212023020221021203332310013030203312020030120112022202310303122211200"},
+    {"K1AB AA00 0", "K1AB", "AA00", 0, 1, None, "", 0,
+     "310022001200113022100303133020000210032320202030110231010201323020233032323210012210132203303210223022021201001112130011230021112220032322332200202130123102031022"},
+    {"VK2RG QF56 60", "VK2RG", "QF56", 60, 1, None, "", 0,
+     "332002001220113222100323313220220212232120220230330013212021121020211032123010212032330223321210001220023201023310110013230221312220212320110022000132303320033002"},
+    {"W1AW RR99 23", "W1AW", "RR99", 23, 1, None, "", 0,
+     "332022021222313220302103331000020210032322200010312213012003101222033212101210030012130203301010201202001223203332130211230201132220232102332000220330121120033020"},
+    {"PJ4/K1ABC 37", "K1ABC", "", 37, 2, Prefix, "PJ4", 0,
+     "310220001022131020100123131220220230030322022010130031010003323222013010301210032032112203323030223022021023001310310031230021332000010120112222222132323102011022"},
+    {"F/G4JNT 27", "G4JNT", "", 27, 2, Prefix, "  F", 0,
+     "332200201222313220120323111220000230010100002210132233030003101222213032321012232210110023323232223200023001003112132033212203332022030320310222222330101102031220"},
+    {"K1ABC/P 37", "K1ABC", "", 37, 2, Sufix, "", 25,
+     "310220001022111020100121113222020030012122022230130033010001323222013032301210032232130201123230223020001023021312330011230021332000030120132002202330123122033020"},
+    {"K1ABC/7 33", "K1ABC", "", 33, 2, Sufix, "", 7,
+     "330220001022131222100323113020200230032322022232130233030001323220013032301010012030130203123210203222001021001110310211210223132200030122112200202332123120031020"},
+    {"K1ABC/12 13", "K1ABC", "", 13, 2, Sufix, "", 38,
+     "330222001220133222120121113022220230012320002012130231010001301222013030301210012030130001103030203022001221003310330231210023332202010322112020222332123122011020"},
+    {"<K1ABC> FN42AX 37", "K1ABC", "FN42AX", 37, 3, None, "", 0,
+     "332220023220333220322103133220222012210120222030132213012021103002011232323030210030132021323232201022223221201330130211012021312002210122132020220110101322231200"},
+    {"<G4JNT> IO90JU 7", "G4JNT", "IO90JU", 7, 3, None, "", 0,
+     "312002001020331002120103313220002212232322020212332013032021101000233232123212032012330003303210021202001023203110310233232003312202030122310020202132121320031020"},
+    {"<SM7PNV> JO65MR 23", "SM7PNV", "JO65MR", 23, 3, None, "", 0,
+     "312022001222313202120103113022002032232120020012310013010001301000033010103210232212110201103010021022221201023112130031210201312000032320310002222112103122033020"},
+    {"<PJ4/K1ABC> FN42AX 37", "K1ABC", "FN42AX", 37, 3, Prefix, "PJ4", 0,
+     "332022023022333220302103111220222212230322202230132011012003101000011010323232210030112021323032201222223223221330130011010221312202210120112020220310301100211202"},
+    {"<F/G4JNT> IN88QK 20", "G4JNT", "IN88QK", 20, 3, Prefix, "  F", 0,
+     "332200023200331022300121133220202212212300020030132213210003101202013210303210230012332021301210203200021003223132312033212023132000030322332022202332323122031000"},
+    {"<K1ABC/P> FN42AX 37", "K1ABC", "FN42AX", 37, 3, Sufix, "", 25,
+     "312222203022311222322321133220222212210322202010132013012201103000011230323230010230132021123032201222003023223330130011012221312002232320132000220312301322213200"},
+    {"<K1ABC/12> FN42AX 10", "K1ABC", "FN42AX", 10, 3, Sufix, "", 38,
+     "312022003222333020322301113220202212232322222012112211232021121202011010303232010232132023303012221020203223221130110033012021132002232320132020220112121322213202"},
+};
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// Encode a vector with the firmware the way DoWSPR does and compare the symbols
+static void CheckVector(const S_Vector &Vector)
+{
+    S_GadgetData Data;
+    uint8_t Packed[WSPR_PACKED_SIZE];
+    char Symbols[WSPR_SYMBOL_COUNT + 1];
+
+    memset(&Data, 0, sizeof(Data));
+    strcpy(Data.WSPRData.CallSign, Vector.CallSign);
+    Data.WSPRData.SuPreFixOption = Vector.SuPreFixOption;
+    strcpy(Data.WSPRData.Prefix, Vector.Prefix);
+    Data.WSPRData.Sufix = Vector.Sufix;
+    strncpy(Data.WSPRData.MaidenHead6, Vector.Locator, 6);
+    strncpy(Data.WSPRData.MaidenHead4, Vector.Locator, 4);
+    Data.WSPRData.TXPowerdBm = Vector.TXPowerdBm;
+
+    wspr_encode(Data.WSPRData.CallSign, Data.WSPRData.MaidenHead4, Data.WSPRData.TXPowerdBm, Packed, Vector.Type, Data);
+    for (uint8_t i = 0; i < WSPR_SYMBOL_COUNT; i++)
+    {
+        Symbols[i] = '0' + ((Packed[i >> 2] >> ((i & 0x03) << 1)) & 0x03);
+    }
+    Symbols[WSPR_SYMBOL_COUNT] = 0;
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(Vector.Symbols, Symbols, Vector.Message);
+}
+
+static void CheckType(uint8_t Type)
+{
+    uint8_t Count = 0;
+
+    for (uint8_t i = 0; i < sizeof(Vectors) / sizeof(Vectors[0]); i++)
+    {
+        if (Vectors[i].Type == Type)
+        {
+            CheckVector(Vectors[i]);
+            Count++;
+        }
+    }
+    TEST_ASSERT_TRUE(Count > 0);
+}
+
+void test_type1()
+{
+    CheckType(1);
+}
+
+void test_type2()
+{
+    CheckType(2);
+}
+
+void test_type3()
+{
+    CheckType(3);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_type1);
+    RUN_TEST(test_type2);
+    RUN_TEST(test_type3);
+    return UNITY_END();
+}